@@ -0,0 +1,329 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    adv_auth.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Signs the ADV payload with a truncated Carter-Wegman MAC
+ * @author  prisma.ai
+ *
+ *  tag = H(payload) ^ keystream(counter), see mfc_payload.h. The AES work
+ * is kept out of the signing path: the hash tables are built once, and the
+ * keystream words are computed ahead, a few blocks at a time, into a pool.
+ * Signing a payload is then 8 table lookups, a word from the pool and an
+ * XOR (~50 Cortex-M0 cycles).
+ *   Counters are taken a block at a time, and the block number is a boot
+ * number of the event log, written to flash before the first counter of
+ * the block is used. A reset or a used up block moves on to a new one, so
+ * counters only go forward and no keystream word is used twice. Gateways
+ * only accept a counter ahead of the last one they verified, a capture
+ * from before a reset is a replay.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include "adv_auth.h"
+#include "mfc_payload.h"
+#include "clk_gov.h"
+#include "event_log.h"
+#include "lp_timer.h"
+
+#if (ADV_AUTH) && !(EVENT_LOG)
+#error "ADV_AUTH keeps its counter in the event log, build with EVENT_LOG"
+#endif
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+#define ADV_AUTH_POOL_WORDS         (ADV_AUTH_POOL_BLOCKS * MFC_AUTH_WORDS_PER_BLOCK)
+
+static FW_STATE ADV_AUTH_STATS_T adv_auth_stats = {0, 0, 0, 0};
+
+#if (ADV_AUTH)
+/* Blocks of counters start on a keystream block */
+typedef char adv_auth_block_check[(ADV_AUTH_BLOCK_LEN % MFC_AUTH_WORDS_PER_BLOCK == 0u) ? 1 : -1];
+
+#if defined(ADV_AUTH_KEY)
+static const uint8 adv_auth_key[MFC_AUTH_KEY_LEN] = ADV_AUTH_KEY;
+#else
+static const uint8 adv_auth_master_key[MFC_AUTH_KEY_LEN] = ADV_AUTH_MASTER_KEY;
+static FW_STATE uint8 adv_auth_key[MFC_AUTH_KEY_LEN];   // Derived by AdvAuthStart
+#endif
+
+static FW_STATE uint8  auth_addr[MFC_AUTH_ADDR_LEN];     // Band's BD address
+static FW_STATE MFC_AUTH_HASH_T auth_hash;
+static FW_STATE uint32 auth_pool[ADV_AUTH_POOL_WORDS];
+static FW_STATE uint8  auth_pool_head = 0;       // Next word to use
+static FW_STATE uint8  auth_pool_count = 0;      // Words ready
+static FW_STATE uint32 auth_counter = 0;         // Counter of auth_pool[auth_pool_head]
+static FW_STATE uint32 auth_block_end = 0;       // First counter past the block
+static FW_STATE uint8  auth_saved = 0;           // The block's number is in flash
+static FW_STATE uint32 auth_tried = 0;           // Uptime of the last EventLogReserve
+
+/*******************************************************************************
+* @brief This routine runs one block through the BLESS AES engine.
+*
+* @param uint8 domain:              MFC_AUTH_DOMAIN_KEYSTREAM or _HASH
+* @param uint32 index:              Block number
+* @param uint8* out:                MFC_AUTH_BLOCK_LEN bytes
+*
+* @returns None
+*******************************************************************************/
+static void AdvAuthBlock(uint8 domain, uint32 index, uint8 *out)
+{
+    uint8 in[MFC_AUTH_BLOCK_LEN];
+
+    MfcAuthBlockInput(in, domain, auth_addr, index);
+    CyBle_AesEncrypt(in, (uint8 *)adv_auth_key, out);
+    ++adv_auth_stats.aesBlocks;
+}
+
+/*******************************************************************************
+* @brief This routine appends one keystream block to the pool.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvAuthPoolAppend(void)
+{
+    uint8 block[MFC_AUTH_BLOCK_LEN];
+    uint32 counter = auth_counter + auth_pool_count;   // Block aligned
+    uint8 tail = (uint8)((auth_pool_head + auth_pool_count) % ADV_AUTH_POOL_WORDS);
+    uint8 i;
+
+    AdvAuthBlock(MFC_AUTH_DOMAIN_KEYSTREAM, counter / MFC_AUTH_WORDS_PER_BLOCK, block);
+
+    for(i = 0; i < MFC_AUTH_WORDS_PER_BLOCK; ++i)
+    {
+        auth_pool[tail] = MfcAuthKeystreamWord(block, counter + i);
+        tail = (uint8)((tail + 1u) % ADV_AUTH_POOL_WORDS);
+    }
+    auth_pool_count += MFC_AUTH_WORDS_PER_BLOCK;
+}
+
+/*******************************************************************************
+* @brief This routine moves the counter to the start of a new block, once it
+*       is reserved in flash. The words left in the pool are dropped.
+*
+*   If its number couldn't be written, nothing is signed until a retry
+* gets it there: after a reset the same number could come back, and with
+* it counters and keystream words already used.
+*
+* @param uint8 next:                0 for the block of this boot (or the one
+*                                  asked for before), 1 for a new one
+*
+* @returns None
+*******************************************************************************/
+static void AdvAuthReserve(uint8 next)
+{
+    uint16 boot;
+
+    auth_tried = LowPowerTimerSeconds();
+    auth_pool_head = 0;
+    auth_pool_count = 0;
+    auth_saved = EventLogReserve(next, auth_tried, &boot);
+    if(!auth_saved)
+    {
+        ++adv_auth_stats.unsaved;
+        return;
+    }
+    auth_counter = (uint32)boot << ADV_AUTH_BLOCK_BITS;
+    auth_block_end = auth_counter + ADV_AUTH_BLOCK_LEN;
+}
+
+/*******************************************************************************
+* @brief This routine appends keystream blocks until the pool has room for
+*       less than one more, or it reaches the end of the counter block.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvAuthPoolFill(void)
+{
+    while(auth_pool_count + MFC_AUTH_WORDS_PER_BLOCK <= ADV_AUTH_POOL_WORDS &&
+          auth_counter + auth_pool_count != auth_block_end)
+    {
+        AdvAuthPoolAppend();
+    }
+}
+#endif
+
+/*******************************************************************************
+* @brief This routine derives the hash tables from the key and the band's
+*       address, reserves the first block of counters and fills the
+*       keystream pool. Called on STACK_ON, after EventLogStart.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvAuthStart(void)
+{
+#if (ADV_AUTH)
+    uint8 rows[MFC_AUTH_HASH_BLOCKS * MFC_AUTH_BLOCK_LEN];
+    CYBLE_GAP_BD_ADDR_T addr;
+    uint8 i;
+
+    /* Every AES input carries the address, a payload can't be moved to
+     * another band */
+    CyBle_GetDeviceAddress(&addr);
+    memcpy(auth_addr, addr.bdAddr, MFC_AUTH_ADDR_LEN);
+#if !defined(ADV_AUTH_KEY)
+    {
+        uint8 in[MFC_AUTH_BLOCK_LEN];
+
+        MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_BAND_KEY, auth_addr, 0u);
+        CyBle_AesEncrypt(in, (uint8 *)adv_auth_master_key, adv_auth_key);
+        ++adv_auth_stats.aesBlocks;
+    }
+#endif
+
+    for(i = 0; i < MFC_AUTH_HASH_BLOCKS; ++i)
+    {
+        AdvAuthBlock(MFC_AUTH_DOMAIN_HASH, i, &rows[i * MFC_AUTH_BLOCK_LEN]);
+    }
+    MfcAuthHashInit(&auth_hash, rows);
+
+    /* The block of this boot, its number was staged by EventLogStart */
+    AdvAuthReserve(0u);
+    if(auth_saved)
+    {
+        AdvAuthPoolFill();
+    }
+#endif
+}
+
+/*******************************************************************************
+* @brief This routine refills the keystream pool once it is half empty.
+*       Called from the main loop, while the CPU is awake anyway.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvAuthRefill(void)
+{
+#if (ADV_AUTH)
+    if(auth_pool_count > ADV_AUTH_POOL_WORDS / 2u ||
+       (!auth_saved && LowPowerTimerSeconds() - auth_tried < ADV_AUTH_RETRY_S))
+    {
+        return;
+    }
+#if (CLK_GOV)
+    ClockGovernorBoost();
+#endif
+    if(!auth_saved)
+    {
+        /* The last number didn't make it to flash, try again */
+        AdvAuthReserve(0u);
+    }
+    else if(auth_counter + auth_pool_count == auth_block_end &&
+            auth_pool_count < MFC_AUTH_WORDS_PER_BLOCK)
+    {
+        /* Block nearly used up, the next one before the pool runs dry */
+        AdvAuthReserve(1u);
+    }
+    if(auth_saved)
+    {
+        AdvAuthPoolFill();
+    }
+#endif
+}
+
+/*******************************************************************************
+* @brief This function tells whether payloads can be signed: the block of
+*       counters in use is in flash.
+*
+* @param None
+*
+* @returns uint8:                   1 if ready, 0 otherwise (or without
+*                                  ADV_AUTH)
+*******************************************************************************/
+uint8 AdvAuthReady(void)
+{
+#if (ADV_AUTH)
+    return auth_saved;
+#else
+    return 0u;
+#endif
+}
+
+/*******************************************************************************
+* @brief This function signs an encoded version 2 payload: it takes the next
+*       counter and writes it with the tag after the first MFC_PAYLOAD_LEN
+*       bytes.
+*
+* @param uint8* payload:            MFC_PAYLOAD_AUTH_LEN bytes
+*
+* @returns uint8:                   1 if signed, 0 if the next block of
+*                                  counters couldn't be reserved
+*******************************************************************************/
+uint8 AdvAuthSign(uint8 *payload)
+{
+#if (ADV_AUTH)
+    uint32 counter, tag;
+
+    if(!auth_saved)
+    {
+        return 0u;
+    }
+    if(auth_pool_count == 0u)
+    {
+        /* Signed faster than the main loop refills, pay for it now */
+        ++adv_auth_stats.misses;
+        if(auth_counter == auth_block_end)
+        {
+            AdvAuthReserve(1u);
+            if(!auth_saved)
+            {
+                return 0u;
+            }
+        }
+        AdvAuthPoolAppend();
+    }
+
+    counter = auth_counter;
+    tag = MfcAuthHash(&auth_hash, payload) ^ auth_pool[auth_pool_head];
+
+    auth_pool_head = (uint8)((auth_pool_head + 1u) % ADV_AUTH_POOL_WORDS);
+    --auth_pool_count;
+    ++auth_counter;
+    ++adv_auth_stats.signatures;
+
+    payload[4] = (uint8)(counter & 0xFFu);
+    payload[5] = (uint8)((counter >> 8) & 0xFFu);
+    payload[6] = (uint8)((counter >> 16) & 0xFFu);
+    payload[7] = (uint8)(counter >> 24);
+    payload[8] = (uint8)(tag & 0xFFu);
+    payload[9] = (uint8)((tag >> 8) & 0xFFu);
+    payload[10] = (uint8)((tag >> 16) & 0xFFu);
+    payload[11] = (uint8)(tag >> 24);
+    return 1u;
+#else
+    (void)payload;
+    return 0u;
+#endif
+}
+
+/*******************************************************************************
+* @brief This function returns the signing counters.
+*
+* @param None
+*
+* @returns const ADV_AUTH_STATS_T*:  Signatures / AES blocks / pool misses /
+*                                   unsaved blocks
+*******************************************************************************/
+const ADV_AUTH_STATS_T *GetAdvAuthStats(void)
+{
+    return &adv_auth_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,126 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    adv_auth.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for adv_auth.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef ADV_AUTH_HEADER
+#define ADV_AUTH_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Set to 0 to broadcast the unauthenticated (version 1) payload */
+#ifndef ADV_AUTH
+#define ADV_AUTH                    (1u)
+#endif
+
+/*  Master key of the fleet, the gateways derive every band's key from it
+ * and the band's address (mfc_payload.h). This one is a development key:
+ * without ADV_AUTH_KEY, the band derives its own key from it at start.
+ * Production bands are programmed with ADV_AUTH_KEY, their derived key,
+ * and never hold the master one */
+#ifndef ADV_AUTH_MASTER_KEY
+#define ADV_AUTH_MASTER_KEY         { 0x53, 0x61, 0x66, 0x65, 0x20, 0x53, 0x69, 0x67, \
+                                      0x6e, 0x61, 0x6c, 0x20, 0x44, 0x45, 0x56, 0x31 }
+#endif
+
+/*  Keystream pool, in AES blocks of 4 words. Half of it is refilled at once
+ * when it runs low */
+#define ADV_AUTH_POOL_BLOCKS        (4u)
+
+/*  Counters are taken in blocks of 2^ADV_AUTH_BLOCK_BITS, the block number
+ * is a boot number of the event log (EventLogReserve). 65536 signatures,
+ * about 45 days at one a minute (the uptime in the payload) */
+#ifndef ADV_AUTH_BLOCK_BITS
+#define ADV_AUTH_BLOCK_BITS         (16u)
+#endif
+#define ADV_AUTH_BLOCK_LEN          ((uint32)1u << ADV_AUTH_BLOCK_BITS)
+
+/*  A block whose number couldn't be written to flash isn't used, the
+ * payload goes out unsigned and the write is retried this often */
+#define ADV_AUTH_RETRY_S            (10u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 signatures;      // Payloads signed
+    uint32 aesBlocks;       // CyBle_AesEncrypt calls
+    uint32 misses;          // Signatures that found the pool empty
+    uint32 unsaved;         // Blocks whose number didn't make it to flash
+} ADV_AUTH_STATS_T;
+
+/*******************************************************************************
+* @brief This routine derives the hash tables from the key and the band's
+*       address, reserves the first block of counters and fills the
+*       keystream pool. Called on STACK_ON, after EventLogStart.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvAuthStart(void);
+
+/*******************************************************************************
+* @brief This routine refills the keystream pool once it is half empty.
+*       Called from the main loop, while the CPU is awake anyway.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvAuthRefill(void);
+
+/*******************************************************************************
+* @brief This function tells whether payloads can be signed: the block of
+*       counters in use is in flash.
+*
+* @param None
+*
+* @returns uint8:                   1 if ready, 0 otherwise (or without
+*                                  ADV_AUTH)
+*******************************************************************************/
+uint8 AdvAuthReady(void);
+
+/*******************************************************************************
+* @brief This function signs an encoded version 2 payload: it takes the next
+*       counter and writes it with the tag after the first MFC_PAYLOAD_LEN
+*       bytes.
+*
+* @param uint8* payload:            MFC_PAYLOAD_AUTH_LEN bytes
+*
+* @returns uint8:                   1 if signed, 0 if the next block of
+*                                  counters couldn't be reserved
+*******************************************************************************/
+uint8 AdvAuthSign(uint8 *payload);
+
+/*******************************************************************************
+* @brief This function returns the signing counters.
+*
+* @param None
+*
+* @returns const ADV_AUTH_STATS_T*:  Signatures / AES blocks / pool misses /
+*                                   unsaved blocks
+*******************************************************************************/
+const ADV_AUTH_STATS_T *GetAdvAuthStats(void);
+
+#endif
+
+/* [] END OF FILE */
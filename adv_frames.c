@@ -0,0 +1,290 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    adv_frames.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Rotates the ADV packet between prebuilt frames
+ * @author  prisma.ai
+ *
+ *  One ADV packet can't hold the name, the status payload, the telemetry
+ * and the service UUID a phone filters on when pairing, so they go out in
+ * turns, one frame per advertising event:
+ *      ADV_FRAME_ALERT     the component's packet: flags, name, payload
+ *      ADV_FRAME_TELEMETRY flags, payload and the counters after it
+ *      ADV_FRAME_PAIRING   flags, Immediate Alert UUID, TX power, payload
+ *   The frames are built once, at start. A rotation points
+ * cyBle_discoveryModeInfo.advData at the next one, the status payload is
+ * then written into it like into any frame (DynamicADVPayloadUpdate, only
+ * the bytes that changed), and the telemetry frame gets its counters
+ * patched in.
+ *   Which frame goes in which slot is a fixed table for each state of the
+ * band, the telemetry frame takes 1 of the 16 slots of a round out of
+ * pairing. Every swap costs a stack update, two for a frame that is on air
+ * for one slot, so they are kept few. Rounds restart on a new gesture code, so it goes out in the first frame of
+ * the new schedule.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include "adv_frames.h"
+#include "ble_func.h"
+#include "adv_sched.h"
+#include "gesture.h"
+#include "mfc_payload.h"
+#include "power_stats.h"
+
+/*******************************************************************************
+* Compile time checks: the payload and the counters fit the telemetry frame
+*******************************************************************************/
+typedef char adv_frames_len_check[(3u + 4u + MFC_PAYLOAD_AUTH_LEN + ADV_FRAME_TELEMETRY_LEN <=
+                                   CYBLE_GAP_MAX_ADV_DATA_LEN) ? 1 : -1];
+
+#if (ADV_FRAMES)
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Schedules, one per state of the band */
+#define ADV_FRAMES_IDLE             (0u)    // No gesture, or one below an alert
+#define ADV_FRAMES_ALERTING         (1u)    // GESTURE_CODE_ALERT or more
+#define ADV_FRAMES_PAIRING          (2u)    // GESTURE_CODE_PAIRING
+#define ADV_FRAMES_SCHEDULES        (3u)
+
+#define A                           ADV_FRAME_ALERT
+#define T                           ADV_FRAME_TELEMETRY
+#define P                           ADV_FRAME_PAIRING
+
+/* Frame of each slot of a round */
+static const uint8 adv_frames_schedule[ADV_FRAMES_SCHEDULES][ADV_FRAME_SLOTS] =
+{
+    [ADV_FRAMES_IDLE]       = { A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, T },
+    [ADV_FRAMES_ALERTING]   = { A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, T },
+    [ADV_FRAMES_PAIRING]    = { P, P, P, A, P, P, P, A, P, P, P, A, P, P, P, A },
+};
+
+#undef A
+#undef T
+#undef P
+
+/* What the built frames start with, the Manfc. Data comes next */
+static const uint8 adv_frames_telemetry_head[] =
+{
+    0x02u, 0x01u, 0x06u                 // Flags: LE General Discoverable, no BR/EDR
+};
+
+static const uint8 adv_frames_pairing_head[] =
+{
+    0x02u, 0x01u, 0x06u,                // Flags: LE General Discoverable, no BR/EDR
+    0x03u, 0x03u, 0x02u, 0x18u,         // 16-bit UUIDs: Immediate Alert (0x1802)
+    0x02u, 0x0Au, 0x00u                 // TX power level: 0 dBm
+};
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE CYBLE_GAPP_DISC_DATA_T adv_frames_built[ADV_FRAME_COUNT - 1u];
+static FW_STATE CYBLE_GAPP_DISC_DATA_T *adv_frames[ADV_FRAME_COUNT];
+static FW_STATE uint8 adv_frames_status_index[ADV_FRAME_COUNT];
+static FW_STATE uint8 adv_frames_telemetry_index = 0;
+
+static FW_STATE uint8 adv_frames_on_air = ADV_FRAME_ALERT;
+static FW_STATE uint8 adv_frames_slot = 0;
+static FW_STATE uint8 adv_frames_code = GESTURE_CODE_NONE;
+static FW_STATE ADV_FRAMES_STATS_T adv_frames_stats;
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine builds a frame: a head, then the Manfc. Data with a
+*       copy of the status payload and room for extra bytes after it.
+*
+* @param uint8 frame:               Which one (ie: ADV_FRAME_PAIRING)
+* @param const uint8* head:         AD structures before the Manfc. Data
+* @param uint8 headLen:             Their length
+* @param const uint8* status:       The status payload
+* @param uint8 statusLen:           Its length
+* @param uint8 extraLen:            Bytes after it, in the same AD structure
+*
+* @returns None
+*******************************************************************************/
+static void AdvFramesBuild(uint8 frame, const uint8 *head, uint8 headLen,
+                           const uint8 *status, uint8 statusLen, uint8 extraLen)
+{
+    CYBLE_GAPP_DISC_DATA_T *data = &adv_frames_built[frame - 1u];
+    uint8 *out = data->advData;
+
+    memcpy(out, head, headLen);
+    out += headLen;
+    *out++ = (uint8)(1u + MFC_COMPANY_ID_LEN + statusLen + extraLen);
+    *out++ = MFC_AD_TYPE;
+    *out++ = (uint8)(MFC_COMPANY_ID & 0xFFu);
+    *out++ = (uint8)(MFC_COMPANY_ID >> 8);
+    adv_frames_status_index[frame] = (uint8)(out - data->advData);
+    memcpy(out, status, statusLen);
+    out += statusLen + extraLen;
+    data->advDataLen = (uint8)(out - data->advData);
+
+    adv_frames[frame] = data;
+}
+
+/*******************************************************************************
+* @brief This routine writes a saturated little endian uint16.
+*
+* @param uint8* field:              Where to write
+* @param uint32 value:              The value
+*
+* @returns None
+*******************************************************************************/
+static void AdvFramesPut16(uint8 *field, uint32 value)
+{
+    if(value > 0xFFFFu)
+    {
+        value = 0xFFFFu;
+    }
+    field[0] = (uint8)(value & 0xFFu);
+    field[1] = (uint8)(value >> 8);
+}
+
+/*******************************************************************************
+* @brief This routine patches the counters into the telemetry frame, while
+*       it is off air.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvFramesTelemetry(void)
+{
+    uint8 *field = &adv_frames[ADV_FRAME_TELEMETRY]->advData[adv_frames_telemetry_index];
+
+    field[0] = ADV_FRAME_TELEMETRY_VERSION;
+    field[1] = GetAdvProfile();
+    AdvFramesPut16(&field[2], power_stats.wakeButton);
+    AdvFramesPut16(&field[4], power_stats.wakeTimer);
+    AdvFramesPut16(&field[6], power_stats.wakeBle);
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine builds the telemetry and pairing frames around the
+*       status payload of the component's packet, which becomes the alert
+*       frame. Called once from InitializeSystem.
+*
+* @param uint8 statusIndex:         Where the status payload is in the
+*                                  component's packet (MfcPayloadFind)
+* @param uint8 statusLen:           Its length (ie: MFC_PAYLOAD_AUTH_LEN)
+*
+* @returns None
+*******************************************************************************/
+void AdvFramesStart(uint8 statusIndex, uint8 statusLen)
+{
+    const uint8 *status = &advPayload[statusIndex];
+
+    adv_frames[ADV_FRAME_ALERT] = cyBle_discoveryModeInfo.advData;
+    adv_frames_status_index[ADV_FRAME_ALERT] = statusIndex;
+
+    AdvFramesBuild(ADV_FRAME_TELEMETRY, adv_frames_telemetry_head,
+                   sizeof(adv_frames_telemetry_head), status, statusLen,
+                   ADV_FRAME_TELEMETRY_LEN);
+    adv_frames_telemetry_index = adv_frames_status_index[ADV_FRAME_TELEMETRY] + statusLen;
+    AdvFramesTelemetry();
+
+    AdvFramesBuild(ADV_FRAME_PAIRING, adv_frames_pairing_head,
+                   sizeof(adv_frames_pairing_head), status, statusLen, 0u);
+}
+
+/*******************************************************************************
+* @brief This function puts the frame of the next slot on air, by pointing
+*       cyBle_discoveryModeInfo.advData at it. Called once per advertising
+*       event, at EVENT_CLOSE.
+*
+*   A new gesture code starts a new round, so it goes out in the first
+* frame of its schedule.
+*
+* @param uint8 code:                Gesture code on air (ie: GESTURE_CODE_ALERT)
+*
+* @returns uint8:                   1 if the frame changed, the stack needs
+*                                  an update
+*******************************************************************************/
+uint8 AdvFramesRotate(uint8 code)
+{
+    uint8 schedule;
+    uint8 frame;
+
+    if(code != adv_frames_code)
+    {
+        adv_frames_code = code;
+        adv_frames_slot = 0;
+    }
+
+    if(code == GESTURE_CODE_PAIRING)
+    {
+        schedule = ADV_FRAMES_PAIRING;
+    }
+    else if(code >= GESTURE_CODE_ALERT)
+    {
+        schedule = ADV_FRAMES_ALERTING;
+    }
+    else
+    {
+        schedule = ADV_FRAMES_IDLE;
+    }
+
+    frame = adv_frames_schedule[schedule][adv_frames_slot];
+    adv_frames_slot = (uint8)((adv_frames_slot + 1u) % ADV_FRAME_SLOTS);
+    ++adv_frames_stats.slots[frame];
+
+    if(frame == adv_frames_on_air)
+    {
+        return 0;
+    }
+
+    if(frame == ADV_FRAME_TELEMETRY)
+    {
+        AdvFramesTelemetry();
+    }
+    adv_frames_on_air = frame;
+    cyBle_discoveryModeInfo.advData = adv_frames[frame];
+    ++adv_frames_stats.swaps;
+    return 1;
+}
+
+/*******************************************************************************
+* @brief This function tells where the status payload is in the frame on air.
+*
+* @param None
+*
+* @returns uint8:                   Index in advPayload
+*******************************************************************************/
+uint8 AdvFramesStatusIndex(void)
+{
+    return adv_frames_status_index[adv_frames_on_air];
+}
+#endif
+
+/*******************************************************************************
+* @brief This function returns the rotation counters.
+*
+* @param None
+*
+* @returns const ADV_FRAMES_STATS_T*:   Slots / swaps, NULL without ADV_FRAMES
+*******************************************************************************/
+const ADV_FRAMES_STATS_T *GetAdvFramesStats(void)
+{
+#if (ADV_FRAMES)
+    return &adv_frames_stats;
+#else
+    return NULL;
+#endif
+}
+
+/* [] END OF FILE */
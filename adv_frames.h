@@ -0,0 +1,114 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    adv_frames.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for adv_frames.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef ADV_FRAMES_HEADER
+#define ADV_FRAMES_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Set to 0 to keep the component's ADV packet on air all the time */
+#ifndef ADV_FRAMES
+#define ADV_FRAMES                  (1u)
+#endif
+
+/* Frames */
+#define ADV_FRAME_ALERT             (0u)    // The component's packet (name)
+#define ADV_FRAME_TELEMETRY         (1u)    // Counters after the payload
+#define ADV_FRAME_PAIRING           (2u)    // Service UUID and TX power
+#define ADV_FRAME_COUNT             (3u)
+
+/* Slots (advertising events) in one round of the rotation */
+#define ADV_FRAME_SLOTS             (16u)
+
+/*  Every frame carries the status payload (mfc_payload.h) in its Manfc.
+ * Data, so a receiver that only reads the payload sees the same thing in
+ * all of them. The telemetry frame goes on after the payload with:
+ *      [0]     ADV_FRAME_TELEMETRY_VERSION
+ *      [1]     Advertising profile (ADV_PROFILE_x)
+ *      [2-3]   Wakeups by a button interrupt
+ *      [4-5]   Wakeups by the low power timer
+ *      [6-7]   Wakeups by BLE (anything else)
+ *  multi-byte values little endian and saturated. MFC_PAYLOAD_AUTH_LEN plus
+ * this fits one ADV packet next to the flags.                              */
+#define ADV_FRAME_TELEMETRY_VERSION (0x01u)
+#define ADV_FRAME_TELEMETRY_LEN     (8u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 slots[ADV_FRAME_COUNT];  // Advertising events each frame was picked for
+    uint32 swaps;                   // Frame changes handed to the stack
+} ADV_FRAMES_STATS_T;
+
+#if (ADV_FRAMES)
+/*******************************************************************************
+* @brief This routine builds the telemetry and pairing frames around the
+*       status payload of the component's packet, which becomes the alert
+*       frame. Called once from InitializeSystem.
+*
+* @param uint8 statusIndex:         Where the status payload is in the
+*                                  component's packet (MfcPayloadFind)
+* @param uint8 statusLen:           Its length (ie: MFC_PAYLOAD_AUTH_LEN)
+*
+* @returns None
+*******************************************************************************/
+void AdvFramesStart(uint8 statusIndex, uint8 statusLen);
+
+/*******************************************************************************
+* @brief This function puts the frame of the next slot on air, by pointing
+*       cyBle_discoveryModeInfo.advData at it. Called once per advertising
+*       event, at EVENT_CLOSE.
+*
+*   A new gesture code starts a new round, so it goes out in the first
+* frame of its schedule.
+*
+* @param uint8 code:                Gesture code on air (ie: GESTURE_CODE_ALERT)
+*
+* @returns uint8:                   1 if the frame changed, the stack needs
+*                                  an update
+*******************************************************************************/
+uint8 AdvFramesRotate(uint8 code);
+
+/*******************************************************************************
+* @brief This function tells where the status payload is in the frame on air.
+*
+* @param None
+*
+* @returns uint8:                   Index in advPayload
+*******************************************************************************/
+uint8 AdvFramesStatusIndex(void);
+#endif
+
+/*******************************************************************************
+* @brief This function returns the rotation counters.
+*
+* @param None
+*
+* @returns const ADV_FRAMES_STATS_T*:   Slots / swaps, NULL without ADV_FRAMES
+*******************************************************************************/
+const ADV_FRAMES_STATS_T *GetAdvFramesStats(void);
+
+#endif
+
+/* [] END OF FILE */
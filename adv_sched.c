@@ -0,0 +1,406 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    adv_sched.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Picks the advertising interval from the alert state
+ * @author  prisma.ai
+ *
+ *  Instead of the component's fixed fast / slow intervals, advertising runs
+ * with a profile for the current state:
+ *      alert press     => ADV_PROFILE_BURST for ADV_BURST_MS
+ *      pairing (0xff)  => ADV_PROFILE_PAIRING for ADV_PAIRING_MS
+ *      then            => ADV_PROFILE_ACTIVE, while the gesture is broadcasted
+ *      counters at 0   => ADV_PROFILE_ACTIVE for ADV_DECAY_MS, then
+ *                         ADV_PROFILE_SLOW for ADV_IDLE_MS, then ADV_PROFILE_IDLE
+ *   With ADV_FAST_PAIRING the pairing gesture opens a window instead:
+ *      bonded phone    => ADV_PROFILE_DIRECTED for ADV_DIRECTED_MS, then
+ *      pairing (0xff)  => ADV_PROFILE_PAIRING for ADV_PAIRING_MS, then
+ *      connected / not => ADV_PROFILE_SLOW, or ADV_PROFILE_IDLE if it was idle
+ * Directed ADV carries no payload, only the bonded phone sees it.
+ *   The interval can only be changed while advertising is stopped, so a
+ * change stops it and the START_STOP event restarts it as CUSTOM with the
+ * new interval, in the same main loop pass.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include "adv_sched.h"
+#include "ble_func.h"
+#include "gesture.h"
+#include "lp_timer.h"
+#include "deferred.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* ADV intervals are set in units of 0.625 ms */
+#define ADV_MS_TO_UNITS(ms)         ((uint16)(((ms) * 8u) / 5u))
+
+/* Profile intervals, indexed by ADV_PROFILE_x */
+static const uint16 adv_profile_interval[ADV_PROFILE_COUNT] =
+{
+    [ADV_PROFILE_BURST]     = ADV_MS_TO_UNITS(ADV_BURST_INTERVAL_MS),
+    [ADV_PROFILE_PAIRING]   = ADV_MS_TO_UNITS(ADV_PAIRING_INTERVAL_MS),
+    [ADV_PROFILE_ACTIVE]    = ADV_MS_TO_UNITS(ADV_ACTIVE_INTERVAL_MS),
+    [ADV_PROFILE_SLOW]      = ADV_MS_TO_UNITS(ADV_SLOW_INTERVAL_MS),
+    [ADV_PROFILE_IDLE]      = ADV_MS_TO_UNITS(ADV_IDLE_INTERVAL_MS),
+    [ADV_PROFILE_DIRECTED]  = ADV_MS_TO_UNITS(ADV_BURST_INTERVAL_MS), // Unused, 3.75 ms at most
+};
+
+/* How long each stage lasts (0 = until a new gesture code) and the next one */
+static const uint32 adv_stage_ticks[ADV_PROFILE_COUNT] =
+{
+    [ADV_PROFILE_BURST]     = LP_TIMER_MS_TO_TICKS(ADV_BURST_MS),
+    [ADV_PROFILE_PAIRING]   = LP_TIMER_MS_TO_TICKS(ADV_PAIRING_MS),
+    [ADV_PROFILE_ACTIVE]    = LP_TIMER_MS_TO_TICKS(ADV_DECAY_MS),
+    [ADV_PROFILE_SLOW]      = LP_TIMER_MS_TO_TICKS(ADV_IDLE_MS),
+    [ADV_PROFILE_IDLE]      = 0u,
+    [ADV_PROFILE_DIRECTED]  = LP_TIMER_MS_TO_TICKS(ADV_DIRECTED_MS),
+};
+
+static const uint8 adv_stage_next[ADV_PROFILE_COUNT] =
+{
+    [ADV_PROFILE_BURST]     = ADV_PROFILE_ACTIVE,
+    [ADV_PROFILE_PAIRING]   = ADV_PROFILE_ACTIVE,
+    [ADV_PROFILE_ACTIVE]    = ADV_PROFILE_SLOW,
+    [ADV_PROFILE_SLOW]      = ADV_PROFILE_IDLE,
+    [ADV_PROFILE_IDLE]      = ADV_PROFILE_IDLE,
+    [ADV_PROFILE_DIRECTED]  = ADV_PROFILE_PAIRING,
+};
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE uint8  sched_profile = ADV_PROFILE_ACTIVE;   // Profile on air
+static FW_STATE uint8  sched_stage = ADV_PROFILE_ACTIVE;     // Profile wanted
+static FW_STATE uint8  sched_code = GESTURE_CODE_NONE;       // Last gesture code seen
+static FW_STATE uint8  sched_restart = 0;                    // Stopped for a change
+
+#if (ADV_FAST_PAIRING)
+static FW_STATE uint8  sched_return = ADV_PROFILE_SLOW;      // Stage after the pairing window
+static FW_STATE uint32 sched_pairing_since = 0;              // When it opened
+static FW_STATE CYBLE_GAP_BD_ADDR_T sched_peer;              // Bonded phone it is directed to
+static FW_STATE ADV_PAIRING_STATS_T pairing_stats = {0, 0, 0, 0, 0, 0};
+#endif
+
+#if (ADV_FAST_PAIRING)
+static void AdvSchedulerNext(void);
+
+/*******************************************************************************
+* @brief This routine opens the pairing window, directed to the bonded phone
+*       if there is one.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvSchedulerPairingStart(void)
+{
+    CYBLE_GAP_BONDED_DEV_ADDR_LIST_T bonded;
+
+    /* Straight back to the low power profile afterwards, no decay */
+    sched_return = (sched_stage == ADV_PROFILE_IDLE) ? ADV_PROFILE_IDLE : ADV_PROFILE_SLOW;
+    sched_pairing_since = LowPowerTimerNow();
+    ++pairing_stats.attempts;
+
+    if(CyBle_GapGetBondedDevicesList(&bonded) == CYBLE_ERROR_OK && bonded.count != 0u)
+    {
+        /* The most recent one, last in the list */
+        sched_peer = bonded.bdAddrList[bonded.count - 1u];
+        sched_stage = ADV_PROFILE_DIRECTED;
+        ++pairing_stats.directed;
+    }
+    else
+    {
+        sched_stage = ADV_PROFILE_PAIRING;
+    }
+}
+
+/*******************************************************************************
+* @brief This routine closes the pairing window, straight to sched_return.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvSchedulerPairingEnd(void)
+{
+    sched_stage = sched_return;
+
+    if(adv_stage_ticks[sched_stage] != 0u)
+    {
+        DeferredArm(DEFERRED_ADV_STAGE, adv_stage_ticks[sched_stage], AdvSchedulerNext);
+    }
+    else
+    {
+        DeferredCancel(DEFERRED_ADV_STAGE);
+    }
+}
+#endif
+
+/*******************************************************************************
+* @brief This routine moves sched_stage to the next stage, once the timed one
+*       is over. DEFERRED_ADV_STAGE callback.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvSchedulerNext(void)
+{
+#if (ADV_FAST_PAIRING)
+    if(sched_stage == ADV_PROFILE_PAIRING)
+    {
+        /* Nobody connected in time */
+        ++pairing_stats.timeouts;
+        AdvSchedulerPairingEnd();
+        return;
+    }
+#endif
+
+    sched_stage = adv_stage_next[sched_stage];
+
+    /* Decay only starts once the counters are back to 0, see below */
+    if(adv_stage_ticks[sched_stage] != 0u && sched_stage != ADV_PROFILE_ACTIVE)
+    {
+        DeferredArm(DEFERRED_ADV_STAGE, adv_stage_ticks[sched_stage], AdvSchedulerNext);
+    }
+}
+
+/*******************************************************************************
+* @brief This routine moves sched_stage along with the gesture code.
+*
+*   A new gesture code restarts the stages, the timed ones then move on by
+* themselves from DEFERRED_ADV_STAGE. The ACTIVE one only starts its decay
+* while no gesture is in progress or broadcasted. With ADV_FAST_PAIRING the
+* pairing window went back to the low power profile before its gesture is
+* cleared, so clearing it changes nothing.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvSchedulerStage(void)
+{
+    uint8 code = GetGestureCode();
+#if (ADV_FAST_PAIRING)
+    uint8 previous = sched_code;
+#endif
+
+    if(code != sched_code)
+    {
+        sched_code = code;
+
+        if(code == GESTURE_CODE_PAIRING)
+        {
+#if (ADV_FAST_PAIRING)
+            AdvSchedulerPairingStart();
+#else
+            sched_stage = ADV_PROFILE_PAIRING;
+#endif
+        }
+        else if(code != GESTURE_CODE_NONE)
+        {
+            sched_stage = ADV_PROFILE_BURST;
+        }
+#if (ADV_FAST_PAIRING)
+        else if(previous == GESTURE_CODE_PAIRING)
+        {
+            return;
+        }
+#endif
+        else
+        {
+            sched_stage = ADV_PROFILE_ACTIVE;
+        }
+
+        if(sched_stage == ADV_PROFILE_ACTIVE)
+        {
+            DeferredCancel(DEFERRED_ADV_STAGE);
+        }
+        else
+        {
+            DeferredArm(DEFERRED_ADV_STAGE, adv_stage_ticks[sched_stage], AdvSchedulerNext);
+        }
+    }
+
+    if(sched_stage == ADV_PROFILE_ACTIVE)
+    {
+        if(GestureActive())
+        {
+            DeferredCancel(DEFERRED_ADV_STAGE);
+        }
+        else if(!DeferredPending(DEFERRED_ADV_STAGE))
+        {
+            DeferredArm(DEFERRED_ADV_STAGE, adv_stage_ticks[ADV_PROFILE_ACTIVE], AdvSchedulerNext);
+        }
+    }
+}
+
+/*******************************************************************************
+* @brief This routine starts advertising with the profile for the current
+*       state. Called on CYBLE_EVT_STACK_ON and after a disconnect.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerStart(void)
+{
+    AdvSchedulerStage();
+
+    sched_profile = sched_stage;
+    sched_restart = 0;
+
+    cyBle_discoveryModeInfo.advParam->advIntvMin = adv_profile_interval[sched_profile];
+    cyBle_discoveryModeInfo.advParam->advIntvMax = adv_profile_interval[sched_profile];
+    cyBle_discoveryModeInfo.advTo = 0; // Advertise until told otherwise
+
+#if (ADV_FAST_PAIRING)
+    /* ADV_DIRECT_IND to the bonded phone, until it connects or the stack
+     * stops after ADV_DIRECTED_MS */
+    if(sched_profile == ADV_PROFILE_DIRECTED)
+    {
+        cyBle_discoveryModeInfo.advParam->advType = CYBLE_GAPP_CONNECTABLE_HIGH_DC_DIRECTED_ADV;
+        cyBle_discoveryModeInfo.advParam->directAddrType = sched_peer.type;
+        memcpy(cyBle_discoveryModeInfo.advParam->directAddr, sched_peer.bdAddr,
+               CYBLE_GAP_BD_ADDR_SIZE);
+    }
+    else
+    {
+        cyBle_discoveryModeInfo.advParam->advType = CYBLE_GAPP_CONNECTABLE_UNDIRECTED_ADV;
+    }
+#endif
+
+    CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_CUSTOM);
+}
+
+/*******************************************************************************
+* @brief This routine picks the profile for the current state and, if it
+*       changed, stops advertising so it restarts with the new interval.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerUpdate(void)
+{
+    AdvSchedulerStage();
+
+    if(sched_stage != sched_profile && sched_restart == 0 &&
+       CyBle_GetState() == CYBLE_STATE_ADVERTISING)
+    {
+        sched_restart = 1;
+        CyBle_GappStopAdvertisement();
+        
+        /* With the radio stopped nothing would wake us up to handle the 
+         * START_STOP event, so handle it now */
+        CyBle_ProcessEvents();
+    }
+}
+
+/*******************************************************************************
+* @brief This routine handles CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP,
+*       restarting advertising after a stop requested by AdvSchedulerUpdate.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerStartStop(void)
+{
+#if (ADV_FAST_PAIRING)
+    /* Directed ADV that the stack stopped by itself, before DEFERRED_ADV_STAGE */
+    if(sched_restart == 0 && sched_profile == ADV_PROFILE_DIRECTED &&
+       CyBle_GetState() == CYBLE_STATE_DISCONNECTED)
+    {
+        if(sched_stage == ADV_PROFILE_DIRECTED)
+        {
+            AdvSchedulerNext();
+        }
+        sched_restart = 1;
+    }
+#endif
+
+    if(sched_restart != 0 && CyBle_GetState() == CYBLE_STATE_DISCONNECTED)
+    {
+        AdvSchedulerStart();
+    }
+}
+
+/*******************************************************************************
+* @brief This routine handles CYBLE_EVT_GAP_DEVICE_CONNECTED, ending the
+*       pairing window if one is open.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerConnected(void)
+{
+#if (ADV_FAST_PAIRING)
+    if(sched_stage == ADV_PROFILE_DIRECTED || sched_stage == ADV_PROFILE_PAIRING)
+    {
+        ++pairing_stats.connected;
+        if(sched_profile == ADV_PROFILE_DIRECTED)
+        {
+            ++pairing_stats.directedConnected;
+        }
+        pairing_stats.lastTicks = LowPowerTimerNow() - sched_pairing_since;
+        AdvSchedulerPairingEnd();
+    }
+#endif
+}
+
+/*******************************************************************************
+* @brief This function tells if the current profile is a timed one (burst or
+*       pairing). The gesture only starts to expire after it (COUNTER_EXPIRY_MS).
+*
+* @param None
+*
+* @returns uint8:                   1 if holding, 0 otherwise
+*******************************************************************************/
+uint8 AdvSchedulerHolding(void)
+{
+    return (sched_stage == ADV_PROFILE_BURST ||
+            sched_stage == ADV_PROFILE_PAIRING ||
+            sched_stage == ADV_PROFILE_DIRECTED) ? 1u : 0u;
+}
+
+/*******************************************************************************
+* @brief This function returns the profile on air.
+*
+* @param None
+*
+* @returns uint8:                   The profile (ie: ADV_PROFILE_BURST)
+*******************************************************************************/
+uint8 GetAdvProfile(void)
+{
+    return sched_profile;
+}
+
+/*******************************************************************************
+* @brief This function returns the pairing window counters.
+*
+* @param None
+*
+* @returns const ADV_PAIRING_STATS_T*: The counters, NULL without ADV_FAST_PAIRING
+*******************************************************************************/
+const ADV_PAIRING_STATS_T *GetAdvPairingStats(void)
+{
+#if (ADV_FAST_PAIRING)
+    return &pairing_stats;
+#else
+    return NULL;
+#endif
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,151 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    adv_sched.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for adv_sched.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef ADV_SCHED_HEADER
+#define ADV_SCHED_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/*  Fast-connect pairing: the pairing gesture opens a short high duty
+ * window, directed to the bonded phone first if there is one, that ends
+ * on a connection or a timeout and goes straight back to the low power
+ * profile. Off: pairing is only broadcasted, then decays like a gesture */
+#ifndef ADV_FAST_PAIRING
+#define ADV_FAST_PAIRING            (1u)
+#endif
+
+/* Advertising profiles */
+#define ADV_PROFILE_BURST           (0u)    // Right after an alert press
+#define ADV_PROFILE_PAIRING         (1u)    // Pairing mode (0xff)
+#define ADV_PROFILE_ACTIVE          (2u)    // Gesture broadcasted / just reseted
+#define ADV_PROFILE_SLOW            (3u)    // Idle for ADV_DECAY_MS
+#define ADV_PROFILE_IDLE            (4u)    // Idle for ADV_IDLE_MS more
+#define ADV_PROFILE_DIRECTED        (5u)    // Pairing mode, to the bonded phone
+#define ADV_PROFILE_COUNT           (6u)
+
+/* Advertising intervals, in ms */
+#define ADV_BURST_INTERVAL_MS       (20u)   // Lowest allowed for connectable ADV
+#if (ADV_FAST_PAIRING)
+#define ADV_PAIRING_INTERVAL_MS     (20u)
+#else
+#define ADV_PAIRING_INTERVAL_MS     (50u)
+#endif
+#define ADV_ACTIVE_INTERVAL_MS      (100u)
+#define ADV_SLOW_INTERVAL_MS        (1000u)
+#define ADV_IDLE_INTERVAL_MS        (2500u)
+
+/* How long each timed profile lasts, in ms */
+#define ADV_BURST_MS                (2000u)
+#if (ADV_FAST_PAIRING)
+#define ADV_PAIRING_MS              (3000u) // After ADV_PROFILE_DIRECTED, if any
+#else
+#define ADV_PAIRING_MS              (5000u)
+#endif
+#define ADV_DIRECTED_MS             (1280u) // High duty directed ADV, the most allowed
+#define ADV_DECAY_MS                (10000u)
+#define ADV_IDLE_MS                 (60000u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+/* Pairing windows, see ADV_FAST_PAIRING */
+typedef struct
+{
+    uint32  attempts;           // Pairing gestures
+    uint32  directed;           // Of them started with ADV_PROFILE_DIRECTED
+    uint32  connected;          // Ended by a connection
+    uint32  directedConnected;  // Of them while directed
+    uint32  timeouts;           // Ended by ADV_PAIRING_MS
+    uint32  lastTicks;          // Gesture to connection, of the last one
+} ADV_PAIRING_STATS_T;
+
+/*******************************************************************************
+* @brief This routine starts advertising with the profile for the current
+*       state. Called on CYBLE_EVT_STACK_ON and after a disconnect.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerStart(void);
+
+/*******************************************************************************
+* @brief This routine picks the profile for the current state and, if it
+*       changed, stops advertising so it restarts with the new interval.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerUpdate(void);
+
+/*******************************************************************************
+* @brief This routine handles CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP,
+*       restarting advertising after a stop requested by AdvSchedulerUpdate.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerStartStop(void);
+
+/*******************************************************************************
+* @brief This routine handles CYBLE_EVT_GAP_DEVICE_CONNECTED, ending the
+*       pairing window if one is open.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void AdvSchedulerConnected(void);
+
+/*******************************************************************************
+* @brief This function tells if the current profile is a timed one (burst or
+*       pairing). The gesture only starts to expire after it (COUNTER_EXPIRY_MS).
+*
+* @param None
+*
+* @returns uint8:                   1 if holding, 0 otherwise
+*******************************************************************************/
+uint8 AdvSchedulerHolding(void);
+
+/*******************************************************************************
+* @brief This function returns the profile on air.
+*
+* @param None
+*
+* @returns uint8:                   The profile (ie: ADV_PROFILE_BURST)
+*******************************************************************************/
+uint8 GetAdvProfile(void);
+
+/*******************************************************************************
+* @brief This function returns the pairing window counters.
+*
+* @param None
+*
+* @returns const ADV_PAIRING_STATS_T*: The counters, NULL without ADV_FAST_PAIRING
+*******************************************************************************/
+const ADV_PAIRING_STATS_T *GetAdvPairingStats(void);
+
+#endif
+
+/* [] END OF FILE */
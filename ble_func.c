@@ -15,13 +15,112 @@
 /*******************************************************************************
 * Headers / Libs
 *******************************************************************************/
+#include <string.h>
 #include "ble_func.h"
 #include "button_func.h"
+#include "adv_sched.h"
+#include "power_stats.h"
+#include "mfc_payload.h"
+#include "adv_auth.h"
+#include "event_log.h"
+#include "log_sync.h"
+#include "clk_gov.h"
+#include "deferred.h"
+#include "profiling.h"
+#include "event_trace.h"
+#include "adv_frames.h"
+#include "scan_telemetry.h"
 
 /*******************************************************************************
-* Global variables
+* ADV payload shadow
+*
+*   advPayload always holds what was last handed to the stack, so it doubles
+* as the shadow: bytes are only rewritten when they change, and the stack is
+* only updated when a byte actually changed (adv_dirty).
+*   A frame swap (adv_frames.c) also needs an update, but nothing waits on
+* it: it goes to the stack at the clock it finds (adv_swapped).
+*******************************************************************************/
+static FW_STATE uint8 adv_dirty = 0;
+static FW_STATE uint8 adv_swapped = 0;
+static FW_STATE ADV_UPDATE_STATS_T adv_update_stats = {0, 0};
+
+/* Where the Manfc. Data payload is in advPayload, see InitializeSystem */
+static FW_STATE uint8 mfc_index = 0;
+static FW_STATE uint8 mfc_seq = 0;
+static FW_STATE uint8 mfc_last_code = GESTURE_CODE_NONE;
+static FW_STATE uint8 mfc_last_starts = 0;   // GetGestureStarts() at the last change
+
+#if (ADV_AUTH)
+/* Last signed payload, counter and tag included, for every frame that
+ * rotates in (see adv_frames.c) */
+static FW_STATE uint8 mfc_signed[MFC_PAYLOAD_AUTH_LEN];
+#endif
+
+#if (ADV_FRAMES)
+/* Set at the first EVENT_CLOSE pass of a radio event, cleared when a pass
+ * sees BLESS in another state: one rotation per advertising event */
+static FW_STATE uint8 adv_event_closed = 0;
+#endif
+
+/*******************************************************************************
+* @brief This routine writes bytes into the ADV payload, marking it dirty only
+*       if one of them changed.
+* 
+* @param uint8 index:              First byte to write (ie: mfc_index)
+* @param const uint8* data:        The new bytes
+* @param uint8 length:             How many bytes to write
+*
+* @returns None
 *******************************************************************************/
-uint8 count_broadcasts = 0;
+static void AdvPayloadWrite(uint8 index, const uint8 *data, uint8 length)
+{
+    uint8 i;
+    
+    for(i = 0; i < length; ++i)
+    {
+        if(advPayload[index + i] != data[i])
+        {
+            advPayload[index + i] = data[i];
+            adv_dirty = 1;
+        }
+    }
+}
+
+/*******************************************************************************
+* @brief This routine hands the ADV payload to the stack if it is dirty, or
+*       if the frame changed.
+* 
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void AdvPayloadCommit(void)
+{
+    if(adv_dirty == 0 && adv_swapped == 0)
+    {
+        ++adv_update_stats.skipped;
+        return;
+    }
+    
+#if (CLK_GOV)
+    /* Only a new payload is worth the boost */
+    if(adv_dirty)
+    {
+        ClockGovernorBoost();
+    }
+#endif
+    
+    /* Set the ADV data and SCAN response data, on failure stay dirty and
+     * retry on the next event */
+    if(CyBle_GapUpdateAdvData(
+        cyBle_discoveryModeInfo.advData, 
+        cyBle_discoveryModeInfo.scanRspData) == CYBLE_ERROR_OK)
+    {
+        adv_dirty = 0;
+        adv_swapped = 0;
+        ++adv_update_stats.pushed;
+    }
+}
 
 /*******************************************************************************
 * @brief This routine initializes all the componnets and firmware state.
@@ -33,6 +132,13 @@ uint8 count_broadcasts = 0;
 void InitializeSystem(void)
 {
     CYBLE_API_RESULT_T apiResult;
+    int index;
+    uint8 length = 0;
+
+#if (PROFILING)
+    /* Paint the stack before it is used any deeper */
+    ProfilingStart();
+#endif
 
     CyGlobalIntEnable;  /* Enable global interrupts */
 
@@ -48,6 +154,35 @@ void InitializeSystem(void)
     
     /* ILO is no longer required, shut it down */
     CySysClkIloStop();
+    
+    /* Start the WDT based timer used to debounce the buttons */
+    LowPowerTimerStart();
+    
+#if (CLK_GOV)
+    /* Run the IMO at the LOW level until there is work */
+    ClockGovernorStart();
+#endif
+    
+#if (EVENT_LOG)
+    /* Find the end of the event log in flash */
+    EventLogStart(LowPowerTimerSeconds());
+#endif
+    
+    /* Find the Manfc. Data payload in the ADV packet set in the component */
+    index = MfcPayloadFind(advPayload, cyBle_discoveryModeInfo.advData->advDataLen,
+                           &length);
+    if(index < 0 || length < (ADV_AUTH ? MFC_PAYLOAD_AUTH_LEN : MFC_PAYLOAD_LEN))
+    {
+        CYASSERT(0);  /* No Manfc. Data with room for the payload */
+    }
+    else
+    {
+        mfc_index = (uint8)index;
+#if (ADV_FRAMES)
+        /* Build the other frames around it (see adv_frames.c) */
+        AdvFramesStart(mfc_index, ADV_AUTH ? MFC_PAYLOAD_AUTH_LEN : MFC_PAYLOAD_LEN);
+#endif
+    }
 }
 
 
@@ -62,6 +197,16 @@ void EnterLowPowerMode(void)
 {
     CYBLE_BLESS_STATE_T blessState;
     uint8 intrStatus;
+    POWER_STATS_MARK_T mark;
+    uint8 slept = 0;
+    
+#if (CLK_GOV)
+    /* The work of this pass is done, wait / sleep at the LOW level */
+    ClockGovernorRelax();
+#endif
+    
+    /* Wake up for the earliest deferred deadline, if nothing else does */
+    DeferredSleep();
     
     /* Configure BLESS in Deep-Sleep mode */
     CyBle_EnterLPM(CYBLE_BLESS_DEEPSLEEP);
@@ -71,13 +216,25 @@ void EnterLowPowerMode(void)
     
     /* Get the current state of BLESS block */
     blessState = CyBle_GetBleSsState();
+    EVENT_TRACE_STACK(EVENT_TRACE_AT_LOW_POWER, blessState);
+#if (ADV_FRAMES)
+    if(blessState != CYBLE_BLESS_STATE_EVENT_CLOSE)
+    {
+        adv_event_closed = 0;
+    }
+#endif
     
     /* If BLESS is in Deep-Sleep mode or the XTAL oscillator is turning on, 
      * then PSoC 4 BLE can enter Deep-Sleep mode (1.3uA current consumption) */
     if(blessState == CYBLE_BLESS_STATE_ECO_ON || 
         blessState == CYBLE_BLESS_STATE_DEEPSLEEP)
     {
+        PowerStatsSleep(&mark, POWER_STATE_DEEPSLEEP);
+#if (CLK_GOV)
+        ClockGovernorSleep();
+#endif
         CySysPmDeepSleep();
+        slept = 1;
     }
     else if(blessState != CYBLE_BLESS_STATE_EVENT_CLOSE)
     {
@@ -85,29 +242,56 @@ void EnterLowPowerMode(void)
          * Sleep mode (~1.6mA current consumption) */
         CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_ECO);
         CySysClkImoStop();
+        PowerStatsSleep(&mark, POWER_STATE_SLEEP);
+#if (CLK_GOV)
+        ClockGovernorSleep();
+#endif
         CySysPmSleep();
+        slept = 1;
         CySysClkImoStart();
         CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_IMO);
     }
     else
     {
         /* Keep trying to enter either Sleep or Deep-Sleep mode */    
+        POWER_STATS_COUNT(closeSpins);
     }
     
     CyExitCriticalSection(intrStatus);
+    
+    /* The interrupt that woke us up has run by now */
+    if(slept) {
+        PowerStatsWake(&mark);
+#if (CLK_GOV)
+        ClockGovernorWake();
+#endif
+    }
 }
 
 
 /*******************************************************************************
 * @brief This routine updates the BLE advertisment packet.
 * 
-*   We update the Manfc. Data (index MFC_DATA_INDEX) with the current status of 
+*   We update the Manfc. Data (see mfc_payload.h) with the current status of 
 * the button status / how many times was the button pressed
 *   What each no. of presses mean:
 *       0   => Not pressed / Reseted
 *       1   => Pressed once = Feels Unsafe
 *       2   => Pressed twiche = Configurable through the app
 *       >=4 => Pressed 4 or more times = High Danger / Send 113 Alert
+*             (or both held for LONG_PRESS_DELAY)
+*       MFC_FLAG_PAIRING => Pairing mode
+*   A sequence number (bumped on every change) and the uptime go along.
+*   The press patterns are recognized by the gesture engine (gesture.c), and
+* cleared COUNTER_EXPIRY_MS after they are broadcasted (button_func.c).
+*   With ADV_AUTH each new payload gets a counter and a tag (see adv_auth.c).
+*   With ADV_FRAMES every advertising event puts the next frame of the
+* rotation on air first, the payload is then written into it (see
+* adv_frames.c).
+*   The stack is only updated when the payload bytes or the frame change.
+*   With EVENT_LOG every gesture is also logged to flash (see event_log.c).
+*   With SCAN_TELEMETRY the scan response gets the telemetry once a scanner
+* asked for it (see scan_telemetry.c).
 *
 * @param None
 *
@@ -115,44 +299,122 @@ void EnterLowPowerMode(void)
 *******************************************************************************/
 void DynamicADVPayloadUpdate(void)
 {
+    EVENT_TRACE_STACK(EVENT_TRACE_AT_ADV_UPDATE, CyBle_GetBleSsState());
+    
     if(CyBle_GetBleSsState() == CYBLE_BLESS_STATE_EVENT_CLOSE)
     {
         /*****
-        * advPayloadData:
-        *   if right_counter = PAIRING_MODE_PRESS_NO, broadcast 255, in app it's
-        *  recognized as "pairing mode"
-        *   else broadcast the counter for pressing both buttons
+        * code: the code of the current gesture (see gesture.c), 
+        *  GESTURE_CODE_PAIRING goes out as MFC_FLAG_PAIRING
         *****/
-        uint8 advPayloadData = 0x00;
+        uint8 code = GetGestureCode();
+        uint8 starts = GetGestureStarts();
+        uint32 seconds = LowPowerTimerSeconds();
+        MFC_PAYLOAD_T payload;
+        uint8 encoded[MFC_PAYLOAD_AUTH_LEN];
+        uint8 length;
         
-        uint8 all_counter_status = GetCounterStatus(BOTH_BUTTONS);
-        uint8 right_counter_status = GetCounterStatus(RIGHT_BUTTON);
+#if (ADV_FRAMES)
+        /* Next frame, once per advertising event. Directed ADV carries
+         * none, the rotation waits for it */
+        if(adv_event_closed == 0 && CyBle_GetState() == CYBLE_STATE_ADVERTISING &&
+           GetAdvProfile() != ADV_PROFILE_DIRECTED) {
+            if(AdvFramesRotate(code)) {
+                adv_swapped = 1;
+            }
+            mfc_index = AdvFramesStatusIndex();
+        }
+        adv_event_closed = 1;
+#endif
         
-        /*  After BROADCAST_S broadcasts (ignoring the broadcasts where the 
-         * state is 0) clear the press counter (reset to 0) */
-        if(all_counter_status != 0 || right_counter_status != 0) {
-            ++count_broadcasts;
-            if(count_broadcasts == BROADCAST_S) {
-                count_broadcasts = 0;
-                ResetCounter(ALL_BUTTONS); // Reset all counters
+        /* A new gesture changes the payload even with the code of the last
+         * one, if its clear never made it to a payload update */
+        if(code != mfc_last_code || starts != mfc_last_starts) {
+#if (SCAN_TELEMETRY)
+            /* Counted once it is over, at its highest code */
+            if(mfc_last_code != GESTURE_CODE_NONE &&
+               (code == GESTURE_CODE_NONE || starts != mfc_last_starts)) {
+                ScanTelemetryGesture(mfc_last_code);
             }
-            // Check for special cases ie, pairing mode
-            if (right_counter_status == PAIRING_MODE_PRESS_NO){
-                advPayloadData = 0xff;
-            } else {
-                // If not in pairing mode, send button status
-                advPayloadData = all_counter_status;
+#endif
+            mfc_last_code = code;
+            mfc_last_starts = starts;
+            /* Every change gets a new sequence number, so receivers can tell 
+             * two gestures with the same code apart */
+            ++mfc_seq;
+            EVENT_TRACE_RECORD(EVENT_TRACE_PAYLOAD, code, mfc_seq, 0u);
+#if (EVENT_LOG)
+            if(code != GESTURE_CODE_NONE) {
+                EventLogAppend((code >= GESTURE_CODE_ALERT && code != GESTURE_CODE_PAIRING) ?
+                               EVENT_LOG_ALERT : EVENT_LOG_GESTURE, code, seconds);
             }
+#endif
         }
         
-        /* Set the payload with the button status */
-        advPayload[MFC_DATA_INDEX] = advPayloadData;
-
-        /* Set the ADV data and SCAN response data */
-        CyBle_GapUpdateAdvData(
-            cyBle_discoveryModeInfo.advData, 
-            cyBle_discoveryModeInfo.scanRspData);
+        /* Set the payload with the button status, only update the stack
+         * when it changed */
+        payload.version = AdvAuthReady() ? MFC_PAYLOAD_VERSION_AUTH : MFC_PAYLOAD_VERSION;
+        payload.presses = (code == GESTURE_CODE_PAIRING) ? 0u : code;
+        payload.flags = (code == GESTURE_CODE_PAIRING) ? MFC_FLAG_PAIRING : 0u;
+        payload.seq = mfc_seq;
+        payload.uptimeMinutes = (uint16)(seconds / 60u);
+        payload.counter = 0;
+        payload.tag = 0;
+        length = MfcPayloadEncode(encoded, &payload);
+#if (ADV_AUTH)
+        /* Only sign (and use up a counter) when the fields changed, else 
+         * keep the last counter / tag, the frame on air may be an older copy.
+         * Without a block of counters in flash it goes out as version 1,
+         * until AdvAuthRefill gets one there */
+        if(memcmp(encoded, mfc_signed, MFC_PAYLOAD_LEN) != 0) {
+            if(payload.version == MFC_PAYLOAD_VERSION_AUTH) {
+#if (CLK_GOV)
+                ClockGovernorBoost();
+#endif
+                if(!AdvAuthSign(encoded)) {
+                    payload.version = MFC_PAYLOAD_VERSION;
+                    length = MfcPayloadEncode(encoded, &payload);
+                }
+            }
+            memcpy(mfc_signed, encoded, length);
+        }
+        AdvPayloadWrite(mfc_index, mfc_signed, length);
+#else
+        AdvPayloadWrite(mfc_index, encoded, length);
+#endif
+        
+#if (SCAN_TELEMETRY)
+        /* Telemetry in the scan response, only if a scanner asked for it */
+        if(ScanTelemetryUpdate(cyBle_discoveryModeInfo.scanRspData)) {
+            adv_dirty = 1;
+        }
+#endif
+        AdvPayloadCommit();
+        
+#if (EVENT_LOG)
+        /* Write the staged records, after the payload is handed over and 
+         * not during an alert burst or a connection */
+        EventLogService(seconds, !AdvSchedulerHolding() &&
+                                 CyBle_GetState() != CYBLE_STATE_CONNECTED);
+#endif
+    }
+#if (ADV_FRAMES)
+    else {
+        adv_event_closed = 0;
     }
+#endif
+}
+
+/*******************************************************************************
+* @brief This function returns the ADV payload update counters.
+* 
+* @param None
+*
+* @returns const ADV_UPDATE_STATS_T*:  Pushed / skipped stack updates
+*******************************************************************************/
+const ADV_UPDATE_STATS_T *GetAdvUpdateStats(void)
+{
+    return &adv_update_stats;
 }
 
 /*******************************************************************************
@@ -167,17 +429,64 @@ void DynamicADVPayloadUpdate(void)
 *******************************************************************************/
 void StackEventHandler(uint32 event, void *eventParam)
 {
+    PROFILING_START(event_start);
+    
     switch(event)
     {
         /* Mandatory events to be handled by Find Me Target design */
         case CYBLE_EVT_STACK_ON:
+            AdvAuthStart();
+            AdvSchedulerStart();
+            break;
+            
         case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
-            CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST);
+#if (LOG_SYNC)
+            LogSyncEvent(event, eventParam);
+#endif
+            AdvSchedulerStart();
+            break;
+        
+#if (LOG_SYNC)
+        /* Event log sync (see log_sync.c) */
+        case CYBLE_EVT_GATT_CONNECT_IND:
+        case CYBLE_EVT_GATTS_XCNHG_MTU_REQ:
+        case CYBLE_EVT_GATTS_WRITE_REQ:
+        case CYBLE_EVT_STACK_BUSY_STATUS:
+            LogSyncEvent(event, eventParam);
+            break;
+#endif
+        
+        /* Restart with the new interval after a profile change */
+        case CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP:
+            AdvSchedulerStartStop();
+            break;
+
+#if (SCAN_TELEMETRY)
+        /* Already answered by the link layer, the next answer gets the
+         * telemetry (see scan_telemetry.c) */
+        case CYBLE_EVT_GAPP_SCAN_REQ_RECVD:
+            ScanTelemetryRequested();
+            break;
+#endif
+
+        case CYBLE_EVT_GAP_DEVICE_CONNECTED:
+            /* Ends the pairing window, if one is open */
+            AdvSchedulerConnected();
+            
+            /* Fresh counters / trace for the client to read */
+#if (PROFILING)
+            ProfilingPublish();
+#endif
+#if (EVENT_TRACE)
+            EventTracePublish();
+#endif
             break;
 
         default:
             break;
     }
+    
+    PROFILING_STOP(PROFILING_BLE_EVENT, event_start);
 }
 
 /* [] END OF FILE */
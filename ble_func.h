@@ -20,20 +20,24 @@
 * Headers / Libs
 *******************************************************************************/
 #include <project.h>
+#include "fw_state.h"
     
 /*******************************************************************************
 * Extern and constants required for dynamic ADV payload update
 *******************************************************************************/
-extern CYBLE_GAPP_DISC_MODE_INFO_T cyBle_discoveryModeInfo;
+extern FW_STATE CYBLE_GAPP_DISC_MODE_INFO_T cyBle_discoveryModeInfo;
     
 /* ADV payload data structure */    
 #define advPayload              (cyBle_discoveryModeInfo.advData->advData) 
 
-/* Indexes of the dynamic data contained in the ADV packet */
-#define MFC_DATA_INDEX          (25u)   /* Depends on the packet size! */
-    
-/* How many times to broadcast the status before reseting */
-#define BROADCAST_S             (5u)
+/*******************************************************************************
+* ADV payload update counters
+*******************************************************************************/
+typedef struct
+{
+    uint32 pushed;      // CyBle_GapUpdateAdvData calls (payload changed)
+    uint32 skipped;     // EVENT_CLOSE passes where the payload was unchanged
+} ADV_UPDATE_STATS_T;
 
     
 /*******************************************************************************
@@ -58,13 +62,18 @@ void EnterLowPowerMode(void);
 /*******************************************************************************
 * @brief This routine updates the BLE advertisment packet.
 * 
-*   We update the Manfc. Data (index MFC_DATA_INDEX) with the current status of 
+*   We update the Manfc. Data (see mfc_payload.h) with the current status of 
 * the button status / how many times was the button pressed
 *   What each no. of presses mean:
 *       0   => Not pressed / Reseted
 *       1   => Pressed once = Feels Unsafe
 *       2   => Pressed twiche = Configurable through the app
 *       >=4 => Pressed 4 or more times = High Danger / Send 113 Alert
+*             (or both held for LONG_PRESS_DELAY)
+*       MFC_FLAG_PAIRING => Pairing mode
+*   A sequence number (bumped on every change) and the uptime go along.
+*   The press patterns are recognized by the gesture engine (gesture.c).
+*   The stack is only updated when the payload bytes change.
 *
 * @params None
 *
@@ -72,6 +81,15 @@ void EnterLowPowerMode(void);
 *******************************************************************************/
 void DynamicADVPayloadUpdate(void);
 
+/*******************************************************************************
+* @brief This function returns the ADV payload update counters.
+* 
+* @param None
+*
+* @returns const ADV_UPDATE_STATS_T*:  Pushed / skipped stack updates
+*******************************************************************************/
+const ADV_UPDATE_STATS_T *GetAdvUpdateStats(void);
+
 /*******************************************************************************
 * @brief Event callback to receive events from the BLE Component.
 * 
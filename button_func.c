@@ -16,109 +16,282 @@
 * Headers / Libs
 *******************************************************************************/
 #include "button_func.h"
+#include "power_stats.h"
+#include "clk_gov.h"
+#include "adv_sched.h"
+#include "deferred.h"
+#include "profiling.h"
+#include "event_trace.h"
+
+/*******************************************************************************
+* Compile time checks: a port mask fits in a uint8, a counter in a nibble
+*******************************************************************************/
+typedef char button_count_check[(BUTTON_COUNT <= 8u) ? 1 : -1];
+typedef char button_presses_check[(MAX_AVAILABLE_PRESSES <= 15) ? 1 : -1];
+typedef char button_none_check[((uint8)(0u - 1u) == BUTTON_NONE) ? 1 : -1];
+
+/*******************************************************************************
+* Input of each port mask
+*
+*   One bit is that button. More bits are a chord, only recognized while the
+* chord is still held at the end of PRESS_DELAY. Entries hold the input + 1:
+* a mask left out is 0, which INPUT_OF turns into BUTTON_NONE.
+*******************************************************************************/
+static const uint8 button_input_of[1u << BUTTON_COUNT] =
+{
+    [0x01] = LEFT_BUTTON + 1u,
+    [0x02] = RIGHT_BUTTON + 1u,
+    [0x03] = BOTH_BUTTONS + 1u,
+};
+
+#define INPUT_OF(mask)              ((uint8)(button_input_of[(mask)] - 1u))
+
+/*******************************************************************************
+* What each input does: its gesture engine event, and the input queued when
+* it is held for LONG_PRESS_DELAY (BUTTON_NONE if nothing)
+*******************************************************************************/
+typedef struct
+{
+    uint8 gestureEvent;
+    uint8 longInput;
+} BUTTON_INPUT_T;
+
+static const BUTTON_INPUT_T button_inputs[BUTTON_INPUT_COUNT] =
+{
+    [LEFT_BUTTON]       = { GESTURE_EV_LEFT,        BUTTON_NONE },
+    [RIGHT_BUTTON]      = { GESTURE_EV_RIGHT,       BUTTON_NONE },
+    [BOTH_BUTTONS]      = { GESTURE_EV_BOTH,        BOTH_LONG_PRESS },
+    [BOTH_LONG_PRESS]   = { GESTURE_EV_BOTH_LONG,   BUTTON_NONE },
+};
 
 /*******************************************************************************
 * Variables that stores the number of presses
+*
+*   One nibble per input below BUTTON_COUNTERS, input i in nibbles[i / 2].
+* Only the main loop touches these (ProcessButtonPresses / ResetCounter),
+* the interrupts hand their presses over through the press queue.
 *******************************************************************************/
-volatile uint8 press_counter;
-volatile uint8 right_presses;
+typedef struct
+{
+    uint8 nibbles[(BUTTON_COUNTERS + 1u) / 2u];
+} BUTTON_COUNTERS_T;
+
+static FW_STATE BUTTON_COUNTERS_T button_counters;
+
+#define COUNTER_SHIFT(input)        (((input) & 1u) * 4u)
+
+/*******************************************************************************
+* Debounce state, shared between the button and the timer interrupt
+*******************************************************************************/
+static FW_STATE volatile uint8 debounce_mask = 0;   // Buttons that fired since arming
+static FW_STATE volatile uint8 debounce_armed = 0;  // The PRESS_DELAY timer is running
+
+/*******************************************************************************
+* @brief This function returns the buttons held right now.
+*
+* @param None
+*
+* @returns uint8:                   Port mask, bit N = button N held
+*******************************************************************************/
+static uint8 ButtonsHeld(void) {
+    uint8 port = Alert_Button_Read();
+    
+    return (uint8)((BUTTON_PRESSED ? port : ~port) & BUTTON_ALL_MASK);
+}
+
+/*******************************************************************************
+* @brief Long press timer callback, the chord still held = long press
+*
+*   Runs from the WDT interrupt, LONG_PRESS_DELAY after the first edge.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void LongPressTimerExpired(void) {
+    uint8 held = ButtonsHeld();
+    uint8 input = INPUT_OF(held);
+    
+    EVENT_TRACE_RECORD(EVENT_TRACE_BUTTON_LEVEL, 0u, held, 0u);
+    
+    if (!debounce_armed && input != BUTTON_NONE &&
+        button_inputs[input].longInput != BUTTON_NONE) {
+        HandleButtonPress(button_inputs[input].longInput);
+    }
+}
+
+/*******************************************************************************
+* @brief Debounce timer callback, classifies the press once PRESS_DELAY passed
+*
+*   Runs from the WDT interrupt. A chord still held means its buttons were
+* pressed together, otherwise the first (and only) button that fired wins.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void DebounceTimerExpired(void) {
+    uint8 mask = debounce_mask;
+    uint8 held = ButtonsHeld();
+    uint8 input;
+    
+    debounce_mask = 0;
+    debounce_armed = 0;
+    
+    EVENT_TRACE_RECORD(EVENT_TRACE_BUTTON_LEVEL, 0u, held, 0u);
+    
+    if (held & (held - 1u)) {
+        // More than one button held: the chord
+        input = INPUT_OF(held);
+    } else if (mask & (mask - 1u)) {
+        // More than one fired, but they weren't held together
+        input = BUTTON_NONE;
+    } else {
+        input = INPUT_OF(mask);
+    }
+    
+    if (input == BUTTON_NONE) {
+        return;
+    }
+    
+    HandleButtonPress(input);
+    if (button_inputs[input].longInput != BUTTON_NONE) {
+        // Check again later for a long press
+        LowPowerTimerArm(LP_TIMER_BUTTONS, LONG_PRESS_TICKS, LongPressTimerExpired);
+    }
+}
 
 /*******************************************************************************
 * @brief Setup Interrupt Handler for the Alert Button
 *
-* Handles button presses
+* Handles button presses. The ISR only latches which button fired and arms
+* the low power timer, the press is classified PRESS_DELAY later by
+* DebounceTimerExpired, so the CPU can sleep in the meantime.
 *
 * @param Alert_Interrupt_Handler:   Interrupt Handler Address    
 *
 * @returns None    
 *******************************************************************************/   
-CY_ISR(Alert_Interrupt_Handler) {
-    /* Wait PRESS_DELAY to make sure if the user wanted to press both 
-    buttons we register it */
-    CyDelay(PRESS_DELAY);
+CY_ISR(Alert_Interrupt_Handler)
+{
+    uint8 fired;
+    PROFILING_START(isr_start);
     
-    /* Clear interrupt and get what button was pressed */
-    volatile uint8 mask = Alert_Button_ClearInterrupt();
+    POWER_STATS_COUNT(buttonIrqs);
     
-    if (Alert_Button_Read() == BUTTON_PRESSED) {
-        // Both buttons were pressed
-        HandleAllPressed();
-    } else {
-        switch(mask) {
-            case 0x01:
-                // First (left?) button pressed
-                HandleLeftPressed();
-                break;
-            case 0x02:
-                // Second (right?) button pressed
-                HandleRightPressed();
-                break;
-            default:
-                break;
-        }
+    /* Clear interrupt and remember what button was pressed, bounces only
+    add to the mask */
+    fired = Alert_Button_ClearInterrupt();
+    debounce_mask |= fired;
+    EVENT_TRACE_RECORD(EVENT_TRACE_BUTTON_IRQ, fired, ButtonsHeld(), 0u);
+    
+    /* Wait PRESS_DELAY to make sure if the user wanted to press a chord
+    we register it */
+    if (!debounce_armed)
+    {
+        debounce_armed = 1;
+        LowPowerTimerArm(LP_TIMER_BUTTONS, PRESS_DELAY_TICKS, DebounceTimerExpired);
     }
+    
+    PROFILING_STOP(PROFILING_ISR_BUTTON, isr_start);
 }
 
 /*******************************************************************************
-* @brief This routine handles the press of all the band's buttons.
+* @brief This routine queues the press of an input, for the main loop.
 * 
-* @param None
+* @param uint8 input:               What was pressed (ie: BOTH_BUTTONS or 2)
 *
 * @returns None
 *******************************************************************************/
-void HandleAllPressed(void) {
-    /* If all (atm 2) buttons are pressed increase the press counter to send*/
-    AddButtonPress(BOTH_BUTTONS);
+void HandleButtonPress(uint8 input) {
+    PressQueuePush(LowPowerTimerNow(), input);
 }
 
-
 /*******************************************************************************
-* @brief This routine handles the press of the band's left button.
+* @brief This routine folds the queued presses into the counters and feeds
+*       them to the gesture engine.
 * 
+*   Called from the main loop only, drains everything the interrupts queued
+* since the last call, in order.
+*
 * @param None
 *
 * @returns None
 *******************************************************************************/
-void HandleLeftPressed(void) {
-    /* Modify to add an action for when only the left button is pressed */
+void ProcessButtonPresses(void) {
+    PRESS_EVENT_T event;
+    
+    while (PressQueuePop(&event)) {
+#if (CLK_GOV)
+        ClockGovernorBoost();
+#endif
+        // A new press restarts the expiry, see UpdateCounterExpiry
+        DeferredCancel(DEFERRED_COUNTER_EXPIRY);
+        if (event.button < BUTTON_INPUT_COUNT) {
+            AddButtonPress(event.button);
+            GestureFeed(event.timestamp, button_inputs[event.button].gestureEvent);
+        }
+    }
 }
 
+/*******************************************************************************
+* @brief This routine resets the specified counter to 0 = not pressed.
+* 
+* @param uint8 whatCounter:        The counter to reset (ie: ALL_BUTTONS or 0xFE)
+*
+* @returns None
+*******************************************************************************/
+void ResetCounter(uint8 whatCounter) {
+    uint8 i;
+    
+    if (whatCounter == ALL_BUTTONS) {
+        for (i = 0; i < sizeof(button_counters.nibbles); ++i) {
+            button_counters.nibbles[i] = 0;
+        }
+    } else if (whatCounter < BUTTON_COUNTERS) {
+        button_counters.nibbles[whatCounter >> 1] &= (uint8)~(0x0Fu << COUNTER_SHIFT(whatCounter));
+    }
+}
 
 /*******************************************************************************
-* @brief This routine handles the press of the band's right button.
+* @brief DEFERRED_COUNTER_EXPIRY callback, clears the counters and the gesture
 * 
 * @param None
 *
 * @returns None
 *******************************************************************************/
-void HandleRightPressed(void) {
-    AddButtonPress(RIGHT_BUTTON);
+static void CountersExpired(void) {
+    ResetCounter(ALL_BUTTONS); // Reset all counters
+    GestureReset();
 }
 
 /*******************************************************************************
-* @brief This routine resets the specified counter to 0 = not pressed.
+* @brief This routine arms or drops the expiry of the current gesture.
 * 
-* @param uint8 whatCounter:        The counter to reset (ie: ALL_BUTTONS or 99)
+*   Once the ADV scheduler stops holding it, a gesture is broadcasted for
+* COUNTER_EXPIRY_MS, then the counters and the gesture are cleared. A
+* gesture without a code yet expires GESTURE_WINDOW_MS after its last press.
+* Called from the main loop, after AdvSchedulerUpdate.
+* 
+* @param None
 *
 * @returns None
 *******************************************************************************/
-void ResetCounter(uint8 whatCounter) {
-    switch(whatCounter){
-        case BOTH_BUTTONS:
-            press_counter = 0;
-            break;
-        case RIGHT_BUTTON:
-            right_presses = 0;
-            break;
-        case LEFT_BUTTON:
-            break;
-        case ALL_BUTTONS:
-            press_counter = 0;
-            right_presses = 0;
-            break;
-        default:
-            break;
-    }    
+void UpdateCounterExpiry(void) {
+    uint32 ms;
+    
+    /* Nothing to clear, the scheduler holds it, or it isn't on air (ie: 
+     * connected), it only expires while it is being broadcasted */
+    if (!GestureActive() || AdvSchedulerHolding() ||
+        CyBle_GetState() != CYBLE_STATE_ADVERTISING) {
+        DeferredCancel(DEFERRED_COUNTER_EXPIRY);
+        return;
+    }
+    
+    if (!DeferredPending(DEFERRED_COUNTER_EXPIRY)) {
+        ms = (GetGestureCode() == GESTURE_CODE_NONE) ? GESTURE_WINDOW_MS : COUNTER_EXPIRY_MS;
+        DeferredArm(DEFERRED_COUNTER_EXPIRY, LP_TIMER_MS_TO_TICKS(ms), CountersExpired);
+    }
 }
 
 
@@ -126,28 +299,16 @@ void ResetCounter(uint8 whatCounter) {
 * @brief This routine increments the state of the button with one.
 * 
 * NOTE: It will not increase the counter if the respective counter reached it's
-*   threshold/max value.
+*   threshold/max value. What the presses mean is up to the gesture engine.
 * 
-* @param uint8 whatCounter:        The counter to add to (ie: LEFT_BUTTON or 2)
+* @param uint8 whatCounter:        The counter to add to (ie: LEFT_BUTTON or 0)
 *
 * @returns None
 *******************************************************************************/
 void AddButtonPress(uint8 whatCounter) {
-    switch(whatCounter){
-        case BOTH_BUTTONS:
-            if(right_presses < MAX_AVAILABLE_PRESSES){
-                ++press_counter;
-            }
-            break;
-        case RIGHT_BUTTON:
-            if(right_presses < PAIRING_MODE_PRESS_NO){
-                ++right_presses;
-            }
-            break;
-        case LEFT_BUTTON:
-            break;
-        default:
-            break;
+    if (whatCounter < BUTTON_COUNTERS && 
+        GetCounterStatus(whatCounter) < MAX_AVAILABLE_PRESSES) {
+        button_counters.nibbles[whatCounter >> 1] += (uint8)(1u << COUNTER_SHIFT(whatCounter));
     }
 }
 
@@ -155,25 +316,15 @@ void AddButtonPress(uint8 whatCounter) {
 /*******************************************************************************
 * @brief This function returns the state of the press counter.
 * 
-* @param uint8 whatCounter:        The counter (ie: BOTH_BUTTONS or 0)
+* @param uint8 whatCounter:        The counter (ie: BOTH_BUTTONS or 2)
 *
 * @returns uint8 u_button_state:    The State of the button (0/1/2/4/etc...)
 *******************************************************************************/
 uint8 GetCounterStatus(uint8 whatCounter) {
-    switch(whatCounter){
-        case BOTH_BUTTONS:
-            return press_counter;
-            break;
-        case RIGHT_BUTTON:
-            return right_presses;
-            break;
-        case LEFT_BUTTON:
-            return (int) NULL;
-            break;
-        default:
-            return (int) NULL;
-            break;
+    if (whatCounter >= BUTTON_COUNTERS) {
+        return 0;
     }
+    return (button_counters.nibbles[whatCounter >> 1] >> COUNTER_SHIFT(whatCounter)) & 0x0Fu;
 }
 
 /* [] END OF FILE */
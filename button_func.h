@@ -21,25 +21,44 @@
 * Headers / Libs
 *******************************************************************************/
 #include <project.h>
+#include "fw_state.h"
+#include "lp_timer.h"
+#include "press_queue.h"
+#include "gesture.h"
 
 /*******************************************************************************
 * Constants
 *******************************************************************************/    
-#define BUTTON_PRESSED              (1u) // Change to 0 if pulled low
+#define BUTTON_PRESSED              (1u) // Level of a held button, change to 0 if pulled low
   
 #define PRESS_DELAY                 (50) // In ms
-#define MAX_AVAILABLE_PRESSES       (10) // Do not increase (both)counters beyond this threshold
+#define PRESS_DELAY_TICKS           LP_TIMER_MS_TO_TICKS(PRESS_DELAY)
+#define LONG_PRESS_DELAY            (1000) // In ms, a chord held = long press
+#define LONG_PRESS_TICKS            LP_TIMER_MS_TO_TICKS(LONG_PRESS_DELAY - PRESS_DELAY)
+#define MAX_AVAILABLE_PRESSES       (10) // Do not increase counters beyond this threshold (at most 15)
 #define PAIRING_MODE_PRESS_NO       (5)  // How many times you need to press to enter "pairing mode" 
-
-#define BOTH_BUTTONS                (0)  // Used for setting/getting counters
-#define RIGHT_BUTTON                (1)  // Used for setting/getting counters
-#define LEFT_BUTTON                 (2)  // Used for setting/getting counters
-#define ALL_BUTTONS                 (99) // Used for reseting ALL counters   
+#define COUNTER_EXPIRY_MS           (500) // In ms, how long a gesture is broadcasted (after the ADV scheduler's hold)
+
+/* Buttons: bit N of the Alert_Button port is button N */
+#define BUTTON_COUNT                (2u)
+#define BUTTON_ALL_MASK             ((1u << BUTTON_COUNT) - 1u)
+
+/*  Inputs: the buttons, then the chords, then the inputs without a counter.
+ * Used for setting/getting counters and queuing presses, see button_inputs */
+#define LEFT_BUTTON                 (0u) // Bit 0
+#define RIGHT_BUTTON                (1u) // Bit 1
+#define BOTH_BUTTONS                (2u) // Chord of bits 0 and 1
+#define BUTTON_COUNTERS             (3u) // Inputs above have a counter
+#define BOTH_LONG_PRESS             (3u) // BOTH_BUTTONS held for LONG_PRESS_DELAY
+#define BUTTON_INPUT_COUNT          (4u)
+#define BUTTON_NONE                 (0xFFu) // No input for a port mask
+#define ALL_BUTTONS                 (0xFEu) // Used for reseting ALL counters
 
 /*******************************************************************************
 * @brief Setup Interrupt Handler for the Alert Button
 *
-* Handles button presses
+* Handles button presses, the press itself is classified PRESS_DELAY later
+* from the low power timer
 *
 * @param Alert_Interrupt_Handler:   Interrupt Handler Address    
 *
@@ -49,51 +68,59 @@ CY_ISR(Alert_Interrupt_Handler);
 
 
 /*******************************************************************************
-* @brief This routine handles the press of all the band's buttons.
+* @brief This routine queues the press of an input, for the main loop.
 * 
-* @param None
+* @param uint8 input:               What was pressed (ie: BOTH_BUTTONS or 2)
 *
 * @returns None
 *******************************************************************************/
-void HandleAllPressed(void);
-
+void HandleButtonPress(uint8 input);
 
 /*******************************************************************************
-* @brief This routine handles the press of the band's left button.
+* @brief This routine folds the queued presses into the counters and feeds
+*       them to the gesture engine.
 * 
+*   Called from the main loop only, drains everything the interrupts queued
+* since the last call, in order.
+*
 * @param None
 *
 * @returns None
 *******************************************************************************/
-void HandleLeftPressed(void);
-
+void ProcessButtonPresses(void);
 
 /*******************************************************************************
-* @brief This routine handles the press of the band's right button.
+* @brief This routine resets the specified counter to 0 = not pressed.
 * 
-* @param None
+* @param uint8 whatCounter:        The counter to reset (ie: ALL_BUTTONS or 0xFE)
 *
 * @returns None
 *******************************************************************************/
-void HandleRightPressed(void);
+void ResetCounter(uint8 whatCounter);
+
 
 /*******************************************************************************
-* @brief This routine resets the specified counter to 0 = not pressed.
+* @brief This routine arms or drops the expiry of the current gesture.
 * 
-* @param uint8 whatCounter:        The counter to reset (ie: ALL_BUTTONS or 99)
+*   Once the ADV scheduler stops holding it, a gesture is broadcasted for
+* COUNTER_EXPIRY_MS, then the counters and the gesture are cleared. A
+* gesture without a code yet expires GESTURE_WINDOW_MS after its last press.
+* Called from the main loop, after AdvSchedulerUpdate.
+* 
+* @param None
 *
 * @returns None
 *******************************************************************************/
-void ResetCounter(uint8 whatCounter);
+void UpdateCounterExpiry(void);
 
 
 /*******************************************************************************
 * @brief This routine increments the state of the button with one.
 * 
 * NOTE: It will not increase the counter if the respective counter reached it's
-*   threshold/max value.
+*   threshold/max value. What the presses mean is up to the gesture engine.
 * 
-* @param uint8 whatCounter:        The counter to add to (ie: LEFT_BUTTON or 2)
+* @param uint8 whatCounter:        The counter to add to (ie: LEFT_BUTTON or 0)
 *
 * @returns None
 *******************************************************************************/
@@ -103,7 +130,7 @@ void AddButtonPress(uint8 whatCounter);
 /*******************************************************************************
 * @brief This function returns the state of the press counter.
 * 
-* @param uint8 whatCounter:        The counter (ie: BOTH_BUTTONS or 0)
+* @param uint8 whatCounter:        The counter (ie: BOTH_BUTTONS or 2)
 *
 * @returns uint8 u_button_state:    The State of the button (0/1/2/4/etc...)
 *******************************************************************************/
@@ -0,0 +1,150 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    clk_gov.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Picks the IMO frequency for the work queued in the main loop
+ * @author  prisma.ai
+ *
+ *  Most wakeups only service the stack and wait for BLESS, so the IMO runs
+ * at CLK_GOV_LOW_MHZ. The routines that have cycles to burn (signing, the
+ * ADV update, the log sync pump, gesture recognition) boost it first, and
+ * the main loop relaxes it before going back to sleep, so a wakeup switches
+ * at most twice. Flash rows are left alone: CySysFlashWriteRow already runs
+ * the IMO at 48 MHz for the write and restores it.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "clk_gov.h"
+#include "lp_timer.h"
+
+#if (CLK_GOV)
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE CLK_GOV_STATS_T clk_gov_stats;
+
+static FW_STATE uint8  clk_level = CLK_GOV_LOW;
+static FW_STATE uint32 clk_since = 0;   // LowPowerTimerNow() when the level was set
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine charges the time since clk_since to the current level.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void ClockGovernorAccount(void)
+{
+    uint32 now = LowPowerTimerNow();
+
+    clk_gov_stats.ticks[clk_level] += now - clk_since;
+    clk_since = now;
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine sets the IMO to the LOW level. Called once, before
+*       the main loop.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorStart(void)
+{
+    clk_level = CLK_GOV_LOW;
+    clk_since = LowPowerTimerNow();
+    CySysClkWriteImoFreq(CLK_GOV_LOW_MHZ);
+}
+
+/*******************************************************************************
+* @brief This routine raises the IMO to the BOOST level, before work that
+*       is counted in cycles. It stays there until ClockGovernorRelax.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorBoost(void)
+{
+    if(clk_level == CLK_GOV_BOOST)
+    {
+        return;
+    }
+
+    ClockGovernorAccount();
+    clk_level = CLK_GOV_BOOST;
+    ++clk_gov_stats.boosts;
+    CySysClkWriteImoFreq(CLK_GOV_BOOST_MHZ);
+}
+
+/*******************************************************************************
+* @brief This routine drops the IMO back to the LOW level, once the work
+*       queued in the main loop is done.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorRelax(void)
+{
+    if(clk_level == CLK_GOV_LOW)
+    {
+        return;
+    }
+
+    ClockGovernorAccount();
+    clk_level = CLK_GOV_LOW;
+    CySysClkWriteImoFreq(CLK_GOV_LOW_MHZ);
+}
+
+/*******************************************************************************
+* @brief These routines stop / restart the residency count around a low
+*       power mode, next to PowerStatsSleep / PowerStatsWake.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorSleep(void)
+{
+    ClockGovernorAccount();
+}
+
+void ClockGovernorWake(void)
+{
+    clk_since = LowPowerTimerNow();
+}
+#endif
+
+/*******************************************************************************
+* @brief This function returns the residency counters.
+*
+* @param None
+*
+* @returns const CLK_GOV_STATS_T*:  Ticks at each level / boosts
+*******************************************************************************/
+const CLK_GOV_STATS_T *GetClockGovernorStats(void)
+{
+#if (CLK_GOV)
+    return &clk_gov_stats;
+#else
+    static const CLK_GOV_STATS_T none;
+    return &none;
+#endif
+}
+
+/* [] END OF FILE */
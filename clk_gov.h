@@ -0,0 +1,113 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    clk_gov.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for clk_gov.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef CLK_GOV_HEADER
+#define CLK_GOV_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*
+*   The active current is a fixed part plus a part per MHz, so work that is
+* counted in cycles (AES, the stack's ADV update, notifications) costs the
+* least at the highest clock, while waits that are counted in time (the
+* wakeup, EVENT_CLOSE spins, flash rows) cost the least at the lowest one.
+*******************************************************************************/
+/* Set to 0 to keep the IMO at the frequency set in the component */
+#ifndef CLK_GOV
+#define CLK_GOV                     (1u)
+#endif
+
+/*  IMO frequencies, MHz. Below 12 the main loop is too slow to catch BLESS
+ * in EVENT_CLOSE, and the ADV payload stops being updated */
+#ifndef CLK_GOV_LOW_MHZ
+#define CLK_GOV_LOW_MHZ             (12u)
+#endif
+#ifndef CLK_GOV_BOOST_MHZ
+#define CLK_GOV_BOOST_MHZ           (CY_SYS_CLK_IMO_MAX_FREQ_MHZ)
+#endif
+
+/* Levels */
+#define CLK_GOV_LOW                 (0u)    // Servicing the stack, waiting
+#define CLK_GOV_BOOST               (1u)    // Work queued
+#define CLK_GOV_LEVELS              (2u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 ticks[CLK_GOV_LEVELS];   // LFCLK ticks awake at each level (wraps)
+    uint32 boosts;                  // LOW to BOOST switches
+} CLK_GOV_STATS_T;
+
+/*******************************************************************************
+* @brief This routine sets the IMO to the LOW level. Called once, before
+*       the main loop.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorStart(void);
+
+/*******************************************************************************
+* @brief This routine raises the IMO to the BOOST level, before work that
+*       is counted in cycles. It stays there until ClockGovernorRelax.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorBoost(void);
+
+/*******************************************************************************
+* @brief This routine drops the IMO back to the LOW level, once the work
+*       queued in the main loop is done.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorRelax(void);
+
+/*******************************************************************************
+* @brief These routines stop / restart the residency count around a low
+*       power mode, next to PowerStatsSleep / PowerStatsWake.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ClockGovernorSleep(void);
+void ClockGovernorWake(void);
+
+/*******************************************************************************
+* @brief This function returns the residency counters.
+*
+* @param None
+*
+* @returns const CLK_GOV_STATS_T*:  Ticks at each level / boosts
+*******************************************************************************/
+const CLK_GOV_STATS_T *GetClockGovernorStats(void);
+
+#endif
+
+/* [] END OF FILE */
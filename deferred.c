@@ -0,0 +1,222 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    deferred.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Tickless deadlines for the work the main loop defers
+ * @author  prisma.ai
+ *
+ *  Each user owns one slot (DEFERRED_x) holding a deadline and a callback.
+ * There is no periodic tick: DeferredSleep arms the LP_TIMER_DEFERRED
+ * one-shot for the earliest deadline only, the wakeup it causes lets the
+ * main loop run DeferredService, which calls whatever is due. Callbacks run
+ * in the main loop, so they can touch the same state as the rest of it.
+ *   Every WDT register write waits a few LFCLK cycles (~90 us) for the
+ * clock domain crossing, so the one-shot is only armed again when the
+ * earliest deadline moved or the one armed went off, not on every main loop
+ * pass. It reaches LP_TIMER_MAX_TICKS (2 s) at most, a deadline further
+ * than that costs a wakeup every 2 s.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "deferred.h"
+#include "lp_timer.h"
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32              since;      // LowPowerTimerNow() when armed
+    uint32              ticks;      // Deadline, from since
+    DEFERRED_CALLBACK_T callback;   // NULL when not pending
+} DEFERRED_SLOT_T;
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE DEFERRED_SLOT_T deferred_slots[DEFERRED_COUNT];
+static FW_STATE DEFERRED_STATS_T deferred_stats = {0, 0, 0};
+static FW_STATE uint8  deferred_changed = 0;    // A deadline was set or dropped
+static FW_STATE uint8  deferred_armed = 0;      // LP_TIMER_DEFERRED is running
+static FW_STATE uint32 deferred_armed_at = 0;   // LowPowerTimerNow() it fires at
+
+/*******************************************************************************
+* @brief This routine sets a deadline, replacing the pending one of the same
+*       id. Main loop only.
+*
+* @param uint8 id:                      The deadline (ie: DEFERRED_ADV_STAGE)
+* @param uint32 ticks:                  LFCLK ticks from now (below 2^31)
+* @param DEFERRED_CALLBACK_T callback:  What to call from DeferredService
+*
+* @returns None
+*******************************************************************************/
+void DeferredArm(uint8 id, uint32 ticks, DEFERRED_CALLBACK_T callback)
+{
+    deferred_slots[id].since = LowPowerTimerNow();
+    deferred_slots[id].ticks = ticks;
+    deferred_slots[id].callback = callback;
+    deferred_changed = 1u;
+}
+
+/*******************************************************************************
+* @brief This routine drops a deadline, if it is pending.
+*
+* @param uint8 id:                  The deadline (ie: DEFERRED_ADV_STAGE)
+*
+* @returns None
+*******************************************************************************/
+void DeferredCancel(uint8 id)
+{
+    if(deferred_slots[id].callback != NULL)
+    {
+        deferred_slots[id].callback = NULL;
+        deferred_changed = 1u;
+    }
+}
+
+/*******************************************************************************
+* @brief This function tells if a deadline is pending.
+*
+* @param uint8 id:                  The deadline (ie: DEFERRED_ADV_STAGE)
+*
+* @returns uint8:                   1 if pending, 0 otherwise
+*******************************************************************************/
+uint8 DeferredPending(uint8 id)
+{
+    return (deferred_slots[id].callback != NULL) ? 1u : 0u;
+}
+
+/*******************************************************************************
+* @brief This routine runs the callbacks whose deadline passed. Called from
+*       the main loop, every pass.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void DeferredService(void)
+{
+    uint32 now = LowPowerTimerNow();
+    uint8 id;
+
+    for(id = 0; id < DEFERRED_COUNT; ++id)
+    {
+        DEFERRED_SLOT_T *slot = &deferred_slots[id];
+        DEFERRED_CALLBACK_T callback = slot->callback;
+        uint32 elapsed = now - slot->since;
+
+        if(callback == NULL || elapsed < slot->ticks)
+        {
+            continue;
+        }
+
+        if(elapsed - slot->ticks > deferred_stats.lateMaxTicks)
+        {
+            deferred_stats.lateMaxTicks = elapsed - slot->ticks;
+        }
+        ++deferred_stats.runs;
+
+        /* Before the call, it may arm the slot again */
+        slot->callback = NULL;
+        deferred_changed = 1u;
+        callback();
+    }
+}
+
+/*******************************************************************************
+* @brief This routine arms the LP_TIMER_DEFERRED one-shot for the earliest
+*       deadline, unless it already runs for it. Called from
+*       EnterLowPowerMode, before sleeping.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void DeferredSleep(void)
+{
+    uint32 now = LowPowerTimerNow();
+    uint32 earliest = 0xFFFFFFFFu;
+    uint32 at;
+    uint8 id;
+
+    /* Nothing moved and it hasn't gone off yet (the interrupt stops it) */
+    if(!deferred_changed && deferred_armed && (int32)(deferred_armed_at - now) > 0)
+    {
+        return;
+    }
+    deferred_changed = 0u;
+
+    for(id = 0; id < DEFERRED_COUNT; ++id)
+    {
+        const DEFERRED_SLOT_T *slot = &deferred_slots[id];
+        uint32 elapsed = now - slot->since;
+
+        if(slot->callback == NULL)
+        {
+            continue;
+        }
+        if(elapsed >= slot->ticks)
+        {
+            earliest = 0;   // Due, armed after DeferredService this pass
+        }
+        else if(slot->ticks - elapsed < earliest)
+        {
+            earliest = slot->ticks - elapsed;
+        }
+    }
+
+    if(earliest == 0xFFFFFFFFu)
+    {
+        if(deferred_armed)
+        {
+            LowPowerTimerCancel(LP_TIMER_DEFERRED);
+            deferred_armed = 0u;
+        }
+        return;
+    }
+
+    /* As LowPowerTimerArm clamps it */
+    if(earliest == 0u)
+    {
+        earliest = 1u;
+    }
+    else if(earliest > LP_TIMER_MAX_TICKS)
+    {
+        earliest = LP_TIMER_MAX_TICKS;
+    }
+    at = now + earliest;
+
+    /* Ie: a slot armed again for the same tick */
+    if(deferred_armed && (int32)(deferred_armed_at - now) > 0 && at == deferred_armed_at)
+    {
+        return;
+    }
+
+    /* Only wakes the CPU up, the main loop does the rest */
+    LowPowerTimerArm(LP_TIMER_DEFERRED, earliest, NULL);
+    deferred_armed = 1u;
+    deferred_armed_at = at;
+    ++deferred_stats.arms;
+}
+
+/*******************************************************************************
+* @brief This function returns the deferred work counters.
+*
+* @param None
+*
+* @returns const DEFERRED_STATS_T*:  Runs / lateness / one-shots armed
+*******************************************************************************/
+const DEFERRED_STATS_T *GetDeferredStats(void)
+{
+    return &deferred_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,107 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    deferred.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for deferred.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef DEFERRED_HEADER
+#define DEFERRED_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Deadlines, one per user */
+#define DEFERRED_ADV_STAGE          (0u)    // adv_sched.c: end of the timed profile
+#define DEFERRED_COUNTER_EXPIRY     (1u)    // button_func.c: clear the gesture on air
+#define DEFERRED_COUNT              (2u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef void (*DEFERRED_CALLBACK_T)(void);
+
+typedef struct
+{
+    uint32 runs;            // Callbacks run
+    uint32 lateMaxTicks;    // Latest a callback ran after its deadline
+    uint32 arms;            // LP_TIMER_DEFERRED armed
+} DEFERRED_STATS_T;
+
+/*******************************************************************************
+* @brief This routine sets a deadline, replacing the pending one of the same
+*       id. Main loop only.
+*
+* @param uint8 id:                      The deadline (ie: DEFERRED_ADV_STAGE)
+* @param uint32 ticks:                  LFCLK ticks from now (below 2^31)
+* @param DEFERRED_CALLBACK_T callback:  What to call from DeferredService
+*
+* @returns None
+*******************************************************************************/
+void DeferredArm(uint8 id, uint32 ticks, DEFERRED_CALLBACK_T callback);
+
+/*******************************************************************************
+* @brief This routine drops a deadline, if it is pending.
+*
+* @param uint8 id:                  The deadline (ie: DEFERRED_ADV_STAGE)
+*
+* @returns None
+*******************************************************************************/
+void DeferredCancel(uint8 id);
+
+/*******************************************************************************
+* @brief This function tells if a deadline is pending.
+*
+* @param uint8 id:                  The deadline (ie: DEFERRED_ADV_STAGE)
+*
+* @returns uint8:                   1 if pending, 0 otherwise
+*******************************************************************************/
+uint8 DeferredPending(uint8 id);
+
+/*******************************************************************************
+* @brief This routine runs the callbacks whose deadline passed. Called from
+*       the main loop, every pass.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void DeferredService(void);
+
+/*******************************************************************************
+* @brief This routine arms the LP_TIMER_DEFERRED one-shot for the earliest
+*       deadline, unless it already runs for it. Called from
+*       EnterLowPowerMode, before sleeping.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void DeferredSleep(void);
+
+/*******************************************************************************
+* @brief This function returns the deferred work counters.
+*
+* @param None
+*
+* @returns const DEFERRED_STATS_T*:  Runs / lateness / one-shots armed
+*******************************************************************************/
+const DEFERRED_STATS_T *GetDeferredStats(void);
+
+#endif
+
+/* [] END OF FILE */
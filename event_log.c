@@ -0,0 +1,519 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    event_log.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Persistent log of the gestures, in a ring of flash rows
+ * @author  prisma.ai
+ *
+ *  A gesture is cleared from the ADV payload after COUNTER_EXPIRY_MS,
+ * heard or not. The log keeps a record of it across resets.
+ *   Records are staged in a RAM copy of the next row and written a whole
+ * row at a time: a row write is an erase + program that keeps the CPU busy
+ * for ~20 ms, so it is done as rarely as the commit policy allows.
+ *   A row is never rewritten in place. A commit always goes to the row
+ * after the newest one (round-robin, so every row wears the same), and a
+ * partly filled row is carried into the next one with the new records.
+ * Power lost during a write can only tear that next row, the oldest one:
+ * its CRC won't match on boot, and the newest good row is still there.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include "event_log.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define EVENT_LOG_CRC_OFFSET        (CY_FLASH_SIZEOF_ROW - 4u)
+
+/* Row index (0 to EVENT_LOG_ROWS - 1) to its address, the flash is mapped */
+#define EVENT_LOG_ROW(index)        ((const uint8 *)(CY_FLASH_BASE + \
+                                        (EVENT_LOG_FIRST_ROW + (uint32)(index)) * CY_FLASH_SIZEOF_ROW))
+
+/*  CRC-32 (IEEE 802.3, reflected), one nibble at a time. 32 bits because
+ * a torn row mostly ends in erased bytes: a stored CRC of 0 would match one
+ * torn row in 65536 with a 16 bit CRC */
+static const uint32 event_log_crc_table[16] =
+{
+    0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+    0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+};
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE EVENT_LOG_STATS_T event_log_stats;
+
+static FW_STATE uint8  log_stage[CY_FLASH_SIZEOF_ROW];  // The next row, header set on commit
+static FW_STATE uint8  log_staged = 0;       // Records in log_stage
+static FW_STATE uint8  log_committed = 0;    // Of those, the ones already in flash
+static FW_STATE uint8  log_alert = 0;        // An uncommitted EVENT_LOG_ALERT is staged
+static FW_STATE uint32 log_first = 0;        // Number of the first record in log_stage
+static FW_STATE uint32 log_since = 0;        // Uptime of the oldest uncommitted record
+static FW_STATE uint32 log_row_seq = 0;      // Sequence number of the next row
+static FW_STATE uint8  log_next_row = 0;     // Where it goes
+static FW_STATE uint16 log_boot = 0;
+static FW_STATE uint8  log_reserve = 0;      // A new boot number was asked for, not staged yet
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint16 EventLogGet16(const uint8 *data)
+{
+    return (uint16)((uint16)data[0] | ((uint16)data[1] << 8));
+}
+
+static uint32 EventLogGet32(const uint8 *data)
+{
+    return (uint32)data[0] | ((uint32)data[1] << 8) |
+           ((uint32)data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+static void EventLogPut16(uint8 *data, uint16 value)
+{
+    data[0] = (uint8)(value & 0xFFu);
+    data[1] = (uint8)(value >> 8);
+}
+
+static void EventLogPut32(uint8 *data, uint32 value)
+{
+    data[0] = (uint8)(value & 0xFFu);
+    data[1] = (uint8)((value >> 8) & 0xFFu);
+    data[2] = (uint8)((value >> 16) & 0xFFu);
+    data[3] = (uint8)(value >> 24);
+}
+
+static uint32 EventLogCrc(const uint8 *data, uint8 length)
+{
+    uint32 crc = 0xFFFFFFFFu;
+
+    while(length-- > 0u)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ event_log_crc_table[crc & 0x0Fu];
+        crc = (crc >> 4) ^ event_log_crc_table[crc & 0x0Fu];
+    }
+    return ~crc;
+}
+
+/*******************************************************************************
+* @brief This function checks a row: header, record count and CRC.
+*
+* @param const uint8* row:          The row, in flash
+*
+* @returns uint8:                   1 if it holds records
+*******************************************************************************/
+static uint8 EventLogRowValid(const uint8 *row)
+{
+    return (EventLogGet16(row) == EVENT_LOG_MAGIC &&
+            row[11] == EVENT_LOG_VERSION &&
+            row[10] >= 1u && row[10] <= EVENT_LOG_RECORDS_PER_ROW &&
+            EventLogGet32(&row[EVENT_LOG_CRC_OFFSET]) == EventLogCrc(row, EVENT_LOG_CRC_OFFSET));
+}
+
+/*******************************************************************************
+* @brief This function tells an erased row (all 0) from a torn one.
+*
+* @param const uint8* row:          The row, in flash
+*
+* @returns uint8:                   1 if erased
+*******************************************************************************/
+static uint8 EventLogRowErased(const uint8 *row)
+{
+    uint8 i;
+
+    for(i = 0; i < CY_FLASH_SIZEOF_ROW; ++i)
+    {
+        if(row[i] != 0u)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*******************************************************************************
+* @brief This routine writes the stage to the next row. A full stage is
+*       emptied, a partial one is kept to be carried into the next row.
+*
+*   On a write error the records stay staged and the row is skipped, the
+* next try (EVENT_LOG_COMMIT_S later) goes to the one after it.
+*
+* @param uint32 seconds:            Uptime
+*
+* @returns None
+*******************************************************************************/
+static void EventLogCommit(uint32 seconds)
+{
+    uint8 row = log_next_row;
+
+    EventLogPut16(&log_stage[0], EVENT_LOG_MAGIC);
+    EventLogPut32(&log_stage[2], log_row_seq);
+    EventLogPut32(&log_stage[6], log_first);
+    log_stage[10] = log_staged;
+    log_stage[11] = EVENT_LOG_VERSION;
+    EventLogPut32(&log_stage[EVENT_LOG_CRC_OFFSET], EventLogCrc(log_stage, EVENT_LOG_CRC_OFFSET));
+
+    log_next_row = (uint8)((log_next_row + 1u) % EVENT_LOG_ROWS);
+    ++log_row_seq;
+
+    if(CySysFlashWriteRow(EVENT_LOG_FIRST_ROW + row, log_stage) != CY_SYS_FLASH_SUCCESS)
+    {
+        ++event_log_stats.writeErrors;
+        log_alert = 0;
+        log_since = seconds;
+        return;
+    }
+    ++event_log_stats.commits;
+    log_committed = log_staged;
+    log_alert = 0;
+
+    if(log_staged == EVENT_LOG_RECORDS_PER_ROW)
+    {
+        log_first += log_staged;
+        log_staged = 0;
+        log_committed = 0;
+        memset(log_stage, 0, sizeof(log_stage));
+    }
+}
+
+/*******************************************************************************
+* @brief This routine recovers the log from the flash and appends a
+*       EVENT_LOG_BOOT record. Called once, before the main loop.
+*
+*   The newest row with a good CRC is the end of the log. If it isn't full
+* its records are staged again and carried into the next row.
+*
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+*
+* @returns None
+*******************************************************************************/
+void EventLogStart(uint32 seconds)
+{
+    const uint8 *newest = NULL;
+    uint32 newest_seq = 0;
+    uint8 i;
+
+    memset(&event_log_stats, 0, sizeof(event_log_stats));
+    memset(log_stage, 0, sizeof(log_stage));
+    log_staged = 0;
+    log_committed = 0;
+    log_alert = 0;
+    log_first = 0;
+    log_row_seq = 0;
+    log_next_row = 0;
+    log_boot = 0;
+    log_reserve = 0;
+
+    for(i = 0; i < EVENT_LOG_ROWS; ++i)
+    {
+        const uint8 *row = EVENT_LOG_ROW(i);
+        uint32 seq;
+
+        if(!EventLogRowValid(row))
+        {
+            if(!EventLogRowErased(row))
+            {
+                ++event_log_stats.badRows;
+            }
+            continue;
+        }
+        seq = EventLogGet32(&row[2]);
+        if(newest == NULL || (int32)(seq - newest_seq) > 0)
+        {
+            newest = row;
+            newest_seq = seq;
+            log_next_row = (uint8)((i + 1u) % EVENT_LOG_ROWS);
+        }
+    }
+
+    if(newest != NULL)
+    {
+        uint8 count = newest[10];
+        const uint8 *last = &newest[EVENT_LOG_HEADER_LEN + (count - 1u) * EVENT_LOG_RECORD_LEN];
+
+        log_row_seq = newest_seq + 1u;
+        log_first = EventLogGet32(&newest[6]);
+        log_boot = (uint16)(EventLogGet16(&last[2]) + 1u);
+
+        if(count < EVENT_LOG_RECORDS_PER_ROW)
+        {
+            memcpy(log_stage, newest, CY_FLASH_SIZEOF_ROW);
+            log_staged = count;
+            log_committed = count;
+        }
+        else
+        {
+            log_first += count;
+        }
+    }
+
+    EventLogAppend(EVENT_LOG_BOOT, 0, seconds);
+}
+
+/*******************************************************************************
+* @brief This routine stages one record in RAM.
+*
+* @param uint8 type:                EVENT_LOG_BOOT / _GESTURE / _ALERT
+* @param uint8 code:                Gesture code
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+*
+* @returns None
+*******************************************************************************/
+void EventLogAppend(uint8 type, uint8 code, uint32 seconds)
+{
+    uint8 *record;
+
+    if(log_staged == EVENT_LOG_RECORDS_PER_ROW)
+    {
+        /* Full and not written yet (the radio was busy), write it now */
+        EventLogCommit(seconds);
+        if(log_staged == EVENT_LOG_RECORDS_PER_ROW)
+        {
+            ++event_log_stats.dropped;
+            return;
+        }
+    }
+
+    if(log_committed == log_staged)
+    {
+        log_since = seconds;
+    }
+
+    record = &log_stage[EVENT_LOG_HEADER_LEN + log_staged * EVENT_LOG_RECORD_LEN];
+    record[0] = type;
+    record[1] = code;
+    EventLogPut16(&record[2], log_boot);
+    EventLogPut32(&record[4], seconds);
+
+    ++log_staged;
+    ++event_log_stats.records;
+    if(type == EVENT_LOG_ALERT)
+    {
+        log_alert = 1;
+    }
+}
+
+/*******************************************************************************
+* @brief This routine writes the staged records to the next row when the
+*       commit policy says so (see EVENT_LOG_COMMIT_S).
+*
+* NOTE: The CPU is held for a whole row write (erase + program), so call it
+*   right after a radio event, when BLESS is in EVENT_CLOSE.
+*
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+* @param uint8 quiet:               0 while the radio is busy (ie: an alert
+*                                  burst), only a full row is written then
+*
+* @returns None
+*******************************************************************************/
+void EventLogService(uint32 seconds, uint8 quiet)
+{
+    if(log_committed == log_staged)
+    {
+        return;
+    }
+    if(log_staged == EVENT_LOG_RECORDS_PER_ROW ||
+       (quiet && (log_alert || (uint32)(seconds - log_since) >= EVENT_LOG_COMMIT_S)))
+    {
+        EventLogCommit(seconds);
+    }
+}
+
+/*******************************************************************************
+* @brief This function gets the boot number into flash: the staged records
+*       are written right away if they aren't. With next set, a new number
+*       is taken first, with an EVENT_LOG_RESERVE record.
+*
+*   A new number asked for is remembered until its record is staged (a
+* full stage that can't be written has no room for it), later calls take
+* it even with next clear.
+*
+* NOTE: The CPU is held for a row write. On a write error the records stay
+*   staged and 0 is returned: after a reset EventLogStart only knows the
+*   numbers in flash and may hand the same one out again.
+*
+* @param uint8 next:                1 to take a new number
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+* @param uint16* boot:              Set to the boot number
+*
+* @returns uint8:                   1 if *boot is in flash, 0 otherwise
+*******************************************************************************/
+uint8 EventLogReserve(uint8 next, uint32 seconds, uint16 *boot)
+{
+    if(next)
+    {
+        log_reserve = 1;
+    }
+    if(log_reserve)
+    {
+        if(log_staged == EVENT_LOG_RECORDS_PER_ROW)
+        {
+            EventLogCommit(seconds);
+        }
+        if(log_staged < EVENT_LOG_RECORDS_PER_ROW)
+        {
+            ++log_boot;
+            EventLogAppend(EVENT_LOG_RESERVE, 0, seconds);
+            log_reserve = 0;
+        }
+    }
+    if(!log_reserve && log_committed != log_staged)
+    {
+        EventLogCommit(seconds);
+    }
+    *boot = log_boot;
+    return (!log_reserve && log_committed == log_staged) ? 1u : 0u;
+}
+
+/*******************************************************************************
+* @brief This function returns the number of the oldest record still in
+*       the log.
+*
+* @param None
+*
+* @returns uint32:                  Record number
+*******************************************************************************/
+uint32 EventLogOldest(void)
+{
+    uint32 oldest = log_first;
+    uint8 i;
+
+    for(i = 0; i < EVENT_LOG_ROWS; ++i)
+    {
+        const uint8 *row = EVENT_LOG_ROW(i);
+
+        if(EventLogRowValid(row) && (int32)(EventLogGet32(&row[6]) - oldest) < 0)
+        {
+            oldest = EventLogGet32(&row[6]);
+        }
+    }
+    return oldest;
+}
+
+/*******************************************************************************
+* @brief This function returns the number the next record will get.
+*
+* @param uint8 committed:           1 to count only the records in flash
+*
+* @returns uint32:                  Record number
+*******************************************************************************/
+uint32 EventLogEnd(uint8 committed)
+{
+    return log_first + (committed ? log_committed : log_staged);
+}
+
+/*******************************************************************************
+* @brief This function finds a record, in the stage or in the flash.
+*
+* @param uint32 number:             Record number
+* @param uint8* run:                Set to how many records from this one on
+*                                  are stored next to each other
+*
+* @returns const uint8*:            The record, NULL if it isn't in the log
+*******************************************************************************/
+static const uint8 *EventLogFind(uint32 number, uint8 *run)
+{
+    uint8 i;
+
+    if((uint32)(number - log_first) < log_staged)
+    {
+        *run = (uint8)(log_staged - (number - log_first));
+        return &log_stage[EVENT_LOG_HEADER_LEN + (number - log_first) * EVENT_LOG_RECORD_LEN];
+    }
+    for(i = 0; i < EVENT_LOG_ROWS; ++i)
+    {
+        const uint8 *row = EVENT_LOG_ROW(i);
+        uint32 offset = number - EventLogGet32(&row[6]);
+
+        /* Only the row that has it pays for the CRC */
+        if(offset < row[10] && EventLogRowValid(row))
+        {
+            *run = (uint8)(row[10] - offset);
+            return &row[EVENT_LOG_HEADER_LEN + offset * EVENT_LOG_RECORD_LEN];
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* @brief This function reads one record, from the stage or the flash.
+*
+* @param uint32 number:             Record number, EventLogOldest() to
+*                                  EventLogEnd(0) - 1
+* @param EVENT_LOG_RECORD_T* record: Where to put it
+*
+* @returns uint8:                   1 if found
+*******************************************************************************/
+uint8 EventLogRead(uint32 number, EVENT_LOG_RECORD_T *record)
+{
+    uint8 run;
+    const uint8 *data = EventLogFind(number, &run);
+
+    if(data == NULL)
+    {
+        return 0;
+    }
+
+    record->type = data[0];
+    record->code = data[1];
+    record->boot = EventLogGet16(&data[2]);
+    record->seconds = EventLogGet32(&data[4]);
+    return 1;
+}
+
+/*******************************************************************************
+* @brief This function copies consecutive records, as stored (see the
+*       record layout in event_log.h).
+*
+* @param uint32 number:             Number of the first record
+* @param uint8* data:               Where to put them, max records long
+* @param uint8 max:                 How many records at most
+*
+* @returns uint8:                   Records copied, less than max at the end
+*                                  of the log
+*******************************************************************************/
+uint8 EventLogCopy(uint32 number, uint8 *data, uint8 max)
+{
+    uint8 count = 0;
+    uint8 run;
+
+    while(count < max)
+    {
+        const uint8 *record = EventLogFind(number + count, &run);
+
+        if(record == NULL)
+        {
+            break;
+        }
+        if(run > max - count)
+        {
+            run = (uint8)(max - count);
+        }
+        memcpy(&data[count * EVENT_LOG_RECORD_LEN], record, (uint32)run * EVENT_LOG_RECORD_LEN);
+        count += run;
+    }
+    return count;
+}
+
+/*******************************************************************************
+* @brief This function returns the log counters.
+*
+* @param None
+*
+* @returns const EVENT_LOG_STATS_T*: Records / commits / errors
+*******************************************************************************/
+const EVENT_LOG_STATS_T *GetEventLogStats(void)
+{
+    return &event_log_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,206 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    event_log.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for event_log.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef EVENT_LOG_HEADER
+#define EVENT_LOG_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*
+*   The log takes the last EVENT_LOG_ROWS rows of the flash, which have to
+* be kept out of the application image (linker script). They are written
+* round-robin, a whole row at a time.
+*******************************************************************************/
+/* Set to 0 to build without the log */
+#ifndef EVENT_LOG
+#define EVENT_LOG                   (1u)
+#endif
+
+#ifndef EVENT_LOG_ROWS
+#define EVENT_LOG_ROWS              (16u)   // 2 KB, 224 records
+#endif
+#define EVENT_LOG_FIRST_ROW         (CY_FLASH_NUMBER_ROWS - EVENT_LOG_ROWS)
+
+/*  Staged records are committed once a row is full, once they are this old,
+ * or right away (when the radio is quiet) if one of them is an alert */
+#define EVENT_LOG_COMMIT_S          (600u)
+
+/*  Row layout, multi-byte values are little endian:
+ *      [0-1]       EVENT_LOG_MAGIC
+ *      [2-5]       Row sequence number, +1 on every row written
+ *      [6-9]       Number of the first record in the row
+ *      [10]        Records in the row (1 to EVENT_LOG_RECORDS_PER_ROW)
+ *      [11]        EVENT_LOG_VERSION
+ *      [12-123]    Records, EVENT_LOG_RECORD_LEN bytes each
+ *      [124-127]   CRC-32 of bytes 0 to 123
+ *   Record:
+ *      [0]         Type (EVENT_LOG_BOOT, ...)
+ *      [1]         Gesture code
+ *      [2-3]       Boot number, +1 on every EVENT_LOG_BOOT / _RESERVE
+ *      [4-7]       Seconds since that boot                                 */
+#define EVENT_LOG_MAGIC             (0x4C45u)   // "EL"
+#define EVENT_LOG_VERSION           (0x01u)
+#define EVENT_LOG_HEADER_LEN        (12u)
+#define EVENT_LOG_RECORD_LEN        (8u)
+#define EVENT_LOG_RECORDS_PER_ROW   ((CY_FLASH_SIZEOF_ROW - EVENT_LOG_HEADER_LEN - 4u) / \
+                                     EVENT_LOG_RECORD_LEN)
+
+/* Record types */
+#define EVENT_LOG_BOOT              (0x01u) // Power on / reset
+#define EVENT_LOG_GESTURE           (0x02u) // A gesture went on air
+#define EVENT_LOG_ALERT             (0x03u) // A High Danger gesture went on air
+#define EVENT_LOG_RESERVE           (0x04u) // A new boot number without a reset
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint8  type;
+    uint8  code;
+    uint16 boot;
+    uint32 seconds;
+} EVENT_LOG_RECORD_T;
+
+typedef struct
+{
+    uint32 records;         // Appended since boot
+    uint32 commits;         // Rows written
+    uint32 writeErrors;     // CySysFlashWriteRow failures, retried later
+    uint32 dropped;         // Records lost to a full stage that couldn't be written
+    uint32 badRows;         // Rows with a bad CRC found on boot (torn writes)
+} EVENT_LOG_STATS_T;
+
+/*******************************************************************************
+* @brief This routine recovers the log from the flash and appends a
+*       EVENT_LOG_BOOT record. Called once, before the main loop.
+*
+*   The newest row with a good CRC is the end of the log. If it isn't full
+* its records are staged again and carried into the next row.
+*
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+*
+* @returns None
+*******************************************************************************/
+void EventLogStart(uint32 seconds);
+
+/*******************************************************************************
+* @brief This routine stages one record in RAM.
+*
+* @param uint8 type:                EVENT_LOG_BOOT / _GESTURE / _ALERT
+* @param uint8 code:                Gesture code
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+*
+* @returns None
+*******************************************************************************/
+void EventLogAppend(uint8 type, uint8 code, uint32 seconds);
+
+/*******************************************************************************
+* @brief This routine writes the staged records to the next row when the
+*       commit policy says so (see EVENT_LOG_COMMIT_S).
+*
+* NOTE: The CPU is held for a whole row write (erase + program), so call it
+*   right after a radio event, when BLESS is in EVENT_CLOSE.
+*
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+* @param uint8 quiet:               0 while the radio is busy (ie: an alert
+*                                  burst), only a full row is written then
+*
+* @returns None
+*******************************************************************************/
+void EventLogService(uint32 seconds, uint8 quiet);
+
+/*******************************************************************************
+* @brief This function gets the boot number into flash: the staged records
+*       are written right away if they aren't. With next set, a new number
+*       is taken first, with an EVENT_LOG_RESERVE record.
+*
+*   Boot numbers don't repeat (until they wrap at 65536), adv_auth.c takes
+* a block of ADV counters for each. A new number asked for is remembered
+* until its record is staged, later calls take it even with next clear.
+*
+* NOTE: The CPU is held for a row write. On a write error the records stay
+*   staged and 0 is returned: after a reset EventLogStart only knows the
+*   numbers in flash and may hand the same one out again.
+*
+* @param uint8 next:                1 to take a new number
+* @param uint32 seconds:            Uptime (LowPowerTimerSeconds)
+* @param uint16* boot:              Set to the boot number
+*
+* @returns uint8:                   1 if *boot is in flash, 0 otherwise
+*******************************************************************************/
+uint8 EventLogReserve(uint8 next, uint32 seconds, uint16 *boot);
+
+/*******************************************************************************
+* @brief This function returns the number of the oldest record still in
+*       the log.
+*
+* @param None
+*
+* @returns uint32:                  Record number
+*******************************************************************************/
+uint32 EventLogOldest(void);
+
+/*******************************************************************************
+* @brief This function returns the number the next record will get.
+*
+* @param uint8 committed:           1 to count only the records in flash
+*
+* @returns uint32:                  Record number
+*******************************************************************************/
+uint32 EventLogEnd(uint8 committed);
+
+/*******************************************************************************
+* @brief This function reads one record, from the stage or the flash.
+*
+* @param uint32 number:             Record number, EventLogOldest() to
+*                                  EventLogEnd(0) - 1
+* @param EVENT_LOG_RECORD_T* record: Where to put it
+*
+* @returns uint8:                   1 if found
+*******************************************************************************/
+uint8 EventLogRead(uint32 number, EVENT_LOG_RECORD_T *record);
+
+/*******************************************************************************
+* @brief This function copies consecutive records, as stored (see the
+*       record layout above). Used to send the log in bulk.
+*
+* @param uint32 number:             Number of the first record
+* @param uint8* data:               Where to put them, max records long
+* @param uint8 max:                 How many records at most
+*
+* @returns uint8:                   Records copied, less than max at the end
+*                                  of the log
+*******************************************************************************/
+uint8 EventLogCopy(uint32 number, uint8 *data, uint8 max);
+
+/*******************************************************************************
+* @brief This function returns the log counters.
+*
+* @param None
+*
+* @returns const EVENT_LOG_STATS_T*: Records / commits / errors
+*******************************************************************************/
+const EVENT_LOG_STATS_T *GetEventLogStats(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,218 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    event_trace.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Binary trace of the inputs and payloads, for replay on the host
+ * @author  prisma.ai
+ *
+ *  Built with EVENT_TRACE = 1 only. The firmware appends a fixed size
+ * record for what it gets from the outside and for what it decides:
+ *      - every button interrupt, with the mask that fired and the buttons
+ *        held, and the held buttons at each debounce / long press check
+ *      - the stack state, when DynamicADVPayloadUpdate or EnterLowPowerMode
+ *        see it change (the BLESS state changes every radio event, it only
+ *        goes along as context)
+ *      - every new gesture code put in the payload, with its sequence number
+ *  Records go to a ring in RAM, stamped with the LFCLK time base, and the
+ * newest ones are copied to the Trace Data characteristic when a client
+ * connects. host/sim/tracereplay.c rebuilds the presses from a trace, runs
+ * the firmware on them and compares the payloads it puts out.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "event_trace.h"
+#include "lp_timer.h"
+
+/*******************************************************************************
+* Compile time checks: the ring index wraps with a mask
+*******************************************************************************/
+typedef char event_trace_ring_check[((EVENT_TRACE_RECORDS & (EVENT_TRACE_RECORDS - 1u)) == 0u) ? 1 : -1];
+
+#if (EVENT_TRACE)
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+typedef struct
+{
+    uint32 time;
+    uint8  kind;
+    uint8  args[3];
+} EVENT_TRACE_RECORD_T;
+
+static FW_STATE EVENT_TRACE_RECORD_T trace_ring[EVENT_TRACE_RECORDS];
+static FW_STATE EVENT_TRACE_STATS_T trace_stats = {0, 0};
+static FW_STATE uint8 trace_ble_state = 0xFF;   // Last one recorded, none yet
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine appends a little endian value to a buffer.
+*
+* @param uint8 **out:               Where to write, moved past the value
+* @param uint32 value:              The value
+* @param uint8 bytes:               Its size
+*
+* @returns None
+*******************************************************************************/
+static void EventTracePut(uint8 **out, uint32 value, uint8 bytes)
+{
+    while(bytes-- > 0u)
+    {
+        *(*out)++ = (uint8)value;
+        value >>= 8;
+    }
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine appends a record to the trace.
+*
+* @param uint8 kind:                What happened (ie: EVENT_TRACE_PAYLOAD)
+* @param uint8 a, b, c:             Kind specific (see EVENT_TRACE_x)
+*
+* @returns None
+*******************************************************************************/
+void EventTraceRecord(uint8 kind, uint8 a, uint8 b, uint8 c)
+{
+    /* The interrupts record too */
+    uint8 intrStatus = CyEnterCriticalSection();
+    EVENT_TRACE_RECORD_T *record = &trace_ring[trace_stats.records & (EVENT_TRACE_RECORDS - 1u)];
+
+    record->time = LowPowerTimerNow();
+    record->kind = kind;
+    record->args[0] = a;
+    record->args[1] = b;
+    record->args[2] = c;
+    if(trace_stats.records >= EVENT_TRACE_RECORDS)
+    {
+        ++trace_stats.dropped;
+    }
+    ++trace_stats.records;
+
+    CyExitCriticalSection(intrStatus);
+}
+
+/*******************************************************************************
+* @brief This routine appends an EVENT_TRACE_BLE_STATE record if the stack
+*       state changed since the last one.
+*
+* @param uint8 site:                Who looked (ie: EVENT_TRACE_AT_LOW_POWER)
+* @param uint8 bless:               CyBle_GetBleSsState() it was seen with
+*
+* @returns None
+*******************************************************************************/
+void EventTraceStack(uint8 site, uint8 bless)
+{
+    uint8 state = (uint8)CyBle_GetState();
+
+    if(state != trace_ble_state)
+    {
+        trace_ble_state = state;
+        EventTraceRecord(EVENT_TRACE_BLE_STATE, state, bless, site);
+    }
+}
+
+/*******************************************************************************
+* @brief This routine copies the newest records to the Data characteristic,
+*       in the trace format. Called when a client connects.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void EventTracePublish(void)
+{
+    static FW_STATE uint8 data[EVENT_TRACE_HEADER_LEN +
+                               EVENT_TRACE_PUBLISH_RECORDS * EVENT_TRACE_RECORD_LEN];
+    CYBLE_GATT_HANDLE_VALUE_PAIR_T pair;
+
+    pair.attrHandle = CYBLE_EVENT_TRACE_DATA_CHAR_HANDLE;
+    pair.value.val = data;
+    pair.value.len = (uint16)EventTraceSerialize(data, EVENT_TRACE_PUBLISH_RECORDS);
+    CyBle_GattsWriteAttributeValue(&pair, 0u, NULL, CYBLE_GATT_DB_LOCALLY_INITIATED);
+}
+#endif
+
+/*******************************************************************************
+* @brief This function writes the trace, header first, with the newest
+*       records up to a count.
+*
+* @param uint8* out:                Where to write, room for the header and
+*                                  maxRecords records
+* @param uint32 maxRecords:         Most records to write
+*
+* @returns uint32:                  Bytes written, 0 without EVENT_TRACE
+*******************************************************************************/
+uint32 EventTraceSerialize(uint8 *out, uint32 maxRecords)
+{
+#if (EVENT_TRACE)
+    uint8 *start = out;
+    uint32 count = trace_stats.records;
+    uint32 i;
+
+    if(count > EVENT_TRACE_RECORDS)
+    {
+        count = EVENT_TRACE_RECORDS;
+    }
+    if(count > maxRecords)
+    {
+        count = maxRecords;
+    }
+
+    for(i = 0; i < 4u; ++i)
+    {
+        *out++ = (uint8)EVENT_TRACE_MAGIC[i];
+    }
+    EventTracePut(&out, EVENT_TRACE_VERSION, 1u);
+    EventTracePut(&out, EVENT_TRACE_RECORD_LEN, 1u);
+    EventTracePut(&out, count, 2u);
+    EventTracePut(&out, trace_stats.records - count, 4u);
+    EventTracePut(&out, LowPowerTimerNow(), 4u);
+
+    for(i = trace_stats.records - count; i != trace_stats.records; ++i)
+    {
+        const EVENT_TRACE_RECORD_T *record = &trace_ring[i & (EVENT_TRACE_RECORDS - 1u)];
+
+        EventTracePut(&out, record->time, 4u);
+        EventTracePut(&out, record->kind, 1u);
+        EventTracePut(&out, record->args[0], 1u);
+        EventTracePut(&out, record->args[1], 1u);
+        EventTracePut(&out, record->args[2], 1u);
+    }
+    return (uint32)(out - start);
+#else
+    (void)out;
+    (void)maxRecords;
+    return 0;
+#endif
+}
+
+/*******************************************************************************
+* @brief This function returns the trace counters.
+*
+* @param None
+*
+* @returns const EVENT_TRACE_STATS_T*:  Recorded / dropped, NULL without
+*                                      EVENT_TRACE
+*******************************************************************************/
+const EVENT_TRACE_STATS_T *GetEventTraceStats(void)
+{
+#if (EVENT_TRACE)
+    return &trace_stats;
+#else
+    return NULL;
+#endif
+}
+
+/* [] END OF FILE */
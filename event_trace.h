@@ -0,0 +1,149 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    event_trace.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for event_trace.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef EVENT_TRACE_HEADER
+#define EVENT_TRACE_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Set to 1 to record the trace, with 0 the macros below compile to nothing */
+#ifndef EVENT_TRACE
+#define EVENT_TRACE                 (0u)
+#endif
+
+/* Records kept in RAM, the oldest are overwritten (a power of 2) */
+#ifndef EVENT_TRACE_RECORDS
+#define EVENT_TRACE_RECORDS         (64u)
+#endif
+
+/*  Trace format, multi-byte values are little endian. A header:
+ *      [0-3]   EVENT_TRACE_MAGIC
+ *      [4]     EVENT_TRACE_VERSION
+ *      [5]     EVENT_TRACE_RECORD_LEN
+ *      [6-7]   Records that follow, oldest first
+ *      [8-11]  Records dropped before them
+ *      [12-15] LowPowerTimerNow() when it was taken, the end of the trace
+ *  then the records:
+ *      [0-3]   LowPowerTimerNow(), LFCLK ticks since boot
+ *      [4]     EVENT_TRACE_x kind
+ *      [5-7]   Kind specific, see below                                    */
+#define EVENT_TRACE_MAGIC           "SSBT"
+#define EVENT_TRACE_VERSION         (0x01u)
+#define EVENT_TRACE_HEADER_LEN      (16u)
+#define EVENT_TRACE_RECORD_LEN      (8u)
+
+/* Record kinds, and what is in [5] [6] [7] */
+#define EVENT_TRACE_BUTTON_IRQ      (1u)    // Fired mask, held mask, 0
+#define EVENT_TRACE_BUTTON_LEVEL    (2u)    // 0, held mask, 0 (debounce / long press check)
+#define EVENT_TRACE_BLE_STATE       (3u)    // CyBle_GetState(), CyBle_GetBleSsState(), site
+#define EVENT_TRACE_PAYLOAD         (4u)    // Gesture code, sequence number, 0
+
+/* Sites of EVENT_TRACE_BLE_STATE */
+#define EVENT_TRACE_AT_ADV_UPDATE   (0u)    // DynamicADVPayloadUpdate
+#define EVENT_TRACE_AT_LOW_POWER    (1u)    // EnterLowPowerMode
+
+/* Newest records in the Data characteristic, it holds 512 bytes at most */
+#define EVENT_TRACE_PUBLISH_RECORDS ((512u - EVENT_TRACE_HEADER_LEN) / EVENT_TRACE_RECORD_LEN)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 records;         // Recorded since boot
+    uint32 dropped;         // Overwritten by newer ones
+} EVENT_TRACE_STATS_T;
+
+/*******************************************************************************
+* Macros
+*
+*   EVENT_TRACE_RECORD(kind, a, b, c) appends a record, from the main loop or
+* an interrupt. EVENT_TRACE_STACK(site, bless) appends one when the
+* stack state changed since the last one, with the BLESS state it was seen
+* with. The arguments are not evaluated without EVENT_TRACE.
+*******************************************************************************/
+#if (EVENT_TRACE)
+#define EVENT_TRACE_RECORD(kind, a, b, c)   EventTraceRecord((kind), (a), (b), (c))
+#define EVENT_TRACE_STACK(site, bless)      EventTraceStack((site), (bless))
+#else
+#define EVENT_TRACE_RECORD(kind, a, b, c)
+#define EVENT_TRACE_STACK(site, bless)
+#endif
+
+#if (EVENT_TRACE)
+/*******************************************************************************
+* @brief This routine appends a record to the trace.
+*
+* @param uint8 kind:                What happened (ie: EVENT_TRACE_PAYLOAD)
+* @param uint8 a, b, c:             Kind specific (see EVENT_TRACE_x)
+*
+* @returns None
+*******************************************************************************/
+void EventTraceRecord(uint8 kind, uint8 a, uint8 b, uint8 c);
+
+/*******************************************************************************
+* @brief This routine appends an EVENT_TRACE_BLE_STATE record if the stack
+*       state changed since the last one.
+*
+* @param uint8 site:                Who looked (ie: EVENT_TRACE_AT_LOW_POWER)
+* @param uint8 bless:               CyBle_GetBleSsState() it was seen with
+*
+* @returns None
+*******************************************************************************/
+void EventTraceStack(uint8 site, uint8 bless);
+
+/*******************************************************************************
+* @brief This routine copies the newest records to the Data characteristic,
+*       in the trace format. Called when a client connects.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void EventTracePublish(void);
+#endif
+
+/*******************************************************************************
+* @brief This function writes the trace, header first, with the newest
+*       records up to a count.
+*
+* @param uint8* out:                Where to write, room for the header and
+*                                  maxRecords records
+* @param uint32 maxRecords:         Most records to write
+*
+* @returns uint32:                  Bytes written, 0 without EVENT_TRACE
+*******************************************************************************/
+uint32 EventTraceSerialize(uint8 *out, uint32 maxRecords);
+
+/*******************************************************************************
+* @brief This function returns the trace counters.
+*
+* @param None
+*
+* @returns const EVENT_TRACE_STATS_T*:  Recorded / dropped, NULL without
+*                                      EVENT_TRACE
+*******************************************************************************/
+const EVENT_TRACE_STATS_T *GetEventTraceStats(void);
+
+#endif
+
+/* [] END OF FILE */
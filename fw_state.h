@@ -0,0 +1,30 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    fw_state.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Marker of the firmware state variables
+ * @author  prisma.ai
+ *
+ *  Every variable holding firmware state (file scope or static) is declared
+ * with FW_STATE. On the band it is empty. The host fleet simulator builds
+ * with -DFW_STATE=__thread and runs each virtual band on its own thread,
+ * so every band gets its own copy of the state.
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef FW_STATE_HEADER
+#define FW_STATE_HEADER
+
+#ifndef FW_STATE
+#define FW_STATE
+#endif
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,187 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    gesture.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Table driven recognition of press patterns
+ * @author  prisma.ai
+ *
+ *  What each press pattern means lives in gesture_table (next state for
+ * every state / event) and gesture_code (what each state broadcasts). Both
+ * are const, so they stay in flash; the engine itself only needs the
+ * current state and the time of the last event in RAM, and every event is
+ * a single table lookup. New semantics = new tables.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "gesture.h"
+#include "button_func.h"
+#include "lp_timer.h"
+
+/*******************************************************************************
+* States
+*******************************************************************************/
+enum
+{
+    GS_IDLE = 0,
+    GS_BOTH_1, GS_BOTH_2, GS_BOTH_3, GS_BOTH_4, GS_BOTH_5,
+    GS_BOTH_6, GS_BOTH_7, GS_BOTH_8, GS_BOTH_9, GS_BOTH_10,
+    GS_RIGHT_1, GS_RIGHT_2, GS_RIGHT_3, GS_RIGHT_4,
+    GS_PAIRING,
+    GS_LONG_ALERT,
+    GESTURE_STATE_COUNT
+};
+
+/* Compile time checks: the tables below are written for these values */
+typedef char gesture_both_check[
+    (GS_BOTH_10 - GS_IDLE == MAX_AVAILABLE_PRESSES) ? 1 : -1];
+typedef char gesture_pairing_check[
+    (GS_PAIRING - GS_RIGHT_1 == PAIRING_MODE_PRESS_NO - 1) ? 1 : -1];
+
+/*******************************************************************************
+* Transition table: gesture_table[state][event] = next state
+*
+*   Both buttons count up to MAX_AVAILABLE_PRESSES. PAIRING_MODE_PRESS_NO
+* right presses, each within GESTURE_WINDOW_MS of the previous one, enter
+* pairing mode. Holding both buttons is an alert straight away. The left
+* button has no action yet.
+*******************************************************************************/
+#define GS_ROW(both, right, left, longPress, timeout) \
+    { (both), (right), (left), (longPress), (timeout) }
+
+static const uint8 gesture_table[GESTURE_STATE_COUNT][GESTURE_EVENT_COUNT] =
+{
+    /*                 BOTH        RIGHT        LEFT           LONG           TIMEOUT */
+    [GS_IDLE]    = GS_ROW(GS_BOTH_1,  GS_RIGHT_1,  GS_IDLE,       GS_LONG_ALERT, GS_IDLE),
+    [GS_BOTH_1]  = GS_ROW(GS_BOTH_2,  GS_BOTH_1,   GS_BOTH_1,     GS_LONG_ALERT, GS_BOTH_1),
+    [GS_BOTH_2]  = GS_ROW(GS_BOTH_3,  GS_BOTH_2,   GS_BOTH_2,     GS_LONG_ALERT, GS_BOTH_2),
+    [GS_BOTH_3]  = GS_ROW(GS_BOTH_4,  GS_BOTH_3,   GS_BOTH_3,     GS_LONG_ALERT, GS_BOTH_3),
+    [GS_BOTH_4]  = GS_ROW(GS_BOTH_5,  GS_BOTH_4,   GS_BOTH_4,     GS_BOTH_4,     GS_BOTH_4),
+    [GS_BOTH_5]  = GS_ROW(GS_BOTH_6,  GS_BOTH_5,   GS_BOTH_5,     GS_BOTH_5,     GS_BOTH_5),
+    [GS_BOTH_6]  = GS_ROW(GS_BOTH_7,  GS_BOTH_6,   GS_BOTH_6,     GS_BOTH_6,     GS_BOTH_6),
+    [GS_BOTH_7]  = GS_ROW(GS_BOTH_8,  GS_BOTH_7,   GS_BOTH_7,     GS_BOTH_7,     GS_BOTH_7),
+    [GS_BOTH_8]  = GS_ROW(GS_BOTH_9,  GS_BOTH_8,   GS_BOTH_8,     GS_BOTH_8,     GS_BOTH_8),
+    [GS_BOTH_9]  = GS_ROW(GS_BOTH_10, GS_BOTH_9,   GS_BOTH_9,     GS_BOTH_9,     GS_BOTH_9),
+    [GS_BOTH_10] = GS_ROW(GS_BOTH_10, GS_BOTH_10,  GS_BOTH_10,    GS_BOTH_10,    GS_BOTH_10),
+    [GS_RIGHT_1] = GS_ROW(GS_BOTH_1,  GS_RIGHT_2,  GS_RIGHT_1,    GS_LONG_ALERT, GS_IDLE),
+    [GS_RIGHT_2] = GS_ROW(GS_BOTH_1,  GS_RIGHT_3,  GS_RIGHT_2,    GS_LONG_ALERT, GS_IDLE),
+    [GS_RIGHT_3] = GS_ROW(GS_BOTH_1,  GS_RIGHT_4,  GS_RIGHT_3,    GS_LONG_ALERT, GS_IDLE),
+    [GS_RIGHT_4] = GS_ROW(GS_BOTH_1,  GS_PAIRING,  GS_RIGHT_4,    GS_LONG_ALERT, GS_IDLE),
+    [GS_PAIRING] = GS_ROW(GS_PAIRING, GS_PAIRING,  GS_PAIRING,    GS_LONG_ALERT, GS_PAIRING),
+    [GS_LONG_ALERT] = GS_ROW(GS_LONG_ALERT, GS_LONG_ALERT, GS_LONG_ALERT, GS_LONG_ALERT, GS_LONG_ALERT),
+};
+
+/* What every state broadcasts */
+static const uint8 gesture_code[GESTURE_STATE_COUNT] =
+{
+    [GS_IDLE]       = GESTURE_CODE_NONE,
+    [GS_BOTH_1]     = 1u,   [GS_BOTH_2] = 2u,   [GS_BOTH_3] = 3u,
+    [GS_BOTH_4]     = 4u,   [GS_BOTH_5] = 5u,   [GS_BOTH_6] = 6u,
+    [GS_BOTH_7]     = 7u,   [GS_BOTH_8] = 8u,   [GS_BOTH_9] = 9u,
+    [GS_BOTH_10]    = 10u,
+    [GS_RIGHT_1]    = GESTURE_CODE_NONE,
+    [GS_RIGHT_2]    = GESTURE_CODE_NONE,
+    [GS_RIGHT_3]    = GESTURE_CODE_NONE,
+    [GS_RIGHT_4]    = GESTURE_CODE_NONE,
+    [GS_PAIRING]    = GESTURE_CODE_PAIRING,
+    [GS_LONG_ALERT] = GESTURE_CODE_ALERT,
+};
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE uint8 gesture_state = GS_IDLE;
+static FW_STATE uint32 gesture_last_event = 0;
+static FW_STATE uint8 gesture_starts = 0;   // Gestures that put a code on air
+
+/*******************************************************************************
+* @brief This routine resets the engine to the idle state.
+* 
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void GestureReset(void) {
+    gesture_state = GS_IDLE;
+}
+
+/*******************************************************************************
+* @brief This function runs one event through the transition table.
+* 
+* NOTE: A GESTURE_EV_TIMEOUT is fed first if the previous event is older
+*   than GESTURE_WINDOW_MS.
+* 
+* @param uint32 timestamp:          When the event happened (LFCLK ticks)
+* @param uint8 event:               The event (ie: GESTURE_EV_BOTH or 0)
+*
+* @returns uint8:                   The gesture code after the event
+*******************************************************************************/
+uint8 GestureFeed(uint32 timestamp, uint8 event) {
+    uint8 previous;
+    
+    if (event >= GESTURE_EVENT_COUNT) {
+        return gesture_code[gesture_state];
+    }
+    
+    if (gesture_state != GS_IDLE && 
+        (uint32)(timestamp - gesture_last_event) > 
+        LP_TIMER_MS_TO_TICKS(GESTURE_WINDOW_MS)) {
+        gesture_state = gesture_table[gesture_state][GESTURE_EV_TIMEOUT];
+    }
+    
+    previous = gesture_state;
+    gesture_state = gesture_table[gesture_state][event];
+    gesture_last_event = timestamp;
+    
+    if (gesture_code[previous] == GESTURE_CODE_NONE &&
+        gesture_code[gesture_state] != GESTURE_CODE_NONE) {
+        ++gesture_starts;
+    }
+    
+    return gesture_code[gesture_state];
+}
+
+/*******************************************************************************
+* @brief This function returns the code of the current gesture.
+* 
+* @param None
+*
+* @returns uint8:                   The gesture code (ie: GESTURE_CODE_ALERT)
+*******************************************************************************/
+uint8 GetGestureCode(void) {
+    return gesture_code[gesture_state];
+}
+
+/*******************************************************************************
+* @brief This function counts the gestures that put a code on air.
+* 
+*   A gesture can be cleared and the next one reach the same code between
+* two payload updates, this tells them apart.
+*
+* @param None
+*
+* @returns uint8:                   The count, wraps
+*******************************************************************************/
+uint8 GetGestureStarts(void) {
+    return gesture_starts;
+}
+
+/*******************************************************************************
+* @brief This function tells if a gesture is in progress or being broadcasted.
+* 
+* @param None
+*
+* @returns uint8:                   1 if not idle, 0 otherwise
+*******************************************************************************/
+uint8 GestureActive(void) {
+    return (gesture_state != GS_IDLE);
+}
+
+/* [] END OF FILE */
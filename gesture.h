@@ -0,0 +1,99 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    gesture.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for gesture.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef GESTURE_HEADER
+#define GESTURE_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define GESTURE_WINDOW_MS           (1500u) // Max gap between presses of one gesture
+
+/* Events fed to the engine */
+#define GESTURE_EV_BOTH             (0u)    // Both buttons pressed
+#define GESTURE_EV_RIGHT            (1u)    // Right button pressed
+#define GESTURE_EV_LEFT             (2u)    // Left button pressed
+#define GESTURE_EV_BOTH_LONG        (3u)    // Both buttons held for LONG_PRESS_DELAY
+#define GESTURE_EV_TIMEOUT          (4u)    // More than GESTURE_WINDOW_MS since the last press
+#define GESTURE_EVENT_COUNT         (5u)
+
+/* Gesture codes, as broadcasted (see DynamicADVPayloadUpdate) */
+#define GESTURE_CODE_NONE           (0x00u) // Not pressed / Reseted
+#define GESTURE_CODE_UNSAFE         (0x01u) // Pressed once = Feels Unsafe
+#define GESTURE_CODE_CUSTOM         (0x02u) // Pressed twice = Configurable
+#define GESTURE_CODE_ALERT          (0x04u) // >= 4 = High Danger / Send 113 Alert
+#define GESTURE_CODE_PAIRING        (0xffu) // Pairing mode
+
+/*******************************************************************************
+* @brief This routine resets the engine to the idle state.
+* 
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void GestureReset(void);
+
+/*******************************************************************************
+* @brief This function runs one event through the transition table.
+* 
+* NOTE: A GESTURE_EV_TIMEOUT is fed first if the previous event is older
+*   than GESTURE_WINDOW_MS.
+* 
+* @param uint32 timestamp:          When the event happened (LFCLK ticks)
+* @param uint8 event:               The event (ie: GESTURE_EV_BOTH or 0)
+*
+* @returns uint8:                   The gesture code after the event
+*******************************************************************************/
+uint8 GestureFeed(uint32 timestamp, uint8 event);
+
+/*******************************************************************************
+* @brief This function returns the code of the current gesture.
+* 
+* @param None
+*
+* @returns uint8:                   The gesture code (ie: GESTURE_CODE_ALERT)
+*******************************************************************************/
+uint8 GetGestureCode(void);
+
+/*******************************************************************************
+* @brief This function counts the gestures that put a code on air.
+* 
+*   A gesture can be cleared and the next one reach the same code between
+* two payload updates, this tells them apart.
+*
+* @param None
+*
+* @returns uint8:                   The count, wraps
+*******************************************************************************/
+uint8 GetGestureStarts(void);
+
+/*******************************************************************************
+* @brief This function tells if a gesture is in progress or being broadcasted.
+* 
+* @param None
+*
+* @returns uint8:                   1 if not idle, 0 otherwise
+*******************************************************************************/
+uint8 GestureActive(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,417 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    adv_decoder_bench.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Packets per second of the gateway decoder, on one core
+ * @author  prisma.ai
+ *
+ *  Every case decodes the same pre-built records ROUNDS times in batches
+ * of BATCH, starting from an empty band table each round. Only the
+ * AdvDecodeBatch() calls are timed.
+ *      foreign     no band payload (iBeacons, random data)
+ *      duplicate   band adverts repeating their last payload
+ *      changed     every advert a new payload, without / with a key
+ *      mix         MIX_FOREIGN_PCT foreign, MIX_CHANGED_PCT changed, the
+ *                  rest duplicates, verified
+ *      moved       changed payloads heard under another address first, as
+ *                  a replay onto another band would be: no event (untimed)
+ *   The event counts are checked too, a wrong one fails the run.
+ *
+ *  adv_decoder_bench [-n records] [-b bands] [-r rounds]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "adv_decoder.h"
+#include "adv_auth.h"
+#include "sim_aes.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_RECORDS         (1u << 18)
+#define DEFAULT_BANDS           (4096u)
+#define DEFAULT_ROUNDS          (8u)
+#define BATCH                   (64u)
+
+#define MIX_FOREIGN_PCT         (60u)
+#define MIX_CHANGED_PCT         (1u)
+
+/* Flags, Shortened Local Name, Manufacturer Specific Data, as the band sends */
+static const uint8_t bandTemplate[] =
+{
+    0x02u, 0x01u, 0x06u,
+    0x0Bu, 0x08u, 'S', 'a', 'f', 'e', 'S', 'i', 'g', 'n', 'a', 'l',
+    0x0Fu, 0xFFu, 0xFFu, 0xFFu
+};
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static const uint8_t benchKey[MFC_AUTH_KEY_LEN] = ADV_AUTH_MASTER_KEY;
+static uint32_t rng = 1u;
+
+/* What the generator last sent for each band */
+typedef struct
+{
+    uint8_t         addr[6];
+    uint8_t         seq;
+    uint32_t        counter;
+    ADV_BAND_KEYS_T keys;       // Derived like the band does
+    uint8_t         data[ADV_RECORD_DATA_LEN];
+    uint8_t         dataLen;
+} BENCH_BAND_T;
+
+typedef enum
+{
+    KIND_FOREIGN = 0,
+    KIND_DUPLICATE,
+    KIND_CHANGED
+} BENCH_KIND_T;
+
+/*******************************************************************************
+* Record generation
+*******************************************************************************/
+static uint32_t Random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void SetAddr(ADV_RECORD_T *record, uint32_t id, uint8_t top)
+{
+    record->addr[0] = (uint8_t)id;
+    record->addr[1] = (uint8_t)(id >> 8);
+    record->addr[2] = (uint8_t)(id >> 16);
+    record->addr[3] = (uint8_t)(id >> 24);
+    record->addr[4] = 0x5Au;
+    record->addr[5] = top;
+}
+
+/* iBeacon, or random AD structures */
+static void MakeForeign(ADV_RECORD_T *record)
+{
+    uint8_t i;
+
+    memset(record, 0, sizeof(*record));
+    SetAddr(record, Random(), 0xC0u);
+    record->rssi = (int8_t)(-40 - (int)(Random() % 50u));
+    if(Random() & 1u)
+    {
+        static const uint8_t ibeacon[] = { 0x02u, 0x01u, 0x06u, 0x1Au, 0xFFu, 0x4Cu, 0x00u, 0x02u, 0x15u };
+
+        memcpy(record->data, ibeacon, sizeof(ibeacon));
+        for(i = sizeof(ibeacon); i < 30u; ++i)
+        {
+            record->data[i] = (uint8_t)Random();
+        }
+        record->dataLen = 30u;
+    }
+    else
+    {
+        record->dataLen = (uint8_t)(3u + Random() % 29u);
+        for(i = 0u; i < record->dataLen; ++i)
+        {
+            record->data[i] = (uint8_t)Random();
+        }
+    }
+}
+
+/* Key and hash rows of a band, from the master key and its address */
+static void InitBand(BENCH_BAND_T *band, uint32_t id)
+{
+    uint8_t in[MFC_AUTH_BLOCK_LEN];
+    uint32_t i;
+
+    band->addr[0] = (uint8_t)id;
+    band->addr[1] = (uint8_t)(id >> 8);
+    band->addr[2] = (uint8_t)(id >> 16);
+    band->addr[3] = (uint8_t)(id >> 24);
+    band->addr[4] = 0x5Au;
+    band->addr[5] = 0x00u;
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_BAND_KEY, band->addr, 0u);
+    SimAesEncrypt(in, benchKey, band->keys.key);
+    for(i = 0u; i < MFC_AUTH_HASH_BLOCKS; ++i)
+    {
+        MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_HASH, band->addr, i);
+        SimAesEncrypt(in, band->keys.key, &band->keys.rows[i * MFC_AUTH_BLOCK_LEN]);
+    }
+}
+
+/* Next payload of a band, signed like adv_auth.c does */
+static void NextBandPayload(BENCH_BAND_T *band)
+{
+    MFC_PAYLOAD_T payload;
+    uint8_t in[MFC_AUTH_BLOCK_LEN], block[MFC_AUTH_BLOCK_LEN];
+    uint8_t *out = &band->data[sizeof(bandTemplate)];
+
+    ++band->seq;
+    ++band->counter;
+    payload.version = MFC_PAYLOAD_VERSION_AUTH;
+    payload.presses = (uint8_t)(Random() % 5u);
+    payload.flags = 0u;
+    payload.seq = band->seq;
+    payload.uptimeMinutes = (uint16_t)Random();
+    payload.counter = band->counter;
+    payload.tag = 0u;
+    memcpy(band->data, bandTemplate, sizeof(bandTemplate));
+    MfcPayloadEncode(out, &payload);
+
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_KEYSTREAM, band->addr,
+                      band->counter / MFC_AUTH_WORDS_PER_BLOCK);
+    SimAesEncrypt(in, band->keys.key, block);
+    payload.tag = MfcAuthHashRows(band->keys.rows, out) ^
+                  MfcAuthKeystreamWord(block, band->counter);
+    MfcPayloadEncode(out, &payload);
+    band->dataLen = (uint8_t)(sizeof(bandTemplate) + MFC_PAYLOAD_AUTH_LEN);
+}
+
+static void MakeBand(ADV_RECORD_T *record, const BENCH_BAND_T *band)
+{
+    memset(record, 0, sizeof(*record));
+    memcpy(record->addr, band->addr, sizeof(record->addr));
+    record->rssi = (int8_t)(-40 - (int)(Random() % 50u));
+    record->dataLen = band->dataLen;
+    memcpy(record->data, band->data, sizeof(record->data));
+}
+
+/*  Fills records with the given share of kinds. prime gets one record per
+ * band with its payload before the first one in records, so duplicates
+ * are duplicates from the start. Returns the changed records. */
+static uint32_t Generate(ADV_RECORD_T *records, uint32_t count,
+                         ADV_RECORD_T *prime, BENCH_BAND_T *bands,
+                         uint32_t bandCount, uint32_t foreignPct,
+                         uint32_t changedPct)
+{
+    uint32_t changed = 0u;
+    uint32_t i;
+
+    memset(bands, 0, bandCount * sizeof(*bands));
+    for(i = 0u; i < bandCount; ++i)
+    {
+        InitBand(&bands[i], i);
+        bands[i].counter = Random();
+        NextBandPayload(&bands[i]);
+        MakeBand(&prime[i], &bands[i]);
+    }
+
+    for(i = 0u; i < count; ++i)
+    {
+        uint32_t roll = Random() % 100u;
+        uint32_t id = Random() % bandCount;
+
+        if(roll < foreignPct)
+        {
+            MakeForeign(&records[i]);
+            continue;
+        }
+        if(roll < foreignPct + changedPct)
+        {
+            NextBandPayload(&bands[id]);
+            ++changed;
+        }
+        MakeBand(&records[i], &bands[id]);
+    }
+    return changed;
+}
+
+/*******************************************************************************
+* Timing
+*******************************************************************************/
+typedef struct
+{
+    const char      *name;
+    uint32_t        foreignPct;
+    uint32_t        changedPct;
+    int             verify;
+} BENCH_CASE_T;
+
+static const BENCH_CASE_T benchCases[] =
+{
+    { "foreign",        100u,   0u,   1 },
+    { "duplicate",      0u,     0u,   1 },
+    { "changed",        0u,     100u, 0 },
+    { "changed+auth",   0u,     100u, 1 },
+    { "mix+auth",       MIX_FOREIGN_PCT, MIX_CHANGED_PCT, 1 },
+};
+
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-n records] [-b bands] [-r rounds]\n"
+        "  -n  records per case (default %u)\n"
+        "  -b  bands in range (default %u)\n"
+        "  -r  timed passes over the records (default %u)\n",
+        name, DEFAULT_RECORDS, DEFAULT_BANDS, DEFAULT_ROUNDS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = DEFAULT_RECORDS;
+    uint32_t bandCount = DEFAULT_BANDS;
+    uint32_t rounds = DEFAULT_ROUNDS;
+    uint32_t capacity = 4u;
+    ADV_RECORD_T *records, *prime;
+    ADV_EVENT_T *events;
+    ADV_BAND_STATE_T *table;
+    BENCH_BAND_T *bands;
+    ADV_DECODER_T decoder;
+    int failed = 0;
+    uint32_t c, i;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:b:r:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': count = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'b': bandCount = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': rounds = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if(count == 0u || bandCount == 0u || rounds == 0u)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Table at most half full */
+    while(capacity < 2u * bandCount)
+    {
+        capacity <<= 1;
+    }
+
+    records = calloc(count, sizeof(*records));
+    prime = calloc(bandCount, sizeof(*prime));
+    events = calloc((count > bandCount) ? count : bandCount, sizeof(*events));
+    table = calloc(capacity, sizeof(*table));
+    bands = calloc(bandCount, sizeof(*bands));
+    if(records == NULL || prime == NULL || events == NULL || table == NULL || bands == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Gateway decoder, %u records x %u rounds, %u bands, %s prefilter\n",
+           count, rounds, bandCount,
+#if defined(__SSE2__) && !defined(ADV_DECODER_SCALAR)
+           "SSE2"
+#else
+           "scalar"
+#endif
+           );
+    printf("case              Mpkt/s    ns/pkt    events\n");
+
+    for(c = 0u; c < sizeof(benchCases) / sizeof(benchCases[0]); ++c)
+    {
+        const BENCH_CASE_T *bc = &benchCases[c];
+        uint32_t changed = Generate(records, count, prime, bands, bandCount,
+                                    bc->foreignPct, bc->changedPct);
+        uint32_t expected = (bc->foreignPct == 100u) ? 0u : changed;
+        double elapsed = 0.0;
+        uint64_t got = 0u;
+        uint32_t round;
+
+        for(round = 0u; round < rounds; ++round)
+        {
+            double start;
+
+            AdvDecoderInit(&decoder, table, capacity,
+                           bc->verify ? benchKey : NULL, SimAesEncrypt);
+            AdvDecodeBatch(&decoder, prime, bandCount, events);
+
+            got = 0u;
+            start = NowSeconds();
+            for(i = 0u; i < count; i += BATCH)
+            {
+                got += AdvDecodeBatch(&decoder, &records[i],
+                                      (count - i < BATCH) ? count - i : BATCH, events);
+            }
+            elapsed += NowSeconds() - start;
+        }
+
+        printf("%-14s %9.2f %9.1f %9llu%s\n", bc->name,
+               (double)count * rounds / elapsed / 1e6,
+               elapsed * 1e9 / ((double)count * rounds),
+               (unsigned long long)got,
+               (got != expected) ? "   WRONG" : "");
+        if(got != expected)
+        {
+            failed = 1;
+        }
+    }
+
+    /*  Moved: new signed payloads, heard first under another band's address
+     * or one never heard. Not one may come out as an event, the same
+     * records under their own address all do */
+    {
+        uint32_t changed = Generate(records, count, prime, bands, bandCount, 0u, 100u);
+        uint64_t moved = 0u, own = 0u;
+
+        AdvDecoderInit(&decoder, table, capacity, benchKey, SimAesEncrypt);
+        AdvDecodeBatch(&decoder, prime, bandCount, events);
+        for(i = 0u; i < count; ++i)
+        {
+            ADV_RECORD_T record = records[i];
+            uint32_t id = (uint32_t)record.addr[0] | ((uint32_t)record.addr[1] << 8) |
+                          ((uint32_t)record.addr[2] << 16) | ((uint32_t)record.addr[3] << 24);
+
+            if((i & 1u) && bandCount > 1u)
+            {
+                memcpy(record.addr, bands[(id + 1u) % bandCount].addr, sizeof(record.addr));
+            }
+            else
+            {
+                record.addr[5] ^= 0x01u;    // Not a band in range
+            }
+            moved += AdvDecodeBatch(&decoder, &record, 1u, events);
+        }
+        for(i = 0u; i < count; i += BATCH)
+        {
+            own += AdvDecodeBatch(&decoder, &records[i],
+                                  (count - i < BATCH) ? count - i : BATCH, events);
+        }
+
+        printf("%-14s %9s %9s %9llu%s\n", "moved+auth", "-", "-",
+               (unsigned long long)moved,
+               (moved != 0u || own != changed) ? "   WRONG" : "");
+        if(moved != 0u || own != changed)
+        {
+            failed = 1;
+        }
+    }
+
+    free(records);
+    free(prime);
+    free(events);
+    free(table);
+    free(bands);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
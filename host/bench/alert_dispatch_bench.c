@@ -0,0 +1,410 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_dispatch_bench.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Per tier latency of the alert dispatcher, up to 4x overload
+ * @author  prisma.ai
+ *
+ *  Producer threads submit episodes at a fixed rate, in 1 ms ticks, with
+ * MIX_x percent of each tier. The handler stands for a backend call: it
+ * sleeps -u us. Every load level runs for -t ms at a share of what the
+ * unreserved workers can handle (loadPct), then the dispatcher is stopped,
+ * which drains it.
+ *   The latency of an item is the time from its submission to its handler
+ * call, reported per tier: p50 / p99 / p99.9 / max, with how often a
+ * full tier turned a producer back (the episode is shed, an alert is
+ * retried instead) and what the workers merged. Pairing and configurable
+ * episodes come from small sets of bands, as repeated presses of the same
+ * few would, so their backlog coalesces.
+ *
+ *  alert_dispatch_bench [-w workers] [-a reserved] [-p producers] [-u us] [-t ms]
+ *
+ *  The run fails if an alert was lost or waited more than ALERT_P99_MS at
+ * p99 in any load level.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "alert_dispatch.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_WORKERS         (4u)
+#define DEFAULT_RESERVED        (1u)
+#define DEFAULT_PRODUCERS       (2u)
+#define DEFAULT_HANDLER_US      (200u)
+#define DEFAULT_LEVEL_MS        (1000u)
+
+/* Share of each tier in the offered load, percent */
+#define MIX_ALERT               (2u)
+#define MIX_UNSAFE              (18u)
+#define MIX_CUSTOM              (30u)
+#define MIX_PAIRING             (50u)
+
+/* Bands each tier comes from */
+#define BANDS_ALERT             (4096u)
+#define BANDS_UNSAFE            (1024u)
+#define BANDS_CUSTOM            (256u)
+#define BANDS_PAIRING           (64u)
+
+/* Ring of every tier */
+#define RING_CELLS              (1024u)
+
+#define TICK_NS                 (1000000u)
+#define ALERT_P99_MS            (5.0)
+
+/* Offered load of each level, percent of what the workers can take */
+static const uint32_t loadPct[] = { 50u, 100u, 200u, 400u };
+
+static const char *tierNames[ALERT_TIERS] =
+{
+    [ALERT_TIER_ALERT]      = "alert",
+    [ALERT_TIER_UNSAFE]     = "unsafe",
+    [ALERT_TIER_CUSTOM]     = "custom",
+    [ALERT_TIER_PAIRING]    = "pairing",
+};
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+typedef struct
+{
+    uint32_t            *samples[ALERT_TIERS];     // Latency, us
+    _Atomic uint32_t    taken[ALERT_TIERS];
+    uint32_t            room;                       // Samples per tier
+    uint32_t            handlerUs;
+} BENCH_SINK_T;
+
+typedef struct
+{
+    ALERT_DISPATCH_T        *dispatch;
+    pthread_t               thread;
+    uint32_t                rng;
+    double                  perTick;    // Episodes per tick, this producer
+    uint32_t                ticks;
+    ALERT_SUBMIT_STATS_T    stats;
+} BENCH_PRODUCER_T;
+
+/*******************************************************************************
+* Helpers
+*******************************************************************************/
+static uint32_t Random(uint32_t *rng)
+{
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 17;
+    *rng ^= *rng << 5;
+    return *rng;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void SleepUntil(uint64_t ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(ns / 1000000000u);
+    ts.tv_nsec = (long)(ns % 1000000000u);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+    {
+    }
+}
+
+static int ByValue(const void *a, const void *b)
+{
+    uint32_t va = *(const uint32_t *)a;
+    uint32_t vb = *(const uint32_t *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+static double Percentile(const uint32_t *sorted, uint32_t count, double p)
+{
+    uint32_t at = (uint32_t)(p * (double)(count - 1u) + 0.5);
+
+    return (count == 0u) ? 0.0 : (double)sorted[at] / 1000.0;
+}
+
+/* An episode of a random tier, from that tier's bands */
+static void MakeEpisode(ALERT_EPISODE_T *episode, uint32_t *rng)
+{
+    uint32_t roll = Random(rng) % 100u;
+    uint32_t band;
+
+    memset(episode, 0, sizeof(*episode));
+    if(roll < MIX_ALERT)
+    {
+        band = Random(rng) % BANDS_ALERT;
+        episode->presses = (uint8_t)(4u + Random(rng) % 7u);
+    }
+    else if(roll < MIX_ALERT + MIX_UNSAFE)
+    {
+        band = Random(rng) % BANDS_UNSAFE;
+        episode->presses = 1u;
+    }
+    else if(roll < MIX_ALERT + MIX_UNSAFE + MIX_CUSTOM)
+    {
+        band = Random(rng) % BANDS_CUSTOM;
+        episode->presses = 2u;
+    }
+    else
+    {
+        band = Random(rng) % BANDS_PAIRING;
+        episode->flags = MFC_FLAG_PAIRING;
+    }
+
+    episode->firstUs = NowNs() / 1000u;
+    episode->addr[0] = (uint8_t)band;
+    episode->addr[1] = (uint8_t)(band >> 8);
+    episode->addr[2] = (uint8_t)(roll);     // Tiers apart
+    episode->addr[4] = 0x5Au;
+    episode->rssi = (int8_t)(-40 - (int)(Random(rng) % 50u));
+    episode->seq = (uint8_t)(Random(rng) & MFC_SEQ_MASK);
+}
+
+/*******************************************************************************
+* Threads
+*******************************************************************************/
+static void BenchHandler(void *context, const ALERT_DISPATCH_ITEM_T *item,
+                         uint32_t tier)
+{
+    BENCH_SINK_T *sink = context;
+    uint64_t now = NowNs();
+    uint32_t at = atomic_fetch_add_explicit(&sink->taken[tier], 1u, memory_order_relaxed);
+    struct timespec ts;
+
+    if(at < sink->room)
+    {
+        sink->samples[tier][at] = (uint32_t)((now - item->queuedNs) / 1000u);
+    }
+
+    /* The backend call */
+    ts.tv_sec = 0;
+    ts.tv_nsec = (long)sink->handlerUs * 1000;
+    nanosleep(&ts, NULL);
+}
+
+static void *BenchProducer(void *arg)
+{
+    BENCH_PRODUCER_T *p = arg;
+    uint64_t next = NowNs();
+    double owed = 0.0;
+    uint32_t tick;
+
+    for(tick = 0u; tick < p->ticks; ++tick)
+    {
+        for(owed += p->perTick; owed >= 1.0; owed -= 1.0)
+        {
+            ALERT_EPISODE_T episode;
+
+            MakeEpisode(&episode, &p->rng);
+            /* An alert is never dropped, the others are shed */
+            while(AlertDispatchSubmit(p->dispatch, &episode, &p->stats) == ALERT_SUBMIT_FULL &&
+                  AlertDispatchTier(&episode) == ALERT_TIER_ALERT)
+            {
+                sched_yield();
+            }
+        }
+        next += TICK_NS;
+        SleepUntil(next);
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* Main
+*******************************************************************************/
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-w workers] [-a reserved] [-p producers] [-u us] [-t ms]\n"
+        "  -w  workers (default %u)\n"
+        "  -a  of them for alerts only (default %u)\n"
+        "  -p  producer threads (default %u)\n"
+        "  -u  handler time, us (default %u)\n"
+        "  -t  time per load level, ms (default %u)\n",
+        name, DEFAULT_WORKERS, DEFAULT_RESERVED, DEFAULT_PRODUCERS,
+        DEFAULT_HANDLER_US, DEFAULT_LEVEL_MS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t workerCount = DEFAULT_WORKERS;
+    uint32_t reserved = DEFAULT_RESERVED;
+    uint32_t producerCount = DEFAULT_PRODUCERS;
+    uint32_t handlerUs = DEFAULT_HANDLER_US;
+    uint32_t levelMs = DEFAULT_LEVEL_MS;
+    ALERT_DISPATCH_CELL_T *cells[ALERT_TIERS];
+    uint32_t capacity[ALERT_TIERS];
+    ALERT_DISPATCH_T dispatch;
+    ALERT_WORKER_T *workers;
+    BENCH_PRODUCER_T *producers;
+    BENCH_SINK_T sink;
+    double perSecond;
+    int failed = 0;
+    uint32_t level, tier, i;
+    int opt;
+
+    while((opt = getopt(argc, argv, "w:a:p:u:t:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'w': workerCount = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'a': reserved = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'p': producerCount = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'u': handlerUs = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 't': levelMs = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if(workerCount == 0u || workerCount > ALERT_DISPATCH_MAX_WORKERS ||
+       reserved >= workerCount || producerCount == 0u || handlerUs == 0u ||
+       levelMs == 0u)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* What the unreserved workers can take, and room for the highest level */
+    perSecond = (double)(workerCount - reserved) * 1e6 / handlerUs;
+    sink.handlerUs = handlerUs;
+    sink.room = (uint32_t)(perSecond * loadPct[sizeof(loadPct) / sizeof(loadPct[0]) - 1u] /
+                           100.0 * levelMs / 1000.0) + 1024u;
+
+    workers = calloc(workerCount, sizeof(*workers));
+    producers = calloc(producerCount, sizeof(*producers));
+    if(workers == NULL || producers == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+    for(tier = 0u; tier < ALERT_TIERS; ++tier)
+    {
+        capacity[tier] = RING_CELLS;
+        cells[tier] = calloc(RING_CELLS, sizeof(*cells[tier]));
+        sink.samples[tier] = calloc(sink.room, sizeof(*sink.samples[tier]));
+        if(cells[tier] == NULL || sink.samples[tier] == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("Alert dispatch, %u workers (%u for alerts only), %u producers, "
+           "%u us per handler call, %.0f episodes/s at 100%%\n",
+           workerCount, reserved, producerCount, handlerUs, perSecond);
+
+    for(level = 0u; level < sizeof(loadPct) / sizeof(loadPct[0]); ++level)
+    {
+        ALERT_SUBMIT_STATS_T submitted;
+        uint64_t coalesced[ALERT_TIERS] = { 0u };
+
+        for(tier = 0u; tier < ALERT_TIERS; ++tier)
+        {
+            atomic_store(&sink.taken[tier], 0u);
+        }
+        if(AlertDispatchInit(&dispatch, cells, capacity, BenchHandler, &sink) != 0 ||
+           AlertDispatchStart(&dispatch, workers, workerCount, reserved) != 0)
+        {
+            fprintf(stderr, "dispatcher not started\n");
+            return EXIT_FAILURE;
+        }
+
+        for(i = 0u; i < producerCount; ++i)
+        {
+            BENCH_PRODUCER_T *p = &producers[i];
+
+            memset(p, 0, sizeof(*p));
+            p->dispatch = &dispatch;
+            p->rng = 0x9E3779B9u * (i + 1u) + level;
+            p->perTick = perSecond * loadPct[level] / 100.0 / 1000.0 / producerCount;
+            p->ticks = levelMs;
+            pthread_create(&p->thread, NULL, BenchProducer, p);
+        }
+        memset(&submitted, 0, sizeof(submitted));
+        for(i = 0u; i < producerCount; ++i)
+        {
+            pthread_join(producers[i].thread, NULL);
+            for(tier = 0u; tier < ALERT_TIERS; ++tier)
+            {
+                submitted.queued[tier] += producers[i].stats.queued[tier];
+                submitted.full[tier] += producers[i].stats.full[tier];
+            }
+        }
+        AlertDispatchStop(&dispatch);
+        for(i = 0u; i < workerCount; ++i)
+        {
+            for(tier = 0u; tier < ALERT_TIERS; ++tier)
+            {
+                coalesced[tier] += workers[i].stats.coalesced[tier];
+            }
+        }
+
+        printf("\nLoad %u%%:\n", loadPct[level]);
+        printf("  tier         queued     full   merged   p50 ms   p99 ms p99.9 ms   max ms\n");
+        for(tier = 0u; tier < ALERT_TIERS; ++tier)
+        {
+            uint32_t count = atomic_load(&sink.taken[tier]);
+            double p99;
+            int wrong = 0;
+
+            if(count > sink.room)
+            {
+                count = sink.room;
+            }
+            qsort(sink.samples[tier], count, sizeof(uint32_t), ByValue);
+            p99 = Percentile(sink.samples[tier], count, 0.99);
+            if(tier == ALERT_TIER_ALERT)
+            {
+                /* Retried until queued, so every one was handled once */
+                wrong = (p99 > ALERT_P99_MS) ||
+                        (count != submitted.queued[tier]);
+            }
+            printf("  %-8s %10llu %8llu %8llu %8.2f %8.2f %8.2f %8.2f%s\n",
+                   tierNames[tier],
+                   (unsigned long long)submitted.queued[tier],
+                   (unsigned long long)submitted.full[tier],
+                   (unsigned long long)coalesced[tier],
+                   Percentile(sink.samples[tier], count, 0.50), p99,
+                   Percentile(sink.samples[tier], count, 0.999),
+                   (count != 0u) ? (double)sink.samples[tier][count - 1u] / 1000.0 : 0.0,
+                   wrong ? "   WRONG" : "");
+            if(wrong)
+            {
+                failed = 1;
+            }
+        }
+    }
+
+    for(tier = 0u; tier < ALERT_TIERS; ++tier)
+    {
+        free(cells[tier]);
+        free(sink.samples[tier]);
+    }
+    free(workers);
+    free(producers);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,413 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_index_bench.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Adverts per second and memory of the gateway alert index
+ * @author  prisma.ai
+ *
+ *  A day of a busy site, sped up: every band has EPISODES gestures a few
+ * seconds apart, each reported by GATEWAYS gateways ADVERTS times while on
+ * air, then the idle payload after it, reported the same way. A report is
+ * now and then uploaded late (LATE_PCT, LATE_MS), past the first reports
+ * of the next gesture. The reports go in receive time order to the
+ * threads, report i to thread i % threads, in batches of BATCH. The
+ * threads meet every TICK_MS of receive time, as gateways uploading in
+ * turns would, and every SWEEP_TICKS of those each sweeps its share of
+ * the shards.
+ *   The run is timed with 1, 2, ... up to -j threads, and checked: one
+ * episode per gesture, every other report a duplicate, a stale or an
+ * idle one. A wrong count fails it.
+ *
+ *  alert_index_bench [-b bands] [-s shards] [-c slots] [-j threads] [-r rounds]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "alert_index.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_BANDS           (8192u)
+#define DEFAULT_SHARDS          (16u)
+#define DEFAULT_SLOTS           (1u << 14)
+#define DEFAULT_THREADS         (4u)
+#define DEFAULT_ROUNDS          (4u)
+
+#define EPISODES                (6u)        // Gestures per band
+#define GATEWAYS                (4u)        // Gateways in range of a band
+#define ADVERTS                 (5u)        // Reports of a payload per gateway
+#define IDLE_ADVERTS            (2u)        // Of the idle payload after it
+#define PAIRING_PCT             (12u)       // Gestures that are pairing ones
+
+#define START_SPAN_MS           (600000u)   // Bands start within this
+#define GAP_MIN_MS              (3000u)     // Between two gestures of a band
+#define GAP_RANDOM_MS           (5000u)
+#define ON_AIR_MS               (2500u)     // Burst and COUNTER_EXPIRY_MS
+#define LATE_PCT                (2u)
+#define LATE_MS                 (3000u)
+
+#define BATCH                   (64u)
+#define TICK_MS                 (500u)      // Receive time between meetings
+#define SWEEP_TICKS             (8u)
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static uint32_t rng = 1u;
+
+typedef struct
+{
+    ALERT_INDEX_T           *index;
+    pthread_barrier_t       *barrier;
+    uint64_t                firstUs;    // Receive time of the first report
+    ADV_EVENT_T             *mine;      // Reports i % threads == id
+    uint32_t                mineCount;
+    uint32_t                ticks;      // The same for every thread
+    ALERT_EPISODE_T         episodes[BATCH];
+    uint32_t                id;
+    uint32_t                threads;
+    uint32_t                peakUsed;   // Thread 0 only
+    ALERT_INDEX_STATS_T     stats;
+} BENCH_THREAD_T;
+
+/*******************************************************************************
+* Report generation
+*******************************************************************************/
+static uint32_t Random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int ByTime(const void *a, const void *b)
+{
+    uint64_t ta = ((const ADV_EVENT_T *)a)->timeUs;
+    uint64_t tb = ((const ADV_EVENT_T *)b)->timeUs;
+
+    return (ta > tb) - (ta < tb);
+}
+
+/* adverts reports of one payload by every gateway, from startMs on */
+static ADV_EVENT_T *Report(ADV_EVENT_T *out, uint32_t id, uint64_t startMs,
+                           uint32_t adverts, uint8_t presses, uint8_t flags,
+                           uint8_t seq)
+{
+    uint32_t g, a;
+
+    for(g = 0u; g < GATEWAYS; ++g)
+    {
+        for(a = 0u; a < adverts; ++a)
+        {
+            uint64_t atUs = (startMs + a * (ON_AIR_MS / adverts)) * 1000u +
+                            Random() % (ON_AIR_MS * 1000u / adverts);
+
+            if(Random() % 100u < LATE_PCT)
+            {
+                atUs += LATE_MS * 1000u;
+            }
+            memset(out, 0, sizeof(*out));
+            out->timeUs = atUs;
+            out->addr[0] = (uint8_t)id;
+            out->addr[1] = (uint8_t)(id >> 8);
+            out->addr[2] = (uint8_t)(id >> 16);
+            out->addr[3] = 0x00u;
+            out->addr[4] = 0x5Au;
+            out->addr[5] = 0x00u;
+            out->rssi = (int8_t)(-40 - (int)(Random() % 50u));
+            out->authenticated = 1u;
+            out->payload.version = MFC_PAYLOAD_VERSION_AUTH;
+            out->payload.presses = presses;
+            out->payload.flags = flags;
+            out->payload.seq = seq & MFC_SEQ_MASK;
+            out->payload.counter = ((uint32_t)seq << 8) | a;
+            ++out;
+        }
+    }
+    return out;
+}
+
+/* Every report of every band, in receive time order. Returns the count */
+static uint32_t Generate(ADV_EVENT_T *reports, uint32_t bandCount)
+{
+    ADV_EVENT_T *out = reports;
+    uint32_t b, e;
+
+    for(b = 0u; b < bandCount; ++b)
+    {
+        uint64_t atMs = Random() % START_SPAN_MS;
+        uint8_t seq = (uint8_t)Random();
+
+        for(e = 0u; e < EPISODES; ++e)
+        {
+            if(Random() % 100u < PAIRING_PCT)
+            {
+                out = Report(out, b, atMs, ADVERTS, 0u, MFC_FLAG_PAIRING, ++seq);
+            }
+            else
+            {
+                out = Report(out, b, atMs, ADVERTS, (uint8_t)(1u + Random() % 5u), 0u, ++seq);
+            }
+            out = Report(out, b, atMs + ON_AIR_MS, IDLE_ADVERTS, 0u, 0u, ++seq);
+            atMs += GAP_MIN_MS + Random() % GAP_RANDOM_MS;
+        }
+    }
+
+    qsort(reports, (size_t)(out - reports), sizeof(*reports), ByTime);
+    return (uint32_t)(out - reports);
+}
+
+/*******************************************************************************
+* Timing
+*******************************************************************************/
+static void *BenchThread(void *arg)
+{
+    BENCH_THREAD_T *t = arg;
+    uint32_t done = 0u;
+    uint32_t tick;
+
+    for(tick = 1u; tick <= t->ticks; ++tick)
+    {
+        uint64_t reached = t->firstUs + (uint64_t)tick * TICK_MS * 1000u;
+        uint32_t end = done;
+        uint32_t s;
+
+        while(end < t->mineCount && t->mine[end].timeUs < reached)
+        {
+            ++end;
+        }
+        for(; done < end; done += (end - done < BATCH) ? end - done : BATCH)
+        {
+            AlertIndexBatch(t->index, &t->mine[done],
+                            (end - done < BATCH) ? end - done : BATCH,
+                            t->episodes, &t->stats);
+        }
+
+        /* Every report received before reached is in, none after is older */
+        pthread_barrier_wait(t->barrier);
+        if(tick % SWEEP_TICKS != 0u && tick != t->ticks)
+        {
+            continue;
+        }
+        if(t->id == 0u)
+        {
+            uint32_t used = 0u;
+
+            for(s = 0u; s < t->index->shardCount; ++s)
+            {
+                used += atomic_load_explicit(&t->index->shards[s].used, memory_order_relaxed);
+            }
+            if(used > t->peakUsed)
+            {
+                t->peakUsed = used;
+            }
+        }
+        for(s = t->id; s < t->index->shardCount; s += t->threads)
+        {
+            AlertIndexExpire(t->index, s, reached);
+        }
+    }
+    return NULL;
+}
+
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-b bands] [-s shards] [-c slots] [-j threads] [-r rounds]\n"
+        "  -b  bands (default %u)\n"
+        "  -s  shards, a power of two (default %u)\n"
+        "  -c  slots in the index, a power of two (default %u)\n"
+        "  -j  most threads timed (default %u)\n"
+        "  -r  timed runs per thread count (default %u)\n",
+        name, DEFAULT_BANDS, DEFAULT_SHARDS, DEFAULT_SLOTS, DEFAULT_THREADS,
+        DEFAULT_ROUNDS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t bandCount = DEFAULT_BANDS;
+    uint32_t shards = DEFAULT_SHARDS;
+    uint32_t capacity = DEFAULT_SLOTS;
+    uint32_t maxThreads = DEFAULT_THREADS;
+    uint32_t rounds = DEFAULT_ROUNDS;
+    uint32_t expected, count, threads, peakUsed = 0u;
+    ADV_EVENT_T *reports, *partition;
+    ALERT_SLOT_T *slots;
+    ALERT_INDEX_T *index;
+    BENCH_THREAD_T *workers;
+    pthread_t *ids;
+    int failed = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "b:s:c:j:r:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'b': bandCount = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': shards = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': capacity = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'j': maxThreads = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': rounds = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if(bandCount == 0u || bandCount > 0x1000000u || maxThreads == 0u ||
+       maxThreads > 64u || rounds == 0u)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    count = bandCount * EPISODES * GATEWAYS * (ADVERTS + IDLE_ADVERTS);
+    reports = calloc(count, sizeof(*reports));
+    partition = calloc(count, sizeof(*partition));
+    slots = aligned_alloc(64u, (size_t)capacity * sizeof(*slots));
+    index = aligned_alloc(64u, sizeof(*index));
+    workers = calloc(maxThreads, sizeof(*workers));
+    ids = calloc(maxThreads, sizeof(*ids));
+    if(reports == NULL || partition == NULL || slots == NULL || index == NULL ||
+       workers == NULL || ids == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+    if(AlertIndexInit(index, slots, capacity, shards, ALERT_INDEX_WINDOW_MS) != 0)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    count = Generate(reports, bandCount);
+    expected = bandCount * EPISODES;
+
+    printf("Alert index, %u bands x %u gestures, %u reports, %u shards, %u slots\n",
+           bandCount, EPISODES, count, shards, capacity);
+    printf("threads  Madv/s    ns/adv    episodes  duplicates     stale      idle\n");
+
+    for(threads = 1u; threads <= maxThreads; threads <<= 1)
+    {
+        pthread_barrier_t barrier;
+        double elapsed = 0.0;
+        ALERT_INDEX_STATS_T total;
+        uint32_t round, t, i;
+        int wrong;
+
+        /* Report i to thread i % threads, each its own run of them */
+        for(t = 0u, i = 0u; t < threads; ++t)
+        {
+            uint32_t r;
+
+            workers[t].mine = &partition[i];
+            for(r = t; r < count; r += threads)
+            {
+                partition[i++] = reports[r];
+            }
+            workers[t].mineCount = (uint32_t)(&partition[i] - workers[t].mine);
+        }
+
+        for(round = 0u; round < rounds; ++round)
+        {
+            double start;
+
+            AlertIndexInit(index, slots, capacity, shards, ALERT_INDEX_WINDOW_MS);
+            pthread_barrier_init(&barrier, NULL, threads);
+            for(t = 0u; t < threads; ++t)
+            {
+                workers[t].index = index;
+                workers[t].barrier = &barrier;
+                workers[t].firstUs = reports[0].timeUs;
+                workers[t].id = t;
+                workers[t].threads = threads;
+                workers[t].ticks = (uint32_t)((reports[count - 1u].timeUs - reports[0].timeUs) /
+                                              (TICK_MS * 1000u)) + 1u;
+                workers[t].peakUsed = 0u;
+                memset(&workers[t].stats, 0, sizeof(workers[t].stats));
+            }
+
+            start = NowSeconds();
+            for(t = 0u; t < threads; ++t)
+            {
+                pthread_create(&ids[t], NULL, BenchThread, &workers[t]);
+            }
+            for(t = 0u; t < threads; ++t)
+            {
+                pthread_join(ids[t], NULL);
+            }
+            elapsed += NowSeconds() - start;
+            pthread_barrier_destroy(&barrier);
+
+            if(workers[0].peakUsed > peakUsed)
+            {
+                peakUsed = workers[0].peakUsed;
+            }
+        }
+
+        /* Counts of the last round */
+        memset(&total, 0, sizeof(total));
+        for(t = 0u; t < threads; ++t)
+        {
+            total.reports += workers[t].stats.reports;
+            total.episodes += workers[t].stats.episodes;
+            total.duplicates += workers[t].stats.duplicates;
+            total.stale += workers[t].stats.stale;
+            total.idle += workers[t].stats.idle;
+            total.unindexed += workers[t].stats.unindexed;
+        }
+        wrong = total.episodes != expected || total.unindexed != 0u ||
+                total.reports != count ||
+                total.episodes + total.duplicates + total.stale + total.idle != count;
+
+        printf("%7u %8.2f %9.1f %11llu %11llu %9llu %9llu%s\n", threads,
+               (double)count * rounds / elapsed / 1e6,
+               elapsed * 1e9 / ((double)count * rounds),
+               (unsigned long long)total.episodes,
+               (unsigned long long)total.duplicates,
+               (unsigned long long)total.stale,
+               (unsigned long long)total.idle,
+               wrong ? "   WRONG" : "");
+        if(wrong)
+        {
+            failed = 1;
+        }
+    }
+
+    printf("Memory: %u B per slot, %.1f B per tracked band at the 3/4 limit, "
+           "peak %u bands tracked (%.1f KiB)\n",
+           (unsigned)sizeof(ALERT_SLOT_T), (double)sizeof(ALERT_SLOT_T) * 4.0 / 3.0,
+           peakUsed, (double)peakUsed * sizeof(ALERT_SLOT_T) * 4.0 / 3.0 / 1024.0);
+
+    free(reports);
+    free(partition);
+    free(slots);
+    free(index);
+    free(workers);
+    free(ids);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
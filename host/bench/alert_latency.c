@@ -0,0 +1,448 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_latency.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Press to on-air latency benchmark on the host simulator
+ * @author  prisma.ai
+ *
+ *  Every trial is one simulator run, in a forked child (the firmware keeps
+ * its state in globals), with its own seed for the advDelay and a random
+ * press phase. The latency of a trial is the time from the first edge of
+ * the measured press to the start of the first advertising event carrying
+ * the expected payload. That covers the debounce delay, the EVENT_CLOSE
+ * gating of DynamicADVPayloadUpdate and the advertising interval.
+ *
+ *  The gestures start after IDLE_MS, once advertising has decayed to its
+ * idle profile, like on a band that has been worn for a while.
+ *
+ *  alert_latency [-n trials] [-r seed] [-b baseline] [-w baseline]
+ *
+ *  With -b, the run fails (exit 2) if a scenario's p99 is more than
+ * P99_TOLERANCE over the baseline, or if it lost more than LOST_SLACK_PCT
+ * more of its presses.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "gesture.h"
+#include "mfc_payload.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_TRIALS          (500u)
+#define DEFAULT_SEED            (1u)
+
+#define BOTH_PINS               (0x03u)
+#define RIGHT_PIN               (0x02u)
+
+#define IDLE_MS                 (75000u)    // Before the first press
+#define PHASE_MS                (3000u)     // Random extra delay of the first press
+#define PRESS_HOLD_MS           (150u)
+#define PRESS_GAP_MS            (400u)
+#define TIMEOUT_MS              (5000u)     // A press not on air by then is lost
+
+/*  The "reset" scenario presses again around the time the first gesture is
+ * cleared, somewhere in [RESET_FROM_MS, RESET_FROM_MS + RESET_SPREAD_MS) */
+#define RESET_FROM_MS           (1500u)
+#define RESET_SPREAD_MS         (1500u)
+
+#define P99_TOLERANCE           (0.10)      // Allowed p99 regression
+#define P99_SLACK_MS            (1.0)       // Absolute slack, for tiny p99s
+#define LOST_SLACK_PCT          (1.0)       // Allowed increase of lost presses
+
+#define EXIT_REGRESSION         (2)
+
+/* Expected code meaning "any non-zero code under a new sequence number" */
+#define EXPECT_ANY              (0x100u)
+
+/*******************************************************************************
+* Scenarios
+*******************************************************************************/
+typedef struct
+{
+    const char  *name;
+    uint8       pins;
+    uint32      presses;
+    uint32      measured;       // Index of the press that is timed
+    uint32      expected;       // Code it should put on air (or EXPECT_ANY)
+    uint8       reset;          // Last press lands around the counter reset
+} LATENCY_SCENARIO_T;
+
+static const LATENCY_SCENARIO_T scenarios[] =
+{
+    { "single",     BOTH_PINS, 1u, 0u, GESTURE_CODE_UNSAFE,  0u },
+    { "double",     BOTH_PINS, 2u, 1u, GESTURE_CODE_CUSTOM,  0u },
+    { "alert",      BOTH_PINS, 4u, 3u, GESTURE_CODE_ALERT,   0u },
+    { "pairing",    RIGHT_PIN, 5u, 4u, GESTURE_CODE_PAIRING, 0u },
+    { "reset",      BOTH_PINS, 2u, 1u, EXPECT_ANY,           1u },
+};
+
+#define SCENARIO_COUNT          (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/* What a trial sends back to the parent */
+typedef struct
+{
+    int         found;
+    double      latencyMs;
+} LATENCY_RESULT_T;
+
+typedef struct
+{
+    double      p50, p90, p99, max;
+    uint32      lost;
+    double      lostPct;
+} LATENCY_SUMMARY_T;
+
+static SIM_SCENARIO_T scenario;
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32 NextRandom(uint32 *state)
+{
+    /* xorshift32, same as the simulator */
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static uint64_t BuildPresses(const LATENCY_SCENARIO_T *s, uint32 seed)
+{
+    uint32 rng = seed * 2654435761u | 1u;
+    uint64_t startNs = (uint64_t)IDLE_MS * SIM_NS_PER_MS +
+                       (uint64_t)(NextRandom(&rng) % (PHASE_MS * 1000u)) * SIM_NS_PER_US;
+    uint32 i;
+
+    scenario.name = s->name;
+    scenario.pressCount = s->presses;
+
+    for(i = 0u; i < s->presses; ++i)
+    {
+        SIM_PRESS_T *press = &scenario.presses[i];
+
+        press->timeNs = startNs + (uint64_t)i * PRESS_GAP_MS * SIM_NS_PER_MS;
+        press->holdNs = (uint64_t)PRESS_HOLD_MS * SIM_NS_PER_MS;
+        press->pins = s->pins;
+    }
+
+    if(s->reset)
+    {
+        SIM_PRESS_T *press = &scenario.presses[s->presses - 1u];
+        press->timeNs = startNs + (uint64_t)RESET_FROM_MS * SIM_NS_PER_MS +
+            (uint64_t)(NextRandom(&rng) % (RESET_SPREAD_MS * 1000u)) * SIM_NS_PER_US;
+    }
+
+    return scenario.presses[s->measured].timeNs;
+}
+
+/*  Gesture code and sequence number carried by an advertisement, as the app
+ * decodes them */
+static uint8 CodeOf(const SIM_ON_AIR_T *entry, uint8 *seq)
+{
+    MFC_PAYLOAD_T payload;
+    uint8 length = 0u;
+    int index = MfcPayloadFind(entry->advData, entry->advDataLen, &length);
+
+    if(index < 0 ||
+       MfcPayloadDecode(&entry->advData[index], length, &payload) != 0)
+    {
+        *seq = 0u;
+        return GESTURE_CODE_NONE;
+    }
+    *seq = payload.seq;
+    return (payload.flags & MFC_FLAG_PAIRING) ? GESTURE_CODE_PAIRING : payload.presses;
+}
+
+/* Runs in the child: one simulator run, one latency */
+static LATENCY_RESULT_T RunTrial(const LATENCY_SCENARIO_T *s, uint32 seed)
+{
+    LATENCY_RESULT_T result = { 0, 0.0 };
+    SIM_CONFIG_T config;
+    const SIM_STATS_T *stats;
+    uint64_t pressNs = BuildPresses(s, seed);
+    uint8 seqBefore = 0u;
+    uint32 i;
+
+    SimConfigDefaults(&config);
+    config.seed = (double)seed;
+    stats = SimRun(&config, &scenario,
+                   pressNs + (uint64_t)TIMEOUT_MS * SIM_NS_PER_MS, 0);
+
+    for(i = 0u; i < stats->onAirCount; ++i)
+    {
+        const SIM_ON_AIR_T *entry = &stats->onAir[i];
+        uint8 seq;
+        uint8 code = CodeOf(entry, &seq);
+
+        /* A re-press may put the same code on air again, the sequence
+         * number tells it apart from the gesture before it */
+        if(entry->timeNs < pressNs)
+        {
+            seqBefore = seq;
+        }
+        else if((s->expected == EXPECT_ANY) ?
+                (code != GESTURE_CODE_NONE && seq != seqBefore) :
+                (code == s->expected))
+        {
+            result.found = 1;
+            result.latencyMs = (double)(entry->timeNs - pressNs) / SIM_NS_PER_MS;
+            break;
+        }
+    }
+    return result;
+}
+
+static int ForkTrial(const LATENCY_SCENARIO_T *s, uint32 seed,
+                     LATENCY_RESULT_T *result)
+{
+    int fds[2];
+    int status;
+    pid_t pid;
+
+    if(pipe(fds) != 0)
+    {
+        return -1;
+    }
+    pid = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if(pid == 0)
+    {
+        LATENCY_RESULT_T trial = RunTrial(s, seed);
+        ssize_t written = write(fds[1], &trial, sizeof(trial));
+        _exit(written == (ssize_t)sizeof(trial) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    if(read(fds[0], result, sizeof(*result)) != (ssize_t)sizeof(*result))
+    {
+        result->found = -1;
+    }
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return (result->found < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != EXIT_SUCCESS) ? -1 : 0;
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static double Percentile(const double *sorted, uint32 count, double p)
+{
+    uint32 rank;
+
+    if(count == 0u)
+    {
+        return 0.0;
+    }
+    rank = (uint32)(p / 100.0 * count + 0.999999);
+    rank = (rank == 0u) ? 1u : (rank > count ? count : rank);
+    return sorted[rank - 1u];
+}
+
+static int LoadBaseline(const char *path, LATENCY_SUMMARY_T *baseline, int *known)
+{
+    char line[256];
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL)
+    {
+        return -1;
+    }
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        char name[64];
+        double p99, lostPct;
+        uint32 i;
+
+        if(line[0] == '#' || sscanf(line, "%63s %lf %lf", name, &p99, &lostPct) != 3)
+        {
+            continue;
+        }
+        for(i = 0u; i < SCENARIO_COUNT; ++i)
+        {
+            if(strcmp(name, scenarios[i].name) == 0)
+            {
+                baseline[i].p99 = p99;
+                baseline[i].lostPct = lostPct;
+                known[i] = 1;
+            }
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+static int SaveBaseline(const char *path, const LATENCY_SUMMARY_T *summary,
+                        uint32 trials)
+{
+    FILE *file = fopen(path, "w");
+    uint32 i;
+
+    if(file == NULL)
+    {
+        return -1;
+    }
+    fprintf(file, "# alert_latency baseline, %u trials per scenario\n", trials);
+    fprintf(file, "# scenario  p99_ms  lost_pct\n");
+    for(i = 0u; i < SCENARIO_COUNT; ++i)
+    {
+        fprintf(file, "%-10s  %.3f  %.2f\n", scenarios[i].name, summary[i].p99,
+                summary[i].lostPct);
+    }
+    fclose(file);
+    return 0;
+}
+
+static void Usage(const char *self)
+{
+    fprintf(stderr,
+        "usage: %s [-n trials] [-r seed] [-b baseline] [-w baseline]\n"
+        "  -n  trials per scenario (default %u)\n"
+        "  -r  first seed (default %u)\n"
+        "  -b  fail if p99 or lost presses regress against this baseline\n"
+        "  -w  write the results as the new baseline\n",
+        self, DEFAULT_TRIALS, DEFAULT_SEED);
+}
+
+int main(int argc, char **argv)
+{
+    LATENCY_SUMMARY_T summary[SCENARIO_COUNT];
+    LATENCY_SUMMARY_T baseline[SCENARIO_COUNT];
+    int known[SCENARIO_COUNT] = { 0 };
+    const char *baselineIn = NULL;
+    const char *baselineOut = NULL;
+    uint32 trials = DEFAULT_TRIALS;
+    uint32 seed = DEFAULT_SEED;
+    double *samples;
+    int regressed = 0;
+    uint32 i, t;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:r:b:w:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                trials = (uint32)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                seed = (uint32)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                baselineIn = optarg;
+                break;
+            case 'w':
+                baselineOut = optarg;
+                break;
+            default:
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(trials == 0u)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(baselineIn != NULL && LoadBaseline(baselineIn, baseline, known) != 0)
+    {
+        fprintf(stderr, "can't read baseline: %s\n", baselineIn);
+        return EXIT_FAILURE;
+    }
+
+    samples = malloc(trials * sizeof(*samples));
+    if(samples == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("Press to on-air latency, %u trials per scenario (ms)\n", trials);
+    printf("%-10s %9s %9s %9s %9s %6s\n", "scenario", "p50", "p90", "p99", "max", "lost");
+
+    for(i = 0u; i < SCENARIO_COUNT; ++i)
+    {
+        uint32 count = 0u;
+
+        summary[i].lost = 0u;
+        for(t = 0u; t < trials; ++t)
+        {
+            LATENCY_RESULT_T result;
+
+            if(ForkTrial(&scenarios[i], seed + t, &result) != 0)
+            {
+                fprintf(stderr, "%s: trial %u failed\n", scenarios[i].name, t);
+                free(samples);
+                return EXIT_FAILURE;
+            }
+            if(result.found)
+            {
+                samples[count++] = result.latencyMs;
+            }
+            else
+            {
+                ++summary[i].lost;
+            }
+        }
+
+        qsort(samples, count, sizeof(*samples), CompareDouble);
+        summary[i].p50 = Percentile(samples, count, 50.0);
+        summary[i].p90 = Percentile(samples, count, 90.0);
+        summary[i].p99 = Percentile(samples, count, 99.0);
+        summary[i].max = (count != 0u) ? samples[count - 1u] : 0.0;
+        summary[i].lostPct = 100.0 * summary[i].lost / trials;
+
+        printf("%-10s %9.3f %9.3f %9.3f %9.3f %6u", scenarios[i].name,
+               summary[i].p50, summary[i].p90, summary[i].p99, summary[i].max,
+               summary[i].lost);
+
+        if(known[i])
+        {
+            double limit = baseline[i].p99 * (1.0 + P99_TOLERANCE) + P99_SLACK_MS;
+
+            double lostLimit = baseline[i].lostPct + LOST_SLACK_PCT;
+
+            if(summary[i].p99 > limit || summary[i].lostPct > lostLimit)
+            {
+                printf("   REGRESSION (p99 limit %.3f, lost limit %.2f %%)",
+                       limit, lostLimit);
+                regressed = 1;
+            }
+        }
+        printf("\n");
+    }
+    free(samples);
+
+    if(baselineOut != NULL && SaveBaseline(baselineOut, summary, trials) != 0)
+    {
+        fprintf(stderr, "can't write baseline: %s\n", baselineOut);
+        return EXIT_FAILURE;
+    }
+    return regressed ? EXIT_REGRESSION : EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,326 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    auth_reboot_test.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   ADV counters across resets, as the gateway decoder sees them
+ * @author  prisma.ai
+ *
+ *  Boots the firmware several times on the same flash. Every boot is one
+ * simulator run in a forked child (the firmware keeps its state in
+ * globals, a reset clears them), which sends back what went on air and
+ * the flash rows; the parent writes those into its own flash for the next
+ * child. The adverts of each boot go through one gateway decoder, in
+ * order:
+ *      - every payload of the boot has to be accepted, none taken as a
+ *        replay or failing its tag
+ *      - then the adverts of all the boots before it are played again,
+ *        a capture from before the reset: none may come out as an event
+ *   Any failure fails the run.
+ *
+ *  auth_reboot_test [-b boots] [-s scenario] [-t seconds] [-r seed]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "sim_aes.h"
+#include "sim_flash.h"
+#include "adv_auth.h"
+#include "adv_decoder.h"
+#include "mfc_payload.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_BOOTS           (4u)
+#define DEFAULT_SECONDS         (60.0)
+#define MAX_BOOTS               (16u)
+#define DECODER_BANDS           (16u)
+#define BATCH                   (64u)
+
+#define FLASH_LEN               (SIM_FLASH_ROWS * CY_FLASH_SIZEOF_ROW)
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static const uint8_t key[MFC_AUTH_KEY_LEN] = ADV_AUTH_MASTER_KEY;
+static SIM_SCENARIO_T scenario;
+
+/* What went on air in each boot */
+typedef struct
+{
+    ADV_RECORD_T    *records;
+    uint32_t        count;
+} BOOT_T;
+
+static BOOT_T boots[MAX_BOOTS];
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static int WriteAll(int fd, const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+
+    while(length > 0u)
+    {
+        ssize_t n = write(fd, bytes, length);
+
+        if(n <= 0)
+        {
+            return -1;
+        }
+        bytes += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+static int ReadAll(int fd, void *data, size_t length)
+{
+    uint8_t *bytes = data;
+
+    while(length > 0u)
+    {
+        ssize_t n = read(fd, bytes, length);
+
+        if(n <= 0)
+        {
+            return -1;
+        }
+        bytes += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Runs in the child: one boot, sends back the on-air packets and the flash */
+static int RunBoot(int fd, uint32_t seed, double seconds)
+{
+    const uint8_t *flash = (const uint8_t *)(SimFlashBase() +
+                                             (uintptr_t)SIM_FLASH_FIRST_ROW * CY_FLASH_SIZEOF_ROW);
+    const SIM_STATS_T *stats;
+    SIM_CONFIG_T config;
+
+    SimConfigDefaults(&config);
+    config.seed = (double)seed;
+    stats = SimRun(&config, &scenario, (uint64_t)(seconds * SIM_NS_PER_S), 0);
+
+    if(WriteAll(fd, &stats->onAirCount, sizeof(stats->onAirCount)) != 0 ||
+       WriteAll(fd, stats->onAir, stats->onAirCount * sizeof(stats->onAir[0])) != 0 ||
+       WriteAll(fd, flash, FLASH_LEN) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* One boot in a child, on the flash the boots before it left */
+static int ForkBoot(BOOT_T *boot, uint32_t seed, double seconds)
+{
+    static SIM_ON_AIR_T onAir[SIM_MAX_ON_AIR];
+    static uint8_t flash[FLASH_LEN];
+    uint32_t count = 0u;
+    uint32_t i;
+    int fds[2];
+    int status;
+    int result = 0;
+    pid_t pid;
+
+    if(pipe(fds) != 0)
+    {
+        return -1;
+    }
+    pid = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if(pid == 0)
+    {
+        close(fds[0]);
+        _exit(RunBoot(fds[1], seed, seconds) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    if(ReadAll(fds[0], &count, sizeof(count)) != 0 || count > SIM_MAX_ON_AIR ||
+       ReadAll(fds[0], onAir, count * sizeof(onAir[0])) != 0 ||
+       ReadAll(fds[0], flash, FLASH_LEN) != 0)
+    {
+        result = -1;
+    }
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+    if(result != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        return -1;
+    }
+
+    /* The flash survives the reset */
+    for(i = 0u; i < SIM_FLASH_ROWS; ++i)
+    {
+        SimFlashProgram(SIM_FLASH_FIRST_ROW + i, &flash[i * CY_FLASH_SIZEOF_ROW]);
+    }
+
+    boot->records = calloc(count ? count : 1u, sizeof(*boot->records));
+    if(boot->records == NULL)
+    {
+        return -1;
+    }
+    for(i = 0u; i < count; ++i)
+    {
+        ADV_RECORD_T *record = &boot->records[i];
+
+        record->timeUs = onAir[i].timeNs / SIM_NS_PER_US;
+        SimBandAddress(0u, record->addr);   // The same band, band_id 0
+        record->rssi = -50;
+        record->dataLen = onAir[i].advDataLen;
+        memcpy(record->data, onAir[i].advData, onAir[i].advDataLen);
+    }
+    boot->count = count;
+    return 0;
+}
+
+/* Feeds records to the decoder, returns the events, the last counter in *counter */
+static uint32_t Decode(ADV_DECODER_T *decoder, const BOOT_T *boot, uint32_t *counter)
+{
+    ADV_EVENT_T events[BATCH];
+    uint32_t total = 0u;
+    uint32_t done, n, i;
+
+    for(done = 0u; done < boot->count; done += n)
+    {
+        n = (boot->count - done < BATCH) ? boot->count - done : BATCH;
+        i = AdvDecodeBatch(decoder, &boot->records[done], n, events);
+        if(i > 0u && counter != NULL)
+        {
+            *counter = events[i - 1u].payload.counter;
+        }
+        total += i;
+    }
+    return total;
+}
+
+/*******************************************************************************
+* Main
+*******************************************************************************/
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-b boots] [-s scenario] [-t seconds] [-r seed]\n"
+        "  -b  boots on the same flash, 2 to %u (default %u)\n"
+        "  -s  scenario of every boot (default mixed)\n"
+        "  -t  seconds per boot (default %.0f)\n"
+        "  -r  seed of the first boot (default 1)\n",
+        name, MAX_BOOTS, DEFAULT_BOOTS, DEFAULT_SECONDS);
+}
+
+int main(int argc, char **argv)
+{
+    static ADV_BAND_STATE_T table[DECODER_BANDS];
+    ADV_DECODER_T decoder;
+    const char *name = "mixed";
+    double seconds = DEFAULT_SECONDS;
+    uint32_t bootCount = DEFAULT_BOOTS;
+    uint32_t seed = 1u;
+    uint32_t failures = 0u;
+    uint32_t b, before;
+    int opt;
+
+    while((opt = getopt(argc, argv, "b:s:t:r:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'b': bootCount = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': name = optarg; break;
+            case 't': seconds = atof(optarg); break;
+            case 'r': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if(bootCount < 2u || bootCount > MAX_BOOTS || seconds <= 0.0)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(SimScenarioLoad(&scenario, name) != 0)
+    {
+        fprintf(stderr, "unknown scenario %s\n", name);
+        return EXIT_FAILURE;
+    }
+    if(AdvDecoderInit(&decoder, table, DECODER_BANDS, key, SimAesEncrypt) != 0)
+    {
+        fprintf(stderr, "can't set up the gateway decoder\n");
+        return EXIT_FAILURE;
+    }
+    SimFlashErase();
+
+    printf("%u boots of %s, %.0f s each, ADV_AUTH_BLOCK_BITS %u\n",
+           bootCount, name, seconds, ADV_AUTH_BLOCK_BITS);
+    printf("boot   adverts   events  last counter   replayed  accepted\n");
+
+    for(b = 0u; b < bootCount; ++b)
+    {
+        ADV_DECODER_STATS_T start;
+        uint32_t counter = 0u;
+        uint32_t events, replayed = 0u, accepted = 0u;
+
+        if(ForkBoot(&boots[b], seed + b, seconds) != 0)
+        {
+            fprintf(stderr, "boot %u failed\n", b);
+            return EXIT_FAILURE;
+        }
+
+        /* This boot: everything new goes through */
+        start = decoder.stats;
+        events = Decode(&decoder, &boots[b], &counter);
+        if(events == 0u || decoder.stats.replays != start.replays ||
+           decoder.stats.authFailed != start.authFailed)
+        {
+            printf("boot %u: %u events, %llu replays, %llu auth failed\n", b, events,
+                   (unsigned long long)(decoder.stats.replays - start.replays),
+                   (unsigned long long)(decoder.stats.authFailed - start.authFailed));
+            ++failures;
+        }
+
+        /* Then a capture from before the reset */
+        for(before = 0u; before < b; ++before)
+        {
+            replayed += boots[before].count;
+            accepted += Decode(&decoder, &boots[before], NULL);
+        }
+        if(accepted != 0u)
+        {
+            printf("boot %u: %u adverts from before the reset accepted\n", b, accepted);
+            ++failures;
+        }
+
+        printf("%4u  %8u  %7u  %12u  %9u  %8u\n",
+               b, boots[b].count, events, counter, replayed, accepted);
+    }
+
+    printf("Gateway: %llu events, %llu replays, %llu auth failed, %u failures\n",
+           (unsigned long long)decoder.stats.events,
+           (unsigned long long)decoder.stats.replays,
+           (unsigned long long)decoder.stats.authFailed, failures);
+    printf("%s\n", (failures == 0u) ? "OK" : "FAIL");
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
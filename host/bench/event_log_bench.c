@@ -0,0 +1,459 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    event_log_bench.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Append / recovery throughput and power-fail test of the event log
+ * @author  prisma.ai
+ *
+ *  Runs event_log.c against the emulated flash (sim_flash.c), without the
+ * rest of the simulator:
+ *      append      records per second on the host, rows written per 1000
+ *                  records, the wear spread over the rows and the CPU time
+ *                  the row writes would take on the band (FLASH_ROW_MS each)
+ *      recovery    EventLogStart() on a full log
+ *      power-fail  random appends / commits with the power cut during a
+ *                  random row write, then a reboot. Every record committed
+ *                  before the cut has to read back unchanged, a failure
+ *                  fails the run
+ *      reserve     EventLogReserve with row writes refused at random and
+ *                  reboots: a boot number reported in flash is never
+ *                  handed out again, a failure fails the run
+ *
+ *  event_log_bench [-n records] [-t trials] [-s seed]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim_flash.h"
+#include "event_log.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_RECORDS         (1u << 20)
+#define DEFAULT_TRIALS          (20000u)
+#define RECOVERY_ROUNDS         (20000u)
+
+#define FLASH_ROW_MS            (20.0)      // Row write (erase + program), datasheet max
+#define FLASH_ENDURANCE         (100000.0)  // Erase cycles per row
+
+#define TRIAL_STEPS             (400u)      // Appends per power-fail trial
+#define TRIAL_TEAR_MAX          (40u)       // Cut within this many row writes
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static uint32_t rng = 1u;
+static int powerLost = 0;
+static uint32_t failWrites = 0u;            // Row writes left to fail
+
+/*******************************************************************************
+* Flash, as the HAL would do it
+*******************************************************************************/
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    int result;
+
+    if(powerLost)
+    {
+        return CY_SYS_FLASH_INVALID_CLOCK;  // The CPU is gone
+    }
+    if(failWrites > 0u)
+    {
+        --failWrites;                       // Refused, the row is left as it was
+        return CY_SYS_FLASH_PROTECTED;
+    }
+    result = SimFlashProgram(rowNum, rowData);
+    if(result == SIM_FLASH_BAD_ROW)
+    {
+        return CY_SYS_FLASH_INVALID_ADDR;
+    }
+    if(result == SIM_FLASH_TORN)
+    {
+        powerLost = 1;
+        return CY_SYS_FLASH_INVALID_CLOCK;
+    }
+    return CY_SYS_FLASH_SUCCESS;
+}
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32_t Random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Writes to the log rows only, the rest of the emulated flash is unused */
+static void RowWriteSpread(uint32_t *min, uint32_t *max)
+{
+    const SIM_FLASH_STATS_T *stats = SimFlashStats();
+    uint32_t i;
+
+    *min = 0xFFFFFFFFu;
+    *max = 0u;
+    for(i = EVENT_LOG_FIRST_ROW - SIM_FLASH_FIRST_ROW; i < SIM_FLASH_ROWS; ++i)
+    {
+        *min = (stats->rowWrites[i] < *min) ? stats->rowWrites[i] : *min;
+        *max = (stats->rowWrites[i] > *max) ? stats->rowWrites[i] : *max;
+    }
+}
+
+/*******************************************************************************
+* Append
+*******************************************************************************/
+typedef struct
+{
+    const char  *name;
+    uint32_t    alertEvery;     // Every Nth record is an alert, 0 = none
+    uint32_t    gapS;           // Seconds between records
+} BENCH_CASE_T;
+
+static const BENCH_CASE_T benchCases[] =
+{
+    { "gestures",       0u,  60u   },   // Rows fill up
+    { "sparse",         0u,  3600u },   // Committed by age, one or two a row
+    { "alerts 1/8",     8u,  60u   },
+    { "alerts only",    1u,  60u   },   // Every record its own commit
+};
+
+static void BenchAppend(uint32_t count)
+{
+    uint32_t c, i;
+
+    printf("Append, %u records per case, %u rows of %u records\n",
+           count, EVENT_LOG_ROWS, (unsigned)EVENT_LOG_RECORDS_PER_ROW);
+    printf("case            Mrec/s   rows/1000 rec   wear min/max   "
+           "band CPU s/1000 rec   rows worn out after\n");
+
+    for(c = 0u; c < sizeof(benchCases) / sizeof(benchCases[0]); ++c)
+    {
+        const BENCH_CASE_T *bc = &benchCases[c];
+        uint32_t seconds = 0u;
+        uint32_t writes, min, max;
+        double start, elapsed, perThousand;
+
+        SimFlashErase();
+        EventLogStart(seconds);
+        start = NowSeconds();
+        for(i = 1u; i < count; ++i)
+        {
+            seconds += bc->gapS;
+            EventLogAppend((bc->alertEvery != 0u && i % bc->alertEvery == 0u) ?
+                           EVENT_LOG_ALERT : EVENT_LOG_GESTURE, (uint8)(i & 0x07u), seconds);
+            EventLogService(seconds, 1u);
+        }
+        elapsed = NowSeconds() - start;
+
+        writes = SimFlashStats()->writes;
+        RowWriteSpread(&min, &max);
+        perThousand = 1000.0 * writes / count;
+        printf("%-14s %7.2f %15.1f %8u/%-8u %14.2f %17.3g rec\n", bc->name,
+               count / elapsed / 1e6, perThousand, min, max,
+               perThousand * FLASH_ROW_MS / 1000.0,
+               FLASH_ENDURANCE * EVENT_LOG_ROWS * 1000.0 / perThousand);
+    }
+}
+
+/*******************************************************************************
+* Recovery
+*******************************************************************************/
+static void BenchRecovery(void)
+{
+    uint32_t seconds = 0u;
+    uint32_t i;
+    double start, elapsed;
+
+    SimFlashErase();
+    EventLogStart(seconds);
+    for(i = 0u; i < EVENT_LOG_ROWS * EVENT_LOG_RECORDS_PER_ROW * 2u; ++i)
+    {
+        EventLogAppend(EVENT_LOG_GESTURE, 1u, ++seconds);
+        EventLogService(seconds, 1u);
+    }
+
+    start = NowSeconds();
+    for(i = 0u; i < RECOVERY_ROUNDS; ++i)
+    {
+        EventLogStart(seconds);
+    }
+    elapsed = NowSeconds() - start;
+
+    printf("\nRecovery of a full log (%u rows, %u records): %.2f us per boot, "
+           "%.0f boots/s\n", EVENT_LOG_ROWS,
+           (unsigned)(EventLogEnd(0) - EventLogOldest()),
+           elapsed * 1e6 / RECOVERY_ROUNDS, RECOVERY_ROUNDS / elapsed);
+}
+
+/*******************************************************************************
+* Power-fail
+*******************************************************************************/
+typedef struct
+{
+    uint32_t    cuts;
+    uint32_t    tornRows;       // Found by EventLogStart after a cut
+    uint32_t    whole;          // Cuts so late the row was complete anyway
+    uint64_t    checked;        // Committed records read back
+    uint32_t    failures;
+} BENCH_FAULT_T;
+
+static int SameRecord(const EVENT_LOG_RECORD_T *a, const EVENT_LOG_RECORD_T *b)
+{
+    return a->type == b->type && a->code == b->code &&
+           a->boot == b->boot && a->seconds == b->seconds;
+}
+
+/*  After a reboot: the committed records are all there, and unchanged. The
+ * cut row may still read back whole (cut in its last bytes, the CRC matches
+ * by chance), then it holds the records staged before the cut */
+static void Verify(BENCH_FAULT_T *fault, const EVENT_LOG_RECORD_T *shadow,
+                   uint32_t durable, uint32_t staged, uint32_t trial)
+{
+    EVENT_LOG_RECORD_T record;
+    uint32_t oldest = EventLogOldest();
+    uint32_t end = EventLogEnd(1);
+    uint32_t keep = (durable < EVENT_LOG_RECORDS_PER_ROW) ? durable : EVENT_LOG_RECORDS_PER_ROW;
+    uint32_t n;
+
+    fault->tornRows += GetEventLogStats()->badRows;
+    if(end < durable || end > staged || durable - oldest < keep)
+    {
+        printf("trial %u: log ends at %u (oldest %u), %u records were committed\n",
+               trial, end, oldest, durable);
+        ++fault->failures;
+        return;
+    }
+    if(end != durable)
+    {
+        ++fault->whole;
+    }
+    for(n = oldest; n < end; ++n)
+    {
+        ++fault->checked;
+        if(!EventLogRead(n, &record) || !SameRecord(&record, &shadow[n]))
+        {
+            printf("trial %u: record %u lost or changed\n", trial, n);
+            ++fault->failures;
+            return;
+        }
+    }
+    if(!EventLogRead(end, &record) || record.type != EVENT_LOG_BOOT)
+    {
+        printf("trial %u: no boot record after the cut\n", trial);
+        ++fault->failures;
+    }
+}
+
+static void BenchPowerFail(uint32_t trials, BENCH_FAULT_T *fault)
+{
+    static EVENT_LOG_RECORD_T shadow[TRIAL_STEPS * 2u + 2u];
+    uint32_t trial, step;
+
+    memset(fault, 0, sizeof(*fault));
+    for(trial = 0u; trial < trials; ++trial)
+    {
+        uint32_t seconds = 0u;
+        uint32_t durable = 0u;
+
+        SimFlashErase();
+        powerLost = 0;
+        EventLogStart(seconds);
+        EventLogRead(EventLogEnd(0) - 1u, &shadow[EventLogEnd(0) - 1u]);
+        SimFlashTearAt(1u + Random() % TRIAL_TEAR_MAX, Random());
+
+        for(step = 0u; step < TRIAL_STEPS; ++step)
+        {
+            uint8 type = (Random() % 6u == 0u) ? EVENT_LOG_ALERT : EVENT_LOG_GESTURE;
+            uint32_t dropped = GetEventLogStats()->dropped;
+
+            seconds += Random() % 300u;
+            EventLogAppend(type, (uint8)Random(), seconds);
+            if(!powerLost)
+            {
+                if(GetEventLogStats()->dropped == dropped)
+                {
+                    EventLogRead(EventLogEnd(0) - 1u, &shadow[EventLogEnd(0) - 1u]);
+                }
+                durable = EventLogEnd(1);
+                EventLogService(seconds, (Random() % 4u) != 0u);
+            }
+
+            if(powerLost)
+            {
+                /* Reboot: the RAM is gone, only the flash is left */
+                uint32_t staged = EventLogEnd(0);
+
+                ++fault->cuts;
+                powerLost = 0;
+                seconds = 0u;
+                EventLogStart(seconds);
+                Verify(fault, shadow, durable, staged, trial);
+                EventLogRead(EventLogEnd(0) - 1u, &shadow[EventLogEnd(0) - 1u]);
+                SimFlashTearAt(1u + Random() % TRIAL_TEAR_MAX, Random());
+            }
+            durable = EventLogEnd(1);
+        }
+    }
+}
+
+/*******************************************************************************
+* Reserve
+*******************************************************************************/
+typedef struct
+{
+    uint32_t    reserves;
+    uint32_t    refused;        // Reported as not in flash
+    uint32_t    reboots;
+    uint32_t    failures;
+} BENCH_RESERVE_T;
+
+/*  Appends, EventLogReserve calls and reboots, with row writes failing in
+ * runs. A boot number reported in flash is used by adv_auth.c for a block
+ * of counters: a new one has to be above every number handed out before,
+ * across reboots too, and the same number comes back until a new one is
+ * asked for */
+static void BenchReserve(uint32_t trials, BENCH_RESERVE_T *reserve)
+{
+    uint32_t trial, step;
+
+    memset(reserve, 0, sizeof(*reserve));
+    for(trial = 0u; trial < trials; ++trial)
+    {
+        uint32_t seconds = 0u;
+        uint32_t used = 0u;         // Highest number handed out, + 1
+        uint32_t last = 0u;
+        int fresh = 1;              // A number above used is due
+
+        SimFlashErase();
+        powerLost = 0;
+        failWrites = 0u;
+        EventLogStart(seconds);
+
+        for(step = 0u; step < TRIAL_STEPS; ++step)
+        {
+            uint32_t roll = Random() % 16u;
+            uint16 boot;
+
+            seconds += Random() % 120u;
+            if(roll < 6u)
+            {
+                EventLogAppend(EVENT_LOG_GESTURE, (uint8)Random(), seconds);
+                EventLogService(seconds, 1u);
+            }
+            else if(roll < 12u)
+            {
+                uint8 next = (uint8)(Random() & 1u);
+
+                ++reserve->reserves;
+                fresh |= next;
+                if(!EventLogReserve(next, seconds, &boot))
+                {
+                    ++reserve->refused;
+                    continue;
+                }
+                if(fresh ? (boot < used) : (boot != last))
+                {
+                    printf("trial %u: boot number %u handed out again (up to %u used)\n",
+                           trial, boot, used - 1u);
+                    ++reserve->failures;
+                    break;
+                }
+                last = boot;
+                used = (boot + 1u > used) ? boot + 1u : used;
+                fresh = 0;
+            }
+            else if(roll < 15u)
+            {
+                failWrites = 1u + Random() % 4u;
+            }
+            else
+            {
+                /* Reset: whatever was staged is gone */
+                ++reserve->reboots;
+                seconds = 0u;
+                EventLogStart(seconds);
+                fresh = 1;
+            }
+        }
+    }
+    failWrites = 0u;
+}
+
+/*******************************************************************************
+* Main
+*******************************************************************************/
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-n records] [-t trials] [-s seed]\n"
+        "  -n  records per append case (default %u)\n"
+        "  -t  power-fail and reserve trials (default %u)\n"
+        "  -s  random seed (default 1)\n",
+        name, DEFAULT_RECORDS, DEFAULT_TRIALS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = DEFAULT_RECORDS;
+    uint32_t trials = DEFAULT_TRIALS;
+    BENCH_FAULT_T fault;
+    BENCH_RESERVE_T reserve;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:t:s:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': count = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 't': trials = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': rng = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if(count < 2u)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    BenchAppend(count);
+    BenchRecovery();
+    BenchPowerFail(trials, &fault);
+    BenchReserve(trials, &reserve);
+
+    printf("\nPower-fail, %u trials: %u cuts, %u torn rows found on boot, "
+           "%u read back whole, %llu committed records read back, %u failures\n",
+           trials, fault.cuts, fault.tornRows, fault.whole,
+           (unsigned long long)fault.checked, fault.failures);
+    printf("Reserve with failing writes, %u trials: %u reserves, %u not in flash, "
+           "%u reboots, %u failures\n",
+           trials, reserve.reserves, reserve.refused, reserve.reboots, reserve.failures);
+    return (fault.failures == 0u && reserve.failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,376 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    mfc_payload_test.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Encode / decode round trips of the Manfc. Data payload
+ * @author  prisma.ai
+ *
+ *  Runs mfc_payload.c on its own:
+ *      round trip  every presses / flags / seq of both versions, with a few
+ *                  uptimes and random counters / tags, has to decode to
+ *                  what was encoded
+ *      edges       presses saturate at MFC_PRESSES_MAX, seq is taken modulo
+ *                  128, the uptime wraps, other versions go out as version
+ *                  1, short buffers and unknown versions don't decode
+ *      auth        the AES input layout, MfcAuthHashRows against the
+ *                  tables of MfcAuthHash on random payloads
+ *      find        MfcPayloadFind on good packets, then on malformed ones:
+ *                  zero length and truncated AD structures, then on random
+ *                  bytes, where an index it returns has to be in the packet
+ *  Any failure fails the run.
+ *
+ *  mfc_payload_test [-n packets] [-s seed]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "mfc_payload.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_PACKETS         (1u << 20)
+#define ADV_DATA_LEN_MAX        (31u)
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static uint32_t rng = 1u;
+static uint32_t checks = 0u;
+static uint32_t failures = 0u;
+
+/* Uptimes around the byte and the 16 bit boundaries */
+static const uint16_t uptimes[] = { 0u, 1u, 0xFFu, 0x100u, 0x7FFFu, 0xFFFEu, 0xFFFFu };
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32_t Random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void Check(int ok, const char *what, uint32_t value)
+{
+    ++checks;
+    if(!ok)
+    {
+        printf("%s (%u)\n", what, value);
+        ++failures;
+    }
+}
+
+static int SamePayload(const MFC_PAYLOAD_T *a, const MFC_PAYLOAD_T *b)
+{
+    return a->version == b->version && a->presses == b->presses &&
+           a->flags == b->flags && a->seq == b->seq &&
+           a->uptimeMinutes == b->uptimeMinutes &&
+           a->counter == b->counter && a->tag == b->tag;
+}
+
+/*  Encodes, checks the length, decodes from exactly that many bytes and
+ * returns what came out */
+static void RoundTrip(const MFC_PAYLOAD_T *in, MFC_PAYLOAD_T *out)
+{
+    uint8_t data[MFC_PAYLOAD_AUTH_LEN];
+    uint8_t length = MfcPayloadEncode(data, in);
+
+    Check(length == ((in->version == MFC_PAYLOAD_VERSION_AUTH) ?
+                     MFC_PAYLOAD_AUTH_LEN : MFC_PAYLOAD_LEN),
+          "encoded length", length);
+    memset(out, 0xA5, sizeof(*out));
+    Check(MfcPayloadDecode(data, length, out) == 0, "decode failed, version", in->version);
+}
+
+/*******************************************************************************
+* Cases
+*******************************************************************************/
+static void TestRoundTrip(void)
+{
+    MFC_PAYLOAD_T in, out;
+    uint8_t version, presses, flags, seq;
+    uint32_t u;
+
+    for(version = MFC_PAYLOAD_VERSION; version <= MFC_PAYLOAD_VERSION_AUTH; ++version)
+    {
+        for(presses = 0u; presses <= MFC_PRESSES_MAX; ++presses)
+        {
+            for(flags = 0u; flags <= MFC_FLAG_PAIRING; ++flags)
+            {
+                for(seq = 0u; seq <= MFC_SEQ_MASK; ++seq)
+                {
+                    for(u = 0u; u < sizeof(uptimes) / sizeof(uptimes[0]); ++u)
+                    {
+                        in.version = version;
+                        in.presses = presses;
+                        in.flags = flags;
+                        in.seq = seq;
+                        in.uptimeMinutes = uptimes[u];
+                        in.counter = (version == MFC_PAYLOAD_VERSION_AUTH) ? Random() : 0u;
+                        in.tag = (version == MFC_PAYLOAD_VERSION_AUTH) ? Random() : 0u;
+                        RoundTrip(&in, &out);
+                        Check(SamePayload(&in, &out), "round trip, seq", seq);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void TestEdges(void)
+{
+    static const uint8_t otherVersions[] = { 0u, 3u, 15u, 0xF2u };
+    MFC_PAYLOAD_T in, out;
+    uint8_t data[MFC_PAYLOAD_AUTH_LEN + 1u];
+    uint32_t presses, seq, minutes, i;
+    uint8_t length, version;
+
+    memset(&in, 0, sizeof(in));
+    in.version = MFC_PAYLOAD_VERSION_AUTH;
+    in.counter = 0xFFFFFFFFu;
+    in.tag = 0x80000001u;
+
+    /* Presses saturate, they don't wrap into the version nibble */
+    for(presses = MFC_PRESSES_MAX; presses <= 0xFFu; ++presses)
+    {
+        in.presses = (uint8_t)presses;
+        RoundTrip(&in, &out);
+        Check(out.presses == MFC_PRESSES_MAX && out.version == in.version,
+              "presses not saturated", presses);
+    }
+    in.presses = 1u;
+
+    /* seq is 7 bit, flags other than MFC_FLAG_PAIRING are dropped */
+    for(seq = 0u; seq <= 0xFFu; ++seq)
+    {
+        in.seq = (uint8_t)seq;
+        in.flags = (uint8_t)(0xFEu | (seq & 1u));
+        RoundTrip(&in, &out);
+        Check(out.seq == (seq & MFC_SEQ_MASK) && out.flags == (seq & 1u),
+              "seq / flags, seq", seq);
+    }
+
+    /* Uptime wraps at 65536 minutes, as the firmware truncates it */
+    for(minutes = 0xFFF0u; minutes <= 0x10010u; ++minutes)
+    {
+        in.uptimeMinutes = (uint16_t)minutes;
+        RoundTrip(&in, &out);
+        Check(out.uptimeMinutes == (minutes & 0xFFFFu), "uptime, minutes", minutes);
+    }
+
+    /* Other versions go out as version 1, without counter and tag */
+    for(i = 0u; i < sizeof(otherVersions); ++i)
+    {
+        in.version = otherVersions[i];
+        length = MfcPayloadEncode(data, &in);
+        Check(length == MFC_PAYLOAD_LEN && (data[0] & 0x0Fu) == MFC_PAYLOAD_VERSION,
+              "version not written as 1", otherVersions[i]);
+    }
+
+    /* Short buffers: version 1 needs MFC_PAYLOAD_LEN bytes, version 2
+     * MFC_PAYLOAD_AUTH_LEN, more is fine */
+    for(version = MFC_PAYLOAD_VERSION; version <= MFC_PAYLOAD_VERSION_AUTH; ++version)
+    {
+        in.version = version;
+        length = MfcPayloadEncode(data, &in);
+        data[length] = 0xFFu;
+        for(i = 0u; i <= length + 1u; ++i)
+        {
+            Check((MfcPayloadDecode(data, (uint8_t)i, &out) == 0) == (i >= length),
+                  (version == MFC_PAYLOAD_VERSION) ? "v1 decode, length" : "v2 decode, length", i);
+        }
+    }
+
+    /* Unknown versions don't decode, whatever the length */
+    for(version = 0u; version <= 0x0Fu; ++version)
+    {
+        if(version == MFC_PAYLOAD_VERSION || version == MFC_PAYLOAD_VERSION_AUTH)
+        {
+            continue;
+        }
+        memset(data, 0, sizeof(data));
+        data[0] = (uint8_t)(version | 0x40u);
+        Check(MfcPayloadDecode(data, sizeof(data), &out) != 0, "unknown version decoded", version);
+    }
+}
+
+static void TestAuth(uint32_t payloads)
+{
+    static const uint8_t addr[MFC_AUTH_ADDR_LEN] = { 0x01u, 0x02u, 0x03u, 0x04u, 0x5Au, 0xC0u };
+    uint8_t rows[MFC_AUTH_HASH_BLOCKS * MFC_AUTH_BLOCK_LEN];
+    uint8_t in[MFC_AUTH_BLOCK_LEN];
+    uint8_t payload[MFC_PAYLOAD_LEN];
+    MFC_AUTH_HASH_T hash;
+    uint32_t n, i;
+
+    /* Domain, index, address, every other byte 0 */
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_KEYSTREAM, addr, 0x89ABCDEFu);
+    Check(in[0] == MFC_AUTH_DOMAIN_KEYSTREAM && in[1] == 0u && in[2] == 0u && in[3] == 0u &&
+          in[4] == 0xEFu && in[5] == 0xCDu && in[6] == 0xABu && in[7] == 0x89u &&
+          memcmp(&in[8], addr, MFC_AUTH_ADDR_LEN) == 0 && in[14] == 0u && in[15] == 0u,
+          "block input layout", in[0]);
+
+    /* The tables and the rows give the same hash */
+    for(i = 0u; i < sizeof(rows); ++i)
+    {
+        rows[i] = (uint8_t)Random();
+    }
+    MfcAuthHashInit(&hash, rows);
+    for(n = 0u; n < payloads; ++n)
+    {
+        uint32_t r = Random();
+
+        memcpy(payload, &r, sizeof(payload));
+        Check(MfcAuthHash(&hash, payload) == MfcAuthHashRows(rows, payload),
+              "hash from rows, payload", r);
+    }
+}
+
+/*  Appends an AD structure, returns the new length */
+static uint8_t PutAd(uint8_t *adv, uint8_t at, uint8_t type, const uint8_t *data, uint8_t length)
+{
+    adv[at] = (uint8_t)(1u + length);
+    adv[at + 1u] = type;
+    memcpy(&adv[at + 2u], data, length);
+    return (uint8_t)(at + 2u + length);
+}
+
+static void TestFind(uint32_t packets)
+{
+    static const uint8_t flags[] = { 0x06u };
+    static const uint8_t name[] = { 'B', 'a', 'n', 'd' };
+    uint8_t mfc[2u + MFC_PAYLOAD_AUTH_LEN];
+    uint8_t adv[ADV_DATA_LEN_MAX + 2u];
+    uint8_t length, at, payloadLen;
+    uint32_t n;
+    int index;
+
+    mfc[0] = (uint8_t)(MFC_COMPANY_ID & 0xFFu);
+    mfc[1] = (uint8_t)(MFC_COMPANY_ID >> 8);
+    memset(&mfc[2], 0x11u, MFC_PAYLOAD_AUTH_LEN);
+
+    /* Good packet: flags, name, Manfc. Data */
+    length = PutAd(adv, 0u, 0x01u, flags, sizeof(flags));
+    length = PutAd(adv, length, 0x09u, name, sizeof(name));
+    at = length;
+    length = PutAd(adv, length, MFC_AD_TYPE, mfc, sizeof(mfc));
+    payloadLen = 0u;
+    index = MfcPayloadFind(adv, length, &payloadLen);
+    Check(index == at + 4 && payloadLen == MFC_PAYLOAD_AUTH_LEN, "find, index", (uint32_t)index);
+    Check(MfcPayloadFind(adv, length, NULL) == index, "find without payloadLen", 0u);
+
+    /* Cut anywhere into the Manfc. Data, the structure runs past the end */
+    for(n = 0u; n < length; ++n)
+    {
+        Check(MfcPayloadFind(adv, (uint8_t)n, &payloadLen) == -1, "truncated, length", n);
+    }
+
+    /* Payload shorter than MFC_PAYLOAD_LEN */
+    length = PutAd(adv, at, MFC_AD_TYPE, mfc, 2u + MFC_PAYLOAD_LEN - 1u);
+    Check(MfcPayloadFind(adv, length, NULL) == -1, "short payload found", length);
+
+    /* Another company first, ours after it */
+    mfc[0] ^= 0x01u;
+    length = PutAd(adv, at, MFC_AD_TYPE, mfc, sizeof(mfc));
+    mfc[0] ^= 0x01u;
+    length = PutAd(adv, length, MFC_AD_TYPE, mfc, 2u + MFC_PAYLOAD_LEN);
+    index = MfcPayloadFind(adv, length, &payloadLen);
+    Check(index == (int)(length - MFC_PAYLOAD_LEN) && payloadLen == MFC_PAYLOAD_LEN,
+          "second Manfc. Data, index", (uint32_t)index);
+
+    /* A zero length ends the significant part, nothing after it is read */
+    adv[0] = 0u;
+    Check(MfcPayloadFind(adv, length, NULL) == -1, "found after a zero length", 0u);
+    Check(MfcPayloadFind(adv, 0u, NULL) == -1, "found in an empty packet", 0u);
+
+    /* A length running past the end, and one byte short of a header */
+    adv[0] = 0xFFu;
+    Check(MfcPayloadFind(adv, length, NULL) == -1, "found after length 0xFF", 0u);
+    adv[0] = 0x02u;
+    Check(MfcPayloadFind(adv, 1u, NULL) == -1, "found in a 1 byte packet", 0u);
+
+    /* Random bytes: whatever is found is a whole Manfc. Data of ours, in
+     * the packet */
+    for(n = 0u; n < packets; ++n)
+    {
+        uint8_t i;
+
+        length = (uint8_t)(Random() % (ADV_DATA_LEN_MAX + 1u));
+        for(i = 0u; i < length; ++i)
+        {
+            uint32_t r = Random();
+
+            /* Small lengths and our type / company ID often enough to matter */
+            adv[i] = (r & 0x100u) ? (uint8_t)(r % 16u) : (r & 0x200u) ? 0xFFu : (uint8_t)r;
+        }
+        payloadLen = 0xEEu;
+        index = MfcPayloadFind(adv, length, &payloadLen);
+        if(index != -1)
+        {
+            Check(index >= 4 && index + payloadLen <= length &&
+                  payloadLen >= MFC_PAYLOAD_LEN &&
+                  adv[index - 3] == MFC_AD_TYPE &&
+                  adv[index - 4] == 1u + MFC_COMPANY_ID_LEN + payloadLen,
+                  "random packet, index", (uint32_t)index);
+        }
+        else
+        {
+            Check(payloadLen == 0xEEu, "payloadLen set on -1", n);
+        }
+    }
+}
+
+/*******************************************************************************
+* Main
+*******************************************************************************/
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-n packets] [-s seed]\n"
+        "  -n  random packets for MfcPayloadFind and hashes (default %u)\n"
+        "  -s  random seed (default 1)\n",
+        name, DEFAULT_PACKETS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t packets = DEFAULT_PACKETS;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:s:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': packets = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': rng = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    TestRoundTrip();
+    TestEdges();
+    TestAuth(packets);
+    TestFind(packets);
+
+    printf("%u checks, %u failures\n", checks, failures);
+    printf("%s\n", (failures == 0u) ? "OK" : "FAIL");
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
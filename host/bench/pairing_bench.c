@@ -0,0 +1,337 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    pairing_bench.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Time to connect and charge of a pairing attempt on the simulator
+ * @author  prisma.ai
+ *
+ *  Every trial presses the pairing gesture on an idle band (after IDLE_MS,
+ * like alert_latency.c) while a phone starts scanning for it, and runs
+ * twice in forked children (the firmware keeps its state in globals):
+ *      with the gesture    => when the phone connected, and the charge
+ *                             drawn up to then, or up to HORIZON_MS after
+ *                             the gesture if it never did
+ *      without it          => the charge drawn up to the same time
+ * The charge of the attempt is the difference: what the pairing window and
+ * the way back to the idle profile cost. HORIZON_MS covers the longest way
+ * back (ADV_PAIRING_MS, then ADV_DECAY_MS and ADV_IDLE_MS without
+ * ADV_FAST_PAIRING). Time to connect counts from the last press.
+ *
+ *  The phones scan like the GAP connection establishment timers of the
+ * Core spec: 30 ms every 60 ms with the app open, 11.25 ms every 1.28 s in
+ * the background, from a random phase.
+ *
+ *  pairing_bench [-n trials] [-r seed]
+ *
+ *  Built twice by "make pairing", against the firmware with and without
+ * ADV_FAST_PAIRING.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "adv_sched.h"
+#include "button_func.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_TRIALS          (200u)
+#define DEFAULT_SEED            (1u)
+
+#define RIGHT_PIN               (0x02u)
+
+#define IDLE_MS                 (75000u)    // Before the first press
+#define PHASE_MS                (3000u)     // Random extra delay of the first press
+#define PRESS_HOLD_MS           (150u)
+#define PRESS_GAP_MS            (400u)
+#define HORIZON_MS              (80000u)    // After the last press
+
+/*******************************************************************************
+* Phones
+*******************************************************************************/
+typedef struct
+{
+    const char  *name;
+    uint8       present;
+    uint8       bonded;         // In the band's bond list
+    double      windowMs;       // Scans this long ...
+    double      intervalMs;     // ... out of this
+} PAIRING_CASE_T;
+
+static const PAIRING_CASE_T cases[] =
+{
+    { "no phone",           0u, 0u,  0.0,     0.0 },
+    { "bonded, away",       0u, 1u,  0.0,     0.0 },
+    { "app open",           1u, 0u, 30.0,    60.0 },
+    { "background",         1u, 0u, 11.25, 1280.0 },
+    { "bonded, app open",   1u, 1u, 30.0,    60.0 },
+    { "bonded, background", 1u, 1u, 11.25, 1280.0 },
+};
+
+#define CASE_COUNT              (sizeof(cases) / sizeof(cases[0]))
+
+/* What a run sends back to the parent */
+typedef struct
+{
+    int         ok;
+    uint32      connections;
+    uint64_t    connectNs;
+    double      connectCharge;      // uA * ns
+    double      chargeAt;           // uA * ns
+} PAIRING_RUN_T;
+
+static SIM_SCENARIO_T scenario;
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32 NextRandom(uint32 *state)
+{
+    /* xorshift32, same as the simulator */
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* Fills the scenario, returns the time of the last press */
+static uint64_t BuildPresses(uint32 seed, uint32 *rng)
+{
+    uint64_t startNs;
+    uint32 i;
+
+    *rng = seed * 2654435761u | 1u;
+    startNs = (uint64_t)IDLE_MS * SIM_NS_PER_MS +
+              (uint64_t)(NextRandom(rng) % (PHASE_MS * 1000u)) * SIM_NS_PER_US;
+
+    scenario.name = "pairing";
+    scenario.pressCount = PAIRING_MODE_PRESS_NO;
+    for(i = 0u; i < PAIRING_MODE_PRESS_NO; ++i)
+    {
+        SIM_PRESS_T *press = &scenario.presses[i];
+
+        press->timeNs = startNs + (uint64_t)i * PRESS_GAP_MS * SIM_NS_PER_MS;
+        press->holdNs = (uint64_t)PRESS_HOLD_MS * SIM_NS_PER_MS;
+        press->pins = RIGHT_PIN;
+    }
+    return scenario.presses[PAIRING_MODE_PRESS_NO - 1u].timeNs;
+}
+
+/* Runs in the child: one simulator run */
+static PAIRING_RUN_T Run(const SIM_CONFIG_T *config, uint64_t durationNs)
+{
+    PAIRING_RUN_T run;
+    const SIM_STATS_T *stats = SimRun(config, &scenario, durationNs, 0);
+
+    run.ok = 1;
+    run.connections = stats->connections;
+    run.connectNs = stats->connectNs;
+    run.connectCharge = stats->connectCharge;
+    run.chargeAt = stats->chargeAt;
+    return run;
+}
+
+static int ForkRun(const SIM_CONFIG_T *config, uint64_t durationNs,
+                   PAIRING_RUN_T *result)
+{
+    int fds[2];
+    int status;
+    pid_t pid;
+
+    if(pipe(fds) != 0)
+    {
+        return -1;
+    }
+    pid = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if(pid == 0)
+    {
+        PAIRING_RUN_T run = Run(config, durationNs);
+        ssize_t written = write(fds[1], &run, sizeof(run));
+        _exit(written == (ssize_t)sizeof(run) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    if(read(fds[0], result, sizeof(*result)) != (ssize_t)sizeof(*result))
+    {
+        result->ok = 0;
+    }
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return (!result->ok || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != EXIT_SUCCESS) ? -1 : 0;
+}
+
+/*  One trial: time to connect (negative if the phone never did) and the
+ * charge of the attempt in uC */
+static int RunTrial(const PAIRING_CASE_T *c, uint32 seed, double *connectMs,
+                    double *chargeUc)
+{
+    SIM_CONFIG_T config;
+    PAIRING_RUN_T with, without;
+    uint32 rng;
+    uint64_t pressNs = BuildPresses(seed, &rng);
+    uint64_t markNs = pressNs + (uint64_t)HORIZON_MS * SIM_NS_PER_MS;
+    double charge;
+
+    SimConfigDefaults(&config);
+    config.seed = (double)seed;
+    if(c->present)
+    {
+        config.connectAtMs = (double)pressNs / SIM_NS_PER_MS;
+        config.scanWindowMs = c->windowMs;
+        config.scanIntervalMs = c->intervalMs;
+        config.scanPhaseMs = (double)(NextRandom(&rng) % (uint32)(c->intervalMs * 1000.0)) /
+                             1000.0;
+    }
+    config.centralBonded = c->bonded;
+    config.chargeAtMs = (double)markNs / SIM_NS_PER_MS;
+    if(ForkRun(&config, markNs + SIM_NS_PER_S, &with) != 0)
+    {
+        return -1;
+    }
+
+    if(with.connections != 0u)
+    {
+        markNs = with.connectNs;
+        charge = with.connectCharge;
+        *connectMs = (double)(with.connectNs - pressNs) / SIM_NS_PER_MS;
+    }
+    else
+    {
+        charge = with.chargeAt;
+        *connectMs = -1.0;
+    }
+
+    /* Same band, same seed, no gesture and no phone */
+    scenario.pressCount = 0u;
+    config.connectAtMs = 0.0;
+    config.chargeAtMs = (double)markNs / SIM_NS_PER_MS;
+    if(ForkRun(&config, markNs + SIM_NS_PER_S, &without) != 0)
+    {
+        return -1;
+    }
+    *chargeUc = (charge - without.chargeAt) / 1e9;
+    return 0;
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static double Percentile(const double *sorted, uint32 count, double p)
+{
+    uint32 rank;
+
+    if(count == 0u)
+    {
+        return 0.0;
+    }
+    rank = (uint32)(p / 100.0 * count + 0.999999);
+    rank = (rank == 0u) ? 1u : (rank > count ? count : rank);
+    return sorted[rank - 1u];
+}
+
+static void Usage(const char *self)
+{
+    fprintf(stderr,
+        "usage: %s [-n trials] [-r seed]\n"
+        "  -n  trials per case (default %u)\n"
+        "  -r  first seed (default %u)\n",
+        self, DEFAULT_TRIALS, DEFAULT_SEED);
+}
+
+int main(int argc, char **argv)
+{
+    uint32 trials = DEFAULT_TRIALS;
+    uint32 seed = DEFAULT_SEED;
+    double *samples;
+    uint32 i, t;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:r:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                trials = (uint32)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                seed = (uint32)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(trials == 0u)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    samples = malloc(trials * sizeof(*samples));
+    if(samples == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("Pairing attempts, ADV_FAST_PAIRING %s, %u trials per case\n",
+           ADV_FAST_PAIRING ? "on" : "off", trials);
+    printf("%-20s %10s %9s %9s %9s %12s\n", "phone", "connected",
+           "p50 ms", "p90 ms", "max ms", "charge uC");
+
+    for(i = 0u; i < CASE_COUNT; ++i)
+    {
+        uint32 count = 0u;
+        double charge = 0.0;
+
+        for(t = 0u; t < trials; ++t)
+        {
+            double connectMs, chargeUc;
+
+            if(RunTrial(&cases[i], seed + t, &connectMs, &chargeUc) != 0)
+            {
+                fprintf(stderr, "%s: trial %u failed\n", cases[i].name, t);
+                free(samples);
+                return EXIT_FAILURE;
+            }
+            if(connectMs >= 0.0)
+            {
+                samples[count++] = connectMs;
+            }
+            charge += chargeUc;
+        }
+
+        qsort(samples, count, sizeof(*samples), CompareDouble);
+        printf("%-20s %9.1f%% %9.1f %9.1f %9.1f %12.1f\n", cases[i].name,
+               100.0 * count / trials, Percentile(samples, count, 50.0),
+               Percentile(samples, count, 90.0),
+               (count != 0u) ? samples[count - 1u] : 0.0, charge / trials);
+    }
+    free(samples);
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,152 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    press_queue_stress.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Interrupt-injection stress run of the press queue
+ * @author  prisma.ai
+ *
+ *  A POSIX timer signal plays the button / WDT interrupt: it preempts the
+ * "main loop" at arbitrary instructions and pushes sequence-numbered
+ * presses, while the main loop drains in batches (sometimes slowly, to
+ * force overflows). Every press must come out exactly once, in order, or
+ * be accounted for as dropped.
+ *
+ *  press_queue_stress [seconds] [period_us]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "press_queue.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_SECONDS         (5.0)
+#define DEFAULT_PERIOD_US       (20l)
+#define SLOW_DRAIN_EVERY        (64u)   // Every Nth batch stalls the consumer
+#define SLOW_DRAIN_SPINS        (20000u)
+
+/*******************************************************************************
+* Variables shared with the "interrupt"
+*******************************************************************************/
+static volatile uint32 produced = 0;        // Presses offered to the queue
+static volatile uint32 accepted = 0;        // Presses the queue took
+static volatile uint8 maxFill = 0;
+
+static void InjectInterrupt(int signo)
+{
+    (void)signo;
+
+    /* Two presses per interrupt, like a chord plus a bounce */
+    accepted += PressQueuePush(produced, (uint8)(produced % 3u));
+    ++produced;
+    accepted += PressQueuePush(produced, (uint8)(produced % 3u));
+    ++produced;
+}
+
+static double Seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : DEFAULT_SECONDS;
+    long periodUs = (argc > 2) ? atol(argv[2]) : DEFAULT_PERIOD_US;
+    struct sigaction action = { 0 };
+    struct sigevent sev = { 0 };
+    struct itimerspec spec = { 0 };
+    timer_t timer;
+    PRESS_EVENT_T event;
+    uint32 popped = 0u, batches = 0u, errors = 0u;
+    int64_t lastSeq = -1;
+    uint32 lastDropped = 0u;
+    double start, elapsed;
+
+    action.sa_handler = InjectInterrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGRTMIN, &action, NULL);
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGRTMIN;
+    timer_create(CLOCK_MONOTONIC, &sev, &timer);
+    spec.it_interval.tv_nsec = periodUs * 1000l;
+    spec.it_value.tv_nsec = periodUs * 1000l;
+    timer_settime(timer, 0, &spec, NULL);
+
+    start = Seconds();
+    while ((elapsed = Seconds() - start) < seconds)
+    {
+        uint32 batch = 0u;
+
+        while (PressQueuePop(&event))
+        {
+            /* Sequence numbers may only skip what the producer dropped */
+            uint32 dropped = PressQueueDropped();
+            int64_t skipped = (int64_t)event.timestamp - lastSeq - 1;
+
+            if (event.timestamp <= lastSeq ||
+                skipped > (int64_t)(dropped - lastDropped) ||
+                event.button != (uint8)(event.timestamp % 3u))
+            {
+                ++errors;
+            }
+            lastDropped += (uint32)skipped;
+            lastSeq = event.timestamp;
+            ++popped;
+            ++batch;
+        }
+        if (batch > maxFill)
+        {
+            maxFill = (uint8)batch;
+        }
+        if (++batches % SLOW_DRAIN_EVERY == 0u)
+        {
+            volatile uint32 spin;
+            for (spin = 0u; spin < SLOW_DRAIN_SPINS; ++spin)
+            {
+            }
+        }
+    }
+
+    spec.it_interval.tv_nsec = 0;
+    spec.it_value.tv_nsec = 0;
+    timer_settime(timer, 0, &spec, NULL);
+    while (PressQueuePop(&event))
+    {
+        ++popped;
+    }
+
+    printf("Interrupts injected   %u (%.0f /s)\n", produced / 2u,
+           produced / 2u / elapsed);
+    printf("Presses offered       %u\n", produced);
+    printf("Presses drained       %u\n", popped);
+    printf("Presses dropped       %u (queue of %u)\n",
+           PressQueueDropped(), PRESS_QUEUE_SIZE);
+    printf("Largest batch         %u\n", maxFill);
+    printf("Order / loss errors   %u\n", errors);
+
+    if (errors != 0u || popped != accepted ||
+        popped + PressQueueDropped() != produced)
+    {
+        printf("FAIL\n");
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
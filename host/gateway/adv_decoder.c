@@ -0,0 +1,332 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    adv_decoder.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Gateway side decoder of the band advertisements
+ * @author  prisma.ai
+ *
+ *  A gateway hears every band around it about 10 times a second, and most
+ * of what it hears isn't a band at all. So a record goes through the
+ * cheapest test that can reject it first:
+ *      1. the prefilter, a SIMD search for the AD type / company ID bytes
+ *      2. the AD structure walk (MfcPayloadFind)
+ *      3. the band table: a payload identical to the band's last one is a
+ *         duplicate, one hash probe and a 12 byte compare
+ *      4. only then the decode and, with a key, the tag check (one AES block,
+ *         and 9 more to derive the keys of a band not in the table yet)
+ *   The band table is an open addressing hash table owned by the caller.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#if defined(__SSE2__) && !defined(ADV_DECODER_SCALAR)
+#include <emmintrin.h>
+#define ADV_DECODER_SSE2            (1)
+#endif
+#include "adv_decoder.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define ADV_SLOT_USED               (1ull << 63)
+
+/* Bytes that start every band payload's AD structure, after its length */
+#define ADV_MATCH_0                 (MFC_AD_TYPE)
+#define ADV_MATCH_1                 (MFC_COMPANY_ID & 0xFFu)
+#define ADV_MATCH_2                 (MFC_COMPANY_ID >> 8)
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint64_t AddrKey(const uint8_t *addr)
+{
+    return ADV_SLOT_USED |
+           (uint64_t)addr[0] | ((uint64_t)addr[1] << 8) |
+           ((uint64_t)addr[2] << 16) | ((uint64_t)addr[3] << 24) |
+           ((uint64_t)addr[4] << 32) | ((uint64_t)addr[5] << 40);
+}
+
+/* Slot of a band, a free one if it isn't in the table (NULL when full) */
+static ADV_BAND_STATE_T *FindBand(ADV_DECODER_T *decoder, uint64_t key)
+{
+    uint32_t i = (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & decoder->mask;
+
+    for(;;)
+    {
+        ADV_BAND_STATE_T *band = &decoder->bands[i];
+
+        if(band->addr == key)
+        {
+            return band;
+        }
+        if(band->addr == 0u)
+        {
+            /* Keep a quarter of the table free, probes stay short */
+            if(decoder->used >= decoder->mask + 1u - ((decoder->mask + 1u) >> 2))
+            {
+                return NULL;
+            }
+            return band;
+        }
+        i = (i + 1u) & decoder->mask;
+    }
+}
+
+/* Key and hash rows of the band at addr, 9 AES blocks */
+static void DeriveBandKeys(const ADV_DECODER_T *decoder, const uint8_t *addr,
+                           ADV_BAND_KEYS_T *keys)
+{
+    uint8_t in[MFC_AUTH_BLOCK_LEN];
+    uint32_t i;
+
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_BAND_KEY, addr, 0u);
+    decoder->aes(in, decoder->master, keys->key);
+    for(i = 0u; i < MFC_AUTH_HASH_BLOCKS; ++i)
+    {
+        MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_HASH, addr, i);
+        decoder->aes(in, keys->key, &keys->rows[i * MFC_AUTH_BLOCK_LEN]);
+    }
+}
+
+/* Tag check of a version 2 payload heard from addr, 0 if it's forged */
+static int VerifyTag(const ADV_DECODER_T *decoder, const ADV_BAND_KEYS_T *keys,
+                     const uint8_t *addr, const uint8_t *data,
+                     const MFC_PAYLOAD_T *payload)
+{
+    uint8_t in[MFC_AUTH_BLOCK_LEN], block[MFC_AUTH_BLOCK_LEN];
+
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_KEYSTREAM, addr,
+                      payload->counter / MFC_AUTH_WORDS_PER_BLOCK);
+    decoder->aes(in, keys->key, block);
+    return (MfcAuthHashRows(keys->rows, data) ^
+            MfcAuthKeystreamWord(block, payload->counter)) == payload->tag;
+}
+
+/*******************************************************************************
+* @brief This function sets up a decoder over a caller owned band table.
+*
+* NOTE: nothing is allocated, here or while decoding. The table is cleared.
+*   Every band's key is derived from the master key and the address it is
+* heard from (mfc_payload.h), a payload sent under another address fails
+* its tag.
+*
+* @param ADV_DECODER_T* decoder:        The decoder
+* @param ADV_BAND_STATE_T* bands:       Table, one slot per band heard
+* @param uint32_t capacity:             Its size, a power of two
+* @param const uint8_t* key:            Master key of the fleet, or NULL to
+*                                      accept every payload unchecked
+* @param ADV_AES_FN_T aes:              AES-128, needed with a key
+*
+* @returns int:                         0 on success, -1 on bad arguments
+*******************************************************************************/
+int AdvDecoderInit(ADV_DECODER_T *decoder, ADV_BAND_STATE_T *bands,
+                   uint32_t capacity, const uint8_t *key, ADV_AES_FN_T aes)
+{
+    if(decoder == NULL || bands == NULL || capacity < 4u ||
+       (capacity & (capacity - 1u)) != 0u || (key != NULL && aes == NULL))
+    {
+        return -1;
+    }
+
+    memset(decoder, 0, sizeof(*decoder));
+    memset(bands, 0, capacity * sizeof(*bands));
+    decoder->bands = bands;
+    decoder->mask = capacity - 1u;
+
+    if(key != NULL)
+    {
+        memcpy(decoder->master, key, MFC_AUTH_KEY_LEN);
+        decoder->aes = aes;
+        decoder->verify = 1;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* @brief This function tells whether a record may carry a band payload.
+*
+*   True when the AD type and company ID bytes (0xFF 0xFF 0xFF) show up
+* anywhere in the data, checked 16 bytes at a time with SSE2 when built for
+* it (-DADV_DECODER_SCALAR forces the byte loop).
+*
+* @param const ADV_RECORD_T* record:    The record
+*
+* @returns int:                         0 if it surely doesn't
+*******************************************************************************/
+int AdvPrefilter(const ADV_RECORD_T *record)
+{
+    uint8_t length = (record->dataLen < ADV_RECORD_DATA_LEN) ?
+                     record->dataLen : (uint8_t)(ADV_RECORD_DATA_LEN - 1u);
+#if defined(ADV_DECODER_SSE2)
+    const __m128i lo = _mm_loadu_si128((const __m128i *)&record->data[0]);
+    const __m128i hi = _mm_loadu_si128((const __m128i *)&record->data[16]);
+    uint32_t m0, m1, m2;
+
+    /* Bit i of mN: data[i] is the Nth byte to match */
+    m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lo, _mm_set1_epi8((char)ADV_MATCH_0))) |
+         ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(hi, _mm_set1_epi8((char)ADV_MATCH_0))) << 16);
+    m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lo, _mm_set1_epi8((char)ADV_MATCH_1))) |
+         ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(hi, _mm_set1_epi8((char)ADV_MATCH_1))) << 16);
+    m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lo, _mm_set1_epi8((char)ADV_MATCH_2))) |
+         ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(hi, _mm_set1_epi8((char)ADV_MATCH_2))) << 16);
+
+    /* The three bytes in a row, inside the data */
+    return (m0 & (m1 >> 1) & (m2 >> 2) & ((1u << length) - 1u)) != 0u;
+#else
+    uint8_t i;
+
+    for(i = 0u; i + 2u < length; ++i)
+    {
+        if(record->data[i] == ADV_MATCH_0 && record->data[i + 1u] == ADV_MATCH_1 &&
+           record->data[i + 2u] == ADV_MATCH_2)
+        {
+            return 1;
+        }
+    }
+    return 0;
+#endif
+}
+
+/*******************************************************************************
+* @brief This function decodes a batch of records, keeping only the bands
+*       whose payload changed since their last record.
+*
+*   With a key, version 1 payloads, bad tags and replayed counters are
+* dropped (and counted) without touching the band's state.
+*
+* @param ADV_DECODER_T* decoder:        The decoder
+* @param const ADV_RECORD_T* records:   The batch
+* @param uint32_t count:                Records in the batch
+* @param ADV_EVENT_T* events:           Room for count events
+*
+* @returns uint32_t:                    Events written
+*******************************************************************************/
+uint32_t AdvDecodeBatch(ADV_DECODER_T *decoder, const ADV_RECORD_T *records,
+                        uint32_t count, ADV_EVENT_T *events)
+{
+    ADV_DECODER_STATS_T *stats = &decoder->stats;
+    uint32_t written = 0u;
+    uint32_t r;
+
+    stats->records += count;
+
+    for(r = 0u; r < count; ++r)
+    {
+        const ADV_RECORD_T *record = &records[r];
+        ADV_BAND_STATE_T *band;
+        ADV_BAND_KEYS_T keys;
+        const ADV_BAND_KEYS_T *bandKeys = &keys;
+        ADV_EVENT_T *event;
+        const uint8_t *data;
+        uint8_t length = 0u;
+        int index;
+
+        if(!AdvPrefilter(record))
+        {
+            ++stats->filtered;
+            continue;
+        }
+        index = MfcPayloadFind(record->data, (record->dataLen < ADV_RECORD_DATA_LEN) ?
+                               record->dataLen : (uint8_t)(ADV_RECORD_DATA_LEN - 1u),
+                               &length);
+        if(index < 0)
+        {
+            ++stats->foreign;
+            continue;
+        }
+        data = &record->data[index];
+        if((data[0] & 0x0Fu) == MFC_PAYLOAD_VERSION)
+        {
+            length = MFC_PAYLOAD_LEN;       // Telemetry may follow (adv_frames.h)
+        }
+        else if(length > MFC_PAYLOAD_AUTH_LEN)
+        {
+            length = MFC_PAYLOAD_AUTH_LEN;  // Room left by a later version
+        }
+
+        /* Same bytes as last time: nothing new from this band */
+        band = FindBand(decoder, AddrKey(record->addr));
+        if(band != NULL && band->addr != 0u && band->length == length &&
+           memcmp(band->last, data, length) == 0)
+        {
+            ++stats->duplicates;
+            continue;
+        }
+
+        event = &events[written];
+        if(MfcPayloadDecode(data, length, &event->payload) != 0)
+        {
+            ++stats->foreign;
+            continue;
+        }
+        event->authenticated = 0u;
+
+        if(decoder->verify)
+        {
+            if(event->payload.version != MFC_PAYLOAD_VERSION_AUTH)
+            {
+                ++stats->unsignedPayloads;
+                continue;
+            }
+            if(band != NULL && band->addr != 0u && band->length == MFC_PAYLOAD_AUTH_LEN &&
+               (uint32_t)(band->counter - event->payload.counter) < ADV_REPLAY_WINDOW)
+            {
+                ++stats->replays;
+                continue;
+            }
+            /* A band heard before has its keys in its slot, a new one
+             * costs deriving them */
+            if(band != NULL && band->addr != 0u)
+            {
+                bandKeys = &band->keys;
+            }
+            else
+            {
+                DeriveBandKeys(decoder, record->addr, &keys);
+            }
+            if(!VerifyTag(decoder, bandKeys, record->addr, data, &event->payload))
+            {
+                ++stats->authFailed;
+                continue;
+            }
+            event->authenticated = 1u;
+        }
+
+        if(band == NULL)
+        {
+            ++stats->tableFull;
+        }
+        else
+        {
+            if(band->addr == 0u)
+            {
+                band->addr = AddrKey(record->addr);
+                if(decoder->verify)
+                {
+                    band->keys = keys;
+                }
+                ++decoder->used;
+            }
+            band->counter = event->payload.counter;
+            band->length = length;
+            memcpy(band->last, data, length);
+        }
+
+        event->timeUs = record->timeUs;
+        memcpy(event->addr, record->addr, sizeof(event->addr));
+        event->rssi = record->rssi;
+        ++written;
+    }
+    stats->events += written;
+    return written;
+}
+
+/* [] END OF FILE */
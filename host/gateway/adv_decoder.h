@@ -0,0 +1,159 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    adv_decoder.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for adv_decoder.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef ADV_DECODER_HEADER
+#define ADV_DECODER_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdint.h>
+#include "mfc_payload.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/*  ADV data of a record, 31 bytes and one byte of padding: the prefilter
+ * reads whole 16 byte lanes */
+#define ADV_RECORD_DATA_LEN         (32u)
+
+/*  A counter is a replay if it is at most this far behind the last one of
+ * the band, equal included: half the counter space, so only counters ahead
+ * of it are accepted. A band's counter only goes forward, across resets
+ * too (see adv_auth.c), and the comparison wraps with it */
+#define ADV_REPLAY_WINDOW           (0x80000000u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+/* One advertising report from the scanner */
+typedef struct
+{
+    uint64_t    timeUs;
+    uint8_t     addr[6];        // BD address, as received
+    int8_t      rssi;
+    uint8_t     dataLen;
+    uint8_t     data[ADV_RECORD_DATA_LEN];
+} ADV_RECORD_T;
+
+/* A band whose payload changed */
+typedef struct
+{
+    uint64_t        timeUs;
+    uint8_t         addr[6];
+    int8_t          rssi;
+    uint8_t         authenticated;  // Tag checked, 0 when not verifying
+    MFC_PAYLOAD_T   payload;
+} ADV_EVENT_T;
+
+/* Key of a band and the rows of its hash, derived from the master key */
+typedef struct
+{
+    uint8_t     key[MFC_AUTH_KEY_LEN];
+    uint8_t     rows[MFC_AUTH_HASH_BLOCKS * MFC_AUTH_BLOCK_LEN];
+} ADV_BAND_KEYS_T;
+
+/* Last payload of a band, one slot of the deduplication table */
+typedef struct
+{
+    uint64_t        addr;       // 0 = free slot, else address | ADV_SLOT_USED
+    uint32_t        counter;    // Last verified counter
+    uint8_t         length;
+    uint8_t         last[MFC_PAYLOAD_AUTH_LEN];
+    ADV_BAND_KEYS_T keys;       // When verifying, derived as the band is added
+} ADV_BAND_STATE_T;
+
+/* Signature of the AES-128 block encryption used to verify tags */
+typedef void (*ADV_AES_FN_T)(const uint8_t *plain, const uint8_t *key, uint8_t *out);
+
+typedef struct
+{
+    uint64_t    records;
+    uint64_t    filtered;       // Dropped by the prefilter
+    uint64_t    foreign;        // Passed it, but no band payload
+    uint64_t    duplicates;     // Same payload as last time
+    uint64_t    events;
+    uint64_t    unsignedPayloads; // Version 1 payloads while verifying
+    uint64_t    authFailed;
+    uint64_t    replays;
+    uint64_t    tableFull;      // Decoded without deduplication
+} ADV_DECODER_STATS_T;
+
+typedef struct
+{
+    ADV_BAND_STATE_T    *bands;
+    uint32_t            mask;       // Capacity - 1
+    uint32_t            used;       // Slots taken, kept under 3/4
+
+    int                 verify;
+    uint8_t             master[MFC_AUTH_KEY_LEN];
+    ADV_AES_FN_T        aes;
+
+    ADV_DECODER_STATS_T stats;
+} ADV_DECODER_T;
+
+/*******************************************************************************
+* @brief This function sets up a decoder over a caller owned band table.
+*
+* NOTE: nothing is allocated, here or while decoding. The table is cleared.
+*   Every band's key is derived from the master key and the address it is
+* heard from (mfc_payload.h), a payload sent under another address fails
+* its tag.
+*
+* @param ADV_DECODER_T* decoder:        The decoder
+* @param ADV_BAND_STATE_T* bands:       Table, one slot per band heard
+* @param uint32_t capacity:             Its size, a power of two
+* @param const uint8_t* key:            Master key of the fleet, or NULL to
+*                                      accept every payload unchecked
+* @param ADV_AES_FN_T aes:              AES-128, needed with a key
+*
+* @returns int:                         0 on success, -1 on bad arguments
+*******************************************************************************/
+int AdvDecoderInit(ADV_DECODER_T *decoder, ADV_BAND_STATE_T *bands,
+                   uint32_t capacity, const uint8_t *key, ADV_AES_FN_T aes);
+
+/*******************************************************************************
+* @brief This function decodes a batch of records, keeping only the bands
+*       whose payload changed since their last record.
+*
+*   With a key, version 1 payloads, bad tags and replayed counters are
+* dropped (and counted) without touching the band's state.
+*
+* @param ADV_DECODER_T* decoder:        The decoder
+* @param const ADV_RECORD_T* records:   The batch
+* @param uint32_t count:                Records in the batch
+* @param ADV_EVENT_T* events:           Room for count events
+*
+* @returns uint32_t:                    Events written
+*******************************************************************************/
+uint32_t AdvDecodeBatch(ADV_DECODER_T *decoder, const ADV_RECORD_T *records,
+                        uint32_t count, ADV_EVENT_T *events);
+
+/*******************************************************************************
+* @brief This function tells whether a record may carry a band payload.
+*
+*   True when the AD type and company ID bytes (0xFF 0xFF 0xFF) show up
+* anywhere in the data, checked 16 bytes at a time with SSE2 when built for
+* it (-DADV_DECODER_SCALAR forces the byte loop).
+*
+* @param const ADV_RECORD_T* record:    The record
+*
+* @returns int:                         0 if it surely doesn't
+*******************************************************************************/
+int AdvPrefilter(const ADV_RECORD_T *record);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,449 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_dispatch.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Hands the episodes of the alert index to a worker pool, most
+ *          urgent first
+ * @author  prisma.ai
+ *
+ *  Taken in arrival order, a 113 alert can wait behind a crowd of pairing
+ * bands and single presses. Here every tier (ALERT_TIER_x) has its own
+ * queue, and a worker always takes from the most urgent one that has
+ * something:
+ *      - the queues are bounded rings (one turn counter per cell, head and
+ *        tail taken with a CAS), any number of producers and workers, no lock
+ *      - an alert is handled on its own, and every worker looks at the
+ *        alert queue again before each handler call, lower tier or not
+ *      - reserved workers only ever take alerts, so one is free for them
+ *        even when every other worker is busy with a slow handler
+ *      - the lower tiers are taken ALERT_DISPATCH_COALESCE items at a time,
+ *        those of the same band merged into one handler call, so a backlog
+ *        shrinks as it grows; a full lower tier turns producers back
+ *   Workers with nothing to take sleep on a condition variable. Producers
+ * only touch its lock when someone sleeps.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include <time.h>
+#include "alert_dispatch.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Presses from which a gesture is an alert: GESTURE_CODE_ALERT (gesture.h) */
+#define ALERT_DISPATCH_ALERT_PRESSES    (4u)
+#define ALERT_DISPATCH_CUSTOM_PRESSES   (2u)
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*  A cell's turn is its position when free to fill, position + 1 when
+ * filled, and position + capacity once taken (free for the next lap) */
+static int QueuePush(ALERT_DISPATCH_QUEUE_T *queue, const ALERT_DISPATCH_ITEM_T *item)
+{
+    uint64_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    ALERT_DISPATCH_CELL_T *cell;
+
+    for(;;)
+    {
+        int64_t lag;
+
+        cell = &queue->cells[pos & queue->mask];
+        lag = (int64_t)(atomic_load_explicit(&cell->turn, memory_order_acquire) - pos);
+        if(lag == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1u,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(lag < 0)
+        {
+            return 0;   // A lap behind: full
+        }
+        else
+        {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+
+    cell->item = *item;
+    atomic_store_explicit(&cell->turn, pos + 1u, memory_order_release);
+    return 1;
+}
+
+static int QueuePop(ALERT_DISPATCH_QUEUE_T *queue, ALERT_DISPATCH_ITEM_T *item)
+{
+    uint64_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    ALERT_DISPATCH_CELL_T *cell;
+
+    for(;;)
+    {
+        int64_t lag;
+
+        cell = &queue->cells[pos & queue->mask];
+        lag = (int64_t)(atomic_load_explicit(&cell->turn, memory_order_acquire) - (pos + 1u));
+        if(lag == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1u,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(lag < 0)
+        {
+            return 0;   // Not filled yet: empty
+        }
+        else
+        {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+
+    *item = cell->item;
+    atomic_store_explicit(&cell->turn, pos + queue->mask + 1u, memory_order_release);
+    return 1;
+}
+
+/* Something queued, or being queued, on the tiers up to lowest */
+static int AnyQueued(ALERT_DISPATCH_T *dispatch, uint32_t lowest)
+{
+    uint32_t tier;
+
+    for(tier = 0u; tier <= lowest; ++tier)
+    {
+        ALERT_DISPATCH_QUEUE_T *queue = &dispatch->tiers[tier];
+
+        if(atomic_load(&queue->tail) != atomic_load(&queue->head))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void Handle(ALERT_WORKER_T *worker, const ALERT_DISPATCH_ITEM_T *item,
+                   uint32_t tier)
+{
+    uint64_t wait = NowNs() - item->queuedNs;
+
+    if(wait > worker->stats.maxWaitNs[tier])
+    {
+        worker->stats.maxWaitNs[tier] = wait;
+    }
+    ++worker->stats.handled[tier];
+    worker->dispatch->handler(worker->dispatch->context, item, tier);
+}
+
+/* Every queued alert, one handler call each */
+static int HandleAlerts(ALERT_WORKER_T *worker)
+{
+    ALERT_DISPATCH_ITEM_T item;
+    int any = 0;
+
+    while(QueuePop(&worker->dispatch->tiers[ALERT_TIER_ALERT], &item))
+    {
+        Handle(worker, &item, ALERT_TIER_ALERT);
+        any = 1;
+    }
+    return any;
+}
+
+/* Takes a batch of the most urgent lower tier with something, merged by
+ * band, and handles it with the alerts first. Returns 0 if all were empty */
+static int HandleLower(ALERT_WORKER_T *worker)
+{
+    ALERT_DISPATCH_T *dispatch = worker->dispatch;
+    uint32_t tier;
+
+    for(tier = ALERT_TIER_ALERT + 1u; tier <= worker->lowest; ++tier)
+    {
+        ALERT_DISPATCH_ITEM_T item;
+        uint32_t count = 0u;
+        uint32_t i;
+
+        while(count < ALERT_DISPATCH_COALESCE &&
+              QueuePop(&dispatch->tiers[tier], &item))
+        {
+            for(i = 0u; i < count; ++i)
+            {
+                if(memcmp(worker->batch[i].episode.addr, item.episode.addr,
+                          sizeof(item.episode.addr)) == 0)
+                {
+                    break;
+                }
+            }
+            if(i == count)
+            {
+                worker->batch[count++] = item;
+                continue;
+            }
+
+            /* Same band: its newest episode, queued since the oldest */
+            worker->batch[i].episode = item.episode;
+            worker->batch[i].merged += item.merged;
+            ++worker->stats.coalesced[tier];
+        }
+        if(count == 0u)
+        {
+            continue;
+        }
+
+        for(i = 0u; i < count; ++i)
+        {
+            HandleAlerts(worker);
+            Handle(worker, &worker->batch[i], tier);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void *AlertWorker(void *arg)
+{
+    ALERT_WORKER_T *worker = arg;
+    ALERT_DISPATCH_T *dispatch = worker->dispatch;
+
+    for(;;)
+    {
+        if(HandleAlerts(worker) || HandleLower(worker))
+        {
+            continue;
+        }
+        if(atomic_load(&dispatch->stop) != 0u)
+        {
+            break;
+        }
+
+        /* Nothing to take: sleep, unless something came in meanwhile */
+        pthread_mutex_lock(&dispatch->lock);
+        atomic_fetch_add(&dispatch->sleepers, 1u);
+        atomic_thread_fence(memory_order_seq_cst);
+        if(!AnyQueued(dispatch, worker->lowest) && atomic_load(&dispatch->stop) == 0u)
+        {
+            ++worker->stats.sleeps;
+            pthread_cond_wait(&dispatch->wake, &dispatch->lock);
+        }
+        atomic_fetch_sub(&dispatch->sleepers, 1u);
+        pthread_mutex_unlock(&dispatch->lock);
+    }
+    return NULL;
+}
+
+static void WakeAll(ALERT_DISPATCH_T *dispatch)
+{
+    pthread_mutex_lock(&dispatch->lock);
+    pthread_cond_broadcast(&dispatch->wake);
+    pthread_mutex_unlock(&dispatch->lock);
+}
+
+/*******************************************************************************
+* @brief This function tells which tier an episode goes to.
+*
+* @param const ALERT_EPISODE_T* episode:    From AlertIndexBatch
+*
+* @returns uint32_t:                        ALERT_TIER_x
+*******************************************************************************/
+uint32_t AlertDispatchTier(const ALERT_EPISODE_T *episode)
+{
+    if(episode->presses >= ALERT_DISPATCH_ALERT_PRESSES)
+    {
+        return ALERT_TIER_ALERT;
+    }
+    if(episode->flags & MFC_FLAG_PAIRING)
+    {
+        return ALERT_TIER_PAIRING;
+    }
+    if(episode->presses == ALERT_DISPATCH_CUSTOM_PRESSES)
+    {
+        return ALERT_TIER_CUSTOM;
+    }
+    return ALERT_TIER_UNSAFE;
+}
+
+/*******************************************************************************
+* @brief This function sets up a dispatcher over caller owned rings, one
+*       per tier.
+*
+* NOTE: nothing is allocated, here or while dispatching. No worker runs
+*       before AlertDispatchStart.
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+* @param ALERT_DISPATCH_CELL_T** cells: A ring per tier (ie: cells[ALERT_TIER_ALERT])
+* @param const uint32_t* capacity:      Their sizes, powers of two. The size
+*                                      of a lower tier is how far it may
+*                                      lag before producers are turned back
+* @param ALERT_HANDLER_T handler:       Called for every item
+* @param void* context:                 Passed to it
+*
+* @returns int:                         0 on success, -1 on bad arguments
+*******************************************************************************/
+int AlertDispatchInit(ALERT_DISPATCH_T *dispatch, ALERT_DISPATCH_CELL_T **cells,
+                      const uint32_t *capacity, ALERT_HANDLER_T handler,
+                      void *context)
+{
+    uint32_t tier, i;
+
+    if(dispatch == NULL || cells == NULL || capacity == NULL || handler == NULL)
+    {
+        return -1;
+    }
+    for(tier = 0u; tier < ALERT_TIERS; ++tier)
+    {
+        if(cells[tier] == NULL || capacity[tier] < 2u ||
+           (capacity[tier] & (capacity[tier] - 1u)) != 0u)
+        {
+            return -1;
+        }
+    }
+
+    memset(dispatch, 0, sizeof(*dispatch));
+    for(tier = 0u; tier < ALERT_TIERS; ++tier)
+    {
+        ALERT_DISPATCH_QUEUE_T *queue = &dispatch->tiers[tier];
+
+        queue->cells = cells[tier];
+        queue->mask = capacity[tier] - 1u;
+        for(i = 0u; i < capacity[tier]; ++i)
+        {
+            atomic_init(&queue->cells[i].turn, i);
+        }
+    }
+    dispatch->handler = handler;
+    dispatch->context = context;
+    pthread_mutex_init(&dispatch->lock, NULL);
+    pthread_cond_init(&dispatch->wake, NULL);
+    return 0;
+}
+
+/*******************************************************************************
+* @brief This function starts the worker pool.
+*
+*   Every worker takes the most urgent item there is, and looks at the
+* alert tier again before every handler call, so a 113 alert waits for at
+* most one handler call per worker, plus the alerts queued before it. The
+* first reserved workers take nothing but alerts: those are free for them
+* however far behind the lower tiers are.
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+* @param ALERT_WORKER_T* workers:       Room for count workers
+* @param uint32_t count:                Workers, up to ALERT_DISPATCH_MAX_WORKERS
+* @param uint32_t reserved:             Of them for ALERT_TIER_ALERT only,
+*                                      less than count
+*
+* @returns int:                         0 on success, -1 if not started
+*******************************************************************************/
+int AlertDispatchStart(ALERT_DISPATCH_T *dispatch, ALERT_WORKER_T *workers,
+                       uint32_t count, uint32_t reserved)
+{
+    uint32_t i;
+
+    if(workers == NULL || count == 0u || count > ALERT_DISPATCH_MAX_WORKERS ||
+       reserved >= count)
+    {
+        return -1;
+    }
+
+    atomic_store(&dispatch->stop, 0u);
+    dispatch->workers = workers;
+    dispatch->workerCount = 0u;
+    for(i = 0u; i < count; ++i)
+    {
+        ALERT_WORKER_T *worker = &workers[i];
+
+        memset(worker, 0, sizeof(*worker));
+        worker->dispatch = dispatch;
+        worker->lowest = (i < reserved) ? ALERT_TIER_ALERT : ALERT_TIERS - 1u;
+        if(pthread_create(&worker->thread, NULL, AlertWorker, worker) != 0)
+        {
+            AlertDispatchStop(dispatch);
+            return -1;
+        }
+        ++dispatch->workerCount;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* @brief This function queues an episode on its tier and wakes a worker.
+*
+*   Safe from any number of threads at once. Never blocks: a full tier
+* turns the episode back, and what then happens to it is the caller's
+* call (retried for ALERT_TIER_ALERT, dropped or held for the others).
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+* @param const ALERT_EPISODE_T* episode: The episode
+* @param ALERT_SUBMIT_STATS_T* stats:   The caller's counters, added to
+*
+* @returns int:                         ALERT_SUBMIT_QUEUED or ALERT_SUBMIT_FULL
+*******************************************************************************/
+int AlertDispatchSubmit(ALERT_DISPATCH_T *dispatch, const ALERT_EPISODE_T *episode,
+                        ALERT_SUBMIT_STATS_T *stats)
+{
+    uint32_t tier = AlertDispatchTier(episode);
+    ALERT_DISPATCH_ITEM_T item;
+
+    item.episode = *episode;
+    item.queuedNs = NowNs();
+    item.merged = 1u;
+    if(!QueuePush(&dispatch->tiers[tier], &item))
+    {
+        ++stats->full[tier];
+        return ALERT_SUBMIT_FULL;
+    }
+    ++stats->queued[tier];
+
+    /* Pairs with the fence of a worker going to sleep */
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&dispatch->sleepers, memory_order_relaxed) != 0u)
+    {
+        WakeAll(dispatch);
+    }
+    return ALERT_SUBMIT_QUEUED;
+}
+
+/*******************************************************************************
+* @brief This function stops the workers once every tier is empty, and
+*       waits for them.
+*
+* NOTE: nothing may be submitted from now on.
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+*
+* @returns None
+*******************************************************************************/
+void AlertDispatchStop(ALERT_DISPATCH_T *dispatch)
+{
+    uint32_t i;
+
+    atomic_store(&dispatch->stop, 1u);
+    WakeAll(dispatch);
+    for(i = 0u; i < dispatch->workerCount; ++i)
+    {
+        pthread_join(dispatch->workers[i].thread, NULL);
+    }
+    dispatch->workerCount = 0u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,202 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_dispatch.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for alert_dispatch.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef ALERT_DISPATCH_HEADER
+#define ALERT_DISPATCH_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "alert_index.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/*  Tiers, most urgent first, from the gesture codes of gesture.h as the
+ * payload carries them (presses, MFC_FLAG_PAIRING). 3 presses have no
+ * meaning of their own and go with 1, the more urgent of their neighbours */
+#define ALERT_TIER_ALERT            (0u)    // 4 presses or more: send a 113 alert
+#define ALERT_TIER_UNSAFE           (1u)    // 1 or 3 presses: feels unsafe
+#define ALERT_TIER_CUSTOM           (2u)    // 2 presses: configurable
+#define ALERT_TIER_PAIRING          (3u)    // Pairing mode
+#define ALERT_TIERS                 (4u)
+
+#define ALERT_DISPATCH_MAX_WORKERS  (64u)
+
+/*  Items a worker takes at once from a lower tier. Those of the same band
+ * are merged into one handler call (the newest episode wins) */
+#define ALERT_DISPATCH_COALESCE     (32u)
+
+/* What AlertDispatchSubmit did with an episode */
+#define ALERT_SUBMIT_QUEUED         (0)
+#define ALERT_SUBMIT_FULL           (1)     // Its tier is full, not queued
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+/* An episode on its way to the handler */
+typedef struct
+{
+    ALERT_EPISODE_T     episode;
+    uint64_t            queuedNs;   // CLOCK_MONOTONIC, when submitted
+    uint32_t            merged;     // Episodes it stands for, 1 if not coalesced
+} ALERT_DISPATCH_ITEM_T;
+
+/* A cell of a tier's ring, see alert_dispatch.c */
+typedef struct
+{
+    _Atomic uint64_t        turn;
+    ALERT_DISPATCH_ITEM_T   item;
+} ALERT_DISPATCH_CELL_T;
+
+/* One tier: a bounded ring, producers and workers on their own lines */
+typedef struct
+{
+    _Alignas(64) _Atomic uint64_t   tail;       // Next cell to fill
+    _Alignas(64) _Atomic uint64_t   head;       // Next cell to take
+    _Alignas(64) ALERT_DISPATCH_CELL_T *cells;
+    uint32_t                        mask;       // Capacity - 1
+} ALERT_DISPATCH_QUEUE_T;
+
+/* Called by the workers, once per item, from any of them at once */
+typedef void (*ALERT_HANDLER_T)(void *context, const ALERT_DISPATCH_ITEM_T *item,
+                                uint32_t tier);
+
+/* Counters of one producer */
+typedef struct
+{
+    uint64_t    queued[ALERT_TIERS];
+    uint64_t    full[ALERT_TIERS];      // Turned back, see ALERT_SUBMIT_FULL
+} ALERT_SUBMIT_STATS_T;
+
+/* Counters of one worker */
+typedef struct
+{
+    uint64_t    handled[ALERT_TIERS];   // Handler calls
+    uint64_t    coalesced[ALERT_TIERS]; // Items merged into another one
+    uint64_t    maxWaitNs[ALERT_TIERS]; // Longest time queued
+    uint64_t    sleeps;
+} ALERT_WORKER_STATS_T;
+
+struct ALERT_DISPATCH;
+
+typedef struct
+{
+    struct ALERT_DISPATCH   *dispatch;
+    pthread_t               thread;
+    uint32_t                lowest;     // Lowest tier it takes
+    ALERT_WORKER_STATS_T    stats;
+    ALERT_DISPATCH_ITEM_T   batch[ALERT_DISPATCH_COALESCE];
+} ALERT_WORKER_T;
+
+typedef struct ALERT_DISPATCH
+{
+    ALERT_DISPATCH_QUEUE_T  tiers[ALERT_TIERS];
+    ALERT_HANDLER_T         handler;
+    void                    *context;
+    ALERT_WORKER_T          *workers;
+    uint32_t                workerCount;
+
+    /* Idle workers sleep here, producers wake them */
+    _Alignas(64) _Atomic uint32_t   sleepers;
+    _Atomic uint32_t                stop;
+    pthread_mutex_t                 lock;
+    pthread_cond_t                  wake;
+} ALERT_DISPATCH_T;
+
+/*******************************************************************************
+* @brief This function tells which tier an episode goes to.
+*
+* @param const ALERT_EPISODE_T* episode:    From AlertIndexBatch
+*
+* @returns uint32_t:                        ALERT_TIER_x
+*******************************************************************************/
+uint32_t AlertDispatchTier(const ALERT_EPISODE_T *episode);
+
+/*******************************************************************************
+* @brief This function sets up a dispatcher over caller owned rings, one
+*       per tier.
+*
+* NOTE: nothing is allocated, here or while dispatching. No worker runs
+*       before AlertDispatchStart.
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+* @param ALERT_DISPATCH_CELL_T** cells: A ring per tier (ie: cells[ALERT_TIER_ALERT])
+* @param const uint32_t* capacity:      Their sizes, powers of two. The size
+*                                      of a lower tier is how far it may
+*                                      lag before producers are turned back
+* @param ALERT_HANDLER_T handler:       Called for every item
+* @param void* context:                 Passed to it
+*
+* @returns int:                         0 on success, -1 on bad arguments
+*******************************************************************************/
+int AlertDispatchInit(ALERT_DISPATCH_T *dispatch, ALERT_DISPATCH_CELL_T **cells,
+                      const uint32_t *capacity, ALERT_HANDLER_T handler,
+                      void *context);
+
+/*******************************************************************************
+* @brief This function starts the worker pool.
+*
+*   Every worker takes the most urgent item there is, and looks at the
+* alert tier again before every handler call, so a 113 alert waits for at
+* most one handler call per worker, plus the alerts queued before it. The
+* first reserved workers take nothing but alerts: those are free for them
+* however far behind the lower tiers are.
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+* @param ALERT_WORKER_T* workers:       Room for count workers
+* @param uint32_t count:                Workers, up to ALERT_DISPATCH_MAX_WORKERS
+* @param uint32_t reserved:             Of them for ALERT_TIER_ALERT only,
+*                                      less than count
+*
+* @returns int:                         0 on success, -1 if not started
+*******************************************************************************/
+int AlertDispatchStart(ALERT_DISPATCH_T *dispatch, ALERT_WORKER_T *workers,
+                       uint32_t count, uint32_t reserved);
+
+/*******************************************************************************
+* @brief This function queues an episode on its tier and wakes a worker.
+*
+*   Safe from any number of threads at once. Never blocks: a full tier
+* turns the episode back, and what then happens to it is the caller's
+* call (retried for ALERT_TIER_ALERT, dropped or held for the others).
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+* @param const ALERT_EPISODE_T* episode: The episode
+* @param ALERT_SUBMIT_STATS_T* stats:   The caller's counters, added to
+*
+* @returns int:                         ALERT_SUBMIT_QUEUED or ALERT_SUBMIT_FULL
+*******************************************************************************/
+int AlertDispatchSubmit(ALERT_DISPATCH_T *dispatch, const ALERT_EPISODE_T *episode,
+                        ALERT_SUBMIT_STATS_T *stats);
+
+/*******************************************************************************
+* @brief This function stops the workers once every tier is empty, and
+*       waits for them.
+*
+* NOTE: nothing may be submitted from now on.
+*
+* @param ALERT_DISPATCH_T* dispatch:    The dispatcher
+*
+* @returns None
+*******************************************************************************/
+void AlertDispatchStop(ALERT_DISPATCH_T *dispatch);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,602 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_index.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Turns the reports of many gateways into one episode per gesture
+ * @author  prisma.ai
+ *
+ *  A gesture stays on air for seconds, and every gateway and phone in range
+ * reports it, each through its own decoder. The index keeps one slot per
+ * band, with the band's current episode (sequence number, code, start) and
+ * its counters, so the first report of an episode goes through and the rest
+ * only bump a count.
+ *   The slots are an open addressing table (linear probing) split into
+ * shards by the band's hash, each with its own counters on its own cache
+ * line. A report costs one probe and two or three atomics, no lock:
+ *      - a free slot is taken with a CAS on its band word, and a band word
+ *        is only cleared by AlertIndexExpire, so probe chains never break
+ *        under a reporter
+ *      - the episode word (sequence number, code, start time) is replaced
+ *        with a CAS, the reporter that wins it has the new episode
+ *      - the counters word is tagged with the episode's start, so a report
+ *        of the previous episode can't count in the new one
+ *   Episodes end by time: one that had no report for the window is over,
+ * and AlertIndexExpire frees the slots of such bands with a backward shift
+ * delete. That one needs the shard to itself: reporters count themselves
+ * in a shard (once per batch and shard) and wait while it is swept.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include "alert_index.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define ALERT_SLOT_USED             (1ull << 63)
+
+/*  Episode word:
+ *      [0-6]   sequence number
+ *      [7]     ALERT_EPISODE_SET
+ *      [8-11]  presses
+ *      [12]    MFC_FLAG_PAIRING
+ *      [16-63] start, ms                                                   */
+#define ALERT_EPISODE_SET           (1ull << 7)
+#define ALERT_EPISODE_START_SHIFT   (16u)
+
+/*  Counters word:
+ *      [0-31]  start of the episode counted, ms (low 32 bits)
+ *      [32-39] best RSSI
+ *      [40-63] reports, saturated                                          */
+#define ALERT_STATS_RSSI_SHIFT      (32u)
+#define ALERT_STATS_REPORTS_SHIFT   (40u)
+#define ALERT_STATS_REPORTS_MAX     (0xFFFFFFull)
+
+/* A report this far behind the current sequence number is an older one */
+#define ALERT_SEQ_BEHIND_MAX        (MFC_SEQ_MASK / 2u)
+
+/*******************************************************************************
+* Compile time checks: a slot is 32 bytes, a shard one cache line
+*******************************************************************************/
+typedef char alert_slot_check[(sizeof(ALERT_SLOT_T) == 32u) ? 1 : -1];
+typedef char alert_shard_check[(sizeof(ALERT_SHARD_T) == 64u) ? 1 : -1];
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint64_t AddrKey(const uint8_t *addr)
+{
+    return ALERT_SLOT_USED |
+           (uint64_t)addr[0] | ((uint64_t)addr[1] << 8) |
+           ((uint64_t)addr[2] << 16) | ((uint64_t)addr[3] << 24) |
+           ((uint64_t)addr[4] << 32) | ((uint64_t)addr[5] << 40);
+}
+
+static uint64_t KeyHash(uint64_t key)
+{
+    return key * 0x9E3779B97F4A7C15ull;
+}
+
+/* Shard from bits 26-31 of the hash, the slot from bits 32 and up */
+static uint32_t ShardOf(const ALERT_INDEX_T *index, uint64_t hash)
+{
+    return (uint32_t)(hash >> 26) & (index->shardCount - 1u);
+}
+
+static uint32_t HomeOf(const ALERT_SHARD_T *shard, uint64_t hash)
+{
+    return (uint32_t)(hash >> 32) & shard->mask;
+}
+
+static uint64_t EpisodeStart(uint64_t episode)
+{
+    return episode >> ALERT_EPISODE_START_SHIFT;
+}
+
+/* Wrap safe "a is after b", for the 32 bit ms times */
+static int32_t MsSince(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b);
+}
+
+/* Counts the caller in a shard, unless it is being swept: then it leaves
+ * every shard it is in (see entered) and waits, so two sweeps can't wait on
+ * each other through it */
+static void ShardEnter(ALERT_INDEX_T *index, uint32_t shard, uint64_t *entered)
+{
+    ALERT_SHARD_T *s = &index->shards[shard];
+
+    for(;;)
+    {
+        uint32_t i;
+
+        atomic_fetch_add(&s->inside, 1u);
+        if(atomic_load(&s->sweeping) == 0u)
+        {
+            *entered |= 1ull << shard;
+            return;
+        }
+        atomic_fetch_sub(&s->inside, 1u);
+
+        for(i = 0u; i < index->shardCount; ++i)
+        {
+            if(*entered & (1ull << i))
+            {
+                atomic_fetch_sub(&index->shards[i].inside, 1u);
+            }
+        }
+        *entered = 0u;
+        while(atomic_load_explicit(&s->sweeping, memory_order_relaxed) != 0u)
+        {
+        }
+    }
+}
+
+static void ShardLeaveAll(ALERT_INDEX_T *index, uint64_t entered)
+{
+    uint32_t i;
+
+    for(i = 0u; entered != 0u; ++i, entered >>= 1)
+    {
+        if(entered & 1u)
+        {
+            atomic_fetch_sub(&index->shards[i].inside, 1u);
+        }
+    }
+}
+
+/* Slot of a band, claimed if it isn't in the shard (NULL when full) */
+static ALERT_SLOT_T *FindOrClaim(ALERT_SHARD_T *shard, uint64_t key, uint64_t hash)
+{
+    uint32_t i = HomeOf(shard, hash);
+
+    for(;;)
+    {
+        ALERT_SLOT_T *slot = &shard->slots[i];
+        uint64_t band = atomic_load_explicit(&slot->band, memory_order_acquire);
+
+        if(band == key)
+        {
+            return slot;
+        }
+        if(band == 0u)
+        {
+            /* Keep a quarter of the shard free, probes stay short */
+            if(atomic_load_explicit(&shard->used, memory_order_relaxed) >= shard->limit)
+            {
+                return NULL;
+            }
+            if(atomic_compare_exchange_strong(&slot->band, &band, key))
+            {
+                atomic_fetch_add_explicit(&shard->used, 1u, memory_order_relaxed);
+                return slot;
+            }
+            /* Someone took it first, maybe for the same band */
+            if(band == key)
+            {
+                return slot;
+            }
+        }
+        i = (i + 1u) & shard->mask;
+    }
+}
+
+/* Adds a report to the counters of its episode, if that is still the one
+ * counted or a newer one */
+static void CountReport(ALERT_SLOT_T *slot, uint32_t startMs, int8_t rssi)
+{
+    uint64_t stats = atomic_load_explicit(&slot->stats, memory_order_relaxed);
+    uint64_t next;
+
+    do
+    {
+        int32_t age = MsSince(startMs, (uint32_t)stats);
+
+        if(stats == 0u || age > 0)
+        {
+            /* First report counted for this episode */
+            next = (uint64_t)startMs |
+                   ((uint64_t)(uint8_t)rssi << ALERT_STATS_RSSI_SHIFT) |
+                   (1ull << ALERT_STATS_REPORTS_SHIFT);
+        }
+        else if(age < 0)
+        {
+            return;     // A report of the episode before
+        }
+        else
+        {
+            uint64_t reports = stats >> ALERT_STATS_REPORTS_SHIFT;
+            int8_t best = (int8_t)(uint8_t)(stats >> ALERT_STATS_RSSI_SHIFT);
+
+            if(reports < ALERT_STATS_REPORTS_MAX)
+            {
+                ++reports;
+            }
+            if(rssi > best)
+            {
+                best = rssi;
+            }
+            next = (stats & 0xFFFFFFFFull) |
+                   ((uint64_t)(uint8_t)best << ALERT_STATS_RSSI_SHIFT) |
+                   (reports << ALERT_STATS_REPORTS_SHIFT);
+        }
+    } while(!atomic_compare_exchange_weak_explicit(&slot->stats, &stats, next,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed));
+}
+
+/* Moves the newest report time forward */
+static void TouchSlot(ALERT_SLOT_T *slot, uint32_t nowMs)
+{
+    uint32_t last = atomic_load_explicit(&slot->lastMs, memory_order_relaxed);
+
+    while(MsSince(nowMs, last) > 0 &&
+          !atomic_compare_exchange_weak_explicit(&slot->lastMs, &last, nowMs,
+                                                 memory_order_relaxed,
+                                                 memory_order_relaxed))
+    {
+    }
+}
+
+/* Folds one report into its band's slot, ALERT_REPORT_x */
+static int AlertIndexReport(ALERT_INDEX_T *index, const ADV_EVENT_T *report,
+                            uint64_t *entered)
+{
+    const MFC_PAYLOAD_T *payload = &report->payload;
+    uint64_t key, hash, nowMs, want, episode;
+    uint32_t shard;
+    ALERT_SLOT_T *slot;
+    int result;
+
+    if(payload->presses == 0u && (payload->flags & MFC_FLAG_PAIRING) == 0u)
+    {
+        return ALERT_REPORT_IDLE;
+    }
+
+    key = AddrKey(report->addr);
+    hash = KeyHash(key);
+    shard = ShardOf(index, hash);
+    if((*entered & (1ull << shard)) == 0u)
+    {
+        ShardEnter(index, shard, entered);
+    }
+    slot = FindOrClaim(&index->shards[shard], key, hash);
+    if(slot == NULL)
+    {
+        return ALERT_REPORT_UNINDEXED;
+    }
+
+    nowMs = report->timeUs / 1000u;
+    want = (uint64_t)(payload->seq & MFC_SEQ_MASK) | ALERT_EPISODE_SET |
+           ((uint64_t)(payload->presses & 0x0Fu) << 8) |
+           ((uint64_t)(payload->flags & MFC_FLAG_PAIRING) << 12) |
+           (nowMs << ALERT_EPISODE_START_SHIFT);
+    episode = atomic_load_explicit(&slot->episode, memory_order_acquire);
+
+    for(;;)
+    {
+        if(episode != 0u)
+        {
+            /* Since the later of its start and its newest report */
+            uint32_t startMs = (uint32_t)EpisodeStart(episode);
+            uint32_t lastMs = atomic_load_explicit(&slot->lastMs, memory_order_relaxed);
+            uint32_t seqBehind = (uint32_t)((episode & MFC_SEQ_MASK) - payload->seq) & MFC_SEQ_MASK;
+
+            if(MsSince(lastMs, startMs) < 0)
+            {
+                lastMs = startMs;
+            }
+            if(MsSince((uint32_t)nowMs, lastMs) <= (int32_t)index->windowMs)
+            {
+                if(seqBehind == 0u)
+                {
+                    result = ALERT_REPORT_DUPLICATE;
+                    break;
+                }
+                if(seqBehind <= ALERT_SEQ_BEHIND_MAX)
+                {
+                    return ALERT_REPORT_STALE;
+                }
+            }
+        }
+
+        if(atomic_compare_exchange_weak_explicit(&slot->episode, &episode, want,
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire))
+        {
+            episode = want;
+            result = ALERT_REPORT_NEW;
+            break;
+        }
+    }
+
+    CountReport(slot, (uint32_t)EpisodeStart(episode), report->rssi);
+    TouchSlot(slot, (uint32_t)nowMs);
+    return result;
+}
+
+/*******************************************************************************
+* @brief This function sets up an index over a caller owned slot table,
+*       split evenly between the shards.
+*
+* NOTE: nothing is allocated, here or while reporting. The table is cleared.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param ALERT_SLOT_T* slots:           Table, one slot per band with an episode
+* @param uint32_t capacity:             Its size, a power of two
+* @param uint32_t shards:               Shards, a power of two up to
+*                                      ALERT_INDEX_MAX_SHARDS, at least 4
+*                                      slots each
+* @param uint32_t windowMs:             Episode window (ie: ALERT_INDEX_WINDOW_MS)
+*
+* @returns int:                         0 on success, -1 on bad arguments
+*******************************************************************************/
+int AlertIndexInit(ALERT_INDEX_T *index, ALERT_SLOT_T *slots, uint32_t capacity,
+                   uint32_t shards, uint32_t windowMs)
+{
+    uint32_t per, i;
+
+    if(index == NULL || slots == NULL || shards == 0u ||
+       shards > ALERT_INDEX_MAX_SHARDS || (shards & (shards - 1u)) != 0u ||
+       (capacity & (capacity - 1u)) != 0u || capacity < 4u * shards ||
+       windowMs == 0u || windowMs > 0x7FFFFFFFu)
+    {
+        return -1;
+    }
+
+    memset(index, 0, sizeof(*index));
+    memset(slots, 0, capacity * sizeof(*slots));
+    index->shardCount = shards;
+    index->windowMs = windowMs;
+
+    per = capacity / shards;
+    for(i = 0u; i < shards; ++i)
+    {
+        ALERT_SHARD_T *shard = &index->shards[i];
+
+        shard->slots = &slots[i * per];
+        shard->mask = per - 1u;
+        shard->limit = per - (per >> 2);
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* @brief This function folds a batch of decoded reports into the index,
+*       keeping the first report of every episode.
+*
+*   Safe from any number of threads at once, over the same bands or not.
+* An episode is a band and a sequence number: every report of it after the
+* first, from any gateway, is a duplicate. One of an older sequence number
+* (within the window) is stale. Reports without a gesture are skipped.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param const ADV_EVENT_T* reports:    The batch (ie: from AdvDecodeBatch)
+* @param uint32_t count:                Reports in the batch
+* @param ALERT_EPISODE_T* episodes:     Room for count episodes
+* @param ALERT_INDEX_STATS_T* stats:    The caller's counters, added to
+*
+* @returns uint32_t:                    Episodes written
+*******************************************************************************/
+uint32_t AlertIndexBatch(ALERT_INDEX_T *index, const ADV_EVENT_T *reports,
+                         uint32_t count, ALERT_EPISODE_T *episodes,
+                         ALERT_INDEX_STATS_T *stats)
+{
+    uint64_t entered = 0u;
+    uint32_t written = 0u;
+    uint32_t r;
+
+    stats->reports += count;
+
+    for(r = 0u; r < count; ++r)
+    {
+        const ADV_EVENT_T *report = &reports[r];
+        ALERT_EPISODE_T *episode;
+
+        switch(AlertIndexReport(index, report, &entered))
+        {
+            case ALERT_REPORT_DUPLICATE:
+                ++stats->duplicates;
+                continue;
+            case ALERT_REPORT_STALE:
+                ++stats->stale;
+                continue;
+            case ALERT_REPORT_IDLE:
+                ++stats->idle;
+                continue;
+            case ALERT_REPORT_UNINDEXED:
+                ++stats->unindexed;
+                break;
+            default:
+                break;
+        }
+
+        episode = &episodes[written++];
+        episode->firstUs = report->timeUs;
+        memcpy(episode->addr, report->addr, sizeof(episode->addr));
+        episode->rssi = report->rssi;
+        episode->presses = report->payload.presses;
+        episode->flags = report->payload.flags & MFC_FLAG_PAIRING;
+        episode->seq = report->payload.seq & MFC_SEQ_MASK;
+    }
+
+    ShardLeaveAll(index, entered);
+    stats->episodes += written;
+    return written;
+}
+
+/*******************************************************************************
+* @brief This function frees the slots of the bands whose episode is over:
+*       no report for longer than the window.
+*
+*   Reporters wait while a shard is swept. Not to be called from inside
+* AlertIndexBatch.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param uint32_t shard:                Which shard (0 to shards - 1)
+* @param uint64_t nowUs:                Receive time no later report is older than
+*
+* @returns uint32_t:                    Slots freed
+*******************************************************************************/
+uint32_t AlertIndexExpire(ALERT_INDEX_T *index, uint32_t shard, uint64_t nowUs)
+{
+    ALERT_SHARD_T *s = &index->shards[shard & (index->shardCount - 1u)];
+    uint32_t nowMs = (uint32_t)(nowUs / 1000u);
+    uint32_t expected = 0u;
+    uint32_t freed = 0u;
+    uint32_t i, start;
+
+    /* One sweep at a time, then wait for the reporters to leave */
+    if(!atomic_compare_exchange_strong(&s->sweeping, &expected, 1u))
+    {
+        return 0u;
+    }
+    while(atomic_load(&s->inside) != 0u)
+    {
+    }
+
+    /* Start after a free slot, so no probe chain wraps into the sweep */
+    for(start = 0u; start <= s->mask; ++start)
+    {
+        if(atomic_load_explicit(&s->slots[start].band, memory_order_relaxed) == 0u)
+        {
+            break;
+        }
+    }
+
+    for(i = 0u; i <= s->mask; ++i)
+    {
+        uint32_t at = (start + i) & s->mask;
+        ALERT_SLOT_T *slot = &s->slots[at];
+        uint64_t episode;
+        uint32_t lastMs, hole, j;
+
+        if(atomic_load_explicit(&slot->band, memory_order_relaxed) == 0u)
+        {
+            continue;
+        }
+        episode = atomic_load_explicit(&slot->episode, memory_order_relaxed);
+        lastMs = atomic_load_explicit(&slot->lastMs, memory_order_relaxed);
+        if(MsSince(lastMs, (uint32_t)EpisodeStart(episode)) < 0)
+        {
+            lastMs = (uint32_t)EpisodeStart(episode);
+        }
+        if(MsSince(nowMs, lastMs) <= (int32_t)index->windowMs)
+        {
+            continue;
+        }
+
+        /* Backward shift: pull up the next slots that may live in the hole */
+        hole = at;
+        for(j = (hole + 1u) & s->mask; ; j = (j + 1u) & s->mask)
+        {
+            ALERT_SLOT_T *next = &s->slots[j];
+            uint64_t band = atomic_load_explicit(&next->band, memory_order_relaxed);
+            uint32_t home;
+
+            if(band == 0u)
+            {
+                break;
+            }
+            home = HomeOf(s, KeyHash(band));
+            /* Movable if its home isn't in (hole, j] */
+            if(((j - home) & s->mask) >= ((j - hole) & s->mask))
+            {
+                ALERT_SLOT_T *to = &s->slots[hole];
+
+                atomic_store_explicit(&to->band, band, memory_order_relaxed);
+                atomic_store_explicit(&to->episode,
+                    atomic_load_explicit(&next->episode, memory_order_relaxed),
+                    memory_order_relaxed);
+                atomic_store_explicit(&to->stats,
+                    atomic_load_explicit(&next->stats, memory_order_relaxed),
+                    memory_order_relaxed);
+                atomic_store_explicit(&to->lastMs,
+                    atomic_load_explicit(&next->lastMs, memory_order_relaxed),
+                    memory_order_relaxed);
+                hole = j;
+            }
+        }
+        atomic_store_explicit(&s->slots[hole].band, 0u, memory_order_relaxed);
+        atomic_store_explicit(&s->slots[hole].episode, 0u, memory_order_relaxed);
+        atomic_store_explicit(&s->slots[hole].stats, 0u, memory_order_relaxed);
+        atomic_store_explicit(&s->slots[hole].lastMs, 0u, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&s->used, 1u, memory_order_relaxed);
+        ++freed;
+
+        /* Something moved into this slot, look at it again */
+        if(hole != at)
+        {
+            --i;
+        }
+    }
+
+    atomic_store(&s->sweeping, 0u);
+    return freed;
+}
+
+/*******************************************************************************
+* @brief This function reads what the index holds for a band.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param const uint8_t* addr:           The band's address
+* @param ALERT_BAND_T* band:            Its current episode and counters
+*
+* @returns int:                         0 if found, -1 if the band has none
+*******************************************************************************/
+int AlertIndexLookup(ALERT_INDEX_T *index, const uint8_t *addr, ALERT_BAND_T *band)
+{
+    uint64_t key = AddrKey(addr);
+    uint64_t hash = KeyHash(key);
+    uint32_t shard = ShardOf(index, hash);
+    ALERT_SHARD_T *s = &index->shards[shard];
+    uint64_t entered = 0u;
+    uint32_t i = HomeOf(s, hash);
+    int found = -1;
+
+    ShardEnter(index, shard, &entered);
+    for(;;)
+    {
+        ALERT_SLOT_T *slot = &s->slots[i];
+        uint64_t word = atomic_load_explicit(&slot->band, memory_order_acquire);
+
+        if(word == 0u)
+        {
+            break;
+        }
+        if(word == key)
+        {
+            uint64_t episode = atomic_load(&slot->episode);
+            uint64_t stats = atomic_load(&slot->stats);
+            uint64_t startMs = EpisodeStart(episode);
+            int32_t lastDelta = MsSince(atomic_load(&slot->lastMs), (uint32_t)startMs);
+
+            if(episode == 0u)
+            {
+                break;
+            }
+            band->startUs = startMs * 1000u;
+            band->lastUs = (startMs + (uint64_t)((lastDelta > 0) ? lastDelta : 0)) * 1000u;
+            band->reports = (uint32_t)(stats >> ALERT_STATS_REPORTS_SHIFT);
+            band->bestRssi = (int8_t)(uint8_t)(stats >> ALERT_STATS_RSSI_SHIFT);
+            band->presses = (uint8_t)((episode >> 8) & 0x0Fu);
+            band->flags = (uint8_t)((episode >> 12) & MFC_FLAG_PAIRING);
+            band->seq = (uint8_t)(episode & MFC_SEQ_MASK);
+            found = 0;
+            break;
+        }
+        i = (i + 1u) & s->mask;
+    }
+    ShardLeaveAll(index, entered);
+    return found;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,175 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    alert_index.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for alert_index.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef ALERT_INDEX_HEADER
+#define ALERT_INDEX_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdatomic.h>
+#include <stdint.h>
+#include "adv_decoder.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define ALERT_INDEX_MAX_SHARDS      (64u)
+
+/*  Default episode window: a report more than this after the last one of an
+ * episode opens a new one, even with the same sequence number */
+#define ALERT_INDEX_WINDOW_MS       (30000u)
+
+/* What became of one report (alert_index.c) */
+#define ALERT_REPORT_NEW            (0)     // First report of an episode
+#define ALERT_REPORT_DUPLICATE      (1)     // Another report of the current one
+#define ALERT_REPORT_STALE          (2)     // Late report of an older one
+#define ALERT_REPORT_IDLE           (3)     // No gesture (GESTURE_CODE_NONE)
+#define ALERT_REPORT_UNINDEXED      (4)     // Shard full, taken as new
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+/* One band, 32 bytes. Only ever changed with atomics, see alert_index.c */
+typedef struct
+{
+    _Atomic uint64_t    band;       // 0 = free, else address | ALERT_SLOT_USED
+    _Atomic uint64_t    episode;    // Its current episode (0 = none yet)
+    _Atomic uint64_t    stats;      // Reports / best RSSI of that episode
+    _Atomic uint32_t    lastMs;     // Newest report, ms, wraps
+} ALERT_SLOT_T;
+
+/* A new episode, what the backend gets once per gesture */
+typedef struct
+{
+    uint64_t        firstUs;        // Receive time of its first report
+    uint8_t         addr[6];
+    int8_t          rssi;           // Of the first report
+    uint8_t         presses;
+    uint8_t         flags;          // MFC_FLAG_PAIRING
+    uint8_t         seq;
+} ALERT_EPISODE_T;
+
+/* What the index holds for a band, see AlertIndexLookup */
+typedef struct
+{
+    uint64_t        startUs;        // First report of the episode, ms precision
+    uint64_t        lastUs;         // Newest report, ms precision
+    uint32_t        reports;        // Of the episode, saturates at 2^24 - 1
+    int8_t          bestRssi;
+    uint8_t         presses;
+    uint8_t         flags;
+    uint8_t         seq;
+} ALERT_BAND_T;
+
+/* Counters of one caller, nothing shared is counted */
+typedef struct
+{
+    uint64_t    reports;
+    uint64_t    episodes;
+    uint64_t    duplicates;
+    uint64_t    stale;
+    uint64_t    idle;
+    uint64_t    unindexed;
+} ALERT_INDEX_STATS_T;
+
+/* A shard, alone on its cache lines */
+typedef struct
+{
+    ALERT_SLOT_T        *slots;
+    uint32_t            mask;       // Capacity - 1
+    uint32_t            limit;      // Slots that can be taken, 3/4
+    _Atomic uint32_t    used;
+    _Atomic uint32_t    inside;     // Reporters in the shard
+    _Atomic uint32_t    sweeping;   // AlertIndexExpire has it
+    uint8_t             pad[36];
+} ALERT_SHARD_T;
+
+typedef struct
+{
+    _Alignas(64) ALERT_SHARD_T shards[ALERT_INDEX_MAX_SHARDS];
+    uint32_t        shardCount;
+    uint32_t        windowMs;
+} ALERT_INDEX_T;
+
+/*******************************************************************************
+* @brief This function sets up an index over a caller owned slot table,
+*       split evenly between the shards.
+*
+* NOTE: nothing is allocated, here or while reporting. The table is cleared.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param ALERT_SLOT_T* slots:           Table, one slot per band with an episode
+* @param uint32_t capacity:             Its size, a power of two
+* @param uint32_t shards:               Shards, a power of two up to
+*                                      ALERT_INDEX_MAX_SHARDS, at least 4
+*                                      slots each
+* @param uint32_t windowMs:             Episode window (ie: ALERT_INDEX_WINDOW_MS)
+*
+* @returns int:                         0 on success, -1 on bad arguments
+*******************************************************************************/
+int AlertIndexInit(ALERT_INDEX_T *index, ALERT_SLOT_T *slots, uint32_t capacity,
+                   uint32_t shards, uint32_t windowMs);
+
+/*******************************************************************************
+* @brief This function folds a batch of decoded reports into the index,
+*       keeping the first report of every episode.
+*
+*   Safe from any number of threads at once, over the same bands or not.
+* An episode is a band and a sequence number: every report of it after the
+* first, from any gateway, is a duplicate. One of an older sequence number
+* (within the window) is stale. Reports without a gesture are skipped.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param const ADV_EVENT_T* reports:    The batch (ie: from AdvDecodeBatch)
+* @param uint32_t count:                Reports in the batch
+* @param ALERT_EPISODE_T* episodes:     Room for count episodes
+* @param ALERT_INDEX_STATS_T* stats:    The caller's counters, added to
+*
+* @returns uint32_t:                    Episodes written
+*******************************************************************************/
+uint32_t AlertIndexBatch(ALERT_INDEX_T *index, const ADV_EVENT_T *reports,
+                         uint32_t count, ALERT_EPISODE_T *episodes,
+                         ALERT_INDEX_STATS_T *stats);
+
+/*******************************************************************************
+* @brief This function frees the slots of the bands whose episode is over:
+*       no report for longer than the window.
+*
+*   Reporters wait while a shard is swept. Not to be called from inside
+* AlertIndexBatch.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param uint32_t shard:                Which shard (0 to shards - 1)
+* @param uint64_t nowUs:                Receive time no later report is older than
+*
+* @returns uint32_t:                    Slots freed
+*******************************************************************************/
+uint32_t AlertIndexExpire(ALERT_INDEX_T *index, uint32_t shard, uint64_t nowUs);
+
+/*******************************************************************************
+* @brief This function reads what the index holds for a band.
+*
+* @param ALERT_INDEX_T* index:          The index
+* @param const uint8_t* addr:           The band's address
+* @param ALERT_BAND_T* band:            Its current episode and counters
+*
+* @returns int:                         0 if found, -1 if the band has none
+*******************************************************************************/
+int AlertIndexLookup(ALERT_INDEX_T *index, const uint8_t *addr, ALERT_BAND_T *band);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,285 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    bandsim.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Command line front-end of the host simulator
+ * @author  prisma.ai
+ *
+ *  bandsim [-s scenario] [-t seconds] [-c name=value]... [-m max_uA] [-v] [-p]
+ *          [-o trace]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <unistd.h>
+#include "sim.h"
+#include "ble_func.h"
+#include "power_stats.h"
+#include "lp_timer.h"
+#include "adv_auth.h"
+#include "event_log.h"
+#include "log_sync.h"
+#include "clk_gov.h"
+#include "deferred.h"
+#include "profiling.h"
+#include "event_trace.h"
+#include "adv_frames.h"
+#include "adv_sched.h"
+#include "scan_telemetry.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_SCENARIO        "idle"
+#define DEFAULT_DURATION_S      (60.0)
+
+/* Exit code when the average current is over the -m budget */
+#define EXIT_OVER_BUDGET        (2)
+
+static SIM_SCENARIO_T scenario;
+
+static const char *const profilingNames[PROFILING_SOURCES] =
+{
+    "button ISR", "timer ISR", "BLE events", "main loop"
+};
+
+/* Profiling builds only: the spans of each source, by cycles */
+static void PrintProfiling(const PROFILING_STATS_T *profiling)
+{
+    uint32 source;
+    uint32 bucket;
+
+    printf("FW stack              %u of %u bytes used at most\n",
+           (unsigned)profiling->stackUsed, (unsigned)profiling->stackSize);
+    for(source = 0u; source < PROFILING_SOURCES; ++source)
+    {
+        printf("FW cycles %-11s %u max |", profilingNames[source],
+               (unsigned)profiling->maxCycles[source]);
+        for(bucket = 0u; bucket < PROFILING_BUCKETS; ++bucket)
+        {
+            if(profiling->buckets[source][bucket] != 0u)
+            {
+                printf(" %s%u: %u", (bucket == PROFILING_BUCKETS - 1u) ? ">=" : "<",
+                       1u << (PROFILING_MIN_LOG2 + bucket - (bucket == PROFILING_BUCKETS - 1u)),
+                       (unsigned)profiling->buckets[source][bucket]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+static void Usage(const char *self)
+{
+    fprintf(stderr,
+        "usage: %s [-s scenario] [-t seconds] [-c name=value]... [-m max_uA] [-v] [-p]\n"
+        "          [-o trace]\n"
+        "  -s  idle, single, double, alert, pairing, long, mixed, history or a\n"
+        "      scenario file\n"
+        "  -t  simulated time in seconds (default %.0f)\n"
+        "  -c  override a model parameter, see -p for the list\n"
+        "  -m  fail if the average current is above max_uA\n"
+        "  -v  trace advertising starts / stops and every payload change on air\n"
+        "  -p  print the model parameters and exit\n"
+        "  -o  write the event trace of the run (EVENT_TRACE builds), see\n"
+        "      tracereplay\n",
+        self, DEFAULT_DURATION_S);
+}
+
+/* EVENT_TRACE builds only: every record of the run, in the trace format */
+static int WriteTrace(const char *path)
+{
+    const EVENT_TRACE_STATS_T *traceStats = GetEventTraceStats();
+    uint32 count;
+    uint32 length;
+    uint8 *data;
+    FILE *file;
+    int result = -1;
+
+    if(traceStats == NULL)
+    {
+        fprintf(stderr, "built without EVENT_TRACE\n");
+        return -1;
+    }
+    count = traceStats->records - traceStats->dropped;
+    data = malloc(EVENT_TRACE_HEADER_LEN + (size_t)count * EVENT_TRACE_RECORD_LEN);
+    file = fopen(path, "wb");
+    if(data != NULL && file != NULL)
+    {
+        length = EventTraceSerialize(data, count);
+        result = (fwrite(data, 1u, length, file) == length) ? 0 : -1;
+    }
+    if(file != NULL && fclose(file) != 0)
+    {
+        result = -1;
+    }
+    free(data);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    SIM_CONFIG_T config;
+    const SIM_STATS_T *stats;
+    const PROFILING_STATS_T *profiling;
+    const char *scenarioName = DEFAULT_SCENARIO;
+    const char *traceOut = NULL;
+    double duration = DEFAULT_DURATION_S;
+    double budget = 0.0;
+    int trace = 0;
+    int opt;
+
+    SimConfigDefaults(&config);
+
+    while((opt = getopt(argc, argv, "s:t:c:m:vpo:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 's':
+                scenarioName = optarg;
+                break;
+            case 't':
+                duration = atof(optarg);
+                break;
+            case 'c':
+                if(SimConfigSet(&config, optarg) != 0)
+                {
+                    fprintf(stderr, "unknown parameter: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                budget = atof(optarg);
+                break;
+            case 'v':
+                trace = 1;
+                break;
+            case 'p':
+                SimConfigPrint(stdout, &config);
+                return EXIT_SUCCESS;
+            case 'o':
+                traceOut = optarg;
+                break;
+            default:
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if(SimScenarioLoad(&scenario, scenarioName) != 0)
+    {
+        fprintf(stderr, "can't load scenario: %s\n", scenarioName);
+        return EXIT_FAILURE;
+    }
+
+    stats = SimRun(&config, &scenario, (uint64_t)(duration * SIM_NS_PER_S), trace);
+    /* Right away, before the stack below is used again */
+    profiling = GetProfilingStats();
+
+    if(traceOut != NULL && WriteTrace(traceOut) != 0)
+    {
+        fprintf(stderr, "can't write the trace: %s\n", traceOut);
+        return EXIT_FAILURE;
+    }
+
+    printf("Scenario              %s (%u presses)\n",
+           scenario.name, scenario.pressCount);
+    SimReport(stdout, &config, stats);
+    printf("ADV pushed / skipped   %u / %u\n",
+           (unsigned)GetAdvUpdateStats()->pushed,
+           (unsigned)GetAdvUpdateStats()->skipped);
+    if(GetAdvFramesStats() != NULL)
+    {
+        printf("FW ADV frames         alert %u / telemetry %u / pairing %u slots, "
+               "%u swaps\n",
+               (unsigned)GetAdvFramesStats()->slots[ADV_FRAME_ALERT],
+               (unsigned)GetAdvFramesStats()->slots[ADV_FRAME_TELEMETRY],
+               (unsigned)GetAdvFramesStats()->slots[ADV_FRAME_PAIRING],
+               (unsigned)GetAdvFramesStats()->swaps);
+    }
+    if(GetAdvPairingStats() != NULL && GetAdvPairingStats()->attempts != 0u)
+    {
+        printf("FW pairing            %u windows (%u directed), %u connected "
+               "(%u directed, last after %.3f ms), %u timeouts\n",
+               (unsigned)GetAdvPairingStats()->attempts,
+               (unsigned)GetAdvPairingStats()->directed,
+               (unsigned)GetAdvPairingStats()->connected,
+               (unsigned)GetAdvPairingStats()->directedConnected,
+               (double)GetAdvPairingStats()->lastTicks * 1000.0 / LP_TIMER_HZ,
+               (unsigned)GetAdvPairingStats()->timeouts);
+    }
+    if(GetScanTelemetryStats() != NULL && GetScanTelemetryStats()->requests != 0u)
+    {
+        printf("FW scan telemetry     %u requests, %u builds\n",
+               (unsigned)GetScanTelemetryStats()->requests,
+               (unsigned)GetScanTelemetryStats()->builds);
+    }
+    printf("FW Deep-Sleep         %u entries, %.4f %%\n",
+           (unsigned)power_stats.deepSleepEntries,
+           100.0 * power_stats.deepSleepTicks / (duration * LP_TIMER_HZ));
+    printf("FW Sleep              %u entries, %.4f %%\n",
+           (unsigned)power_stats.sleepEntries,
+           100.0 * power_stats.sleepTicks / (duration * LP_TIMER_HZ));
+    printf("FW EVENT_CLOSE spins  %u\n", (unsigned)power_stats.closeSpins);
+    printf("FW wakeups            button %u / timer %u / BLE %u\n",
+           (unsigned)power_stats.wakeButton, (unsigned)power_stats.wakeTimer,
+           (unsigned)power_stats.wakeBle);
+    printf("FW ADV signatures     %u (AES blocks %u, pool misses %u, unsaved blocks %u, "
+           "%.1f AES cycles per ADV event)\n",
+           (unsigned)GetAdvAuthStats()->signatures,
+           (unsigned)GetAdvAuthStats()->aesBlocks,
+           (unsigned)GetAdvAuthStats()->misses,
+           (unsigned)GetAdvAuthStats()->unsaved,
+           (stats->advEvents == 0u) ? 0.0 :
+               GetAdvAuthStats()->aesBlocks * config.aesCycles / stats->advEvents);
+    printf("FW event log          %u records, %u rows written (%u errors, "
+           "%u dropped, %u torn rows on boot)\n",
+           (unsigned)GetEventLogStats()->records,
+           (unsigned)GetEventLogStats()->commits,
+           (unsigned)GetEventLogStats()->writeErrors,
+           (unsigned)GetEventLogStats()->dropped,
+           (unsigned)GetEventLogStats()->badRows);
+    printf("FW log sync           %u syncs, %u notifications, %u records "
+           "(MTU %u, %u busy, %u timeouts)\n",
+           (unsigned)GetLogSyncStats()->syncs,
+           (unsigned)GetLogSyncStats()->notifications,
+           (unsigned)GetLogSyncStats()->records,
+           (unsigned)GetLogSyncStats()->mtu,
+           (unsigned)GetLogSyncStats()->busy,
+           (unsigned)GetLogSyncStats()->timeouts);
+    printf("FW clock              LOW %.3f ms / BOOST %.3f ms awake, %u boosts\n",
+           (double)GetClockGovernorStats()->ticks[CLK_GOV_LOW] * 1000.0 / LP_TIMER_HZ,
+           (double)GetClockGovernorStats()->ticks[CLK_GOV_BOOST] * 1000.0 / LP_TIMER_HZ,
+           (unsigned)GetClockGovernorStats()->boosts);
+    printf("FW deferred           %u runs, %.3f ms late at most, %u timer arms\n",
+           (unsigned)GetDeferredStats()->runs,
+           (double)GetDeferredStats()->lateMaxTicks * 1000.0 / LP_TIMER_HZ,
+           (unsigned)GetDeferredStats()->arms);
+    if(profiling != NULL)
+    {
+        PrintProfiling(profiling);
+    }
+    if(GetEventTraceStats() != NULL)
+    {
+        printf("FW event trace        %u records, %u overwritten\n",
+               (unsigned)GetEventTraceStats()->records,
+               (unsigned)GetEventTraceStats()->dropped);
+    }
+
+    if(budget > 0.0 && SimAverageUa(stats) > budget)
+    {
+        printf("\nFAIL: average current %.3f uA is over the %.3f uA budget\n",
+               SimAverageUa(stats), budget);
+        return EXIT_OVER_BUDGET;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,553 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    fleetsim.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Fleet simulator: many virtual bands over a shared virtual clock
+ * @author  prisma.ai
+ *
+ *  Built with -DFW_STATE=__thread (see fw_state.h), so the firmware and
+ * simulator state is per thread. Every band runs the unmodified firmware on
+ * its own thread; the state of a band is its thread's copy plus its
+ * FLEET_BAND_T. A thread, and not a state struct, because a band parks at
+ * the end of an epoch in the middle of its main loop, and the firmware keeps
+ * its state in statics. Two mappings per thread (stack, guard page) put the
+ * limit near 32000 bands with the default vm.max_map_count.
+ *
+ *  The run is cut in epochs of virtual time. In an epoch every band runs
+ * until its clock reaches the end of the epoch (the SimSetHooks() epoch
+ * hook) and hands over to the next band of the run queue. At most
+ * `workers` bands run at once, so the pool keeps that many cores busy
+ * whatever the number of bands. Between two epochs, with every band
+ * parked, the advertising events of the epoch are merged in time order and
+ * written out as ADV_RECORD_T (adv_decoder.h).
+ *
+ *  Band n presses the gestures of SimScenarioRandom(seed + n), and the
+ * output only depends on the seed: the checksum printed at the end is the
+ * same for any number of workers.
+ *
+ *  fleetsim [-n bands] [-t seconds] [-j workers] [-r seed] [-g gap_s]
+ *           [-e epoch_ms] [-o file] [-d]
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include "sim.h"
+#include "adv_auth.h"
+#include "adv_decoder.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_BANDS           (1000u)
+#define DEFAULT_DURATION_S      (120.0)
+#define DEFAULT_SEED            (1u)
+#define DEFAULT_GAP_S           (60.0)      // Mean time between gestures
+#define DEFAULT_EPOCH_MS        (1000u)
+
+#define BAND_STACK_BYTES        (256u * 1024u)
+#define DECODER_BANDS           (1u << 16)  // Band table of the -d consumer
+#define DECODER_BATCH           (256u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32          id;
+    pthread_t       thread;
+    sem_t           go;             // Posted to run the band's next epoch
+
+    /* Advertising events not written out yet */
+    ADV_RECORD_T    *records;
+    uint32          count;
+    uint32          capacity;
+
+    /* Results, once its run is over */
+    double          averageUa;
+    uint32          presses;
+    uint32          advEvents;
+    uint32          recordsLost;    // Out of memory
+} FLEET_BAND_T;
+
+typedef struct
+{
+    FLEET_BAND_T    *bands;
+    uint32          bandCount;
+    uint32          workers;
+    uint64_t        seed;
+    uint64_t        durationNs;
+    uint64_t        epochNs;
+    uint64_t        gapMs;
+    SIM_CONFIG_T    config;
+
+    /* Run queue of the current epoch */
+    uint64_t        epochEnd;
+    atomic_uint     next;           // Next band to start
+    atomic_uint     pending;        // Bands still running
+    sem_t           epochDone;
+
+    /* Output */
+    ADV_RECORD_T    *merged;
+    uint64_t        mergedCapacity;
+    FILE            *out;
+    int             fd;             // Socket pair end, -1 = none
+    uint64_t        written;
+    uint64_t        checksum;       // FNV-1a of the records
+} FLEET_T;
+
+static FLEET_T fleet;
+
+/*******************************************************************************
+* Band threads
+*******************************************************************************/
+/* The band is done with the epoch: start the next queued band */
+static void HandOver(void)
+{
+    uint32 next = atomic_fetch_add(&fleet.next, 1u);
+
+    if(next < fleet.bandCount)
+    {
+        sem_post(&fleet.bands[next].go);
+    }
+    if(atomic_fetch_sub(&fleet.pending, 1u) == 1u)
+    {
+        sem_post(&fleet.epochDone);
+    }
+}
+
+static uint64_t BandEpoch(void *arg, uint64_t nowNs)
+{
+    FLEET_BAND_T *band = arg;
+
+    (void)nowNs;
+    HandOver();
+    sem_wait(&band->go);
+    return fleet.epochEnd;
+}
+
+static void BandAdv(void *arg, uint64_t timeNs, const uint8 *advData,
+                    uint8 advDataLen)
+{
+    FLEET_BAND_T *band = arg;
+    ADV_RECORD_T *record;
+
+    if(band->count == band->capacity)
+    {
+        uint32 capacity = (band->capacity == 0u) ? 64u : 2u * band->capacity;
+        ADV_RECORD_T *records = realloc(band->records, capacity * sizeof(*records));
+
+        if(records == NULL)
+        {
+            ++band->recordsLost;
+            return;
+        }
+        band->records = records;
+        band->capacity = capacity;
+    }
+
+    record = &band->records[band->count++];
+    memset(record, 0, sizeof(*record));
+    record->timeUs = timeNs / SIM_NS_PER_US;
+    SimBandAddress(band->id, record->addr);
+    record->rssi = (int8)(-45 - (int)((timeNs / SIM_NS_PER_MS + band->id) % 40u));
+    record->dataLen = (advDataLen < ADV_RECORD_DATA_LEN) ? advDataLen :
+                      (uint8)(ADV_RECORD_DATA_LEN - 1u);
+    memcpy(record->data, advData, record->dataLen);
+}
+
+static void *BandThread(void *arg)
+{
+    FLEET_BAND_T *band = arg;
+    SIM_SCENARIO_T *scenario = malloc(sizeof(*scenario));
+    SIM_CONFIG_T config = fleet.config;
+    const SIM_STATS_T *stats;
+
+    /* Own advDelay sequence and presses for every band */
+    config.seed = (double)(uint32)(fleet.seed * 2654435761u + band->id);
+    config.bandId = (double)band->id;
+    if(scenario != NULL)
+    {
+        SimScenarioRandom(scenario, fleet.seed + band->id,
+                          fleet.durationNs / SIM_NS_PER_MS, fleet.gapMs);
+        band->presses = scenario->pressCount;
+    }
+
+    sem_wait(&band->go);
+    if(scenario == NULL)
+    {
+        band->recordsLost = 1u;
+        HandOver();
+        return NULL;
+    }
+    SimSetHooks(fleet.epochNs, BandEpoch, BandAdv, band);
+    stats = SimRun(&config, scenario, fleet.durationNs, 0);
+    band->averageUa = SimAverageUa(stats);
+    band->advEvents = stats->advEvents;
+    free(scenario);
+
+    HandOver();
+    return NULL;
+}
+
+/*******************************************************************************
+* Output
+*******************************************************************************/
+static int CompareRecords(const void *a, const void *b)
+{
+    const ADV_RECORD_T *ra = a, *rb = b;
+
+    if(ra->timeUs != rb->timeUs)
+    {
+        return (ra->timeUs < rb->timeUs) ? -1 : 1;
+    }
+    return memcmp(ra->addr, rb->addr, sizeof(ra->addr));
+}
+
+static int WriteAll(int fd, const void *data, size_t length)
+{
+    const uint8 *bytes = data;
+
+    while(length > 0u)
+    {
+        ssize_t n = write(fd, bytes, length);
+
+        if(n <= 0)
+        {
+            return -1;
+        }
+        bytes += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Writes out the records before `until`, in time order */
+static int FlushRecords(uint64_t until)
+{
+    uint64_t total = 0u, i;
+    uint32 b;
+
+    for(b = 0u; b < fleet.bandCount; ++b)
+    {
+        total += fleet.bands[b].count;
+    }
+    if(total > fleet.mergedCapacity)
+    {
+        ADV_RECORD_T *merged = realloc(fleet.merged, total * sizeof(*merged));
+
+        if(merged == NULL)
+        {
+            return -1;
+        }
+        fleet.merged = merged;
+        fleet.mergedCapacity = total;
+    }
+
+    /* Take what is before `until`, keep the rest for the next epoch */
+    total = 0u;
+    for(b = 0u; b < fleet.bandCount; ++b)
+    {
+        FLEET_BAND_T *band = &fleet.bands[b];
+        uint32 kept = 0u, r;
+
+        for(r = 0u; r < band->count; ++r)
+        {
+            if(band->records[r].timeUs * SIM_NS_PER_US < until)
+            {
+                fleet.merged[total++] = band->records[r];
+            }
+            else
+            {
+                band->records[kept++] = band->records[r];
+            }
+        }
+        band->count = kept;
+    }
+    qsort(fleet.merged, total, sizeof(*fleet.merged), CompareRecords);
+
+    for(i = 0u; i < total; ++i)
+    {
+        const uint8 *bytes = (const uint8 *)&fleet.merged[i];
+        size_t k;
+
+        for(k = 0u; k < sizeof(fleet.merged[i]); ++k)
+        {
+            fleet.checksum = (fleet.checksum ^ bytes[k]) * 0x100000001B3ull;
+        }
+    }
+    fleet.written += total;
+
+    if(fleet.out != NULL &&
+       fwrite(fleet.merged, sizeof(*fleet.merged), total, fleet.out) != total)
+    {
+        return -1;
+    }
+    if(fleet.fd >= 0 && WriteAll(fleet.fd, fleet.merged, total * sizeof(*fleet.merged)) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* Gateway side (-d): decodes the stream from the other end of the socket pair
+*******************************************************************************/
+typedef struct
+{
+    int                 fd;
+    ADV_DECODER_T       decoder;
+    ADV_BAND_STATE_T    *table;
+} FLEET_GATEWAY_T;
+
+static void *GatewayThread(void *arg)
+{
+    FLEET_GATEWAY_T *gateway = arg;
+    static ADV_RECORD_T records[DECODER_BATCH];
+    static ADV_EVENT_T events[DECODER_BATCH];
+    size_t have = 0u;
+
+    for(;;)
+    {
+        ssize_t n = read(gateway->fd, (uint8 *)records + have, sizeof(records) - have);
+
+        if(n <= 0)
+        {
+            break;
+        }
+        have += (size_t)n;
+        if(have >= sizeof(records[0]))
+        {
+            uint32 count = (uint32)(have / sizeof(records[0]));
+
+            AdvDecodeBatch(&gateway->decoder, records, count, events);
+            have -= count * sizeof(records[0]);
+            memmove(records, &records[count], have);
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* Main
+*******************************************************************************/
+static double NowSeconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void Usage(const char *self)
+{
+    fprintf(stderr,
+        "usage: %s [-n bands] [-t seconds] [-j workers] [-r seed] [-g gap_s]\n"
+        "          [-e epoch_ms] [-o file] [-d]\n"
+        "  -n  virtual bands (default %u)\n"
+        "  -t  simulated time in seconds (default %.0f)\n"
+        "  -j  bands running at once (default: online CPUs)\n"
+        "  -r  seed of the press workload (default %u)\n"
+        "  -g  mean time between two gestures of a band (default %.0f s)\n"
+        "  -e  epoch of the shared clock (default %u ms)\n"
+        "  -o  write the advertising events to a file (ADV_RECORD_T, time order)\n"
+        "  -d  stream them through a socket pair to the gateway decoder\n",
+        self, DEFAULT_BANDS, DEFAULT_DURATION_S, DEFAULT_SEED, DEFAULT_GAP_S,
+        DEFAULT_EPOCH_MS);
+}
+
+int main(int argc, char **argv)
+{
+    static const uint8 key[MFC_AUTH_KEY_LEN] = ADV_AUTH_MASTER_KEY;
+    FLEET_GATEWAY_T gateway;
+    pthread_t gatewayThread;
+    pthread_attr_t attr;
+    const char *outPath = NULL;
+    double duration = DEFAULT_DURATION_S;
+    double gap = DEFAULT_GAP_S;
+    uint32 epochMs = DEFAULT_EPOCH_MS;
+    int decode = 0;
+    double start, wall, sumUa = 0.0;
+    uint64_t presses = 0u, lost = 0u;
+    uint32 b;
+    int opt;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(&fleet, 0, sizeof(fleet));
+    fleet.bandCount = DEFAULT_BANDS;
+    fleet.workers = (cpus > 0) ? (uint32)cpus : 1u;
+    fleet.seed = DEFAULT_SEED;
+    fleet.fd = -1;
+    fleet.checksum = 0xCBF29CE484222325ull;
+    SimConfigDefaults(&fleet.config);
+
+    while((opt = getopt(argc, argv, "n:t:j:r:g:e:o:dh")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': fleet.bandCount = (uint32)strtoul(optarg, NULL, 0); break;
+            case 't': duration = atof(optarg); break;
+            case 'j': fleet.workers = (uint32)strtoul(optarg, NULL, 0); break;
+            case 'r': fleet.seed = strtoull(optarg, NULL, 0); break;
+            case 'g': gap = atof(optarg); break;
+            case 'e': epochMs = (uint32)strtoul(optarg, NULL, 0); break;
+            case 'o': outPath = optarg; break;
+            case 'd': decode = 1; break;
+            default:
+                Usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if(fleet.bandCount == 0u || fleet.workers == 0u || duration <= 0.0 ||
+       epochMs == 0u || gap < 0.0)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    fleet.durationNs = (uint64_t)(duration * SIM_NS_PER_S);
+    fleet.epochNs = (uint64_t)epochMs * SIM_NS_PER_MS;
+    fleet.gapMs = (uint64_t)(gap * 1000.0);
+
+    if(outPath != NULL)
+    {
+        fleet.out = (strcmp(outPath, "-") == 0) ? stdout : fopen(outPath, "wb");
+        if(fleet.out == NULL)
+        {
+            fprintf(stderr, "can't open %s\n", outPath);
+            return EXIT_FAILURE;
+        }
+    }
+    if(decode)
+    {
+        int pair[2];
+
+        gateway.table = calloc(DECODER_BANDS, sizeof(*gateway.table));
+        if(gateway.table == NULL || socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0 ||
+           AdvDecoderInit(&gateway.decoder, gateway.table, DECODER_BANDS, key,
+                          SimAesEncrypt) != 0)
+        {
+            fprintf(stderr, "can't set up the gateway decoder\n");
+            return EXIT_FAILURE;
+        }
+        fleet.fd = pair[0];
+        gateway.fd = pair[1];
+        pthread_create(&gatewayThread, NULL, GatewayThread, &gateway);
+    }
+
+    fleet.bands = calloc(fleet.bandCount, sizeof(*fleet.bands));
+    if(fleet.bands == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+    sem_init(&fleet.epochDone, 0, 0);
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, BAND_STACK_BYTES);
+    for(b = 0u; b < fleet.bandCount; ++b)
+    {
+        fleet.bands[b].id = b;
+        sem_init(&fleet.bands[b].go, 0, 0);
+        if(pthread_create(&fleet.bands[b].thread, &attr, BandThread, &fleet.bands[b]) != 0)
+        {
+            fprintf(stderr, "can't start band %u (see vm.max_map_count, threads-max)\n", b);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Every band takes part in every epoch, the last one ends the runs */
+    start = NowSeconds();
+    for(fleet.epochEnd = fleet.epochNs; ; fleet.epochEnd += fleet.epochNs)
+    {
+        uint32 w;
+
+        if(fleet.epochEnd > fleet.durationNs)
+        {
+            fleet.epochEnd = fleet.durationNs;
+        }
+        atomic_store(&fleet.pending, fleet.bandCount);
+        atomic_store(&fleet.next, 0u);
+        for(w = 0u; w < fleet.workers; ++w)
+        {
+            uint32 next = atomic_fetch_add(&fleet.next, 1u);
+
+            if(next < fleet.bandCount)
+            {
+                sem_post(&fleet.bands[next].go);
+            }
+        }
+        sem_wait(&fleet.epochDone);
+
+        if(FlushRecords(fleet.epochEnd) != 0)
+        {
+            fprintf(stderr, "can't write the advertising events\n");
+            return EXIT_FAILURE;
+        }
+        if(fleet.epochEnd >= fleet.durationNs)
+        {
+            break;
+        }
+    }
+    wall = NowSeconds() - start;
+
+    for(b = 0u; b < fleet.bandCount; ++b)
+    {
+        pthread_join(fleet.bands[b].thread, NULL);
+        sumUa += fleet.bands[b].averageUa;
+        presses += fleet.bands[b].presses;
+        lost += fleet.bands[b].recordsLost;
+        free(fleet.bands[b].records);
+    }
+    if(fleet.out != NULL && fleet.out != stdout)
+    {
+        fclose(fleet.out);
+    }
+    if(decode)
+    {
+        close(fleet.fd);
+        pthread_join(gatewayThread, NULL);
+    }
+
+    printf("Bands                 %u (%u workers, %u ms epochs)\n",
+           fleet.bandCount, fleet.workers, epochMs);
+    printf("Simulated time        %.3f s\n", duration);
+    printf("Wall time             %.3f s\n", wall);
+    printf("Band-seconds / s      %.1f\n", fleet.bandCount * duration / wall);
+    printf("Presses               %llu\n", (unsigned long long)presses);
+    printf("Advertising events    %llu (%.0f / s of wall time)\n",
+           (unsigned long long)fleet.written, fleet.written / wall);
+    printf("Average current       %.3f uA per band\n", sumUa / fleet.bandCount);
+    printf("Stream checksum       %016llx\n", (unsigned long long)fleet.checksum);
+    if(decode)
+    {
+        const ADV_DECODER_STATS_T *stats = &gateway.decoder.stats;
+
+        printf("Gateway               %llu records, %llu events, %llu duplicates, "
+               "%llu auth failed, %llu replays\n",
+               (unsigned long long)stats->records, (unsigned long long)stats->events,
+               (unsigned long long)stats->duplicates,
+               (unsigned long long)stats->authFailed,
+               (unsigned long long)stats->replays);
+    }
+    if(lost != 0u)
+    {
+        printf("\nFAIL: %llu advertising events lost\n", (unsigned long long)lost);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
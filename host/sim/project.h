@@ -0,0 +1,437 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    project.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Simulated PSoC 4 BLE HAL for the host (Linux) build
+ * @author  prisma.ai
+ *
+ *  Stands in for the PSoC Creator generated project.h when the firmware
+ * is built on the host. Only the parts of cy_boot, the BLE component and
+ * the Alert_Button / Alert_Interrupt components the firmware uses are
+ * declared here; sim_hal.c implements them on top of a virtual clock.
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef SIM_PROJECT_HEADER
+#define SIM_PROJECT_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/*******************************************************************************
+* cytypes.h
+*******************************************************************************/
+typedef uint8_t     uint8;
+typedef uint16_t    uint16;
+typedef uint32_t    uint32;
+typedef int8_t      int8;
+typedef int16_t     int16;
+typedef int32_t     int32;
+
+typedef void (*cyisraddress)(void);
+
+#define CY_ISR(FuncName)        void FuncName(void)
+#define CY_ISR_PROTO(FuncName)  void FuncName(void)
+
+/*******************************************************************************
+* CyLib.h - interrupts, delays, asserts
+*******************************************************************************/
+#define CyGlobalIntEnable       SimGlobalIntEnable()
+#define CyGlobalIntDisable      SimGlobalIntDisable()
+#define CYASSERT(x)             SimAssert((x) != 0, #x, __FILE__, __LINE__)
+
+void SimGlobalIntEnable(void);
+void SimGlobalIntDisable(void);
+void SimAssert(int condition, const char *expr, const char *file, int line);
+
+uint8 CyEnterCriticalSection(void);
+void  CyExitCriticalSection(uint8 savedIntrStatus);
+
+void CyDelay(uint32 milliseconds);
+void CyDelayUs(uint16 microseconds);
+
+/*******************************************************************************
+* CyLib.h - power management
+*******************************************************************************/
+void CySysPmSleep(void);
+void CySysPmDeepSleep(void);
+
+/*******************************************************************************
+* CyLib.h - clocks
+*******************************************************************************/
+#define CY_SYS_CLK_ECO_DIV1             (0u)
+#define CY_SYS_CLK_ECO_DIV2             (1u)
+#define CY_SYS_CLK_ECO_DIV4             (2u)
+#define CY_SYS_CLK_ECO_DIV8             (3u)
+
+#define CY_SYS_CLK_HFCLK_IMO            (0u)
+#define CY_SYS_CLK_HFCLK_EXTCLK         (1u)
+#define CY_SYS_CLK_HFCLK_ECO            (2u)
+
+#define CY_SYS_CLK_IMO_MIN_FREQ_MHZ     (3u)
+#define CY_SYS_CLK_IMO_MAX_FREQ_MHZ     (48u)
+
+void CySysClkWriteEcoDiv(uint32 divider);
+void CySysClkWriteHfclkDirect(uint32 clkSelect);
+void CySysClkWriteImoFreq(uint32 freq);
+void CySysClkImoStart(void);
+void CySysClkImoStop(void);
+void CySysClkIloStart(void);
+void CySysClkIloStop(void);
+
+/*******************************************************************************
+* CyLib.h - interrupt controller
+*******************************************************************************/
+#define CY_INT_WDT_IRQ                  (8u)
+
+cyisraddress CyIntSetVector(uint8 number, cyisraddress address);
+void CyIntEnable(uint8 number);
+void CyIntDisable(uint8 number);
+
+/*******************************************************************************
+* CyLib.h - SysTick, counts down at HFCLK while Active
+*******************************************************************************/
+#define CY_SYS_SYST_RVR_CNT_MASK        (0x00FFFFFFu)
+
+void CySysTickEnable(void);
+void CySysTickDisableInterrupt(void);
+void CySysTickSetReload(uint32 value);
+uint32 CySysTickGetValue(void);
+void CySysTickClear(void);
+
+/*******************************************************************************
+* Stack, for profiling.h: the region below the frame of SimRun(), instead of
+* the cy_boot linker symbols
+*******************************************************************************/
+uint8 *SimStackLimit(void);
+uint8 *SimStackTop(void);
+
+#define PROFILING_STACK_LIMIT           SimStackLimit()
+#define PROFILING_STACK_TOP             SimStackTop()
+
+/*******************************************************************************
+* CyLFClk.h - watchdog timer counters, clocked from LFCLK (WCO, 32.768 kHz)
+*******************************************************************************/
+#define CY_SYS_WDT_COUNTER0             (0u)
+#define CY_SYS_WDT_COUNTER1             (1u)
+#define CY_SYS_WDT_COUNTER2             (2u)
+
+#define CY_SYS_WDT_COUNTER0_MASK        (0x00000001u)
+#define CY_SYS_WDT_COUNTER1_MASK        (0x00000100u)
+#define CY_SYS_WDT_COUNTER2_MASK        (0x00010000u)
+
+#define CY_SYS_WDT_COUNTER0_RESET       (0x01u)
+#define CY_SYS_WDT_COUNTER1_RESET       (0x02u)
+#define CY_SYS_WDT_COUNTER2_RESET       (0x04u)
+
+#define CY_SYS_WDT_COUNTER0_INT         (0x00000004u)
+#define CY_SYS_WDT_COUNTER1_INT         (0x00000400u)
+#define CY_SYS_WDT_COUNTER2_INT         (0x00040000u)
+
+#define CY_SYS_WDT_MODE_NONE            (0u)
+#define CY_SYS_WDT_MODE_INT             (1u)
+#define CY_SYS_WDT_MODE_RESET           (2u)
+#define CY_SYS_WDT_MODE_INT_RESET       (3u)
+
+typedef void (*cyWdtCallback)(void);
+
+void   CySysWdtEnable(uint32 counterMask);
+void   CySysWdtDisable(uint32 counterMask);
+void   CySysWdtWriteMode(uint32 counterNum, uint32 mode);
+void   CySysWdtWriteMatch(uint32 counterNum, uint32 match);
+void   CySysWdtWriteClearOnMatch(uint32 counterNum, uint32 enable);
+uint32 CySysWdtReadCount(uint32 counterNum);
+void   CySysWdtResetCounters(uint32 countersMask);
+void   CySysWdtClearInterrupt(uint32 counterMask);
+cyWdtCallback CySysWdtSetInterruptCallback(uint32 counterNum,
+                                           cyWdtCallback function);
+CY_ISR_PROTO(CySysWdtIsr);
+
+/*******************************************************************************
+* CyFlash.h - CY8C4247: 128 KB in 1024 rows of 128 bytes, memory mapped
+*
+*   Only the top SIM_FLASH_ROWS rows are emulated (sim_flash.c), where the
+* firmware keeps its data. Erased bytes read 0.
+*******************************************************************************/
+#define CY_FLASH_BASE                   (SimFlashBase())
+#define CY_FLASH_SIZEOF_ROW             (128u)
+#define CY_FLASH_NUMBER_ROWS            (1024u)
+#define CY_FLASH_SIZE                   (CY_FLASH_SIZEOF_ROW * CY_FLASH_NUMBER_ROWS)
+
+#define CY_SYS_FLASH_SUCCESS            (0x00u)
+#define CY_SYS_FLASH_INVALID_ADDR       (0x04u)
+#define CY_SYS_FLASH_PROTECTED          (0x05u)
+#define CY_SYS_FLASH_INVALID_CLOCK      (0x12u)
+
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[]);
+uintptr_t SimFlashBase(void);
+
+/*******************************************************************************
+* Alert_Button (Pins component) / Alert_Interrupt (Interrupt component)
+*
+*   Alert_Button_Read() returns the port, one bit per held button (active
+* high: bit 0 = left, bit 1 = right), the band finds the chords in it.
+*******************************************************************************/
+uint8 Alert_Button_Read(void);
+uint8 Alert_Button_ClearInterrupt(void);
+
+void Alert_Interrupt_StartEx(cyisraddress address);
+void Alert_Interrupt_Stop(void);
+
+/*******************************************************************************
+* BLE component
+*******************************************************************************/
+#define CYBLE_GAP_MAX_ADV_DATA_LEN          (31u)
+#define CYBLE_GAP_MAX_SCAN_RSP_DATA_LEN     (31u)
+
+#define CYBLE_ADVERTISING_FAST              (0x00u)
+#define CYBLE_ADVERTISING_SLOW              (0x01u)
+#define CYBLE_ADVERTISING_CUSTOM            (0x02u)
+
+/* CYBLE_GAPP_DISC_PARAM_T advType */
+#define CYBLE_GAPP_CONNECTABLE_UNDIRECTED_ADV       (0x00u)
+#define CYBLE_GAPP_CONNECTABLE_HIGH_DC_DIRECTED_ADV (0x01u)
+#define CYBLE_GAPP_SCANNABLE_UNDIRECTED_ADV         (0x02u)
+#define CYBLE_GAPP_NON_CONNECTABLE_UNDIRECTED_ADV   (0x03u)
+#define CYBLE_GAPP_CONNECTABLE_LOW_DC_DIRECTED_ADV  (0x04u)
+
+/* Device addresses and the bond list */
+#define CYBLE_GAP_BD_ADDR_SIZE              (0x06u)
+#define CYBLE_GAP_MAX_BONDED_DEVICE         (0x04u)
+
+/* GATT: default ATT MTU and the largest one set in the component */
+#define CYBLE_GATT_DEFAULT_MTU              (23u)
+#define CYBLE_GATT_MTU                      (247u)
+
+/* CyBle_GattGetBusyStatus() / CYBLE_EVT_STACK_BUSY_STATUS */
+#define CYBLE_STACK_STATE_FREE              (0x00u)
+#define CYBLE_STACK_STATE_BUSY              (0x01u)
+
+/* CyBle_GattsWriteAttributeValue() flags */
+#define CYBLE_GATT_DB_LOCALLY_INITIATED     (0x00u)
+#define CYBLE_GATT_DB_PEER_INITIATED        (0x40u)
+
+/* ATT opcode and error codes used in error responses */
+#define CYBLE_GATT_WRITE_REQ                (0x12u)
+#define CYBLE_GATT_ERR_NONE                 (0x00u)
+#define CYBLE_GATT_ERR_INVALID_ATTRIBUTE_LEN (0x0Du)
+#define CYBLE_GATT_ERR_REQUEST_NOT_SUPPORTED (0x06u)
+
+/*  Handles of the custom Log Sync service (see log_sync.h), as the
+ * customizer lays out the GATT database */
+#define CYBLE_LOG_SYNC_SERVICE_HANDLE                                       (0x0010u)
+#define CYBLE_LOG_SYNC_RECORDS_CHAR_HANDLE                                  (0x0012u)
+#define CYBLE_LOG_SYNC_RECORDS_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE (0x0013u)
+#define CYBLE_LOG_SYNC_CONTROL_CHAR_HANDLE                                  (0x0015u)
+
+/* Handles of the custom Profiling service (see profiling.h) */
+#define CYBLE_PROFILING_SERVICE_HANDLE                                      (0x0016u)
+#define CYBLE_PROFILING_DATA_CHAR_HANDLE                                    (0x0018u)
+
+/* Handles of the custom Event Trace service (see event_trace.h) */
+#define CYBLE_EVENT_TRACE_SERVICE_HANDLE                                    (0x0019u)
+#define CYBLE_EVENT_TRACE_DATA_CHAR_HANDLE                                  (0x001Bu)
+
+typedef enum
+{
+    CYBLE_ERROR_OK = 0,
+    CYBLE_ERROR_INVALID_PARAMETER,
+    CYBLE_ERROR_INVALID_OPERATION,
+    CYBLE_ERROR_MEMORY_ALLOCATION_FAILED,
+    CYBLE_ERROR_INSUFFICIENT_RESOURCES
+} CYBLE_API_RESULT_T;
+
+typedef enum
+{
+    CYBLE_BLESS_STATE_ACTIVE = 0x01,
+    CYBLE_BLESS_STATE_EVENT_CLOSE,
+    CYBLE_BLESS_STATE_SLEEP,
+    CYBLE_BLESS_STATE_ECO_ON,
+    CYBLE_BLESS_STATE_ECO_STABLE,
+    CYBLE_BLESS_STATE_DEEPSLEEP,
+    CYBLE_BLESS_STATE_HIBERNATE,
+    CYBLE_BLESS_STATE_INVALID = 0xFF
+} CYBLE_BLESS_STATE_T;
+
+typedef enum
+{
+    CYBLE_BLESS_ACTIVE = 0x01,
+    CYBLE_BLESS_SLEEP,
+    CYBLE_BLESS_DEEPSLEEP,
+    CYBLE_BLESS_HIBERNATE,
+    CYBLE_BLESS_INVALID = 0xFF
+} CYBLE_LP_MODE_T;
+
+typedef enum
+{
+    CYBLE_EVT_HOST_INVALID = 0,
+    CYBLE_EVT_STACK_ON,
+    CYBLE_EVT_TIMEOUT,
+    CYBLE_EVT_HARDWARE_ERROR,
+    CYBLE_EVT_STACK_BUSY_STATUS,
+    CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP,
+    CYBLE_EVT_GAP_DEVICE_CONNECTED,
+    CYBLE_EVT_GAP_DEVICE_DISCONNECTED,
+    CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP,
+    CYBLE_EVT_GATT_CONNECT_IND,
+    CYBLE_EVT_GATT_DISCONNECT_IND,
+    CYBLE_EVT_GATTS_XCNHG_MTU_REQ,
+    CYBLE_EVT_GATTS_WRITE_REQ,
+    CYBLE_EVT_GAPP_SCAN_REQ_RECVD
+} CYBLE_EVENT_T;
+
+typedef enum
+{
+    CYBLE_STATE_STOPPED = 0,
+    CYBLE_STATE_INITIALIZING,
+    CYBLE_STATE_CONNECTED,
+    CYBLE_STATE_ADVERTISING,
+    CYBLE_STATE_DISCONNECTED
+} CYBLE_STATE_T;
+
+typedef void (*CYBLE_CALLBACK_T)(uint32 eventCode, void *eventParam);
+
+typedef struct
+{
+    uint8   advData[CYBLE_GAP_MAX_ADV_DATA_LEN];
+    uint8   advDataLen;
+} CYBLE_GAPP_DISC_DATA_T;
+
+typedef struct
+{
+    uint8   scanRspData[CYBLE_GAP_MAX_SCAN_RSP_DATA_LEN];
+    uint8   scanRspDataLen;
+} CYBLE_GAPP_SCAN_RSP_DATA_T;
+
+typedef struct
+{
+    uint16  advIntvMin;         /* Units of 0.625 ms */
+    uint16  advIntvMax;         /* Units of 0.625 ms */
+    uint8   advType;
+    uint8   ownAddrType;
+    uint8   directAddrType;     /* Peer of directed ADV */
+    uint8   directAddr[CYBLE_GAP_BD_ADDR_SIZE];
+    uint8   advChannelMap;
+    uint8   advFilterPolicy;
+} CYBLE_GAPP_DISC_PARAM_T;
+
+typedef struct
+{
+    uint8                           discMode;
+    CYBLE_GAPP_DISC_PARAM_T         *advParam;
+    CYBLE_GAPP_DISC_DATA_T          *advData;
+    CYBLE_GAPP_SCAN_RSP_DATA_T      *scanRspData;
+    uint16                          advTo;
+} CYBLE_GAPP_DISC_MODE_INFO_T;
+
+typedef struct
+{
+    uint8   bdAddr[CYBLE_GAP_BD_ADDR_SIZE];
+    uint8   type;               /* 0 = public, 1 = random */
+} CYBLE_GAP_BD_ADDR_T;
+
+typedef struct
+{
+    uint8               count;
+    CYBLE_GAP_BD_ADDR_T bdAddrList[CYBLE_GAP_MAX_BONDED_DEVICE];
+} CYBLE_GAP_BONDED_DEV_ADDR_LIST_T;
+
+typedef uint16 CYBLE_GATT_DB_ATTR_HANDLE_T;
+
+typedef struct
+{
+    uint8   bdHandle;
+    uint8   attId;
+} CYBLE_CONN_HANDLE_T;
+
+typedef struct
+{
+    uint8   *val;
+    uint16  len;
+    uint16  actualLen;
+} CYBLE_GATT_VALUE_T;
+
+typedef struct
+{
+    CYBLE_GATT_VALUE_T          value;
+    CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle;
+} CYBLE_GATT_HANDLE_VALUE_PAIR_T;
+
+typedef CYBLE_GATT_HANDLE_VALUE_PAIR_T CYBLE_GATTS_HANDLE_VALUE_NTF_T;
+
+/* CYBLE_EVT_GATTS_WRITE_REQ */
+typedef struct
+{
+    CYBLE_CONN_HANDLE_T             connHandle;
+    CYBLE_GATT_HANDLE_VALUE_PAIR_T  handleValPair;
+} CYBLE_GATTS_WRITE_REQ_PARAM_T;
+
+/* CYBLE_EVT_GATTS_XCNHG_MTU_REQ, mtu is the client's Rx MTU */
+typedef struct
+{
+    CYBLE_CONN_HANDLE_T connHandle;
+    uint16              mtu;
+} CYBLE_GATT_XCHG_MTU_PARAM_T;
+
+typedef struct
+{
+    uint8                       opCode;
+    CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle;
+    uint8                       errorCode;
+} CYBLE_GATTS_ERR_PARAM_T;
+
+/* Connection parameters, intervals in 1.25 ms, supervision timeout in 10 ms */
+typedef struct
+{
+    uint16  connIntvMin;
+    uint16  connIntvMax;
+    uint16  connLatency;
+    uint16  supervisionTO;
+} CYBLE_GAP_CONN_UPDATE_PARAM_T;
+
+CYBLE_API_RESULT_T  CyBle_Start(CYBLE_CALLBACK_T callbackFunc);
+void                CyBle_ProcessEvents(void);
+CYBLE_LP_MODE_T     CyBle_EnterLPM(CYBLE_LP_MODE_T pwrMode);
+CYBLE_BLESS_STATE_T CyBle_GetBleSsState(void);
+CYBLE_STATE_T       CyBle_GetState(void);
+
+CYBLE_API_RESULT_T  CyBle_GappStartAdvertisement(uint8 advertisingIntervalType);
+void                CyBle_GappStopAdvertisement(void);
+CYBLE_API_RESULT_T  CyBle_GapUpdateAdvData(
+                        CYBLE_GAPP_DISC_DATA_T *advDiscData,
+                        CYBLE_GAPP_SCAN_RSP_DATA_T *advScanRspData);
+CYBLE_API_RESULT_T  CyBle_GapDisconnect(uint8 bdHandle);
+CYBLE_API_RESULT_T  CyBle_GetDeviceAddress(CYBLE_GAP_BD_ADDR_T *bdAddr);
+CYBLE_API_RESULT_T  CyBle_GapGetBondedDevicesList(
+                        CYBLE_GAP_BONDED_DEV_ADDR_LIST_T *bondedDevList);
+CYBLE_API_RESULT_T  CyBle_L2capLeConnectionParamUpdateRequest(uint8 bdHandle,
+                        CYBLE_GAP_CONN_UPDATE_PARAM_T *connParam);
+
+/* GATT server */
+uint8               CyBle_GattGetBusyStatus(void);
+CYBLE_API_RESULT_T  CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle,
+                        CYBLE_GATTS_HANDLE_VALUE_NTF_T *ntfParam);
+uint8               CyBle_GattsWriteAttributeValue(
+                        CYBLE_GATT_HANDLE_VALUE_PAIR_T *handleValuePair,
+                        uint16 offset, CYBLE_CONN_HANDLE_T *connHandle, uint8 flags);
+CYBLE_API_RESULT_T  CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle);
+CYBLE_API_RESULT_T  CyBle_GattsErrorRsp(CYBLE_CONN_HANDLE_T connHandle,
+                        const CYBLE_GATTS_ERR_PARAM_T *errRspParam);
+
+/* BLESS AES-128 engine (16 byte blocks) and random number generator (8 bytes) */
+CYBLE_API_RESULT_T  CyBle_AesEncrypt(uint8 *plainData, uint8 *aesKey,
+                                     uint8 *encryptedData);
+CYBLE_API_RESULT_T  CyBle_GenerateRandomNumber(uint8 *randomNumber);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,353 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Control interface of the simulated HAL (virtual clock, energy)
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef SIM_HEADER
+#define SIM_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdio.h>
+#include <setjmp.h>
+#include "project.h"
+#include "sim_aes.h"
+#include "sim_flash.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define SIM_NS_PER_US               (1000ull)
+#define SIM_NS_PER_MS               (1000000ull)
+#define SIM_NS_PER_S                (1000000000ull)
+#define SIM_LFCLK_HZ                (32768ull)
+
+#define SIM_MAX_PRESSES             (1024u) // Scripted press events per run
+#ifndef SIM_MAX_ON_AIR
+#define SIM_MAX_ON_AIR              (4096u) // Recorded on-air payload changes
+#endif
+
+/* Power states of the CPU / system (CySysPm*) */
+typedef enum
+{
+    SIM_MCU_ACTIVE = 0,
+    SIM_MCU_SLEEP,
+    SIM_MCU_DEEPSLEEP,
+    SIM_MCU_STATE_COUNT
+} SIM_MCU_STATE_T;
+
+/* Power states of the BLE subsystem, indexes into blessUa[] */
+typedef enum
+{
+    SIM_BLESS_DEEPSLEEP = 0,
+    SIM_BLESS_SLEEP,
+    SIM_BLESS_ECO_ON,
+    SIM_BLESS_EVENT_ACTIVE,
+    SIM_BLESS_EVENT_CLOSE,
+    SIM_BLESS_STATE_COUNT
+} SIM_BLESS_STATE_T;
+
+/*******************************************************************************
+* Configuration - every field can be overridden with "-c name=value"
+*******************************************************************************/
+typedef struct
+{
+    /* Current draw per state, in uA */
+    double mcuActiveBaseUa;     /* Active current at 0 MHz (static part) */
+    double mcuActivePerMhzUa;   /* Active current added per MHz of HFCLK */
+    double mcuSleepUa;
+    double mcuDeepSleepUa;
+    double blessUa[SIM_BLESS_STATE_COUNT];
+
+    /* Clocks */
+    double imoMhz;              /* Until the firmware sets it */
+    double ecoMhz;
+    double imoSwitchUs;         /* One CySysClkWriteImoFreq() change */
+
+    /* Advertising timing */
+    double fastIntervalMs;
+    double slowIntervalMs;
+    double fastTimeoutS;
+    double advDelayMaxMs;       /* Random advDelay added to every event */
+    double ecoStartupUs;
+    double advEventUs;          /* Radio on, all three channels */
+    double directedEventUs;     /* Same, high duty directed (ADV_DIRECT_IND) */
+    double eventCloseUs;
+
+    /* Cost of the stubbed calls, in HFCLK cycles */
+    double processEventsCycles;
+    double advUpdateCycles;
+    double aesCycles;           /* One CyBle_AesEncrypt() block */
+    double flashRowUs;          /* One CySysFlashWriteRow(), erase + program */
+    double isrEntryCycles;
+    double isrCycles;           /* A handler's own code, besides its calls */
+    double wdtSyncLfclk;        /* One WDT register write, in LFCLK cycles */
+    double wakeupUs;            /* Deep-Sleep to Active transition */
+
+    /* Button model */
+    double bounceEdges;         /* Extra edges after every press */
+    double bounceSpacingUs;
+
+    /* Power lost during this row write of the run (sim_flash.c), 0 = never */
+    double flashTearAt;
+
+    /* Central (phone) that connects once and syncs the event log */
+    double connectAtMs;         /* At the first ADV event after this, 0 = never */
+    double scanWindowMs;        /* That it sees, scanning this long ... */
+    double scanIntervalMs;      /* ... out of this, 0 = all the time */
+    double scanPhaseMs;         /* Into its scan interval at time 0 */
+    double centralBonded;       /* 1 = in the band's bond list */
+    double connIntervalMs;      /* Interval it connects with */
+    double connMinIntervalMs;   /* Shortest one it accepts in an update */
+    double connUpdateEvents;    /* Events until an accepted update applies */
+    double connPacketsPerEvent; /* Packets it takes from the band per event */
+    double clientMtu;
+    double llPayloadBytes;      /* 27, up to 251 with Data Length Extension */
+    double txBuffers;           /* Notifications the stack can hold */
+    double syncFrom;            /* First record it asks for */
+    double notifyCycles;        /* One CyBle_GattsNotification() */
+
+    /* Phone scanning actively, it asks for the scan response (SCAN_REQ) */
+    double scannerAtMs;         /* On the ADV events after this, 0 = never */
+    double scannerForMs;        /* For this long, 0 = until the end */
+    double scannerEvery;        /* On one ADV event out of this many, 0 = all */
+
+    /* Charge drawn up to this time goes in SIM_STATS_T.chargeAt, 0 = none */
+    double chargeAtMs;
+
+    /* Battery used for the life projection */
+    double batteryMah;
+    double seed;
+
+    /* Band number, the low 32 bits of its BD address (SimBandAddress) */
+    double bandId;
+} SIM_CONFIG_T;
+
+/* One scripted press: pins go down at timeNs and are held for holdNs */
+typedef struct
+{
+    uint64_t    timeNs;
+    uint64_t    holdNs;
+    uint8       pins;           /* 0x01 = left, 0x02 = right, 0x03 = both */
+} SIM_PRESS_T;
+
+typedef struct
+{
+    const char  *name;
+    uint32      pressCount;
+    SIM_PRESS_T presses[SIM_MAX_PRESSES];
+} SIM_SCENARIO_T;
+
+/* A payload that went on air for the first time at timeNs */
+typedef struct
+{
+    uint64_t    timeNs;
+    uint8       advData[CYBLE_GAP_MAX_ADV_DATA_LEN];
+    uint8       advDataLen;
+} SIM_ON_AIR_T;
+
+/*  Called when the virtual clock reaches the end of an epoch, returns the
+ * end of the next one */
+typedef uint64_t (*SIM_EPOCH_FN_T)(void *arg, uint64_t nowNs);
+
+/* Called at the start of every advertising event, with what goes on air */
+typedef void (*SIM_ADV_FN_T)(void *arg, uint64_t timeNs, const uint8 *advData,
+                             uint8 advDataLen);
+
+/*******************************************************************************
+* Statistics collected during a run
+*******************************************************************************/
+typedef struct
+{
+    uint64_t    mcuNs[SIM_MCU_STATE_COUNT];
+    double      mcuCharge[SIM_MCU_STATE_COUNT];         /* uA * ns */
+    uint64_t    blessNs[SIM_BLESS_STATE_COUNT];
+    double      blessCharge[SIM_BLESS_STATE_COUNT];     /* uA * ns */
+
+    uint32      loopIterations;     /* CyBle_ProcessEvents() calls */
+    uint32      advEvents;
+    uint32      advUpdates;         /* CyBle_GapUpdateAdvData() calls */
+    uint32      advStarts;          /* CyBle_GappStartAdvertisement() calls */
+    uint32      directedEvents;     /* Of advEvents, high duty directed */
+    uint32      scanRequests;       /* Of advEvents, answered to the scanner */
+    uint32      scanRspChanges;     /* Answers that differed from the previous one */
+    uint8       scanRsp[CYBLE_GAP_MAX_SCAN_RSP_DATA_LEN];  /* The last answer */
+    uint8       scanRspLen;
+    uint32      aesBlocks;          /* CyBle_AesEncrypt() calls */
+    uint32      flashWrites;        /* CySysFlashWriteRow() calls */
+    uint8       powerLost;          /* Run cut short by a torn flash write */
+    uint32      sleeps;
+    uint32      deepSleeps;
+    uint32      isrCount;
+    uint64_t    isrNs;
+    uint64_t    isrMaxNs;
+    uint64_t    irqLatencyMaxNs;    /* Button edge to ISR entry */
+    uint32      timerIsrCount;      /* WDT interrupts */
+    uint64_t    timerIsrNs;
+    uint64_t    timerIsrMaxNs;
+    double      activeCycles;       /* HFCLK cycles while Active */
+    uint32      imoChanges;         /* CySysClkWriteImoFreq() that changed it */
+    uint32      connections;
+    uint64_t    connectNs;          /* First CONNECT_IND */
+    double      connectCharge;      /* uA * ns drawn up to it */
+    uint32      connEvents;
+    uint64_t    connNs;             /* Time connected */
+    double      connCharge;         /* uA * ns while connected */
+    uint64_t    connIntervalNs;     /* Last one used */
+    uint16      mtu;                /* Last one exchanged */
+    uint32      llPackets;          /* Notification fragments sent by the band */
+    uint32      notifications;      /* Delivered to the central */
+    uint32      notifyBytes;        /* Their ATT values */
+    uint32      syncRecords;
+    uint32      syncGaps;           /* Notifications that skipped records */
+    double      chargeAt;           /* uA * ns drawn up to chargeAtMs */
+    uint32      onAirCount;
+    SIM_ON_AIR_T onAir[SIM_MAX_ON_AIR];
+} SIM_STATS_T;
+
+/*******************************************************************************
+* @brief Fills a configuration with the default CY8C4247 / CR2032 model.
+*
+* @param SIM_CONFIG_T* config:      The configuration to fill
+*
+* @returns None
+*******************************************************************************/
+void SimConfigDefaults(SIM_CONFIG_T *config);
+
+/*******************************************************************************
+* @brief Overrides one configuration field from a "name=value" string.
+*
+* @param SIM_CONFIG_T* config:      The configuration to change
+* @param const char* assignment:    The "name=value" string
+*
+* @returns int:                     0 on success, -1 for an unknown name
+*******************************************************************************/
+int SimConfigSet(SIM_CONFIG_T *config, const char *assignment);
+
+/*******************************************************************************
+* @brief Prints every configuration field with its current value.
+*
+* @param FILE* out:                 Where to print
+* @param const SIM_CONFIG_T* config: The configuration to print
+*
+* @returns None
+*******************************************************************************/
+void SimConfigPrint(FILE *out, const SIM_CONFIG_T *config);
+
+/*******************************************************************************
+* @brief Loads a built-in scenario ("idle", "single", "double", "alert",
+*       "pairing", "long", "mixed", "history") or a scenario file.
+*
+*   Scenario files hold one press per line: "<time_ms> <pins> <hold_ms>",
+* '#' starts a comment.
+*
+* @param SIM_SCENARIO_T* scenario:  The scenario to fill
+* @param const char* name:          Built-in name or file path
+*
+* @returns int:                     0 on success, -1 if it can't be loaded
+*******************************************************************************/
+int SimScenarioLoad(SIM_SCENARIO_T *scenario, const char *name);
+
+/*******************************************************************************
+* @brief Fills a scenario with random gestures (single, double, alert,
+*       pairing, long), the same ones for the same seed.
+*
+* @param SIM_SCENARIO_T* scenario:  The scenario to fill
+* @param uint64_t seed:             Seed of the workload
+* @param uint64_t durationMs:       Gestures start before this
+* @param uint64_t meanGapMs:        Mean time between two gestures (0 = none)
+*
+* @returns None
+*******************************************************************************/
+void SimScenarioRandom(SIM_SCENARIO_T *scenario, uint64_t seed,
+                       uint64_t durationMs, uint64_t meanGapMs);
+
+/*******************************************************************************
+* @brief Runs the firmware against a scenario until durationNs of virtual
+*       time has passed.
+*
+*   The firmware's main() never returns; the simulation unwinds it from
+* CyBle_ProcessEvents() once the virtual clock reaches the end of the run.
+* Firmware globals are not re-initialized, so use one run per process (per
+* thread in a fleet build).
+*
+* @param const SIM_CONFIG_T* config:    The power / timing model
+* @param const SIM_SCENARIO_T* scenario: The presses to inject
+* @param uint64_t durationNs:           How long to run for
+* @param int trace:                     Print on-air payload changes
+*
+* @returns const SIM_STATS_T*:          The statistics of the run
+*******************************************************************************/
+const SIM_STATS_T *SimRun(const SIM_CONFIG_T *config,
+                          const SIM_SCENARIO_T *scenario,
+                          uint64_t durationNs, int trace);
+
+/*******************************************************************************
+* @brief Sets the hooks of the next SimRun() calls (of the calling thread in
+*       a fleet build).
+*
+*   With an epoch hook, the run calls it every time the virtual clock
+* reaches the end of an epoch, the first one at epochNs. Used by the fleet
+* simulator to step many bands over a shared clock.
+*
+* @param uint64_t epochNs:              End of the first epoch
+* @param SIM_EPOCH_FN_T epoch:          Epoch hook, or NULL
+* @param SIM_ADV_FN_T adv:              Advertising event hook, or NULL
+* @param void* arg:                     Passed to the hooks
+*
+* @returns None
+*******************************************************************************/
+void SimSetHooks(uint64_t epochNs, SIM_EPOCH_FN_T epoch, SIM_ADV_FN_T adv,
+                 void *arg);
+
+/*******************************************************************************
+* @brief Average current of a finished run, in uA.
+*******************************************************************************/
+double SimAverageUa(const SIM_STATS_T *stats);
+
+/*******************************************************************************
+* @brief Prints the energy / residency report of a finished run.
+*
+* @param FILE* out:                 Where to print
+* @param const SIM_CONFIG_T* config: The configuration used for the run
+* @param const SIM_STATS_T* stats:  The statistics of the run
+*
+* @returns None
+*******************************************************************************/
+void SimReport(FILE *out, const SIM_CONFIG_T *config, const SIM_STATS_T *stats);
+
+/*******************************************************************************
+* @brief Current virtual time, in ns.
+*******************************************************************************/
+uint64_t SimNow(void);
+
+/*******************************************************************************
+* @brief BD address of a simulated band, as CyBle_GetDeviceAddress returns
+*       it (LSB first): the band number, then 0x5A 0xC0 (static random).
+*
+* @param uint32 bandId:             The band number (SIM_CONFIG_T.bandId)
+* @param uint8* addr:               CYBLE_GAP_BD_ADDR_SIZE bytes
+*
+* @returns None
+*******************************************************************************/
+void SimBandAddress(uint32 bandId, uint8 *addr);
+
+/*******************************************************************************
+* Firmware entry point - main.c is compiled with -Dmain=FirmwareMain
+*******************************************************************************/
+int FirmwareMain(void);
+
+#endif
+
+/* [] END OF FILE */
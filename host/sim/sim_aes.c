@@ -0,0 +1,182 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim_aes.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   AES-128 encryption (FIPS-197) standing in for the BLESS engine
+ * @author  prisma.ai
+ *
+ *  Plain byte oriented implementation, only encryption is needed. Checked
+ * against the FIPS-197 appendix C.1 vector on the first call. Standard C
+ * only, the gateway tools link it too.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_aes.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define SIM_AES_ROUNDS              (10u)
+
+static const uint8_t simAesSbox[256] =
+{
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint8_t simAesRcon[SIM_AES_ROUNDS] =
+{
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+};
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint8_t Xtime(uint8_t value)
+{
+    return (uint8_t)((value << 1) ^ ((value & 0x80u) ? 0x1Bu : 0x00u));
+}
+
+static void ExpandKey(const uint8_t *key, uint8_t roundKeys[SIM_AES_ROUNDS + 1u][16])
+{
+    uint32_t round, i;
+
+    memcpy(roundKeys[0], key, 16u);
+    for(round = 1u; round <= SIM_AES_ROUNDS; ++round)
+    {
+        const uint8_t *prev = roundKeys[round - 1u];
+        uint8_t *next = roundKeys[round];
+
+        next[0] = prev[0] ^ simAesSbox[prev[13]] ^ simAesRcon[round - 1u];
+        next[1] = prev[1] ^ simAesSbox[prev[14]];
+        next[2] = prev[2] ^ simAesSbox[prev[15]];
+        next[3] = prev[3] ^ simAesSbox[prev[12]];
+        for(i = 4u; i < 16u; ++i)
+        {
+            next[i] = prev[i] ^ next[i - 4u];
+        }
+    }
+}
+
+static void SubShiftRows(uint8_t *state)
+{
+    uint8_t tmp[16];
+    uint32_t column, row;
+
+    /* Row r of column c comes from column c + r */
+    for(column = 0u; column < 4u; ++column)
+    {
+        for(row = 0u; row < 4u; ++row)
+        {
+            tmp[column * 4u + row] = simAesSbox[state[((column + row) % 4u) * 4u + row]];
+        }
+    }
+    memcpy(state, tmp, 16u);
+}
+
+static void MixColumns(uint8_t *state)
+{
+    uint32_t column;
+
+    for(column = 0u; column < 4u; ++column)
+    {
+        uint8_t *c = &state[column * 4u];
+        uint8_t all = c[0] ^ c[1] ^ c[2] ^ c[3];
+        uint8_t first = c[0];
+
+        c[0] ^= all ^ Xtime(c[0] ^ c[1]);
+        c[1] ^= all ^ Xtime(c[1] ^ c[2]);
+        c[2] ^= all ^ Xtime(c[2] ^ c[3]);
+        c[3] ^= all ^ Xtime(c[3] ^ first);
+    }
+}
+
+static void AddRoundKey(uint8_t *state, const uint8_t *roundKey)
+{
+    uint32_t i;
+
+    for(i = 0u; i < 16u; ++i)
+    {
+        state[i] ^= roundKey[i];
+    }
+}
+
+static void Encrypt(const uint8_t *plain, const uint8_t *key, uint8_t *out)
+{
+    uint8_t roundKeys[SIM_AES_ROUNDS + 1u][16];
+    uint8_t state[16];
+    uint32_t round;
+
+    ExpandKey(key, roundKeys);
+    memcpy(state, plain, 16u);
+    AddRoundKey(state, roundKeys[0]);
+    for(round = 1u; round < SIM_AES_ROUNDS; ++round)
+    {
+        SubShiftRows(state);
+        MixColumns(state);
+        AddRoundKey(state, roundKeys[round]);
+    }
+    SubShiftRows(state);
+    AddRoundKey(state, roundKeys[SIM_AES_ROUNDS]);
+    memcpy(out, state, 16u);
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+void SimAesEncrypt(const uint8_t *plain, const uint8_t *key, uint8_t *out)
+{
+    static _Thread_local int checked = 0;   // Per fleet thread
+
+    if(!checked)
+    {
+        static const uint8_t vectorOut[16] =
+        {
+            0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+            0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+        };
+        uint8_t vectorKey[16], vectorIn[16], result[16];
+        uint32_t i;
+
+        for(i = 0u; i < 16u; ++i)
+        {
+            vectorKey[i] = (uint8_t)i;
+            vectorIn[i] = (uint8_t)(i * 0x11u);
+        }
+        Encrypt(vectorIn, vectorKey, result);
+        if(memcmp(result, vectorOut, 16u) != 0)
+        {
+            fprintf(stderr, "sim_aes: FIPS-197 test vector failed\n");
+            abort();
+        }
+        checked = 1;
+    }
+    Encrypt(plain, key, out);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,37 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim_aes.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for sim_aes.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef SIM_AES_HEADER
+#define SIM_AES_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+* @brief Encrypts one block with AES-128, like the BLESS engine does.
+*
+* @param const uint8_t* plain:      16 bytes
+* @param const uint8_t* key:        16 bytes
+* @param uint8_t* out:              16 bytes
+*
+* @returns None
+*******************************************************************************/
+void SimAesEncrypt(const uint8_t *plain, const uint8_t *key, uint8_t *out);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,114 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim_flash.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Emulated flash rows, with torn writes on demand
+ * @author  prisma.ai
+ *
+ *  Backs the memory mapped flash the firmware reads (CY_FLASH_BASE) for the
+ * top SIM_FLASH_ROWS rows. Timing is left to the caller: sim_hal.c charges
+ * the row write to the virtual clock, the benchmarks don't.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <string.h>
+#include "sim_flash.h"
+#include "fw_state.h"
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE uint8_t simFlash[SIM_FLASH_ROWS][CY_FLASH_SIZEOF_ROW];
+static FW_STATE SIM_FLASH_STATS_T simFlashStats;
+static FW_STATE uint32_t simFlashTearIn;       /* Writes until the torn one, 0 = none */
+static FW_STATE uint32_t simFlashRng = 1u;
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32_t TearRandom(void)
+{
+    simFlashRng ^= simFlashRng << 13;
+    simFlashRng ^= simFlashRng >> 17;
+    simFlashRng ^= simFlashRng << 5;
+    return simFlashRng;
+}
+
+static void Tear(uint8_t *row, const uint8_t *data)
+{
+    uint32_t cut = TearRandom() % CY_FLASH_SIZEOF_ROW;
+    uint32_t i;
+
+    if(TearRandom() & 1u)
+    {
+        /* During the erase: some of the old bits are already cleared */
+        for(i = 0u; i < CY_FLASH_SIZEOF_ROW; ++i)
+        {
+            row[i] &= (uint8_t)TearRandom();
+        }
+    }
+    else
+    {
+        /* During the program: a prefix of the new data, the rest erased */
+        memset(row, 0, CY_FLASH_SIZEOF_ROW);
+        memcpy(row, data, cut);
+    }
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+uintptr_t SimFlashBase(void)
+{
+    return (uintptr_t)&simFlash[0][0] - (uintptr_t)SIM_FLASH_FIRST_ROW * CY_FLASH_SIZEOF_ROW;
+}
+
+void SimFlashErase(void)
+{
+    memset(simFlash, 0, sizeof(simFlash));
+    memset(&simFlashStats, 0, sizeof(simFlashStats));
+    simFlashTearIn = 0u;
+}
+
+int SimFlashProgram(uint32_t row, const uint8_t *data)
+{
+    uint8_t *target;
+
+    if(row < SIM_FLASH_FIRST_ROW || row >= CY_FLASH_NUMBER_ROWS || data == NULL)
+    {
+        return SIM_FLASH_BAD_ROW;
+    }
+    target = simFlash[row - SIM_FLASH_FIRST_ROW];
+    ++simFlashStats.writes;
+    ++simFlashStats.rowWrites[row - SIM_FLASH_FIRST_ROW];
+
+    if(simFlashTearIn != 0u && --simFlashTearIn == 0u)
+    {
+        ++simFlashStats.torn;
+        Tear(target, data);
+        return SIM_FLASH_TORN;
+    }
+    memcpy(target, data, CY_FLASH_SIZEOF_ROW);
+    return SIM_FLASH_OK;
+}
+
+void SimFlashTearAt(uint32_t write, uint32_t seed)
+{
+    simFlashTearIn = write;
+    simFlashRng = seed | 1u;
+}
+
+const SIM_FLASH_STATS_T *SimFlashStats(void)
+{
+    return &simFlashStats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,91 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim_flash.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Emulated flash rows, with torn writes on demand
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef SIM_FLASH_HEADER
+#define SIM_FLASH_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdint.h>
+#include "project.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define SIM_FLASH_ROWS              (32u)   // Emulated, the top of the flash
+#define SIM_FLASH_FIRST_ROW         (CY_FLASH_NUMBER_ROWS - SIM_FLASH_ROWS)
+
+/* SimFlashProgram() results */
+#define SIM_FLASH_OK                (0)
+#define SIM_FLASH_TORN              (1)     // Power lost during the write
+#define SIM_FLASH_BAD_ROW           (-1)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32_t    writes;                     // Rows erased + programmed
+    uint32_t    torn;
+    uint32_t    rowWrites[SIM_FLASH_ROWS];  // Per row, for the wear spread
+} SIM_FLASH_STATS_T;
+
+/*******************************************************************************
+* @brief Erases every emulated row and clears the counters. The flash keeps
+*       its content across SimRun() calls, like across resets.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void SimFlashErase(void);
+
+/*******************************************************************************
+* @brief Writes one row (erase + program) into the emulated flash.
+*
+* @param uint32_t row:              Row number, from SIM_FLASH_FIRST_ROW
+* @param const uint8_t* data:       CY_FLASH_SIZEOF_ROW bytes
+*
+* @returns int:                     SIM_FLASH_OK / _TORN / _BAD_ROW
+*******************************************************************************/
+int SimFlashProgram(uint32_t row, const uint8_t *data);
+
+/*******************************************************************************
+* @brief Makes a later write tear, as if the power went away during it.
+*
+*   The torn row is left either half erased (old bits cleared at random) or
+* half programmed (a prefix of the new data, erased after it).
+*
+* @param uint32_t write:            Which write from now, 1 = the next one,
+*                                  0 = none
+* @param uint32_t seed:             Picks where it tears
+*
+* @returns None
+*******************************************************************************/
+void SimFlashTearAt(uint32_t write, uint32_t seed);
+
+/*******************************************************************************
+* @brief Returns the write counters.
+*
+* @param None
+*
+* @returns const SIM_FLASH_STATS_T*: Writes / torn writes / per row writes
+*******************************************************************************/
+const SIM_FLASH_STATS_T *SimFlashStats(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,2438 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim_hal.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Simulated PSoC 4 BLE HAL driven by a virtual clock
+ * @author  prisma.ai
+ *
+ *  Time only moves when the firmware spends it: sleeping, delaying or
+ * calling into the (stubbed) BLE stack. Every nanosecond is charged to
+ * the current CPU power state plus the current BLESS state, which gives
+ * the residency and charge figures printed by SimReport().
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "fw_state.h"
+#include "mfc_payload.h"
+#include "adv_auth.h"
+#include "log_sync.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define SIM_EVENT_QUEUE_SIZE        (16u)   // Pending BLE stack events
+#define SIM_NO_DEADLINE             (UINT64_MAX)
+
+/* Kinds of scripted button edges */
+#define SIM_EDGE_PRESS              (0u)
+#define SIM_EDGE_BOUNCE             (1u)
+#define SIM_EDGE_RELEASE            (2u)
+
+/* Link layer, connection side */
+#define SIM_TX_BUFFERS              (16u)   // Upper bound of tx_buffers
+#define SIM_WRITE_MAX               (8u)    // Longest write of the central
+#define SIM_LL_OVERHEAD_BYTES       (10u)   // Preamble, access address, header, CRC
+#define SIM_LL_IFS_US               (150u)
+#define SIM_LL_BYTE_US              (8u)    // 1 Mbps
+#define SIM_LL_TERMINATE_BYTES      (2u)
+#define SIM_L2CAP_HEADER_BYTES      (4u)
+#define SIM_ATT_NTF_HEADER_BYTES    (3u)    // Opcode, handle
+#define SIM_CONNECT_DELAY_US        (1250.0)// CONNECT_IND to the first event
+#define SIM_SCAN_REQ_BYTES          (12u)   // ScanA, AdvA
+#define SIM_SCAN_RSP_HEADER_BYTES   (6u)    // AdvA, then the scan response data
+
+/* High duty cycle directed advertising (Core spec limits) */
+#define SIM_HIGH_DC_INTERVAL_US     (3750.0)// Between two events, at most
+#define SIM_HIGH_DC_MAX_MS          (1280.0)// Then the link layer stops
+
+/* Steps of the scripted central, in order */
+#define SIM_CENTRAL_MTU             (0u)
+#define SIM_CENTRAL_CCCD            (1u)
+#define SIM_CENTRAL_START           (2u)
+#define SIM_CENTRAL_STREAM          (3u)    // Until the end marker
+#define SIM_CENTRAL_DONE            (4u)
+#define SIM_CENTRAL_IDLE            (5u)
+
+#define SIM_WDT_COUNTERS            (3u)
+#define SIM_WDT_COUNTER_BITS        (0x10000ull)    // Counters 0/1 are 16-bit
+
+/* The firmware stack, for profiling.h: below the frame of SimRun */
+#define SIM_STACK_BYTES             (32u * 1024u)
+
+/*******************************************************************************
+* BLE component data (generated by the customizer on the target)
+*******************************************************************************/
+static const CYBLE_GAPP_DISC_PARAM_T simAdvParamInit =
+{
+    0x00A0u, 0x00A0u, 0x00u, 0x00u, 0x00u, { 0u }, 0x07u, 0x00u
+};
+
+/* Address of the scripted central, in the bond list with central_bonded */
+static const CYBLE_GAP_BD_ADDR_T simCentralAddr =
+{
+    { 0x5Au, 0x3Cu, 0x91u, 0x0Eu, 0x7Bu, 0x4Du }, 0x01u
+};
+
+/*  Flags, Shortened Local Name, Manufacturer Specific Data (mfc_payload.h)
+ * with room for the authenticated payload */
+static const CYBLE_GAPP_DISC_DATA_T simAdvDataInit =
+{
+    {
+        0x02u, 0x01u, 0x06u,
+        0x0Bu, 0x08u, 'S', 'a', 'f', 'e', 'S', 'i', 'g', 'n', 'a', 'l',
+        0x0Fu, 0xFFu, 0xFFu, 0xFFu, 0x01u, 0x00u, 0x00u, 0x00u,
+                                    0x00u, 0x00u, 0x00u, 0x00u,
+                                    0x00u, 0x00u, 0x00u, 0x00u
+    },
+    31u
+};
+
+/* Complete list of 16-bit services (Immediate Alert), TX power level */
+static const CYBLE_GAPP_SCAN_RSP_DATA_T simScanRspDataInit =
+{
+    { 0x03u, 0x03u, 0x02u, 0x18u, 0x02u, 0x0Au, 0x00u },
+    7u
+};
+
+/* What the firmware sees, reset to the above by SimRun */
+static FW_STATE CYBLE_GAPP_DISC_PARAM_T simAdvParam;
+static FW_STATE CYBLE_GAPP_DISC_DATA_T simAdvData;
+static FW_STATE CYBLE_GAPP_SCAN_RSP_DATA_T simScanRspData;
+FW_STATE CYBLE_GAPP_DISC_MODE_INFO_T cyBle_discoveryModeInfo;
+
+/*******************************************************************************
+* Simulator state
+*******************************************************************************/
+typedef struct
+{
+    uint64_t    timeNs;
+    uint8       pins;
+    uint8       kind;
+} SIM_EDGE_T;
+
+/* A stack event and its parameter */
+typedef union
+{
+    CYBLE_CONN_HANDLE_T             conn;
+    CYBLE_GATT_XCHG_MTU_PARAM_T     mtu;
+    CYBLE_GATTS_WRITE_REQ_PARAM_T   write;
+    uint8                           status;
+    uint16                          result;
+} SIM_EVENT_PARAM_T;
+
+typedef struct
+{
+    uint32              event;
+    uint8               hasParam;
+    SIM_EVENT_PARAM_T   param;
+    uint8               value[SIM_WRITE_MAX];   /* Of param.write */
+} SIM_EVENT_T;
+
+/* A notification held by the stack until the link layer sends it */
+typedef struct
+{
+    uint16              len;
+    uint8               value[CYBLE_GATT_MTU - 3u];
+} SIM_NOTIFICATION_T;
+
+typedef struct
+{
+    uint8               enabled;
+    uint8               mode;
+    uint8               clearOnMatch;
+    uint32              match;
+    uint64_t            startTick;      /* LFCLK tick the count is relative to */
+    uint64_t            frozenCount;    /* Count kept while disabled */
+    uint64_t            fireTick;       /* Next match, 0 = none */
+    cyWdtCallback       callback;
+} SIM_WDT_COUNTER_T;
+
+typedef struct
+{
+    SIM_CONFIG_T        config;
+    SIM_STATS_T         stats;
+    uint64_t            now;
+    uint64_t            end;
+    uint64_t            epochEnd;       /* Next SIM_HOOKS_T epoch call */
+    int                 trace;
+    jmp_buf             exitJump;
+    uint32              rng;
+    uint32              trng;           // CyBle_GenerateRandomNumber()
+
+    /* CPU */
+    uint8               intEnabled;
+    uint8               inIsr;
+    uint8               isrBodyDue;     /* isrCycles not charged yet */
+    uint8               isrTicksRead;   /* The handler read SysTick */
+    uint32              hfclkSelect;
+    uint32              ecoDiv;
+    double              imoMhz;
+    uint8               imoRunning;
+    uint8               iloRunning;
+    uint32              systickReload;
+    double              systickCleared; /* stats.activeCycles at the clear */
+    uint8               *stackTop;
+
+    /* Buttons */
+    cyisraddress        buttonIsr;
+    SIM_EDGE_T          *edges;
+    uint32              edgeCount;
+    uint32              nextEdge;
+    uint8               held;
+    uint8               intrStatus;
+    uint32              intrCleared;    /* Pin and WDT ClearInterrupt() calls */
+    uint64_t            pendingSince;
+
+    /* Watchdog timer counters */
+    SIM_WDT_COUNTER_T   wdt[SIM_WDT_COUNTERS];
+    uint32              wdtIntr;        /* CY_SYS_WDT_COUNTERx_INT bits */
+    cyisraddress        wdtVector;
+    uint8               wdtIrqEnabled;
+
+    /* BLE */
+    CYBLE_CALLBACK_T    bleCallback;
+    SIM_EVENT_T         events[SIM_EVENT_QUEUE_SIZE];
+    uint32              eventHead;
+    uint32              eventTail;
+    CYBLE_LP_MODE_T     blessLpMode;
+    uint8               advertising;
+    uint8               advIntervalType;
+    uint8               advOnAirDone;
+    uint8               advDirected;    /* High duty directed, no payload */
+    uint8               advToCentral;   /* Directed to the scripted central */
+    uint64_t            advStart;
+    uint64_t            advEvent;       /* Radio-on time of current/next event */
+    uint64_t            advScanNs;      /* SCAN_REQ / SCAN_RSP in this event */
+    uint32              scannerSeen;    /* ADV events the scanner saw */
+    CYBLE_GAPP_DISC_DATA_T      llAdvData;  /* Copy held by the link layer */
+    CYBLE_GAPP_SCAN_RSP_DATA_T  llScanRspData;
+
+    /* Connection, with the scripted central */
+    uint8               connectPending; /* CONNECT_IND on this ADV event */
+    uint8               connected;
+    uint8               connEventDone;
+    uint8               terminate;      /* 1 = asked for, 2 = sent */
+    uint8               central;        /* SIM_CENTRAL_* */
+    uint8               centralWait;    /* Request sent, no response yet */
+    uint8               centralSynced;  /* centralNext is known */
+    uint8               mtuRsp;         /* Responses the band owes */
+    uint8               writeRsp;       /* ATT length of it, 0 = none */
+    uint8               txFull;         /* STACK_BUSY_STATUS busy posted */
+    uint16              mtu;
+    uint64_t            connStart;
+    uint64_t            connEvent;      /* Anchor of current/next event */
+    uint64_t            connActiveNs;   /* Radio time of the current event */
+    uint64_t            connIntervalNs;
+    uint64_t            updateIntervalNs;   /* Accepted update, 0 = none */
+    uint32              updateIn;       /* Events until it applies */
+    uint32              centralNext;    /* Next record the central expects */
+    SIM_NOTIFICATION_T  tx[SIM_TX_BUFFERS];
+    uint32              txHead;
+    uint32              txCount;
+    uint32              txSent;         /* Bytes of tx[txHead] already sent */
+} SIM_STATE_T;
+
+/* Set with SimSetHooks, kept across SimRun */
+typedef struct
+{
+    uint64_t            epochNs;
+    SIM_EPOCH_FN_T      epoch;
+    SIM_ADV_FN_T        adv;
+    void                *arg;
+} SIM_HOOKS_T;
+
+static FW_STATE SIM_STATE_T simState;
+static FW_STATE SIM_STATE_T *sim = NULL;     /* &simState once running */
+static FW_STATE SIM_HOOKS_T simHooks;
+
+/*******************************************************************************
+* Configuration parameters, by name
+*******************************************************************************/
+typedef struct
+{
+    const char  *name;
+    size_t      offset;
+} SIM_PARAM_T;
+
+static const SIM_PARAM_T simParams[] =
+{
+    { "active_base_ua",         offsetof(SIM_CONFIG_T, mcuActiveBaseUa) },
+    { "active_per_mhz_ua",      offsetof(SIM_CONFIG_T, mcuActivePerMhzUa) },
+    { "sleep_ua",               offsetof(SIM_CONFIG_T, mcuSleepUa) },
+    { "deepsleep_ua",           offsetof(SIM_CONFIG_T, mcuDeepSleepUa) },
+    { "bless_deepsleep_ua",     offsetof(SIM_CONFIG_T, blessUa[SIM_BLESS_DEEPSLEEP]) },
+    { "bless_sleep_ua",         offsetof(SIM_CONFIG_T, blessUa[SIM_BLESS_SLEEP]) },
+    { "bless_eco_on_ua",        offsetof(SIM_CONFIG_T, blessUa[SIM_BLESS_ECO_ON]) },
+    { "bless_event_active_ua",  offsetof(SIM_CONFIG_T, blessUa[SIM_BLESS_EVENT_ACTIVE]) },
+    { "bless_event_close_ua",   offsetof(SIM_CONFIG_T, blessUa[SIM_BLESS_EVENT_CLOSE]) },
+    { "imo_mhz",                offsetof(SIM_CONFIG_T, imoMhz) },
+    { "eco_mhz",                offsetof(SIM_CONFIG_T, ecoMhz) },
+    { "imo_switch_us",          offsetof(SIM_CONFIG_T, imoSwitchUs) },
+    { "fast_interval_ms",       offsetof(SIM_CONFIG_T, fastIntervalMs) },
+    { "slow_interval_ms",       offsetof(SIM_CONFIG_T, slowIntervalMs) },
+    { "fast_timeout_s",         offsetof(SIM_CONFIG_T, fastTimeoutS) },
+    { "adv_delay_max_ms",       offsetof(SIM_CONFIG_T, advDelayMaxMs) },
+    { "eco_startup_us",         offsetof(SIM_CONFIG_T, ecoStartupUs) },
+    { "adv_event_us",           offsetof(SIM_CONFIG_T, advEventUs) },
+    { "directed_event_us",      offsetof(SIM_CONFIG_T, directedEventUs) },
+    { "event_close_us",         offsetof(SIM_CONFIG_T, eventCloseUs) },
+    { "process_events_cycles",  offsetof(SIM_CONFIG_T, processEventsCycles) },
+    { "adv_update_cycles",      offsetof(SIM_CONFIG_T, advUpdateCycles) },
+    { "aes_cycles",             offsetof(SIM_CONFIG_T, aesCycles) },
+    { "flash_row_us",           offsetof(SIM_CONFIG_T, flashRowUs) },
+    { "isr_entry_cycles",       offsetof(SIM_CONFIG_T, isrEntryCycles) },
+    { "isr_cycles",             offsetof(SIM_CONFIG_T, isrCycles) },
+    { "wdt_sync_lfclk",         offsetof(SIM_CONFIG_T, wdtSyncLfclk) },
+    { "wakeup_us",              offsetof(SIM_CONFIG_T, wakeupUs) },
+    { "bounce_edges",           offsetof(SIM_CONFIG_T, bounceEdges) },
+    { "bounce_spacing_us",      offsetof(SIM_CONFIG_T, bounceSpacingUs) },
+    { "flash_tear_at",          offsetof(SIM_CONFIG_T, flashTearAt) },
+    { "connect_at_ms",          offsetof(SIM_CONFIG_T, connectAtMs) },
+    { "scan_window_ms",         offsetof(SIM_CONFIG_T, scanWindowMs) },
+    { "scan_interval_ms",       offsetof(SIM_CONFIG_T, scanIntervalMs) },
+    { "scan_phase_ms",          offsetof(SIM_CONFIG_T, scanPhaseMs) },
+    { "central_bonded",         offsetof(SIM_CONFIG_T, centralBonded) },
+    { "scanner_at_ms",          offsetof(SIM_CONFIG_T, scannerAtMs) },
+    { "scanner_for_ms",         offsetof(SIM_CONFIG_T, scannerForMs) },
+    { "scanner_every",          offsetof(SIM_CONFIG_T, scannerEvery) },
+    { "conn_interval_ms",       offsetof(SIM_CONFIG_T, connIntervalMs) },
+    { "conn_min_interval_ms",   offsetof(SIM_CONFIG_T, connMinIntervalMs) },
+    { "conn_update_events",     offsetof(SIM_CONFIG_T, connUpdateEvents) },
+    { "conn_packets_per_event", offsetof(SIM_CONFIG_T, connPacketsPerEvent) },
+    { "client_mtu",             offsetof(SIM_CONFIG_T, clientMtu) },
+    { "ll_payload_bytes",       offsetof(SIM_CONFIG_T, llPayloadBytes) },
+    { "tx_buffers",             offsetof(SIM_CONFIG_T, txBuffers) },
+    { "sync_from",              offsetof(SIM_CONFIG_T, syncFrom) },
+    { "notify_cycles",          offsetof(SIM_CONFIG_T, notifyCycles) },
+    { "charge_at_ms",           offsetof(SIM_CONFIG_T, chargeAtMs) },
+    { "battery_mah",            offsetof(SIM_CONFIG_T, batteryMah) },
+    { "seed",                   offsetof(SIM_CONFIG_T, seed) },
+    { "band_id",                offsetof(SIM_CONFIG_T, bandId) },
+};
+
+#define SIM_PARAM_COUNT     (sizeof(simParams) / sizeof(simParams[0]))
+
+static const char *const mcuStateNames[SIM_MCU_STATE_COUNT] =
+{
+    "Active", "Sleep", "Deep-Sleep"
+};
+
+static const char *const blessStateNames[SIM_BLESS_STATE_COUNT] =
+{
+    "Deep-Sleep", "Sleep", "ECO on", "Event active", "Event close"
+};
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint64_t UsToNs(double us)
+{
+    return (uint64_t)(us * 1000.0 + 0.5);
+}
+
+static uint64_t NowTicks(void)
+{
+    return sim->now * SIM_LFCLK_HZ / SIM_NS_PER_S;
+}
+
+static uint64_t TicksToNs(uint64_t ticks)
+{
+    /* First ns at which NowTicks() reads "ticks" */
+    return (ticks * SIM_NS_PER_S + SIM_LFCLK_HZ - 1u) / SIM_LFCLK_HZ;
+}
+
+static uint32 WdtIntBit(uint32 counterNum)
+{
+    return CY_SYS_WDT_COUNTER0_INT << (counterNum * 8u);
+}
+
+static uint64_t WdtCount(const SIM_WDT_COUNTER_T *counter, uint32 counterNum)
+{
+    uint64_t count = counter->enabled ?
+                     NowTicks() - counter->startTick : counter->frozenCount;
+
+    if(counterNum == CY_SYS_WDT_COUNTER2)
+    {
+        return count & 0xFFFFFFFFull;
+    }
+    if(counter->clearOnMatch)
+    {
+        return count % ((uint64_t)counter->match + 1u);
+    }
+    return count % SIM_WDT_COUNTER_BITS;
+}
+
+/* Work out the tick of the next match interrupt of counter 0 / 1 */
+static void WdtSchedule(uint32 counterNum)
+{
+    SIM_WDT_COUNTER_T *counter = &sim->wdt[counterNum];
+    uint64_t now = NowTicks();
+    uint64_t period = counter->clearOnMatch ?
+                      (uint64_t)counter->match + 1u : SIM_WDT_COUNTER_BITS;
+    uint64_t elapsed;
+
+    counter->fireTick = 0u;
+    if(counterNum == CY_SYS_WDT_COUNTER2 || !counter->enabled ||
+       (counter->mode & CY_SYS_WDT_MODE_INT) == 0u)
+    {
+        return;
+    }
+
+    elapsed = now - counter->startTick;
+    counter->fireTick = counter->startTick + (elapsed / period) * period +
+                        (counter->match % period);
+    if(counter->fireTick <= now)
+    {
+        counter->fireTick += period;
+    }
+}
+
+static uint64_t WdtNextFireNs(void)
+{
+    uint64_t next = SIM_NO_DEADLINE;
+    uint32 i;
+
+    for(i = 0u; i < SIM_WDT_COUNTERS; ++i)
+    {
+        if(sim->wdt[i].fireTick != 0u && TicksToNs(sim->wdt[i].fireTick) < next)
+        {
+            next = TicksToNs(sim->wdt[i].fireTick);
+        }
+    }
+    return next;
+}
+
+static void WdtUpdate(void)
+{
+    uint64_t now = NowTicks();
+    uint32 i;
+
+    for(i = 0u; i < SIM_WDT_COUNTERS; ++i)
+    {
+        if(sim->wdt[i].fireTick != 0u && sim->wdt[i].fireTick <= now)
+        {
+            sim->wdtIntr |= WdtIntBit(i);
+            WdtSchedule(i);
+        }
+    }
+}
+
+static uint32 SimRandom(void)
+{
+    /* xorshift32, reproducible from the "seed" parameter */
+    sim->rng ^= sim->rng << 13;
+    sim->rng ^= sim->rng >> 17;
+    sim->rng ^= sim->rng << 5;
+    return sim->rng;
+}
+
+static uint32 SimTrueRandom(void)
+{
+    /*  Own xorshift32, so the radio's advDelay sequence doesn't depend on
+     * how often the firmware asks for random numbers */
+    sim->trng ^= sim->trng << 13;
+    sim->trng ^= sim->trng >> 17;
+    sim->trng ^= sim->trng << 5;
+    return sim->trng;
+}
+
+static double HfclkMhz(void)
+{
+    if(sim->hfclkSelect == CY_SYS_CLK_HFCLK_ECO)
+    {
+        return sim->config.ecoMhz / (double)(1u << sim->ecoDiv);
+    }
+    return sim->imoMhz;
+}
+
+static uint64_t CyclesToNs(double cycles)
+{
+    return (uint64_t)(cycles * 1000.0 / HfclkMhz() + 0.5);
+}
+
+static double McuUa(SIM_MCU_STATE_T state)
+{
+    switch(state)
+    {
+        case SIM_MCU_ACTIVE:
+            return sim->config.mcuActiveBaseUa +
+                   sim->config.mcuActivePerMhzUa * HfclkMhz();
+        case SIM_MCU_SLEEP:
+            return sim->config.mcuSleepUa;
+        default:
+            return sim->config.mcuDeepSleepUa;
+    }
+}
+
+static uint64_t AdvIntervalNs(void)
+{
+    if(sim->advDirected)
+    {
+        return UsToNs(SIM_HIGH_DC_INTERVAL_US);
+    }
+    switch(sim->advIntervalType)
+    {
+        case CYBLE_ADVERTISING_FAST:
+            return UsToNs(sim->config.fastIntervalMs * 1000.0);
+        case CYBLE_ADVERTISING_SLOW:
+            return UsToNs(sim->config.slowIntervalMs * 1000.0);
+        default:
+            return (uint64_t)cyBle_discoveryModeInfo.advParam->advIntvMin * 625000ull;
+    }
+}
+
+static uint64_t AdvDelayNs(void)
+{
+    uint64_t maxNs = UsToNs(sim->config.advDelayMaxMs * 1000.0);
+    return (maxNs == 0u || sim->advDirected) ? 0u : (SimRandom() % (maxNs + 1u));
+}
+
+/* Radio-on time of the current/next advertising or connection event */
+static uint64_t RadioEventStart(void)
+{
+    return sim->connected ? sim->connEvent : sim->advEvent;
+}
+
+static uint64_t RadioEventOff(void)
+{
+    return sim->connected ? sim->connEvent + sim->connActiveNs :
+                            sim->advEvent + sim->advScanNs + UsToNs(sim->advDirected ?
+                                sim->config.directedEventUs : sim->config.advEventUs);
+}
+
+static uint64_t RadioEventEnd(void)
+{
+    return RadioEventOff() + UsToNs(sim->config.eventCloseUs);
+}
+
+/* Queues a stack event, returns it so the caller can add a parameter */
+static SIM_EVENT_T *PostEvent(uint32 event)
+{
+    uint32 next = (sim->eventHead + 1u) % SIM_EVENT_QUEUE_SIZE;
+    SIM_EVENT_T *entry = &sim->events[sim->eventHead];
+
+    if(next == sim->eventTail)
+    {
+        return NULL;
+    }
+    memset(entry, 0, sizeof(*entry));
+    entry->event = event;
+    sim->eventHead = next;
+    return entry;
+}
+
+/* BLESS state at time t, and the time it changes */
+static SIM_BLESS_STATE_T BlessStateAt(uint64_t t, uint64_t *until)
+{
+    SIM_BLESS_STATE_T idle = (sim->blessLpMode == CYBLE_BLESS_DEEPSLEEP) ?
+                             SIM_BLESS_DEEPSLEEP : SIM_BLESS_SLEEP;
+    uint64_t eco = UsToNs(sim->config.ecoStartupUs);
+    uint64_t start = RadioEventStart();
+    uint64_t ecoStart = (start > eco) ? start - eco : 0u;
+
+    if(!sim->advertising && !sim->connected)
+    {
+        *until = SIM_NO_DEADLINE;
+        return idle;
+    }
+    if(t < ecoStart)
+    {
+        *until = ecoStart;
+        return idle;
+    }
+    if(t < start)
+    {
+        *until = start;
+        return SIM_BLESS_ECO_ON;
+    }
+    if(t < RadioEventOff())
+    {
+        *until = RadioEventOff();
+        return SIM_BLESS_EVENT_ACTIVE;
+    }
+    *until = RadioEventEnd();
+    return SIM_BLESS_EVENT_CLOSE;
+}
+
+/*  Checks a version 2 tag like a gateway would, with the band's key derived
+ * from the development master key */
+static int VerifyMfcTag(const uint8 *data, const MFC_PAYLOAD_T *payload)
+{
+    static const uint8 master[MFC_AUTH_KEY_LEN] = ADV_AUTH_MASTER_KEY;
+    uint8 in[MFC_AUTH_BLOCK_LEN], block[MFC_AUTH_BLOCK_LEN];
+    uint8 key[MFC_AUTH_KEY_LEN];
+    uint8 rows[MFC_AUTH_HASH_BLOCKS * MFC_AUTH_BLOCK_LEN];
+    uint8 addr[MFC_AUTH_ADDR_LEN];
+    uint32 i;
+
+    SimBandAddress((uint32)sim->config.bandId, addr);
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_BAND_KEY, addr, 0u);
+    SimAesEncrypt(in, master, key);
+    for(i = 0u; i < MFC_AUTH_HASH_BLOCKS; ++i)
+    {
+        MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_HASH, addr, i);
+        SimAesEncrypt(in, key, &rows[i * MFC_AUTH_BLOCK_LEN]);
+    }
+    MfcAuthBlockInput(in, MFC_AUTH_DOMAIN_KEYSTREAM, addr,
+                      payload->counter / MFC_AUTH_WORDS_PER_BLOCK);
+    SimAesEncrypt(in, key, block);
+    return (MfcAuthHashRows(rows, data) ^
+            MfcAuthKeystreamWord(block, payload->counter)) == payload->tag;
+}
+
+/* Decoded Manufacturer Specific Data, for the trace */
+static void TraceMfcPayload(const CYBLE_GAPP_DISC_DATA_T *advData)
+{
+    MFC_PAYLOAD_T payload;
+    uint8 length = 0u;
+    int index = MfcPayloadFind(advData->advData, advData->advDataLen, &length);
+
+    if(index >= 0 &&
+       MfcPayloadDecode(&advData->advData[index], length, &payload) == 0)
+    {
+        printf("  [presses %u%s seq %u up %u min", payload.presses,
+               (payload.flags & MFC_FLAG_PAIRING) ? " pairing" : "",
+               payload.seq, payload.uptimeMinutes);
+        if(payload.version == MFC_PAYLOAD_VERSION_AUTH)
+        {
+            printf(" ctr %08x auth %s", payload.counter,
+                   VerifyMfcTag(&advData->advData[index], &payload) ? "ok" : "FAIL");
+        }
+        printf("]");
+    }
+}
+
+/*******************************************************************************
+* Connection model
+*
+*   One scripted central connects on an advertising event, exchanges the
+* MTU, enables the Records notifications, writes LOG_SYNC_OP_START and,
+* once it has the end marker, LOG_SYNC_OP_DONE. It sends one request per
+* connection event and waits for its response. Every connection event is
+* a string of exchanges (central packet, band packet, each followed by an
+* inter frame space) up to conn_packets_per_event, the band sending what
+* its stack holds: responses first, then notifications, ll_payload_bytes
+* per packet.
+*   From connect_at_ms on, it scans scan_window_ms of every scan_interval_ms
+* (all the time if 0), scan_phase_ms into its interval at time 0, and
+* connects on the first advertising event that starts in a window. It only
+* takes directed ADV addressed to it, from a band it is bonded with
+* (central_bonded).
+*   Another phone, the scanner, scans actively from scanner_at_ms on, for
+* scanner_for_ms: on one undirected advertising event out of scanner_every
+* it sends a SCAN_REQ, the link layer answers with the scan response it
+* holds and the stack posts CYBLE_EVT_GAPP_SCAN_REQ_RECVD. The exchange
+* keeps the radio on a little longer in that event.
+*******************************************************************************/
+static uint32 TxBuffers(void)
+{
+    uint32 buffers = (uint32)sim->config.txBuffers;
+
+    if(buffers == 0u)
+    {
+        return 1u;
+    }
+    return (buffers > SIM_TX_BUFFERS) ? SIM_TX_BUFFERS : buffers;
+}
+
+static uint64_t ExchangeNs(uint32 centralLen, uint32 bandLen)
+{
+    return (uint64_t)((centralLen + bandLen + 2u * SIM_LL_OVERHEAD_BYTES) * SIM_LL_BYTE_US +
+                      2u * SIM_LL_IFS_US) * SIM_NS_PER_US;
+}
+
+/* Charge drawn so far, uA * ns */
+static double StatsCharge(const SIM_STATS_T *stats)
+{
+    double charge = 0.0;
+    uint32 i;
+
+    for(i = 0u; i < SIM_MCU_STATE_COUNT; ++i)
+    {
+        charge += stats->mcuCharge[i];
+    }
+    for(i = 0u; i < SIM_BLESS_STATE_COUNT; ++i)
+    {
+        charge += stats->blessCharge[i];
+    }
+    return charge;
+}
+
+/* Whether the central sees the advertising event at t and connects on it */
+static int CentralConnects(uint64_t t)
+{
+    uint64_t from = UsToNs(sim->config.connectAtMs * 1000.0);
+    uint64_t window = UsToNs(sim->config.scanWindowMs * 1000.0);
+    uint64_t interval = UsToNs(sim->config.scanIntervalMs * 1000.0);
+
+    if(sim->config.connectAtMs <= 0.0 || sim->stats.connections != 0u || t < from)
+    {
+        return 0;
+    }
+    if(sim->advDirected && (!sim->advToCentral || sim->config.centralBonded == 0.0))
+    {
+        return 0;
+    }
+    return (window == 0u || window >= interval ||
+            (t + UsToNs(sim->config.scanPhaseMs * 1000.0)) % interval < window);
+}
+
+/* Whether the scanner asks for the scan response on the advertising event at t */
+static int ScannerAsks(uint64_t t)
+{
+    uint64_t from = UsToNs(sim->config.scannerAtMs * 1000.0);
+    uint64_t span = UsToNs(sim->config.scannerForMs * 1000.0);
+    uint32 every = (sim->config.scannerEvery < 1.0) ? 1u : (uint32)sim->config.scannerEvery;
+
+    if(sim->config.scannerAtMs <= 0.0 || sim->advDirected || t < from ||
+       (span != 0u && t >= from + span))
+    {
+        return 0;
+    }
+    return (sim->scannerSeen++ % every) == 0u;
+}
+
+/* Answers the scanner with what the link layer holds */
+static void ScanResponse(void)
+{
+    SIM_STATS_T *stats = &sim->stats;
+    const CYBLE_GAPP_SCAN_RSP_DATA_T *rsp = &sim->llScanRspData;
+
+    sim->advScanNs = ExchangeNs(SIM_SCAN_REQ_BYTES,
+                                SIM_SCAN_RSP_HEADER_BYTES + rsp->scanRspDataLen);
+    if(stats->scanRequests++ == 0u || stats->scanRspLen != rsp->scanRspDataLen ||
+       memcmp(stats->scanRsp, rsp->scanRspData, rsp->scanRspDataLen) != 0)
+    {
+        ++stats->scanRspChanges;
+        stats->scanRspLen = rsp->scanRspDataLen;
+        memcpy(stats->scanRsp, rsp->scanRspData, sizeof(stats->scanRsp));
+
+        if(sim->trace)
+        {
+            uint32 i;
+            printf("%12.3f ms  scan rsp answered:", (double)sim->advEvent / SIM_NS_PER_MS);
+            for(i = 0u; i < rsp->scanRspDataLen; ++i)
+            {
+                printf(" %02x", rsp->scanRspData[i]);
+            }
+            printf("\n");
+        }
+    }
+    PostEvent(CYBLE_EVT_GAPP_SCAN_REQ_RECVD);
+}
+
+static uint32 Get32(const uint8 *data)
+{
+    return (uint32)data[0] | ((uint32)data[1] << 8) |
+           ((uint32)data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+static void Connect(void)
+{
+    SIM_EVENT_T *event;
+
+    sim->connectPending = 0u;
+    sim->advertising = 0u;
+    sim->connected = 1u;
+    sim->connEventDone = 0u;
+    sim->terminate = 0u;
+    sim->central = SIM_CENTRAL_MTU;
+    sim->centralWait = 0u;
+    sim->centralSynced = 0u;
+    sim->mtuRsp = 0u;
+    sim->writeRsp = 0u;
+    sim->txFull = 0u;
+    sim->txHead = 0u;
+    sim->txCount = 0u;
+    sim->txSent = 0u;
+    sim->mtu = CYBLE_GATT_DEFAULT_MTU;
+    sim->connStart = sim->now;
+    sim->connEvent = sim->now + UsToNs(SIM_CONNECT_DELAY_US);
+    sim->connIntervalNs = UsToNs(sim->config.connIntervalMs * 1000.0);
+    sim->updateIntervalNs = 0u;
+    if(sim->stats.connections++ == 0u)
+    {
+        sim->stats.connectNs = sim->now;
+        sim->stats.connectCharge = StatsCharge(&sim->stats);
+    }
+    sim->stats.connIntervalNs = sim->connIntervalNs;
+
+    if(sim->trace)
+    {
+        printf("%12.3f ms  connected, interval %.2f ms\n",
+               (double)sim->now / SIM_NS_PER_MS,
+               (double)sim->connIntervalNs / SIM_NS_PER_MS);
+    }
+    PostEvent(CYBLE_EVT_GAP_DEVICE_CONNECTED);
+    event = PostEvent(CYBLE_EVT_GATT_CONNECT_IND);
+    if(event != NULL)
+    {
+        event->hasParam = 1u;
+    }
+}
+
+static void Disconnect(void)
+{
+    sim->connected = 0u;
+    sim->stats.connNs += sim->now - sim->connStart;
+
+    if(sim->trace)
+    {
+        printf("%12.3f ms  disconnected after %.3f ms\n",
+               (double)sim->now / SIM_NS_PER_MS,
+               (double)(sim->now - sim->connStart) / SIM_NS_PER_MS);
+    }
+    PostEvent(CYBLE_EVT_GATT_DISCONNECT_IND);
+    PostEvent(CYBLE_EVT_GAP_DEVICE_DISCONNECTED);
+}
+
+/* A write request of the central, returns its link layer length */
+static uint32 CentralWrite(CYBLE_GATT_DB_ATTR_HANDLE_T handle, const uint8 *value,
+                           uint16 len)
+{
+    SIM_EVENT_T *event = PostEvent(CYBLE_EVT_GATTS_WRITE_REQ);
+
+    if(event != NULL)
+    {
+        event->hasParam = 1u;
+        event->param.write.handleValPair.attrHandle = handle;
+        event->param.write.handleValPair.value.len = len;
+        event->param.write.handleValPair.value.actualLen = len;
+        memcpy(event->value, value, len);
+    }
+    sim->centralWait = 1u;
+    return SIM_L2CAP_HEADER_BYTES + SIM_ATT_NTF_HEADER_BYTES + len;
+}
+
+/* What the central sends in this event, returns its link layer length */
+static uint32 CentralRequest(void)
+{
+    static const uint8 cccd[2] = { 0x01u, 0x00u };
+    static const uint8 done[1] = { LOG_SYNC_OP_DONE };
+    uint8 start[LOG_SYNC_START_LEN];
+    uint32 from = (uint32)sim->config.syncFrom;
+    SIM_EVENT_T *event;
+
+    if(sim->centralWait)
+    {
+        return 0u;
+    }
+    switch(sim->central)
+    {
+        case SIM_CENTRAL_MTU:
+            event = PostEvent(CYBLE_EVT_GATTS_XCNHG_MTU_REQ);
+            if(event != NULL)
+            {
+                event->hasParam = 1u;
+                event->param.mtu.mtu = (uint16)sim->config.clientMtu;
+            }
+            sim->mtu = ((uint16)sim->config.clientMtu < CYBLE_GATT_MTU) ?
+                       (uint16)sim->config.clientMtu : CYBLE_GATT_MTU;
+            sim->stats.mtu = sim->mtu;
+            sim->centralWait = 1u;
+            return SIM_L2CAP_HEADER_BYTES + 3u;
+
+        case SIM_CENTRAL_CCCD:
+            return CentralWrite(CYBLE_LOG_SYNC_RECORDS_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE,
+                                cccd, sizeof(cccd));
+
+        case SIM_CENTRAL_START:
+            start[0] = LOG_SYNC_OP_START;
+            start[1] = (uint8)from;
+            start[2] = (uint8)(from >> 8);
+            start[3] = (uint8)(from >> 16);
+            start[4] = (uint8)(from >> 24);
+            return CentralWrite(CYBLE_LOG_SYNC_CONTROL_CHAR_HANDLE, start, sizeof(start));
+
+        case SIM_CENTRAL_DONE:
+            return CentralWrite(CYBLE_LOG_SYNC_CONTROL_CHAR_HANDLE, done, sizeof(done));
+
+        default:
+            return 0u;
+    }
+}
+
+static void CentralResponse(void)
+{
+    sim->centralWait = 0u;
+    ++sim->central;
+
+    if(sim->trace && sim->central == SIM_CENTRAL_CCCD)
+    {
+        printf("%12.3f ms  MTU %u\n", (double)sim->now / SIM_NS_PER_MS, sim->mtu);
+    }
+}
+
+static void CentralNotification(const SIM_NOTIFICATION_T *notification)
+{
+    uint32 first = Get32(notification->value);
+    uint32 count = (notification->len - LOG_SYNC_HEADER_LEN) / EVENT_LOG_RECORD_LEN;
+
+    ++sim->stats.notifications;
+    sim->stats.notifyBytes += notification->len;
+
+    if(count == 0u)
+    {
+        if(sim->central == SIM_CENTRAL_STREAM)
+        {
+            sim->central = SIM_CENTRAL_DONE;
+        }
+        if(sim->trace)
+        {
+            printf("%12.3f ms  end of the log at record %u, %u records synced\n",
+                   (double)sim->now / SIM_NS_PER_MS, first, sim->stats.syncRecords);
+        }
+        return;
+    }
+    if(sim->centralSynced && first != sim->centralNext)
+    {
+        ++sim->stats.syncGaps;
+    }
+    sim->centralSynced = 1u;
+    sim->centralNext = first + count;
+    sim->stats.syncRecords += count;
+}
+
+/* Length of the band's next packet, 0 = nothing to send */
+static uint32 BandNextLen(void)
+{
+    uint32 left;
+
+    if(sim->mtuRsp)
+    {
+        return SIM_L2CAP_HEADER_BYTES + 3u;
+    }
+    if(sim->writeRsp != 0u)
+    {
+        return SIM_L2CAP_HEADER_BYTES + sim->writeRsp;
+    }
+    if(sim->terminate != 0u)
+    {
+        return (sim->terminate == 1u) ? SIM_LL_TERMINATE_BYTES : 0u;
+    }
+    if(sim->txCount == 0u)
+    {
+        return 0u;
+    }
+    left = SIM_L2CAP_HEADER_BYTES + SIM_ATT_NTF_HEADER_BYTES +
+           sim->tx[sim->txHead].len - sim->txSent;
+    return (left < (uint32)sim->config.llPayloadBytes) ?
+           left : (uint32)sim->config.llPayloadBytes;
+}
+
+static void BandSend(uint32 len)
+{
+    SIM_NOTIFICATION_T *head = &sim->tx[sim->txHead];
+    SIM_EVENT_T *event;
+
+    if(sim->mtuRsp)
+    {
+        sim->mtuRsp = 0u;
+        CentralResponse();
+        return;
+    }
+    if(sim->writeRsp != 0u)
+    {
+        sim->writeRsp = 0u;
+        CentralResponse();
+        return;
+    }
+    if(sim->terminate == 1u)
+    {
+        sim->terminate = 2u;
+        return;
+    }
+
+    ++sim->stats.llPackets;
+    sim->txSent += len;
+    if(sim->txSent < SIM_L2CAP_HEADER_BYTES + SIM_ATT_NTF_HEADER_BYTES + head->len)
+    {
+        return;
+    }
+    CentralNotification(head);
+    sim->txHead = (sim->txHead + 1u) % SIM_TX_BUFFERS;
+    --sim->txCount;
+    sim->txSent = 0u;
+
+    if(sim->txFull)
+    {
+        sim->txFull = 0u;
+        event = PostEvent(CYBLE_EVT_STACK_BUSY_STATUS);
+        if(event != NULL)
+        {
+            event->hasParam = 1u;
+            event->param.status = CYBLE_STACK_STATE_FREE;
+        }
+    }
+}
+
+/* Runs the connection event starting now, sets how long the radio is on */
+static void ConnEvent(void)
+{
+    uint64_t overhead = UsToNs(sim->config.ecoStartupUs + sim->config.eventCloseUs);
+    uint64_t budget = (sim->connIntervalNs > overhead) ? sim->connIntervalNs - overhead : 0u;
+    uint32 maxPackets = (uint32)sim->config.connPacketsPerEvent;
+    uint32 centralLen;
+    uint32 packets = 0u;
+    uint64_t active = 0u;
+    uint8 mtuRequest = (sim->central == SIM_CENTRAL_MTU && !sim->centralWait);
+
+    ++sim->stats.connEvents;
+    centralLen = CentralRequest();
+
+    for(;;)
+    {
+        uint32 len = BandNextLen();
+        uint64_t exchange = ExchangeNs(centralLen, len);
+
+        if(packets != 0u &&
+           (len == 0u || packets >= maxPackets || active + exchange > budget))
+        {
+            break;
+        }
+        active += exchange;
+        ++packets;
+        centralLen = 0u;
+        if(len == 0u)
+        {
+            break;
+        }
+        BandSend(len);
+    }
+    sim->connActiveNs = active;
+
+    /* The stack answers the MTU request itself, in the next event */
+    if(mtuRequest)
+    {
+        sim->mtuRsp = 1u;
+    }
+}
+
+/* Runs the connection events and rolls over to the next one */
+static void ConnUpdate(void)
+{
+    if(!sim->connEventDone && sim->now >= sim->connEvent)
+    {
+        sim->connEventDone = 1u;
+        ConnEvent();
+    }
+    if(!sim->connEventDone || sim->now < RadioEventEnd())
+    {
+        return;
+    }
+
+    if(sim->terminate == 2u)
+    {
+        Disconnect();
+        return;
+    }
+    if(sim->updateIntervalNs != 0u && --sim->updateIn == 0u)
+    {
+        sim->connIntervalNs = sim->updateIntervalNs;
+        sim->stats.connIntervalNs = sim->connIntervalNs;
+        sim->updateIntervalNs = 0u;
+
+        if(sim->trace)
+        {
+            printf("%12.3f ms  connection interval %.2f ms\n",
+                   (double)sim->now / SIM_NS_PER_MS,
+                   (double)sim->connIntervalNs / SIM_NS_PER_MS);
+        }
+    }
+    sim->connEvent += sim->connIntervalNs;
+    sim->connEventDone = 0u;
+}
+
+/* Capture what goes on air and roll over to the next advertising event */
+static void BlessUpdate(void)
+{
+    if(sim->connected)
+    {
+        ConnUpdate();
+        return;
+    }
+    if(!sim->advertising)
+    {
+        return;
+    }
+
+    if(!sim->advOnAirDone && sim->now >= sim->advEvent)
+    {
+        SIM_STATS_T *stats = &sim->stats;
+        const SIM_ON_AIR_T *last = (stats->onAirCount != 0u) ?
+                                   &stats->onAir[stats->onAirCount - 1u] : NULL;
+
+        sim->advOnAirDone = 1u;
+        ++stats->advEvents;
+        if(CentralConnects(sim->advEvent))
+        {
+            sim->connectPending = 1u;
+        }
+        else if(ScannerAsks(sim->advEvent))
+        {
+            ScanResponse();
+        }
+        if(sim->advDirected)
+        {
+            /* ADV_DIRECT_IND, nothing on air for the gateways */
+            ++stats->directedEvents;
+        }
+        else if(simHooks.adv != NULL)
+        {
+            simHooks.adv(simHooks.arg, sim->advEvent, sim->llAdvData.advData,
+                         sim->llAdvData.advDataLen);
+        }
+
+        if(!sim->advDirected &&
+           (last == NULL || last->advDataLen != sim->llAdvData.advDataLen ||
+           memcmp(last->advData, sim->llAdvData.advData,
+                  sim->llAdvData.advDataLen) != 0))
+        {
+            if(stats->onAirCount < SIM_MAX_ON_AIR)
+            {
+                SIM_ON_AIR_T *entry = &stats->onAir[stats->onAirCount++];
+                entry->timeNs = sim->advEvent;
+                entry->advDataLen = sim->llAdvData.advDataLen;
+                memcpy(entry->advData, sim->llAdvData.advData,
+                       sizeof(entry->advData));
+            }
+            if(sim->trace)
+            {
+                uint32 i;
+                printf("%12.3f ms  on air:", (double)sim->advEvent / SIM_NS_PER_MS);
+                for(i = 0u; i < sim->llAdvData.advDataLen; ++i)
+                {
+                    printf(" %02x", sim->llAdvData.advData[i]);
+                }
+                TraceMfcPayload(&sim->llAdvData);
+                printf("\n");
+            }
+        }
+    }
+
+    if(sim->now >= RadioEventEnd())
+    {
+        if(sim->connectPending)
+        {
+            Connect();
+            return;
+        }
+        /* The component falls back from fast to slow advertising itself */
+        if(sim->advIntervalType == CYBLE_ADVERTISING_FAST &&
+           sim->advEvent - sim->advStart >=
+           UsToNs(sim->config.fastTimeoutS * 1000000.0))
+        {
+            sim->advIntervalType = CYBLE_ADVERTISING_SLOW;
+        }
+        sim->advEvent += AdvIntervalNs() + AdvDelayNs();
+        sim->advScanNs = 0u;
+        sim->advOnAirDone = 0u;
+
+        /* High duty directed advertising ends by itself */
+        if(sim->advDirected &&
+           sim->advEvent - sim->advStart >= UsToNs(SIM_HIGH_DC_MAX_MS * 1000.0))
+        {
+            sim->advertising = 0u;
+            PostEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP);
+
+            if(sim->trace)
+            {
+                printf("%12.3f ms  directed advertising timed out\n",
+                       (double)sim->now / SIM_NS_PER_MS);
+            }
+        }
+    }
+}
+
+/* Apply every button edge that happened up to now */
+static void EdgesUpdate(void)
+{
+    while(sim->nextEdge < sim->edgeCount &&
+          sim->edges[sim->nextEdge].timeNs <= sim->now)
+    {
+        const SIM_EDGE_T *edge = &sim->edges[sim->nextEdge++];
+
+        if(edge->kind == SIM_EDGE_RELEASE)
+        {
+            sim->held &= (uint8)~edge->pins;
+        }
+        else
+        {
+            if(edge->kind == SIM_EDGE_PRESS)
+            {
+                sim->held |= edge->pins;
+            }
+            if(sim->intrStatus == 0u)
+            {
+                sim->pendingSince = edge->timeNs;
+            }
+            sim->intrStatus |= edge->pins;
+        }
+    }
+}
+
+static int ButtonIrqPending(void)
+{
+    return (sim->intrStatus != 0u && sim->buttonIsr != NULL);
+}
+
+static int WdtIrqPending(void)
+{
+    return (sim->wdtIntr != 0u && sim->wdtVector != NULL && sim->wdtIrqEnabled);
+}
+
+static int IrqPending(void)
+{
+    return (ButtonIrqPending() || WdtIrqPending());
+}
+
+static int IrqDeliverable(void)
+{
+    return (IrqPending() && sim->intEnabled && !sim->inIsr);
+}
+
+static void Charge(uint64_t until, SIM_MCU_STATE_T mcu, SIM_BLESS_STATE_T bless)
+{
+    uint64_t dt = until - sim->now;
+    uint64_t at = UsToNs(sim->config.chargeAtMs * 1000.0);
+
+    if(at > sim->now && at <= until)
+    {
+        sim->stats.chargeAt = StatsCharge(&sim->stats) +
+            (McuUa(mcu) + sim->config.blessUa[bless]) * (double)(at - sim->now);
+    }
+
+    sim->stats.mcuNs[mcu] += dt;
+    sim->stats.mcuCharge[mcu] += McuUa(mcu) * (double)dt;
+    if(mcu == SIM_MCU_ACTIVE)
+    {
+        sim->stats.activeCycles += HfclkMhz() * (double)dt / 1000.0;
+    }
+    sim->stats.blessNs[bless] += dt;
+    sim->stats.blessCharge[bless] += sim->config.blessUa[bless] * (double)dt;
+    if(sim->connected)
+    {
+        sim->stats.connCharge += (McuUa(mcu) + sim->config.blessUa[bless]) * (double)dt;
+    }
+}
+
+static void DispatchIrq(void);
+
+/*******************************************************************************
+* @brief Moves the virtual clock forward, charging every step to the given
+*       CPU state and the BLESS state of that moment.
+*
+* @param uint64_t duration:     How long to advance for, in ns
+* @param SIM_MCU_STATE_T mcu:   The CPU power state during that time
+* @param int wake:              Return early on a BLESS change or an IRQ
+*
+* @returns int:                 1 if it returned early
+*******************************************************************************/
+static int Advance(uint64_t duration, SIM_MCU_STATE_T mcu, int wake)
+{
+    uint64_t target = sim->now + duration;
+
+    while(sim->now < target)
+    {
+        uint64_t until;
+        uint64_t next = target;
+        SIM_BLESS_STATE_T bless = BlessStateAt(sim->now, &until);
+
+        if(until < next)
+        {
+            next = until;
+        }
+        if(sim->nextEdge < sim->edgeCount &&
+           sim->edges[sim->nextEdge].timeNs < next)
+        {
+            next = sim->edges[sim->nextEdge].timeNs;
+            if(next < sim->now)
+            {
+                next = sim->now;
+            }
+        }
+
+        if(WdtNextFireNs() < next)
+        {
+            next = WdtNextFireNs();
+            if(next < sim->now)
+            {
+                next = sim->now;
+            }
+        }
+
+        Charge(next, mcu, bless);
+        sim->now = next;
+        BlessUpdate();
+        EdgesUpdate();
+        WdtUpdate();
+
+        if(wake && (next == until || IrqPending()))
+        {
+            return 1;
+        }
+        if(IrqDeliverable())
+        {
+            DispatchIrq();
+        }
+    }
+    return 0;
+}
+
+/* Hands the CPU over at every epoch end of a run with hooks */
+static void EpochCheck(void)
+{
+    while(sim->now >= sim->epochEnd && sim->now < sim->end)
+    {
+        sim->epochEnd = simHooks.epoch(simHooks.arg, sim->now);
+    }
+}
+
+/* The handler's own code, once per interrupt: before its second SysTick
+ * read (PROFILING_STOP) so that it is inside the span, or on return */
+static void IsrBody(void)
+{
+    if(sim->isrBodyDue)
+    {
+        sim->isrBodyDue = 0u;
+        Advance(CyclesToNs(sim->config.isrCycles), SIM_MCU_ACTIVE, 0);
+    }
+}
+
+static void DispatchIrq(void)
+{
+    while(IrqDeliverable())
+    {
+        uint64_t start = sim->now;
+        int button = ButtonIrqPending();
+        uint32 before = sim->intrCleared;
+        uint64_t duration;
+
+        if(button && start - sim->pendingSince > sim->stats.irqLatencyMaxNs)
+        {
+            sim->stats.irqLatencyMaxNs = start - sim->pendingSince;
+        }
+
+        sim->inIsr = 1u;
+        sim->isrBodyDue = 1u;
+        sim->isrTicksRead = 0u;
+        Advance(CyclesToNs(sim->config.isrEntryCycles), SIM_MCU_ACTIVE, 0);
+        if(button)
+        {
+            sim->buttonIsr();
+        }
+        else
+        {
+            sim->wdtVector();
+        }
+        IsrBody();
+        sim->inIsr = 0u;
+        duration = sim->now - start;
+
+        if(button)
+        {
+            ++sim->stats.isrCount;
+            sim->stats.isrNs += duration;
+            if(duration > sim->stats.isrMaxNs)
+            {
+                sim->stats.isrMaxNs = duration;
+            }
+        }
+        else
+        {
+            ++sim->stats.timerIsrCount;
+            sim->stats.timerIsrNs += duration;
+            if(duration > sim->stats.timerIsrMaxNs)
+            {
+                sim->stats.timerIsrMaxNs = duration;
+            }
+        }
+
+        /* An edge or a WDT match can come in while the handler waits on
+         * the WDT register writes, that one is pending for real */
+        if(sim->intrCleared == before)
+        {
+            /* The handler did not clear the source, don't spin forever */
+            CYASSERT(0);
+        }
+    }
+}
+
+static void LowPower(SIM_MCU_STATE_T state)
+{
+    if(state == SIM_MCU_DEEPSLEEP)
+    {
+        ++sim->stats.deepSleeps;
+    }
+    else
+    {
+        ++sim->stats.sleeps;
+    }
+
+    /*  WFI returns straight away if an interrupt is already pending. A long
+     * sleep is cut at the epoch ends, without waking the firmware */
+    while(!IrqPending() && sim->now < sim->end)
+    {
+        uint64_t until = (sim->epochEnd < sim->end) ? sim->epochEnd : sim->end;
+
+        if(Advance(until - sim->now, state, 1) || sim->now >= sim->end)
+        {
+            break;
+        }
+        EpochCheck();
+    }
+
+    if(state == SIM_MCU_DEEPSLEEP)
+    {
+        Advance(UsToNs(sim->config.wakeupUs), SIM_MCU_ACTIVE, 0);
+    }
+}
+
+static int CompareEdges(const void *a, const void *b)
+{
+    const SIM_EDGE_T *ea = a;
+    const SIM_EDGE_T *eb = b;
+
+    if(ea->timeNs != eb->timeNs)
+    {
+        return (ea->timeNs < eb->timeNs) ? -1 : 1;
+    }
+    return (int)ea->kind - (int)eb->kind;
+}
+
+static void BuildEdges(const SIM_SCENARIO_T *scenario)
+{
+    uint32 bounces = (uint32)sim->config.bounceEdges;
+    uint32 i, b;
+
+    free(sim->edges);
+    sim->edges = calloc((size_t)scenario->pressCount * (bounces + 2u) + 1u,
+                        sizeof(SIM_EDGE_T));
+    sim->edgeCount = 0u;
+    sim->nextEdge = 0u;
+
+    for(i = 0u; i < scenario->pressCount; ++i)
+    {
+        const SIM_PRESS_T *press = &scenario->presses[i];
+        SIM_EDGE_T *edge = &sim->edges[sim->edgeCount++];
+
+        edge->timeNs = press->timeNs;
+        edge->pins = press->pins;
+        edge->kind = SIM_EDGE_PRESS;
+
+        for(b = 1u; b <= bounces; ++b)
+        {
+            edge = &sim->edges[sim->edgeCount++];
+            edge->timeNs = press->timeNs + b * UsToNs(sim->config.bounceSpacingUs);
+            edge->pins = press->pins;
+            edge->kind = SIM_EDGE_BOUNCE;
+        }
+
+        edge = &sim->edges[sim->edgeCount++];
+        edge->timeNs = press->timeNs + press->holdNs;
+        edge->pins = press->pins;
+        edge->kind = SIM_EDGE_RELEASE;
+    }
+
+    qsort(sim->edges, sim->edgeCount, sizeof(SIM_EDGE_T), CompareEdges);
+}
+
+/*******************************************************************************
+* CyLib.h
+*******************************************************************************/
+void SimGlobalIntEnable(void)
+{
+    sim->intEnabled = 1u;
+    DispatchIrq();
+}
+
+void SimGlobalIntDisable(void)
+{
+    sim->intEnabled = 0u;
+}
+
+void SimAssert(int condition, const char *expr, const char *file, int line)
+{
+    if(!condition)
+    {
+        fprintf(stderr, "%s:%d: CYASSERT(%s) failed at %.3f ms\n",
+                file, line, expr, (double)sim->now / SIM_NS_PER_MS);
+        abort();
+    }
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+    uint8 saved = sim->intEnabled;
+    sim->intEnabled = 0u;
+    return saved;
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    sim->intEnabled = savedIntrStatus;
+    DispatchIrq();
+}
+
+void CyDelay(uint32 milliseconds)
+{
+    Advance((uint64_t)milliseconds * SIM_NS_PER_MS, SIM_MCU_ACTIVE, 0);
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    Advance((uint64_t)microseconds * SIM_NS_PER_US, SIM_MCU_ACTIVE, 0);
+}
+
+void CySysPmSleep(void)
+{
+    LowPower(SIM_MCU_SLEEP);
+}
+
+void CySysPmDeepSleep(void)
+{
+    LowPower(SIM_MCU_DEEPSLEEP);
+}
+
+void CySysClkWriteEcoDiv(uint32 divider)
+{
+    sim->ecoDiv = divider & 0x03u;
+}
+
+void CySysClkWriteHfclkDirect(uint32 clkSelect)
+{
+    sim->hfclkSelect = clkSelect;
+}
+
+void CySysClkWriteImoFreq(uint32 freq)
+{
+    CYASSERT(freq >= CY_SYS_CLK_IMO_MIN_FREQ_MHZ && freq <= CY_SYS_CLK_IMO_MAX_FREQ_MHZ);
+    if((double)freq == sim->imoMhz)
+    {
+        return;
+    }
+
+    /* New trims, flash wait states, then the IMO settles */
+    ++sim->stats.imoChanges;
+    sim->imoMhz = (double)freq;
+    Advance(UsToNs(sim->config.imoSwitchUs), SIM_MCU_ACTIVE, 0);
+}
+
+void CySysClkImoStart(void)
+{
+    sim->imoRunning = 1u;
+}
+
+void CySysClkImoStop(void)
+{
+    /* Stopping the IMO while it drives HFCLK would hang the real part */
+    CYASSERT(sim->hfclkSelect != CY_SYS_CLK_HFCLK_IMO);
+    sim->imoRunning = 0u;
+}
+
+void CySysClkIloStart(void)
+{
+    sim->iloRunning = 1u;
+}
+
+void CySysClkIloStop(void)
+{
+    sim->iloRunning = 0u;
+}
+
+cyisraddress CyIntSetVector(uint8 number, cyisraddress address)
+{
+    cyisraddress old = NULL;
+
+    if(number == CY_INT_WDT_IRQ)
+    {
+        old = sim->wdtVector;
+        sim->wdtVector = address;
+    }
+    return old;
+}
+
+void CyIntEnable(uint8 number)
+{
+    if(number == CY_INT_WDT_IRQ)
+    {
+        sim->wdtIrqEnabled = 1u;
+        DispatchIrq();
+    }
+}
+
+void CyIntDisable(uint8 number)
+{
+    if(number == CY_INT_WDT_IRQ)
+    {
+        sim->wdtIrqEnabled = 0u;
+    }
+}
+
+/*******************************************************************************
+* CyLib.h - SysTick, only its counter: the interrupt is never enabled
+*******************************************************************************/
+void CySysTickEnable(void)
+{
+}
+
+void CySysTickDisableInterrupt(void)
+{
+}
+
+void CySysTickSetReload(uint32 value)
+{
+    sim->systickReload = value & CY_SYS_SYST_RVR_CNT_MASK;
+}
+
+uint32 CySysTickGetValue(void)
+{
+    uint64_t cycles;
+
+    if(sim->inIsr)
+    {
+        if(sim->isrTicksRead)
+        {
+            IsrBody();
+        }
+        sim->isrTicksRead = 1u;
+    }
+    cycles = (uint64_t)(sim->stats.activeCycles - sim->systickCleared);
+
+    return sim->systickReload - (uint32)(cycles % ((uint64_t)sim->systickReload + 1u));
+}
+
+void CySysTickClear(void)
+{
+    sim->systickCleared = sim->stats.activeCycles;
+}
+
+/*******************************************************************************
+* Stack bounds (project.h)
+*******************************************************************************/
+uint8 *SimStackLimit(void)
+{
+    return sim->stackTop - SIM_STACK_BYTES;
+}
+
+uint8 *SimStackTop(void)
+{
+    return sim->stackTop;
+}
+
+/*******************************************************************************
+* CyLFClk.h - watchdog timer counters
+*******************************************************************************/
+
+/* The WDT runs on LFCLK: a write to its registers busy waits until LFCLK
+ * picked it up, a few of its cycles */
+static void WdtSync(void)
+{
+    Advance((uint64_t)(sim->config.wdtSyncLfclk * SIM_NS_PER_S / SIM_LFCLK_HZ + 0.5),
+            SIM_MCU_ACTIVE, 0);
+}
+
+void CySysWdtEnable(uint32 counterMask)
+{
+    uint32 i;
+
+    WdtSync();
+
+    for(i = 0u; i < SIM_WDT_COUNTERS; ++i)
+    {
+        SIM_WDT_COUNTER_T *counter = &sim->wdt[i];
+
+        if((counterMask & (CY_SYS_WDT_COUNTER0_MASK << (i * 8u))) != 0u &&
+           !counter->enabled)
+        {
+            counter->enabled = 1u;
+            counter->startTick = NowTicks() - counter->frozenCount;
+            WdtSchedule(i);
+        }
+    }
+}
+
+void CySysWdtDisable(uint32 counterMask)
+{
+    uint32 i;
+
+    WdtSync();
+
+    for(i = 0u; i < SIM_WDT_COUNTERS; ++i)
+    {
+        SIM_WDT_COUNTER_T *counter = &sim->wdt[i];
+
+        if((counterMask & (CY_SYS_WDT_COUNTER0_MASK << (i * 8u))) != 0u &&
+           counter->enabled)
+        {
+            counter->frozenCount = NowTicks() - counter->startTick;
+            counter->enabled = 0u;
+            WdtSchedule(i);
+        }
+    }
+}
+
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode)
+{
+    WdtSync();
+    sim->wdt[counterNum].mode = (uint8)mode;
+    WdtSchedule(counterNum);
+}
+
+void CySysWdtWriteMatch(uint32 counterNum, uint32 match)
+{
+    WdtSync();
+    sim->wdt[counterNum].match = match & 0xFFFFu;
+    WdtSchedule(counterNum);
+}
+
+void CySysWdtWriteClearOnMatch(uint32 counterNum, uint32 enable)
+{
+    WdtSync();
+    sim->wdt[counterNum].clearOnMatch = (enable != 0u);
+    WdtSchedule(counterNum);
+}
+
+uint32 CySysWdtReadCount(uint32 counterNum)
+{
+    return (uint32)WdtCount(&sim->wdt[counterNum], counterNum);
+}
+
+void CySysWdtResetCounters(uint32 countersMask)
+{
+    uint32 i;
+
+    WdtSync();
+
+    for(i = 0u; i < SIM_WDT_COUNTERS; ++i)
+    {
+        if((countersMask & (CY_SYS_WDT_COUNTER0_RESET << i)) != 0u)
+        {
+            sim->wdt[i].startTick = NowTicks();
+            sim->wdt[i].frozenCount = 0u;
+            WdtSchedule(i);
+        }
+    }
+}
+
+void CySysWdtClearInterrupt(uint32 counterMask)
+{
+    sim->wdtIntr &= ~counterMask;
+    ++sim->intrCleared;
+}
+
+cyWdtCallback CySysWdtSetInterruptCallback(uint32 counterNum,
+                                           cyWdtCallback function)
+{
+    cyWdtCallback old = sim->wdt[counterNum].callback;
+    sim->wdt[counterNum].callback = function;
+    return old;
+}
+
+CY_ISR(CySysWdtIsr)
+{
+    uint32 i;
+
+    for(i = 0u; i < SIM_WDT_COUNTERS; ++i)
+    {
+        if((sim->wdtIntr & WdtIntBit(i)) != 0u)
+        {
+            CySysWdtClearInterrupt(WdtIntBit(i));
+            if(sim->wdt[i].callback != NULL)
+            {
+                sim->wdt[i].callback();
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Alert_Button / Alert_Interrupt
+*******************************************************************************/
+uint8 Alert_Button_Read(void)
+{
+    return sim->held;
+}
+
+uint8 Alert_Button_ClearInterrupt(void)
+{
+    uint8 mask = sim->intrStatus;
+    sim->intrStatus = 0u;
+    ++sim->intrCleared;
+    return mask;
+}
+
+void Alert_Interrupt_StartEx(cyisraddress address)
+{
+    sim->buttonIsr = address;
+    DispatchIrq();
+}
+
+void Alert_Interrupt_Stop(void)
+{
+    sim->buttonIsr = NULL;
+}
+
+/*******************************************************************************
+* BLE component
+*******************************************************************************/
+CYBLE_API_RESULT_T CyBle_Start(CYBLE_CALLBACK_T callbackFunc)
+{
+    if(callbackFunc == NULL)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    sim->bleCallback = callbackFunc;
+    sim->llAdvData = *cyBle_discoveryModeInfo.advData;
+    sim->llScanRspData = *cyBle_discoveryModeInfo.scanRspData;
+    PostEvent(CYBLE_EVT_STACK_ON);
+    return CYBLE_ERROR_OK;
+}
+
+void CyBle_ProcessEvents(void)
+{
+    if(sim->now >= sim->end)
+    {
+        longjmp(sim->exitJump, 1);
+    }
+    EpochCheck();
+
+    ++sim->stats.loopIterations;
+    Advance(CyclesToNs(sim->config.processEventsCycles), SIM_MCU_ACTIVE, 0);
+
+    while(sim->eventTail != sim->eventHead)
+    {
+        /* A copy, the callback can queue more events */
+        SIM_EVENT_T event = sim->events[sim->eventTail];
+
+        sim->eventTail = (sim->eventTail + 1u) % SIM_EVENT_QUEUE_SIZE;
+        event.param.write.handleValPair.value.val =
+            (event.event == CYBLE_EVT_GATTS_WRITE_REQ) ? event.value : NULL;
+        sim->bleCallback(event.event, event.hasParam ? &event.param : NULL);
+    }
+}
+
+CYBLE_LP_MODE_T CyBle_EnterLPM(CYBLE_LP_MODE_T pwrMode)
+{
+    sim->blessLpMode = pwrMode;
+    return pwrMode;
+}
+
+CYBLE_BLESS_STATE_T CyBle_GetBleSsState(void)
+{
+    uint64_t until;
+
+    switch(BlessStateAt(sim->now, &until))
+    {
+        case SIM_BLESS_ECO_ON:
+            return CYBLE_BLESS_STATE_ECO_ON;
+        case SIM_BLESS_EVENT_ACTIVE:
+            return CYBLE_BLESS_STATE_ACTIVE;
+        case SIM_BLESS_EVENT_CLOSE:
+            return CYBLE_BLESS_STATE_EVENT_CLOSE;
+        case SIM_BLESS_SLEEP:
+            return CYBLE_BLESS_STATE_SLEEP;
+        default:
+            return CYBLE_BLESS_STATE_DEEPSLEEP;
+    }
+}
+
+CYBLE_STATE_T CyBle_GetState(void)
+{
+    if(sim->bleCallback == NULL)
+    {
+        return CYBLE_STATE_STOPPED;
+    }
+    if(sim->connected)
+    {
+        return CYBLE_STATE_CONNECTED;
+    }
+    return sim->advertising ? CYBLE_STATE_ADVERTISING : CYBLE_STATE_DISCONNECTED;
+}
+
+CYBLE_API_RESULT_T CyBle_GappStartAdvertisement(uint8 advertisingIntervalType)
+{
+    if(sim->advertising || sim->connected ||
+       advertisingIntervalType > CYBLE_ADVERTISING_CUSTOM)
+    {
+        return CYBLE_ERROR_INVALID_OPERATION;
+    }
+    sim->advertising = 1u;
+    sim->advIntervalType = advertisingIntervalType;
+    sim->advDirected = (cyBle_discoveryModeInfo.advParam->advType ==
+                        CYBLE_GAPP_CONNECTABLE_HIGH_DC_DIRECTED_ADV) ? 1u : 0u;
+    sim->advToCentral = (memcmp(cyBle_discoveryModeInfo.advParam->directAddr,
+                                simCentralAddr.bdAddr, CYBLE_GAP_BD_ADDR_SIZE) == 0) ? 1u : 0u;
+    sim->advStart = sim->now;
+    sim->advEvent = sim->now + UsToNs(sim->config.ecoStartupUs) + AdvDelayNs();
+    sim->advScanNs = 0u;
+    sim->advOnAirDone = 0u;
+    ++sim->stats.advStarts;
+
+    /* The link layer takes the payload from the discovery mode info */
+    sim->llAdvData = *cyBle_discoveryModeInfo.advData;
+    sim->llScanRspData = *cyBle_discoveryModeInfo.scanRspData;
+
+    if(sim->trace)
+    {
+        printf("%12.3f ms  %sadvertising started, interval %.3f ms\n",
+               (double)sim->now / SIM_NS_PER_MS, sim->advDirected ? "directed " : "",
+               (double)AdvIntervalNs() / SIM_NS_PER_MS);
+    }
+    PostEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP);
+    return CYBLE_ERROR_OK;
+}
+
+void CyBle_GappStopAdvertisement(void)
+{
+    if(sim->advertising)
+    {
+        sim->advertising = 0u;
+        PostEvent(CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP);
+
+        if(sim->trace)
+        {
+            printf("%12.3f ms  advertising stopped\n",
+                   (double)sim->now / SIM_NS_PER_MS);
+        }
+    }
+}
+
+CYBLE_API_RESULT_T CyBle_GapUpdateAdvData(
+    CYBLE_GAPP_DISC_DATA_T *advDiscData,
+    CYBLE_GAPP_SCAN_RSP_DATA_T *advScanRspData)
+{
+    if(advDiscData == NULL || advScanRspData == NULL)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    ++sim->stats.advUpdates;
+    Advance(CyclesToNs(sim->config.advUpdateCycles), SIM_MCU_ACTIVE, 0);
+    if(sim->trace &&
+       (advScanRspData->scanRspDataLen != sim->llScanRspData.scanRspDataLen ||
+        memcmp(advScanRspData->scanRspData, sim->llScanRspData.scanRspData,
+               advScanRspData->scanRspDataLen) != 0))
+    {
+        uint32 i;
+        printf("%12.3f ms  scan rsp:", (double)sim->now / SIM_NS_PER_MS);
+        for(i = 0u; i < advScanRspData->scanRspDataLen; ++i)
+        {
+            printf(" %02x", advScanRspData->scanRspData[i]);
+        }
+        printf("\n");
+    }
+    sim->llAdvData = *advDiscData;
+    sim->llScanRspData = *advScanRspData;
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GapDisconnect(uint8 bdHandle)
+{
+    (void)bdHandle;
+    if(!sim->connected || sim->terminate != 0u)
+    {
+        return CYBLE_ERROR_INVALID_OPERATION;
+    }
+    sim->terminate = 1u;
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GapGetBondedDevicesList(
+    CYBLE_GAP_BONDED_DEV_ADDR_LIST_T *bondedDevList)
+{
+    if(bondedDevList == NULL)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    memset(bondedDevList, 0, sizeof(*bondedDevList));
+    if(sim->config.centralBonded != 0.0)
+    {
+        bondedDevList->bdAddrList[bondedDevList->count++] = simCentralAddr;
+    }
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GetDeviceAddress(CYBLE_GAP_BD_ADDR_T *bdAddr)
+{
+    if(bdAddr == NULL)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    SimBandAddress((uint32)sim->config.bandId, bdAddr->bdAddr);
+    bdAddr->type = 1u;
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_L2capLeConnectionParamUpdateRequest(uint8 bdHandle,
+    CYBLE_GAP_CONN_UPDATE_PARAM_T *connParam)
+{
+    uint64_t floorNs = UsToNs(sim->config.connMinIntervalMs * 1000.0);
+    uint64_t intervalNs;
+    SIM_EVENT_T *event;
+
+    (void)bdHandle;
+    if(!sim->connected || connParam == NULL ||
+       connParam->connIntvMin > connParam->connIntvMax)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+
+    /* The central takes the shortest interval it allows in the range */
+    intervalNs = (uint64_t)connParam->connIntvMin * 1250000ull;
+    if(intervalNs < floorNs)
+    {
+        intervalNs = floorNs;
+    }
+    event = PostEvent(CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP);
+    if(event != NULL)
+    {
+        event->hasParam = 1u;
+        event->param.result = (intervalNs <= (uint64_t)connParam->connIntvMax * 1250000ull) ?
+                              0u : 1u;
+    }
+    if(intervalNs <= (uint64_t)connParam->connIntvMax * 1250000ull)
+    {
+        sim->updateIntervalNs = intervalNs;
+        sim->updateIn = (sim->config.connUpdateEvents < 1.0) ?
+                        1u : (uint32)sim->config.connUpdateEvents;
+    }
+    return CYBLE_ERROR_OK;
+}
+
+uint8 CyBle_GattGetBusyStatus(void)
+{
+    return (sim->connected && sim->txCount >= TxBuffers()) ?
+           CYBLE_STACK_STATE_BUSY : CYBLE_STACK_STATE_FREE;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle,
+                                           CYBLE_GATTS_HANDLE_VALUE_NTF_T *ntfParam)
+{
+    SIM_NOTIFICATION_T *notification;
+    SIM_EVENT_T *event;
+
+    (void)connHandle;
+    if(!sim->connected || sim->terminate != 0u)
+    {
+        return CYBLE_ERROR_INVALID_OPERATION;
+    }
+    if(ntfParam == NULL || ntfParam->value.val == NULL ||
+       ntfParam->value.len > sim->mtu - 3u)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    Advance(CyclesToNs(sim->config.notifyCycles), SIM_MCU_ACTIVE, 0);
+    if(sim->txCount >= TxBuffers())
+    {
+        return CYBLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+
+    notification = &sim->tx[(sim->txHead + sim->txCount) % SIM_TX_BUFFERS];
+    notification->len = ntfParam->value.len;
+    memcpy(notification->value, ntfParam->value.val, ntfParam->value.len);
+    ++sim->txCount;
+
+    if(sim->txCount >= TxBuffers() && !sim->txFull)
+    {
+        sim->txFull = 1u;
+        event = PostEvent(CYBLE_EVT_STACK_BUSY_STATUS);
+        if(event != NULL)
+        {
+            event->hasParam = 1u;
+            event->param.status = CYBLE_STACK_STATE_BUSY;
+        }
+    }
+    return CYBLE_ERROR_OK;
+}
+
+uint8 CyBle_GattsWriteAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T *handleValuePair,
+                                     uint16 offset, CYBLE_CONN_HANDLE_T *connHandle,
+                                     uint8 flags)
+{
+    (void)handleValuePair;
+    (void)offset;
+    (void)connHandle;
+    (void)flags;
+    return CYBLE_GATT_ERR_NONE;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle)
+{
+    (void)connHandle;
+    if(!sim->connected)
+    {
+        return CYBLE_ERROR_INVALID_OPERATION;
+    }
+    sim->writeRsp = 1u;     /* Opcode only */
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsErrorRsp(CYBLE_CONN_HANDLE_T connHandle,
+                                       const CYBLE_GATTS_ERR_PARAM_T *errRspParam)
+{
+    (void)connHandle;
+    if(!sim->connected || errRspParam == NULL)
+    {
+        return CYBLE_ERROR_INVALID_OPERATION;
+    }
+    sim->writeRsp = 5u;     /* Opcode, request opcode, handle, error */
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_AesEncrypt(uint8 *plainData, uint8 *aesKey,
+                                    uint8 *encryptedData)
+{
+    if(plainData == NULL || aesKey == NULL || encryptedData == NULL)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    ++sim->stats.aesBlocks;
+    Advance(CyclesToNs(sim->config.aesCycles), SIM_MCU_ACTIVE, 0);
+    SimAesEncrypt(plainData, aesKey, encryptedData);
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GenerateRandomNumber(uint8 *randomNumber)
+{
+    uint32 i;
+
+    if(randomNumber == NULL)
+    {
+        return CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    for(i = 0u; i < 8u; ++i)
+    {
+        randomNumber[i] = (uint8)SimTrueRandom();
+    }
+    return CYBLE_ERROR_OK;
+}
+
+/*******************************************************************************
+* CyFlash.h
+*******************************************************************************/
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    uint8 saved = sim->intEnabled;
+    int result;
+
+    if(rowNum < SIM_FLASH_FIRST_ROW || rowNum >= CY_FLASH_NUMBER_ROWS || rowData == NULL)
+    {
+        return CY_SYS_FLASH_INVALID_ADDR;
+    }
+
+    /* Blocking, with the interrupts held off like cy_boot does */
+    ++sim->stats.flashWrites;
+    sim->intEnabled = 0u;
+    Advance(UsToNs(sim->config.flashRowUs), SIM_MCU_ACTIVE, 0);
+    result = SimFlashProgram(rowNum, rowData);
+
+    if(sim->trace)
+    {
+        printf("%12.3f ms  flash row %u%s\n", (double)sim->now / SIM_NS_PER_MS,
+               rowNum, (result == SIM_FLASH_TORN) ? " TORN, power lost" : "");
+    }
+    if(result == SIM_FLASH_TORN)
+    {
+        sim->stats.powerLost = 1u;
+        longjmp(sim->exitJump, 1);
+    }
+    sim->intEnabled = saved;
+    DispatchIrq();
+    return CY_SYS_FLASH_SUCCESS;
+}
+
+/*******************************************************************************
+* Simulator control
+*******************************************************************************/
+void SimSetHooks(uint64_t epochNs, SIM_EPOCH_FN_T epoch, SIM_ADV_FN_T adv,
+                 void *arg)
+{
+    simHooks.epochNs = epochNs;
+    simHooks.epoch = epoch;
+    simHooks.adv = adv;
+    simHooks.arg = arg;
+}
+
+void SimConfigDefaults(SIM_CONFIG_T *config)
+{
+    memset(config, 0, sizeof(*config));
+
+    config->mcuActiveBaseUa = 1200.0;
+    config->mcuActivePerMhzUa = 140.0;
+    config->mcuSleepUa = 1100.0;
+    config->mcuDeepSleepUa = 1.3;
+    config->blessUa[SIM_BLESS_DEEPSLEEP] = 0.0;
+    config->blessUa[SIM_BLESS_SLEEP] = 150.0;
+    config->blessUa[SIM_BLESS_ECO_ON] = 250.0;
+    config->blessUa[SIM_BLESS_EVENT_ACTIVE] = 9000.0;
+    config->blessUa[SIM_BLESS_EVENT_CLOSE] = 600.0;
+
+    config->imoMhz = 24.0;
+    config->ecoMhz = 24.0;
+    config->imoSwitchUs = 5.0;
+
+    config->fastIntervalMs = 100.0;
+    config->slowIntervalMs = 1000.0;
+    config->fastTimeoutS = 30.0;
+    config->advDelayMaxMs = 10.0;
+    config->ecoStartupUs = 1500.0;
+    config->advEventUs = 1500.0;
+    config->directedEventUs = 750.0;
+    config->eventCloseUs = 50.0;
+
+    config->processEventsCycles = 400.0;
+    config->advUpdateCycles = 1500.0;
+    config->aesCycles = 1000.0;
+    config->flashRowUs = 20000.0;
+    config->isrEntryCycles = 20.0;
+    config->isrCycles = 100.0;
+    config->wdtSyncLfclk = 3.0;
+    config->wakeupUs = 25.0;
+
+    config->bounceEdges = 2.0;
+    config->bounceSpacingUs = 500.0;
+
+    config->flashTearAt = 0.0;
+
+    config->connectAtMs = 0.0;
+    config->scanWindowMs = 0.0;
+    config->scanIntervalMs = 0.0;
+    config->scanPhaseMs = 0.0;
+    config->centralBonded = 0.0;
+    config->scannerAtMs = 0.0;
+    config->scannerForMs = 0.0;
+    config->scannerEvery = 1.0;
+    config->connIntervalMs = 30.0;
+    config->connMinIntervalMs = 15.0;
+    config->connUpdateEvents = 6.0;
+    config->connPacketsPerEvent = 6.0;
+    config->clientMtu = 247.0;
+    config->llPayloadBytes = 27.0;
+    config->txBuffers = 6.0;
+    config->syncFrom = 0.0;
+    config->notifyCycles = 600.0;
+
+    config->chargeAtMs = 0.0;
+    config->batteryMah = 225.0;
+    config->seed = 1.0;
+    config->bandId = 0.0;
+}
+
+int SimConfigSet(SIM_CONFIG_T *config, const char *assignment)
+{
+    const char *eq = strchr(assignment, '=');
+    uint32 i;
+
+    if(eq == NULL)
+    {
+        return -1;
+    }
+    for(i = 0u; i < SIM_PARAM_COUNT; ++i)
+    {
+        if(strlen(simParams[i].name) == (size_t)(eq - assignment) &&
+           strncmp(simParams[i].name, assignment, (size_t)(eq - assignment)) == 0)
+        {
+            *(double *)((char *)config + simParams[i].offset) = atof(eq + 1);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void SimConfigPrint(FILE *out, const SIM_CONFIG_T *config)
+{
+    uint32 i;
+
+    for(i = 0u; i < SIM_PARAM_COUNT; ++i)
+    {
+        fprintf(out, "%-24s %g\n", simParams[i].name,
+                *(const double *)((const char *)config + simParams[i].offset));
+    }
+}
+
+const SIM_STATS_T *SimRun(const SIM_CONFIG_T *config,
+                          const SIM_SCENARIO_T *scenario,
+                          uint64_t durationNs, int trace)
+{
+    SIM_EDGE_T *edges = simState.edges;
+
+    sim = &simState;
+    memset(sim, 0, sizeof(*sim));
+    sim->edges = edges;
+    sim->config = *config;
+    sim->end = durationNs;
+    sim->epochEnd = (simHooks.epoch != NULL) ? simHooks.epochNs : SIM_NO_DEADLINE;
+    sim->trace = trace;
+    sim->rng = (uint32)config->seed | 1u;
+    sim->trng = ((uint32)config->seed * 0x9E3779B9u) | 1u;
+    sim->hfclkSelect = CY_SYS_CLK_HFCLK_IMO;
+    sim->imoMhz = config->imoMhz;
+    sim->imoRunning = 1u;
+    sim->iloRunning = 1u;
+    sim->blessLpMode = CYBLE_BLESS_ACTIVE;
+    BuildEdges(scenario);
+    SimFlashTearAt((uint32)config->flashTearAt, sim->trng);
+
+    /* Component defaults */
+    simAdvParam = simAdvParamInit;
+    simAdvData = simAdvDataInit;
+    simScanRspData = simScanRspDataInit;
+    cyBle_discoveryModeInfo.discMode = 0x02u;
+    cyBle_discoveryModeInfo.advParam = &simAdvParam;
+    cyBle_discoveryModeInfo.advData = &simAdvData;
+    cyBle_discoveryModeInfo.scanRspData = &simScanRspData;
+    cyBle_discoveryModeInfo.advTo = 0u;
+
+    /* The firmware's stack starts below this frame */
+    sim->stackTop = (uint8 *)&edges;
+
+    if(setjmp(sim->exitJump) == 0)
+    {
+        (void)FirmwareMain();
+    }
+    if(sim->connected)
+    {
+        sim->stats.connNs += sim->now - sim->connStart;
+    }
+    return &sim->stats;
+}
+
+uint64_t SimNow(void)
+{
+    return sim->now;
+}
+
+void SimBandAddress(uint32 bandId, uint8 *addr)
+{
+    addr[0] = (uint8)bandId;
+    addr[1] = (uint8)(bandId >> 8);
+    addr[2] = (uint8)(bandId >> 16);
+    addr[3] = (uint8)(bandId >> 24);
+    addr[4] = 0x5Au;
+    addr[5] = 0xC0u;        /* Static random address */
+}
+
+double SimAverageUa(const SIM_STATS_T *stats)
+{
+    uint64_t total = 0u;
+    uint32 i;
+
+    for(i = 0u; i < SIM_MCU_STATE_COUNT; ++i)
+    {
+        total += stats->mcuNs[i];
+    }
+    return (total == 0u) ? 0.0 : StatsCharge(stats) / (double)total;
+}
+
+void SimReport(FILE *out, const SIM_CONFIG_T *config, const SIM_STATS_T *stats)
+{
+    uint64_t total = 0u;
+    double charge = 0.0;
+    double avgUa = SimAverageUa(stats);
+    uint32 i;
+
+    for(i = 0u; i < SIM_MCU_STATE_COUNT; ++i)
+    {
+        total += stats->mcuNs[i];
+        charge += stats->mcuCharge[i];
+    }
+    for(i = 0u; i < SIM_BLESS_STATE_COUNT; ++i)
+    {
+        charge += stats->blessCharge[i];
+    }
+    if(total == 0u || charge <= 0.0)
+    {
+        fprintf(out, "Nothing was simulated\n");
+        return;
+    }
+
+    fprintf(out, "Simulated time        %.3f s\n", (double)total / SIM_NS_PER_S);
+    fprintf(out, "Average current       %.3f uA\n", avgUa);
+    fprintf(out, "Projected battery     %.1f days (%.0f mAh)\n",
+            config->batteryMah * 1000.0 / avgUa / 24.0, config->batteryMah);
+
+    fprintf(out, "\nCPU state             residency    charge\n");
+    for(i = 0u; i < SIM_MCU_STATE_COUNT; ++i)
+    {
+        fprintf(out, "  %-18s %8.4f %%  %7.3f %%\n", mcuStateNames[i],
+                100.0 * (double)stats->mcuNs[i] / (double)total,
+                100.0 * stats->mcuCharge[i] / charge);
+    }
+    fprintf(out, "BLESS state\n");
+    for(i = 0u; i < SIM_BLESS_STATE_COUNT; ++i)
+    {
+        fprintf(out, "  %-18s %8.4f %%  %7.3f %%\n", blessStateNames[i],
+                100.0 * (double)stats->blessNs[i] / (double)total,
+                100.0 * stats->blessCharge[i] / charge);
+    }
+
+    fprintf(out, "\nLoop iterations       %u\n", stats->loopIterations);
+    fprintf(out, "Advertising events    %u\n", stats->advEvents);
+    fprintf(out, "ADV data updates      %u\n", stats->advUpdates);
+    fprintf(out, "Advertising starts    %u\n", stats->advStarts);
+    if(stats->directedEvents != 0u)
+    {
+        fprintf(out, "Directed ADV events   %u\n", stats->directedEvents);
+    }
+    if(stats->scanRequests != 0u)
+    {
+        fprintf(out, "Scan requests         %u answered, %u different answers\n",
+                stats->scanRequests, stats->scanRspChanges);
+    }
+    fprintf(out, "AES blocks            %u\n", stats->aesBlocks);
+    fprintf(out, "Flash row writes      %u%s\n", stats->flashWrites,
+            stats->powerLost ? " (power lost during the last one)" : "");
+    if(stats->connections != 0u)
+    {
+        fprintf(out, "Connections           %u (MTU %u, interval %.2f ms, %u events), "
+                "first at %.3f ms\n",
+                stats->connections, stats->mtu,
+                (double)stats->connIntervalNs / SIM_NS_PER_MS, stats->connEvents,
+                (double)stats->connectNs / SIM_NS_PER_MS);
+        fprintf(out, "Synced records        %u in %u notifications, %u LL packets%s\n",
+                stats->syncRecords, stats->notifications, stats->llPackets,
+                (stats->syncGaps != 0u) ? " (GAPS)" : "");
+        fprintf(out, "Connected time        %.3f ms, %.0f B/s of records (%.0f B/s of ATT values)\n",
+                (double)stats->connNs / SIM_NS_PER_MS,
+                (stats->connNs == 0u) ? 0.0 :
+                    (double)stats->syncRecords * EVENT_LOG_RECORD_LEN * SIM_NS_PER_S /
+                    (double)stats->connNs,
+                (stats->connNs == 0u) ? 0.0 :
+                    (double)stats->notifyBytes * SIM_NS_PER_S / (double)stats->connNs);
+        fprintf(out, "Charge per connection %.3f uC\n",
+                stats->connCharge / 1e9 / stats->connections);
+    }
+    fprintf(out, "Payload changes       %u\n", stats->onAirCount);
+    fprintf(out, "Sleep / Deep-Sleep    %u / %u\n", stats->sleeps, stats->deepSleeps);
+    fprintf(out, "Button ISRs           %u (avg %.1f us, max %.1f us)\n",
+            stats->isrCount,
+            (stats->isrCount == 0u) ? 0.0 :
+                (double)stats->isrNs / stats->isrCount / SIM_NS_PER_US,
+            (double)stats->isrMaxNs / SIM_NS_PER_US);
+    fprintf(out, "Timer ISRs            %u (avg %.1f us, max %.1f us)\n",
+            stats->timerIsrCount,
+            (stats->timerIsrCount == 0u) ? 0.0 :
+                (double)stats->timerIsrNs / stats->timerIsrCount / SIM_NS_PER_US,
+            (double)stats->timerIsrMaxNs / SIM_NS_PER_US);
+    fprintf(out, "IRQ latency (max)     %.1f us\n",
+            (double)stats->irqLatencyMaxNs / SIM_NS_PER_US);
+    fprintf(out, "Active time           %.3f ms\n",
+            (double)stats->mcuNs[SIM_MCU_ACTIVE] / SIM_NS_PER_MS);
+    fprintf(out, "Active clock          %.2f MHz average, %u IMO changes\n",
+            (stats->mcuNs[SIM_MCU_ACTIVE] == 0u) ? 0.0 :
+                stats->activeCycles * 1000.0 / (double)stats->mcuNs[SIM_MCU_ACTIVE],
+            stats->imoChanges);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,240 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    sim_scenario.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Scripted press scenarios for the host simulator
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define BOTH_PINS           (0x03u)
+#define RIGHT_PIN           (0x02u)
+
+#define PRESS_HOLD_MS       (150u)  // How long a finger stays on the button
+#define PRESS_GAP_MS        (400u)  // Time between presses of one gesture
+#define FIRST_PRESS_MS      (5000u)
+#define LONG_HOLD_MS        (1500u) // Long enough for a long press
+
+/* "history": an hour of random gestures, to fill the event log */
+#define HISTORY_MS          (3600000u)
+#define HISTORY_GAP_MS      (20000u)
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static void AddPress(SIM_SCENARIO_T *scenario, uint64_t timeMs, uint8 pins,
+                     uint64_t holdMs)
+{
+    if(scenario->pressCount < SIM_MAX_PRESSES)
+    {
+        SIM_PRESS_T *press = &scenario->presses[scenario->pressCount++];
+        press->timeNs = timeMs * SIM_NS_PER_MS;
+        press->holdNs = holdMs * SIM_NS_PER_MS;
+        press->pins = pins;
+    }
+}
+
+static void AddGesture(SIM_SCENARIO_T *scenario, uint64_t startMs, uint8 pins,
+                       uint32 presses)
+{
+    uint32 i;
+
+    for(i = 0u; i < presses; ++i)
+    {
+        AddPress(scenario, startMs + i * PRESS_GAP_MS, pins, PRESS_HOLD_MS);
+    }
+}
+
+static void ScenarioIdle(SIM_SCENARIO_T *scenario)
+{
+    (void)scenario;
+}
+
+static void ScenarioSingle(SIM_SCENARIO_T *scenario)
+{
+    AddGesture(scenario, FIRST_PRESS_MS, BOTH_PINS, 1u);
+}
+
+static void ScenarioDouble(SIM_SCENARIO_T *scenario)
+{
+    AddGesture(scenario, FIRST_PRESS_MS, BOTH_PINS, 2u);
+}
+
+static void ScenarioAlert(SIM_SCENARIO_T *scenario)
+{
+    AddGesture(scenario, FIRST_PRESS_MS, BOTH_PINS, 4u);
+}
+
+static void ScenarioPairing(SIM_SCENARIO_T *scenario)
+{
+    AddGesture(scenario, FIRST_PRESS_MS, RIGHT_PIN, 5u);
+}
+
+static void ScenarioLong(SIM_SCENARIO_T *scenario)
+{
+    AddPress(scenario, FIRST_PRESS_MS, BOTH_PINS, LONG_HOLD_MS);
+}
+
+static void ScenarioMixed(SIM_SCENARIO_T *scenario)
+{
+    AddGesture(scenario, FIRST_PRESS_MS, BOTH_PINS, 1u);
+    AddGesture(scenario, FIRST_PRESS_MS + 15000u, BOTH_PINS, 2u);
+    AddGesture(scenario, FIRST_PRESS_MS + 30000u, BOTH_PINS, 4u);
+    AddGesture(scenario, FIRST_PRESS_MS + 45000u, RIGHT_PIN, 5u);
+}
+
+static void ScenarioHistory(SIM_SCENARIO_T *scenario)
+{
+    SimScenarioRandom(scenario, 1u, HISTORY_MS, HISTORY_GAP_MS);
+    scenario->name = "history";
+}
+
+typedef struct
+{
+    const char  *name;
+    void        (*build)(SIM_SCENARIO_T *scenario);
+} SIM_BUILTIN_T;
+
+static const SIM_BUILTIN_T builtins[] =
+{
+    { "idle",       ScenarioIdle },
+    { "single",     ScenarioSingle },
+    { "double",     ScenarioDouble },
+    { "alert",      ScenarioAlert },
+    { "pairing",    ScenarioPairing },
+    { "long",       ScenarioLong },
+    { "mixed",      ScenarioMixed },
+    { "history",    ScenarioHistory },
+};
+
+static int LoadFile(SIM_SCENARIO_T *scenario, const char *path)
+{
+    char line[256];
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL)
+    {
+        return -1;
+    }
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        double timeMs, holdMs;
+        unsigned pins;
+        char *comment = strchr(line, '#');
+
+        if(comment != NULL)
+        {
+            *comment = '\0';
+        }
+        if(sscanf(line, "%lf %i %lf", &timeMs, &pins, &holdMs) == 3)
+        {
+            if(scenario->pressCount < SIM_MAX_PRESSES)
+            {
+                SIM_PRESS_T *press = &scenario->presses[scenario->pressCount++];
+                press->timeNs = (uint64_t)(timeMs * SIM_NS_PER_MS);
+                press->holdNs = (uint64_t)(holdMs * SIM_NS_PER_MS);
+                press->pins = (uint8)pins;
+            }
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+/* splitmix64 */
+static uint64_t NextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/*******************************************************************************
+* Public API
+*******************************************************************************/
+void SimScenarioRandom(SIM_SCENARIO_T *scenario, uint64_t seed,
+                       uint64_t durationMs, uint64_t meanGapMs)
+{
+    uint64_t state = seed;
+    uint64_t timeMs = 0u;
+
+    scenario->name = "random";
+    scenario->pressCount = 0u;
+    if(meanGapMs == 0u)
+    {
+        return;
+    }
+
+    for(;;)
+    {
+        uint32 kind;
+
+        /* Uniform gap in [0, 2 * meanGapMs) between gestures */
+        timeMs += NextRandom(&state) % (2u * meanGapMs);
+        if(timeMs >= durationMs)
+        {
+            break;
+        }
+
+        kind = (uint32)(NextRandom(&state) % 100u);
+        if(kind < 40u)
+        {
+            AddGesture(scenario, timeMs, BOTH_PINS, 1u);
+        }
+        else if(kind < 65u)
+        {
+            AddGesture(scenario, timeMs, BOTH_PINS, 2u);
+        }
+        else if(kind < 80u)
+        {
+            AddGesture(scenario, timeMs, BOTH_PINS, 4u);
+        }
+        else if(kind < 90u)
+        {
+            AddGesture(scenario, timeMs, RIGHT_PIN, 5u);
+        }
+        else
+        {
+            AddPress(scenario, timeMs, BOTH_PINS, LONG_HOLD_MS);
+        }
+        /* No overlap with the next gesture */
+        timeMs += 5u * PRESS_GAP_MS + LONG_HOLD_MS;
+    }
+}
+
+int SimScenarioLoad(SIM_SCENARIO_T *scenario, const char *name)
+{
+    uint32 i;
+
+    scenario->name = name;
+    scenario->pressCount = 0u;
+
+    for(i = 0u; i < sizeof(builtins) / sizeof(builtins[0]); ++i)
+    {
+        if(strcmp(builtins[i].name, name) == 0)
+        {
+            builtins[i].build(scenario);
+            return 0;
+        }
+    }
+    return LoadFile(scenario, name);
+}
+
+/* [] END OF FILE */
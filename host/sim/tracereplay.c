@@ -0,0 +1,590 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai - Public Release
+ * License: GNU GPL v3
+ *
+ * @file    tracereplay.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Replays event traces (event_trace.h) through the firmware
+ * @author  prisma.ai
+ *
+ *  For each trace, the presses are rebuilt from its button records and the
+ * firmware (an EVENT_TRACE build) runs on them in the simulator, in a
+ * forked child, until the time the trace was taken. The gesture codes the
+ * replay put in the payload, with their sequence numbers, are compared to
+ * the recorded ones, in order. A run fails (exit 2) if one differs, or if
+ * one went out more than -d ms away from the recorded time.
+ *
+ *  A press starts at the interrupt that saw its button fire. It ends half
+ * way between the last check that saw the button held and the first that
+ * didn't, so every check of the replay reads what the recorded one did. A
+ * fire of a held button is a bounce until that press was checked. The
+ * bounces are in the trace, so the replay runs with bounce_edges=0.
+ *   A trace that wrapped (records dropped) is replayed from a cold boot, its
+ * first record REPLAY_LEAD_MS in. Sequence numbers are compared relative to
+ * the first payload, the gesture in progress at the wrap can differ, and
+ * the advertising events don't fall where they did: give it a larger -d.
+ *
+ *  tracereplay [-c name=value]... [-d max_drift_ms] [-v] trace...
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "lp_timer.h"
+#include "button_func.h"
+#include "event_trace.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define DEFAULT_DRIFT_MS        (1.0)
+#define REPLAY_LEAD_MS          (75000u)    // Before the first record of a wrapped trace
+
+#define EXIT_REGRESSION         (2)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32      time;
+    uint8       kind;
+    uint8       args[3];
+} TRACE_RECORD_T;
+
+typedef struct
+{
+    uint32          count;
+    uint32          dropped;
+    uint32          end;
+    TRACE_RECORD_T  *records;
+} TRACE_T;
+
+/* What a replay sends back to the parent, followed by its trace */
+typedef struct
+{
+    uint64_t    virtualNs;
+    uint64_t    wallNs;
+    uint32      length;
+} REPLAY_RESULT_T;
+
+/* One gesture code put in the payload */
+typedef struct
+{
+    uint32      time;
+    uint8       code;
+    uint8       seq;
+} REPLAY_PAYLOAD_T;
+
+static SIM_SCENARIO_T scenario;
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32 GetLe(const uint8 *data, uint32 bytes)
+{
+    uint32 value = 0u;
+
+    while(bytes-- > 0u)
+    {
+        value = (value << 8) | data[bytes];
+    }
+    return value;
+}
+
+static uint64_t TicksToNs(uint32 ticks)
+{
+    /* The start of the tick, so LowPowerTimerNow() reads it back */
+    return ((uint64_t)ticks * SIM_NS_PER_S + LP_TIMER_HZ - 1u) / LP_TIMER_HZ;
+}
+
+static double TicksToMs(uint32 ticks)
+{
+    return (double)ticks * 1000.0 / LP_TIMER_HZ;
+}
+
+static int ParseTrace(const uint8 *data, size_t length, TRACE_T *trace)
+{
+    uint32 i;
+
+    if(length < EVENT_TRACE_HEADER_LEN ||
+       memcmp(data, EVENT_TRACE_MAGIC, 4u) != 0 ||
+       data[4] != EVENT_TRACE_VERSION || data[5] != EVENT_TRACE_RECORD_LEN)
+    {
+        return -1;
+    }
+    trace->count = GetLe(&data[6], 2u);
+    trace->dropped = GetLe(&data[8], 4u);
+    trace->end = GetLe(&data[12], 4u);
+    if(length != EVENT_TRACE_HEADER_LEN + (size_t)trace->count * EVENT_TRACE_RECORD_LEN)
+    {
+        return -1;
+    }
+
+    trace->records = calloc(trace->count + 1u, sizeof(TRACE_RECORD_T));
+    if(trace->records == NULL)
+    {
+        return -1;
+    }
+    for(i = 0u; i < trace->count; ++i)
+    {
+        const uint8 *record = &data[EVENT_TRACE_HEADER_LEN + i * EVENT_TRACE_RECORD_LEN];
+
+        trace->records[i].time = GetLe(record, 4u);
+        trace->records[i].kind = record[4];
+        memcpy(trace->records[i].args, &record[5], 3u);
+    }
+    return 0;
+}
+
+static int LoadTrace(const char *path, TRACE_T *trace)
+{
+    FILE *file = fopen(path, "rb");
+    uint8 *data;
+    long length;
+    int result = -1;
+
+    if(file == NULL)
+    {
+        return -1;
+    }
+    if(fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 &&
+       fseek(file, 0, SEEK_SET) == 0 &&
+       (data = malloc((size_t)length + 1u)) != NULL)
+    {
+        if(fread(data, 1u, (size_t)length, file) == (size_t)length)
+        {
+            result = ParseTrace(data, (size_t)length, trace);
+        }
+        free(data);
+    }
+    fclose(file);
+    return result;
+}
+
+/* Time the replay starts the trace at: 0, unless it wrapped */
+static uint32 TraceShift(const TRACE_T *trace)
+{
+    uint32 lead = LP_TIMER_MS_TO_TICKS(REPLAY_LEAD_MS);
+
+    if(trace->dropped == 0u || trace->count == 0u || trace->records[0].time < lead)
+    {
+        return 0u;
+    }
+    return trace->records[0].time - lead;
+}
+
+static int AddPress(uint32 down, uint32 up, uint8 pins, uint32 shift)
+{
+    SIM_PRESS_T *press;
+
+    if(scenario.pressCount >= SIM_MAX_PRESSES)
+    {
+        return -1;
+    }
+    press = &scenario.presses[scenario.pressCount++];
+    press->timeNs = TicksToNs(down - shift);
+    press->holdNs = TicksToNs(up - shift) - press->timeNs;
+    press->pins = pins;
+    return 0;
+}
+
+/* The presses that make the firmware see what the trace recorded */
+static int BuildPresses(const TRACE_T *trace, uint32 shift)
+{
+    uint32 down[BUTTON_COUNT] = { 0 };      // Press start
+    uint32 held[BUTTON_COUNT] = { 0 };      // Last record that saw it held
+    uint8 checked[BUTTON_COUNT] = { 0 };    // A check saw it since it went down
+    uint8 pressed = 0u;
+    uint32 i, b;
+
+    scenario.name = "replay";
+    scenario.pressCount = 0u;
+
+    for(i = 0u; i < trace->count; ++i)
+    {
+        const TRACE_RECORD_T *record = &trace->records[i];
+        uint8 fired = (record->kind == EVENT_TRACE_BUTTON_IRQ) ? record->args[0] : 0u;
+        uint8 level = record->args[1];
+
+        if(record->kind != EVENT_TRACE_BUTTON_IRQ && record->kind != EVENT_TRACE_BUTTON_LEVEL)
+        {
+            continue;
+        }
+
+        for(b = 0u; b < BUTTON_COUNT; ++b)
+        {
+            uint8 pin = (uint8)(1u << b);
+
+            /* Released since: half way, or at once if it never read held */
+            if((pressed & pin) &&
+               (!(level & pin) || ((fired & pin) && checked[b])))
+            {
+                if(AddPress(down[b], held[b] + (record->time - held[b]) / 2u, pin, shift) != 0)
+                {
+                    return -1;
+                }
+                pressed &= (uint8)~pin;
+            }
+
+            if(!(pressed & pin) && ((fired | level) & pin))
+            {
+                if(!(level & pin))
+                {
+                    /* Fired, but already released when the ISR looked */
+                    if(AddPress(record->time, record->time, pin, shift) != 0)
+                    {
+                        return -1;
+                    }
+                    continue;
+                }
+                pressed |= pin;
+                down[b] = record->time;
+                checked[b] = 0u;
+            }
+
+            if(pressed & pin)
+            {
+                held[b] = record->time;
+                checked[b] |= (record->kind == EVENT_TRACE_BUTTON_LEVEL);
+            }
+        }
+    }
+
+    /* Still held at the end */
+    for(b = 0u; b < BUTTON_COUNT; ++b)
+    {
+        if((pressed & (1u << b)) &&
+           AddPress(down[b], trace->end, (uint8)(1u << b), shift) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static uint32 Payloads(const TRACE_T *trace, uint32 shift, REPLAY_PAYLOAD_T *out)
+{
+    uint32 count = 0u;
+    uint32 i;
+
+    for(i = 0u; i < trace->count; ++i)
+    {
+        const TRACE_RECORD_T *record = &trace->records[i];
+
+        if(record->kind == EVENT_TRACE_PAYLOAD)
+        {
+            out[count].time = record->time - shift;
+            out[count].code = record->args[0];
+            out[count].seq = record->args[1];
+            ++count;
+        }
+    }
+    return count;
+}
+
+static uint64_t WallNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * SIM_NS_PER_S + (uint64_t)now.tv_nsec;
+}
+
+static int WriteAll(int fd, const void *data, size_t length)
+{
+    const uint8 *p = data;
+
+    while(length > 0u)
+    {
+        ssize_t written = write(fd, p, length);
+        if(written <= 0)
+        {
+            return -1;
+        }
+        p += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+static int ReadAll(int fd, void *data, size_t length)
+{
+    uint8 *p = data;
+
+    while(length > 0u)
+    {
+        ssize_t got = read(fd, p, length);
+        if(got <= 0)
+        {
+            return -1;
+        }
+        p += got;
+        length -= (size_t)got;
+    }
+    return 0;
+}
+
+/* Runs in the child: one simulator run, its trace to the parent */
+static int RunReplay(const SIM_CONFIG_T *config, const TRACE_T *trace,
+                     uint32 shift, int fd)
+{
+    REPLAY_RESULT_T result;
+    const EVENT_TRACE_STATS_T *traceStats;
+    uint8 *data;
+    uint64_t start;
+
+    result.virtualNs = TicksToNs(trace->end - shift);
+    start = WallNs();
+    (void)SimRun(config, &scenario, result.virtualNs, 0);
+    result.wallNs = WallNs() - start;
+
+    traceStats = GetEventTraceStats();
+    if(traceStats == NULL)
+    {
+        return -1;
+    }
+    data = malloc(EVENT_TRACE_HEADER_LEN +
+                  (size_t)(traceStats->records - traceStats->dropped) * EVENT_TRACE_RECORD_LEN);
+    if(data == NULL)
+    {
+        return -1;
+    }
+    result.length = EventTraceSerialize(data, traceStats->records - traceStats->dropped);
+    return (WriteAll(fd, &result, sizeof(result)) == 0 &&
+            WriteAll(fd, data, result.length) == 0) ? 0 : -1;
+}
+
+static int ForkReplay(const SIM_CONFIG_T *config, const TRACE_T *trace,
+                      uint32 shift, REPLAY_RESULT_T *result, TRACE_T *replayed)
+{
+    uint8 *data = NULL;
+    int fds[2];
+    int status;
+    int failed;
+    pid_t pid;
+
+    if(pipe(fds) != 0)
+    {
+        return -1;
+    }
+    pid = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if(pid == 0)
+    {
+        close(fds[0]);
+        _exit(RunReplay(config, trace, shift, fds[1]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    failed = (ReadAll(fds[0], result, sizeof(*result)) != 0 ||
+              (data = malloc(result->length + 1u)) == NULL ||
+              ReadAll(fds[0], data, result->length) != 0 ||
+              ParseTrace(data, result->length, replayed) != 0);
+    free(data);
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return (failed || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) ? -1 : 0;
+}
+
+static void PrintPayloads(const REPLAY_PAYLOAD_T *recorded, uint32 recordedCount,
+                          const REPLAY_PAYLOAD_T *replayed, uint32 replayedCount)
+{
+    uint32 i;
+
+    printf("  %12s %5s %4s   %12s %5s %4s\n", "recorded ms", "code", "seq",
+           "replayed ms", "code", "seq");
+    for(i = 0u; i < recordedCount || i < replayedCount; ++i)
+    {
+        if(i < recordedCount)
+        {
+            printf("  %12.3f %5u %4u", TicksToMs(recorded[i].time),
+                   recorded[i].code, recorded[i].seq);
+        }
+        else
+        {
+            printf("  %12s %5s %4s", "", "", "");
+        }
+        if(i < replayedCount)
+        {
+            printf("   %12.3f %5u %4u", TicksToMs(replayed[i].time),
+                   replayed[i].code, replayed[i].seq);
+        }
+        printf("\n");
+    }
+}
+
+static void Usage(const char *self)
+{
+    fprintf(stderr,
+        "usage: %s [-c name=value]... [-d max_drift_ms] [-v] trace...\n"
+        "  -c  override a model parameter, see bandsim -p for the list\n"
+        "  -d  fail if a payload goes out further than this from the\n"
+        "      recorded time (default %.1f)\n"
+        "  -v  print the recorded and replayed payloads of every trace\n",
+        self, DEFAULT_DRIFT_MS);
+}
+
+int main(int argc, char **argv)
+{
+    SIM_CONFIG_T config;
+    double maxDriftMs = DEFAULT_DRIFT_MS;
+    uint64_t virtualNs = 0u;
+    uint64_t wallNs = 0u;
+    uint32 differ = 0u;
+    int verbose = 0;
+    int opt;
+    int i;
+
+    SimConfigDefaults(&config);
+    config.bounceEdges = 0.0;
+
+    while((opt = getopt(argc, argv, "c:d:vh")) != -1)
+    {
+        switch(opt)
+        {
+            case 'c':
+                if(SimConfigSet(&config, optarg) != 0)
+                {
+                    fprintf(stderr, "unknown parameter: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'd':
+                maxDriftMs = atof(optarg);
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(optind >= argc)
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(i = optind; i < argc; ++i)
+    {
+        TRACE_T trace;
+        TRACE_T replayed;
+        REPLAY_RESULT_T result;
+        REPLAY_PAYLOAD_T *recordedPayloads;
+        REPLAY_PAYLOAD_T *replayedPayloads;
+        uint32 recordedCount, replayedCount;
+        uint32 shift, p;
+        double driftMs = 0.0;
+        int mismatch = -1;
+
+        if(LoadTrace(argv[i], &trace) != 0)
+        {
+            fprintf(stderr, "can't load trace: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        shift = TraceShift(&trace);
+        if(BuildPresses(&trace, shift) != 0)
+        {
+            fprintf(stderr, "%s: more than %u presses\n", argv[i], SIM_MAX_PRESSES);
+            return EXIT_FAILURE;
+        }
+        if(ForkReplay(&config, &trace, shift, &result, &replayed) != 0)
+        {
+            fprintf(stderr, "%s: replay failed\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        virtualNs += result.virtualNs;
+        wallNs += result.wallNs;
+
+        recordedPayloads = malloc((trace.count + 1u) * sizeof(REPLAY_PAYLOAD_T));
+        replayedPayloads = malloc((replayed.count + 1u) * sizeof(REPLAY_PAYLOAD_T));
+        if(recordedPayloads == NULL || replayedPayloads == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        recordedCount = Payloads(&trace, shift, recordedPayloads);
+        replayedCount = Payloads(&replayed, 0u, replayedPayloads);
+
+        for(p = 0u; p < recordedCount && p < replayedCount; ++p)
+        {
+            const REPLAY_PAYLOAD_T *a = &recordedPayloads[p];
+            const REPLAY_PAYLOAD_T *b = &replayedPayloads[p];
+            double ms = TicksToMs((a->time > b->time) ? a->time - b->time : b->time - a->time);
+
+            if(a->code != b->code ||
+               (uint8)(a->seq - recordedPayloads[0].seq) != (uint8)(b->seq - replayedPayloads[0].seq) ||
+               ms > maxDriftMs)
+            {
+                mismatch = (int)p;
+                break;
+            }
+            if(ms > driftMs)
+            {
+                driftMs = ms;
+            }
+        }
+
+        printf("%-36s ", argv[i]);
+        if(mismatch >= 0)
+        {
+            const REPLAY_PAYLOAD_T *a = &recordedPayloads[mismatch];
+            const REPLAY_PAYLOAD_T *b = &replayedPayloads[mismatch];
+
+            printf("DIFF  payload %d: code %u seq %u at %.3f ms, replayed code %u seq %u at %.3f ms\n",
+                   mismatch, a->code, a->seq, TicksToMs(a->time),
+                   b->code, b->seq, TicksToMs(b->time));
+        }
+        else if(recordedCount != replayedCount)
+        {
+            printf("DIFF  %u payloads, replayed %u\n", recordedCount, replayedCount);
+        }
+        else
+        {
+            printf("OK    %4u payloads, %7.1f s in %8.3f ms (%.0fx), drift %.3f ms\n",
+                   recordedCount, (double)result.virtualNs / SIM_NS_PER_S,
+                   (double)result.wallNs / SIM_NS_PER_MS,
+                   (double)result.virtualNs / (double)(result.wallNs ? result.wallNs : 1u),
+                   driftMs);
+        }
+        if(mismatch >= 0 || recordedCount != replayedCount)
+        {
+            ++differ;
+        }
+        if(verbose)
+        {
+            PrintPayloads(recordedPayloads, recordedCount, replayedPayloads, replayedCount);
+        }
+
+        free(recordedPayloads);
+        free(replayedPayloads);
+        free(trace.records);
+        free(replayed.records);
+    }
+
+    printf("%d traces, %u differ, %.1f s of virtual time in %.3f s (%.0fx real time)\n",
+           argc - optind, differ, (double)virtualNs / SIM_NS_PER_S,
+           (double)wallNs / SIM_NS_PER_S,
+           (double)virtualNs / (double)(wallNs ? wallNs : 1u));
+
+    return (differ != 0u) ? EXIT_REGRESSION : EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,325 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    log_sync.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Drains the event log to a client over the Log Sync service
+ * @author  prisma.ai
+ *
+ *  The radio is most of the energy of a sync, so the connection is kept as
+ * short as possible: the client exchanges the largest MTU, enables the
+ * notifications and writes LOG_SYNC_OP_START; every notification then
+ * carries as many records as the MTU holds, and they are queued until the
+ * stack has no buffers left, so every connection event goes out full. The
+ * band asks for a short interval, and disconnects as soon as the client
+ * has the end marker (or goes quiet), then advertises again.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "log_sync.h"
+#include "lp_timer.h"
+#include "clk_gov.h"
+
+#if (LOG_SYNC)
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define LOG_SYNC_IDLE               (0u)    // Not connected
+#define LOG_SYNC_CONNECTED          (1u)    // Waiting for LOG_SYNC_OP_START
+#define LOG_SYNC_STREAMING          (2u)
+#define LOG_SYNC_ENDED              (3u)    // End marker queued
+#define LOG_SYNC_CLOSING            (4u)    // Disconnect asked for
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE LOG_SYNC_STATS_T log_sync_stats;
+
+static FW_STATE CYBLE_CONN_HANDLE_T sync_conn;
+static FW_STATE uint8  sync_state = LOG_SYNC_IDLE;
+static FW_STATE uint8  sync_notify = 0;          // Notifications enabled (CCCD)
+static FW_STATE uint8  sync_busy = 0;            // Stack buffers full
+static FW_STATE uint16 sync_mtu = CYBLE_GATT_DEFAULT_MTU;
+static FW_STATE uint32 sync_next = 0;            // Next record to send
+static FW_STATE uint32 sync_since = 0;           // LowPowerTimerNow() of the last activity
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static uint32 LogSyncGet32(const uint8 *data)
+{
+    return (uint32)data[0] | ((uint32)data[1] << 8) |
+           ((uint32)data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+static void LogSyncPut32(uint8 *data, uint32 value)
+{
+    data[0] = (uint8)(value & 0xFFu);
+    data[1] = (uint8)((value >> 8) & 0xFFu);
+    data[2] = (uint8)((value >> 16) & 0xFFu);
+    data[3] = (uint8)(value >> 24);
+}
+
+/*******************************************************************************
+* @brief This routine asks for the link to be dropped.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void LogSyncDisconnect(void)
+{
+    if(CyBle_GapDisconnect(sync_conn.bdHandle) == CYBLE_ERROR_OK)
+    {
+        sync_state = LOG_SYNC_CLOSING;
+    }
+}
+
+/*******************************************************************************
+* @brief This routine handles a write to the CCCD or to Control.
+*
+* @param CYBLE_GATTS_WRITE_REQ_PARAM_T* write: The write request
+*
+* @returns None
+*******************************************************************************/
+static void LogSyncWrite(CYBLE_GATTS_WRITE_REQ_PARAM_T *write)
+{
+    const CYBLE_GATT_VALUE_T *value = &write->handleValPair.value;
+    CYBLE_GATTS_ERR_PARAM_T error;
+    uint32 oldest, end;
+
+    error.opCode = CYBLE_GATT_WRITE_REQ;
+    error.attrHandle = write->handleValPair.attrHandle;
+    error.errorCode = CYBLE_GATT_ERR_NONE;
+
+    switch(write->handleValPair.attrHandle)
+    {
+        case CYBLE_LOG_SYNC_RECORDS_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE:
+            if(value->len != 2u)
+            {
+                error.errorCode = CYBLE_GATT_ERR_INVALID_ATTRIBUTE_LEN;
+                break;
+            }
+            sync_notify = value->val[0] & 0x01u;
+            CyBle_GattsWriteAttributeValue(&write->handleValPair, 0u,
+                                           &write->connHandle, CYBLE_GATT_DB_PEER_INITIATED);
+            break;
+
+        case CYBLE_LOG_SYNC_CONTROL_CHAR_HANDLE:
+            if(value->len == LOG_SYNC_START_LEN && value->val[0] == LOG_SYNC_OP_START)
+            {
+                /* Resume where the client stopped, if it's still there */
+                oldest = EventLogOldest();
+                end = EventLogEnd(0);
+                sync_next = LogSyncGet32(&value->val[1]);
+                if((int32)(sync_next - oldest) < 0 || (int32)(sync_next - end) > 0)
+                {
+                    sync_next = oldest;
+                }
+                sync_state = LOG_SYNC_STREAMING;
+                ++log_sync_stats.syncs;
+            }
+            else if(value->len == 1u && value->val[0] == LOG_SYNC_OP_DONE)
+            {
+                sync_state = LOG_SYNC_ENDED;
+                LogSyncDisconnect();
+            }
+            else
+            {
+                error.errorCode = CYBLE_GATT_ERR_REQUEST_NOT_SUPPORTED;
+            }
+            break;
+
+        default:
+            return;
+    }
+
+    if(error.errorCode == CYBLE_GATT_ERR_NONE)
+    {
+        CyBle_GattsWriteRsp(write->connHandle);
+    }
+    else
+    {
+        CyBle_GattsErrorRsp(write->connHandle, &error);
+    }
+}
+
+/*******************************************************************************
+* @brief This routine queues Records notifications until the stack is out
+*       of buffers, the last one being the end marker.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+static void LogSyncPump(void)
+{
+    uint8 value[LOG_SYNC_NOTIFY_MAX];
+    CYBLE_GATTS_HANDLE_VALUE_NTF_T notification;
+    uint8 max = (uint8)((sync_mtu - 3u - LOG_SYNC_HEADER_LEN) / EVENT_LOG_RECORD_LEN);
+    uint8 count;
+
+    notification.attrHandle = CYBLE_LOG_SYNC_RECORDS_CHAR_HANDLE;
+    notification.value.val = value;
+
+#if (CLK_GOV)
+    if(sync_state == LOG_SYNC_STREAMING && sync_notify && !sync_busy)
+    {
+        ClockGovernorBoost();
+    }
+#endif
+
+    while(sync_state == LOG_SYNC_STREAMING && sync_notify && !sync_busy)
+    {
+        count = EventLogCopy(sync_next, &value[LOG_SYNC_HEADER_LEN], max);
+        if(count == 0u && (int32)(sync_next - EventLogOldest()) < 0)
+        {
+            /* Overwritten while it was being sent, skip the gap */
+            sync_next = EventLogOldest();
+            continue;
+        }
+
+        LogSyncPut32(value, sync_next);
+        notification.value.len = (uint16)(LOG_SYNC_HEADER_LEN + count * EVENT_LOG_RECORD_LEN);
+        if(CyBle_GattsNotification(sync_conn, &notification) != CYBLE_ERROR_OK)
+        {
+            /* Out of buffers: go on at CYBLE_EVT_STACK_BUSY_STATUS */
+            sync_busy = 1;
+            ++log_sync_stats.busy;
+            break;
+        }
+
+        ++log_sync_stats.notifications;
+        log_sync_stats.records += count;
+        sync_next += count;
+        sync_since = LowPowerTimerNow();
+        if(count == 0u)
+        {
+            sync_state = LOG_SYNC_ENDED;
+        }
+        else if(CyBle_GattGetBusyStatus() == CYBLE_STACK_STATE_BUSY)
+        {
+            sync_busy = 1;
+            ++log_sync_stats.busy;
+        }
+    }
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine handles the connection / GATT events of the stack:
+*       connect, MTU exchange, writes, buffer status and disconnect.
+*
+* @param uint32 event:              Event from the CYBLE component
+* @param void* eventParam:          Its parameter
+*
+* @returns None
+*******************************************************************************/
+void LogSyncEvent(uint32 event, void *eventParam)
+{
+    CYBLE_GAP_CONN_UPDATE_PARAM_T connParam;
+
+    switch(event)
+    {
+        case CYBLE_EVT_GATT_CONNECT_IND:
+            sync_conn = *(CYBLE_CONN_HANDLE_T *)eventParam;
+            sync_state = LOG_SYNC_CONNECTED;
+            sync_notify = 0;
+            sync_busy = 0;
+            sync_mtu = CYBLE_GATT_DEFAULT_MTU;
+            sync_since = LowPowerTimerNow();
+            ++log_sync_stats.connections;
+            log_sync_stats.mtu = sync_mtu;
+
+            /* The central picks the first interval, ask for a short one */
+            connParam.connIntvMin = LOG_SYNC_INTERVAL_MIN;
+            connParam.connIntvMax = LOG_SYNC_INTERVAL_MAX;
+            connParam.connLatency = 0;
+            connParam.supervisionTO = LOG_SYNC_TIMEOUT;
+            CyBle_L2capLeConnectionParamUpdateRequest(sync_conn.bdHandle, &connParam);
+            break;
+
+        /*  Only the client can start the exchange; the stack answers with
+         * CYBLE_GATT_MTU and both sides use the smaller one */
+        case CYBLE_EVT_GATTS_XCNHG_MTU_REQ:
+            sync_mtu = ((CYBLE_GATT_XCHG_MTU_PARAM_T *)eventParam)->mtu;
+            if(sync_mtu > CYBLE_GATT_MTU)
+            {
+                sync_mtu = CYBLE_GATT_MTU;
+            }
+            log_sync_stats.mtu = sync_mtu;
+            break;
+
+        case CYBLE_EVT_GATTS_WRITE_REQ:
+            sync_since = LowPowerTimerNow();
+            LogSyncWrite((CYBLE_GATTS_WRITE_REQ_PARAM_T *)eventParam);
+            break;
+
+        case CYBLE_EVT_STACK_BUSY_STATUS:
+            sync_busy = (*(uint8 *)eventParam == CYBLE_STACK_STATE_BUSY) ? 1u : 0u;
+            break;
+
+        case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
+            sync_state = LOG_SYNC_IDLE;
+            sync_notify = 0;
+            sync_busy = 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*******************************************************************************
+* @brief This routine queues notifications while the stack has buffers for
+*       them, and disconnects once the client is done or idle. Called from
+*       the main loop.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void LogSyncService(void)
+{
+    if(sync_state == LOG_SYNC_IDLE || sync_state == LOG_SYNC_CLOSING)
+    {
+        return;
+    }
+
+    LogSyncPump();
+
+    if((uint32)(LowPowerTimerNow() - sync_since) >= LP_TIMER_MS_TO_TICKS(LOG_SYNC_IDLE_MS))
+    {
+        ++log_sync_stats.timeouts;
+        LogSyncDisconnect();
+    }
+}
+#endif
+
+/*******************************************************************************
+* @brief This function returns the sync counters.
+*
+* @param None
+*
+* @returns const LOG_SYNC_STATS_T*: Syncs / notifications / records
+*******************************************************************************/
+const LOG_SYNC_STATS_T *GetLogSyncStats(void)
+{
+#if (LOG_SYNC)
+    return &log_sync_stats;
+#else
+    static const LOG_SYNC_STATS_T none;
+    return &none;
+#endif
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,114 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    log_sync.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for log_sync.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef LOG_SYNC_HEADER
+#define LOG_SYNC_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+#include "event_log.h"
+
+/*******************************************************************************
+* Constants
+*
+*   Log Sync is a custom service of the BLE component (GATT settings) with
+* two characteristics:
+*       Records     Notify, with a CCCD
+*       Control     Write
+*   Its largest MTU (CYBLE_GATT_MTU) is 247, the ATT payload that fills one
+* 251 byte link layer packet.
+*******************************************************************************/
+/* Set to 0 to build without the service, it needs the event log */
+#ifndef LOG_SYNC
+#define LOG_SYNC                    (EVENT_LOG)
+#endif
+
+/*  Control writes, little endian:
+ *      LOG_SYNC_OP_START [1-4]     Send the records from this number on
+ *                                  (from the oldest one if it's gone)
+ *      LOG_SYNC_OP_DONE            The end marker arrived, disconnect     */
+#define LOG_SYNC_OP_START           (0x01u)
+#define LOG_SYNC_OP_DONE            (0x02u)
+#define LOG_SYNC_START_LEN          (5u)
+
+/*  Records notification, little endian:
+ *      [0-3]       Number of the first record
+ *      [4-]        Records, as stored (see event_log.h)
+ *   The one with no records is the end marker, its number is the end of
+ * the log */
+#define LOG_SYNC_HEADER_LEN         (4u)
+#define LOG_SYNC_NOTIFY_MAX         (CYBLE_GATT_MTU - 3u)
+
+/*  Connection parameters asked for once connected: a short interval drains
+ * the log in a few events. Units of 1.25 ms / 10 ms */
+#define LOG_SYNC_INTERVAL_MIN       (6u)    // 7.5 ms
+#define LOG_SYNC_INTERVAL_MAX       (12u)   // 15 ms
+#define LOG_SYNC_TIMEOUT            (200u)  // 2 s
+
+/*  A connection that doesn't ask for anything for this long is dropped, so
+ * the band goes back to advertising */
+#define LOG_SYNC_IDLE_MS            (3000u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 connections;
+    uint32 syncs;           // LOG_SYNC_OP_START writes
+    uint32 notifications;   // End markers included
+    uint32 records;
+    uint32 busy;            // Stack buffers full, waited for STACK_BUSY_STATUS
+    uint32 timeouts;        // Dropped after LOG_SYNC_IDLE_MS
+    uint16 mtu;             // Of the last connection
+} LOG_SYNC_STATS_T;
+
+/*******************************************************************************
+* @brief This routine handles the connection / GATT events of the stack:
+*       connect, MTU exchange, writes, buffer status and disconnect.
+*
+* @param uint32 event:              Event from the CYBLE component
+* @param void* eventParam:          Its parameter
+*
+* @returns None
+*******************************************************************************/
+void LogSyncEvent(uint32 event, void *eventParam);
+
+/*******************************************************************************
+* @brief This routine queues notifications while the stack has buffers for
+*       them, and disconnects once the client is done or idle. Called from
+*       the main loop.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void LogSyncService(void);
+
+/*******************************************************************************
+* @brief This function returns the sync counters.
+*
+* @param None
+*
+* @returns const LOG_SYNC_STATS_T*: Syncs / notifications / records
+*******************************************************************************/
+const LOG_SYNC_STATS_T *GetLogSyncStats(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,183 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    lp_timer.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Low power (WDT based) one-shot timer and time base
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "lp_timer.h"
+#include "power_stats.h"
+#include "profiling.h"
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE LP_TIMER_CALLBACK_T timerCallback[LP_TIMER_CHANNELS] = { NULL, NULL };
+
+/* WDT counter / mask / interrupt / reset bits of each channel */
+static const uint32 timer_counter[LP_TIMER_CHANNELS] =
+    { CY_SYS_WDT_COUNTER0, CY_SYS_WDT_COUNTER1 };
+static const uint32 timer_mask[LP_TIMER_CHANNELS] =
+    { CY_SYS_WDT_COUNTER0_MASK, CY_SYS_WDT_COUNTER1_MASK };
+static const uint32 timer_int[LP_TIMER_CHANNELS] =
+    { CY_SYS_WDT_COUNTER0_INT, CY_SYS_WDT_COUNTER1_INT };
+static const uint32 timer_reset[LP_TIMER_CHANNELS] =
+    { CY_SYS_WDT_COUNTER0_RESET, CY_SYS_WDT_COUNTER1_RESET };
+
+/*******************************************************************************
+* @brief WDT counter match callback, stops the counter and calls the user.
+*
+* @param uint8 channel:             The one-shot that fired
+*
+* @returns None
+*******************************************************************************/
+static void LowPowerTimerExpired(uint8 channel) {
+    LP_TIMER_CALLBACK_T callback = timerCallback[channel];
+    PROFILING_START(isr_start);
+    
+    POWER_STATS_COUNT(timerIrqs);
+    
+    /* One-shot: don't let the counter match again */
+    CySysWdtDisable(timer_mask[channel]);
+    timerCallback[channel] = NULL;
+    
+    if (callback != NULL) {
+        callback();
+    }
+    
+    PROFILING_STOP(PROFILING_ISR_TIMER, isr_start);
+}
+
+static void LowPowerTimer0Expired(void) {
+    LowPowerTimerExpired(LP_TIMER_BUTTONS);
+}
+
+static void LowPowerTimer1Expired(void) {
+    LowPowerTimerExpired(LP_TIMER_DEFERRED);
+}
+
+/*******************************************************************************
+* @brief This routine starts the low power timer.
+*
+*   WDT counter 2 is left free-running as the time base, WDT counters 0 and
+* 1 are used as one-shots (LP_TIMER_BUTTONS / LP_TIMER_DEFERRED).
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void LowPowerTimerStart(void) {
+    /* Free-running 32 bit time base, no interrupts */
+    CySysWdtWriteMode(CY_SYS_WDT_COUNTER2, CY_SYS_WDT_MODE_NONE);
+    CySysWdtEnable(CY_SYS_WDT_COUNTER2_MASK);
+    
+    /* One-shots: interrupt on match, enabled only while armed */
+    CySysWdtWriteMode(CY_SYS_WDT_COUNTER0, CY_SYS_WDT_MODE_INT);
+    CySysWdtWriteClearOnMatch(CY_SYS_WDT_COUNTER0, 1u);
+    CySysWdtSetInterruptCallback(CY_SYS_WDT_COUNTER0, LowPowerTimer0Expired);
+    
+    CySysWdtWriteMode(CY_SYS_WDT_COUNTER1, CY_SYS_WDT_MODE_INT);
+    CySysWdtWriteClearOnMatch(CY_SYS_WDT_COUNTER1, 1u);
+    CySysWdtSetInterruptCallback(CY_SYS_WDT_COUNTER1, LowPowerTimer1Expired);
+    
+    CyIntSetVector(CY_INT_WDT_IRQ, &CySysWdtIsr);
+    CyIntEnable(CY_INT_WDT_IRQ);
+}
+
+/*******************************************************************************
+* @brief This function returns the free-running time base.
+*
+* @param None
+*
+* @returns uint32:                  LFCLK ticks since the timer was started
+*******************************************************************************/
+uint32 LowPowerTimerNow(void) {
+    return CySysWdtReadCount(CY_SYS_WDT_COUNTER2);
+}
+
+/*******************************************************************************
+* @brief This function returns the uptime, in seconds.
+*
+* NOTE: The time base wraps every 36 hours, so this has to be called (from
+*   the main loop) at least that often to keep counting.
+*
+* @param None
+*
+* @returns uint32:                  Seconds since the timer was started
+*******************************************************************************/
+uint32 LowPowerTimerSeconds(void) {
+    static FW_STATE uint32 last_ticks = 0;
+    static FW_STATE uint32 ticks = 0;        // Below one second
+    static FW_STATE uint32 seconds = 0;
+    uint32 now = LowPowerTimerNow();
+    
+    ticks += now - last_ticks;
+    last_ticks = now;
+    
+    /* LP_TIMER_HZ is a power of 2 */
+    seconds += ticks / LP_TIMER_HZ;
+    ticks %= LP_TIMER_HZ;
+    
+    return seconds;
+}
+
+/*******************************************************************************
+* @brief This routine arms a one-shot, replacing its pending deadline.
+*
+* NOTE: The callback is called from the WDT interrupt.
+*
+* @param uint8 channel:                 The one-shot (ie: LP_TIMER_BUTTONS)
+* @param uint32 ticks:                  Ticks until the callback (1 to 
+*                                      LP_TIMER_MAX_TICKS)
+* @param LP_TIMER_CALLBACK_T callback:  What to call when the timer fires
+*                                      (NULL to only wake the CPU up)
+*
+* @returns None
+*******************************************************************************/
+void LowPowerTimerArm(uint8 channel, uint32 ticks, LP_TIMER_CALLBACK_T callback) {
+    uint8 intrStatus = CyEnterCriticalSection();
+    
+    if (ticks == 0u) {
+        ticks = 1u;
+    } else if (ticks > LP_TIMER_MAX_TICKS) {
+        ticks = LP_TIMER_MAX_TICKS;
+    }
+    
+    timerCallback[channel] = callback;
+    
+    CySysWdtDisable(timer_mask[channel]);
+    CySysWdtWriteMatch(timer_counter[channel], ticks);
+    CySysWdtResetCounters(timer_reset[channel]);
+    CySysWdtEnable(timer_mask[channel]);
+    
+    CyExitCriticalSection(intrStatus);
+}
+
+/*******************************************************************************
+* @brief This routine cancels the pending one-shot, if there is one.
+*
+* @param uint8 channel:             The one-shot (ie: LP_TIMER_BUTTONS)
+*
+* @returns None
+*******************************************************************************/
+void LowPowerTimerCancel(uint8 channel) {
+    uint8 intrStatus = CyEnterCriticalSection();
+    
+    CySysWdtDisable(timer_mask[channel]);
+    CySysWdtClearInterrupt(timer_int[channel]);
+    timerCallback[channel] = NULL;
+    
+    CyExitCriticalSection(intrStatus);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,107 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    lp_timer.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for lp_timer.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef LP_TIMER_HEADER
+#define LP_TIMER_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*
+*   The timer runs from LFCLK, which has to be sourced from the WCO in the
+* Design Wide Resources (the ILO is stopped in InitializeSystem). It keeps
+* counting in Deep-Sleep and its interrupt wakes the CPU up.
+*******************************************************************************/
+#define LP_TIMER_HZ                 (32768u)    // LFCLK frequency
+#define LP_TIMER_MAX_TICKS          (0xFFFFu)   // WDT counter 0 is 16 bit (2 s)
+
+/* Converts milliseconds to timer ticks, rounding up */
+#define LP_TIMER_MS_TO_TICKS(ms)    ((uint32)((((uint32)(ms)) * LP_TIMER_HZ + 999u) / 1000u))
+
+/* One-shot channels */
+#define LP_TIMER_BUTTONS            (0u)    // WDT counter 0, debounce / long press
+#define LP_TIMER_DEFERRED           (1u)    // WDT counter 1, deferred.c wakeups
+#define LP_TIMER_CHANNELS           (2u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef void (*LP_TIMER_CALLBACK_T)(void);
+
+/*******************************************************************************
+* @brief This routine starts the low power timer.
+*
+*   WDT counter 2 is left free-running as the time base, WDT counters 0 and
+* 1 are used as one-shots (LP_TIMER_BUTTONS / LP_TIMER_DEFERRED).
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void LowPowerTimerStart(void);
+
+/*******************************************************************************
+* @brief This function returns the free-running time base.
+*
+* @param None
+*
+* @returns uint32:                  LFCLK ticks since the timer was started
+*******************************************************************************/
+uint32 LowPowerTimerNow(void);
+
+/*******************************************************************************
+* @brief This function returns the uptime, in seconds.
+*
+* NOTE: The time base wraps every 36 hours, so this has to be called (from
+*   the main loop) at least that often to keep counting.
+*
+* @param None
+*
+* @returns uint32:                  Seconds since the timer was started
+*******************************************************************************/
+uint32 LowPowerTimerSeconds(void);
+
+/*******************************************************************************
+* @brief This routine arms a one-shot, replacing its pending deadline.
+*
+* NOTE: The callback is called from the WDT interrupt.
+*
+* @param uint8 channel:                 The one-shot (ie: LP_TIMER_BUTTONS)
+* @param uint32 ticks:                  Ticks until the callback (1 to 
+*                                      LP_TIMER_MAX_TICKS)
+* @param LP_TIMER_CALLBACK_T callback:  What to call when the timer fires
+*                                      (NULL to only wake the CPU up)
+*
+* @returns None
+*******************************************************************************/
+void LowPowerTimerArm(uint8 channel, uint32 ticks, LP_TIMER_CALLBACK_T callback);
+
+/*******************************************************************************
+* @brief This routine cancels the pending one-shot, if there is one.
+*
+* @param uint8 channel:             The one-shot (ie: LP_TIMER_BUTTONS)
+*
+* @returns None
+*******************************************************************************/
+void LowPowerTimerCancel(uint8 channel);
+
+#endif
+
+/* [] END OF FILE */
@@ -23,6 +23,11 @@
 #include "project.h"
 #include "ble_func.h"
 #include "button_func.h"
+#include "adv_sched.h"
+#include "adv_auth.h"
+#include "log_sync.h"
+#include "deferred.h"
+#include "profiling.h"
 
 /*******************************************************************************
 * Main Function
@@ -43,12 +48,36 @@ int main(void)
 
     for(;;)
     {
+        PROFILING_START(loop_start);
+        
         /* Call service all BLE Stack Events */
         CyBle_ProcessEvents();
         
+        /* Fold the presses queued by the interrupts into the counters */
+        ProcessButtonPresses();
+        
+        /* Run the deferred work that is due (see deferred.c) */
+        DeferredService();
+        
         /* Update the broadcasted packet */
         DynamicADVPayloadUpdate();
         
+        /* Compute the keystream for the next signatures while awake */
+        AdvAuthRefill();
+        
+#if (LOG_SYNC)
+        /* Keep the notification queue full while a client syncs the log */
+        LogSyncService();
+#endif
+        
+        /* Pick the advertising interval for the alert state */
+        AdvSchedulerUpdate();
+        
+        /* Clear the gesture once it was broadcasted long enough */
+        UpdateCounterExpiry();
+        
+        PROFILING_STOP(PROFILING_MAIN_LOOP, loop_start);
+        
         /* Enter lowest possible power mode */
         EnterLowPowerMode();
     }
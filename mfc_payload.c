@@ -0,0 +1,282 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    mfc_payload.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Encoder / decoder of the Manufacturer Specific Data payload
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "mfc_payload.h"
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+static void Put32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value & 0xFFu);
+    out[1] = (uint8_t)((value >> 8) & 0xFFu);
+    out[2] = (uint8_t)((value >> 16) & 0xFFu);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t Get32(const uint8_t *data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/*******************************************************************************
+* @brief This function looks for the Manufacturer Specific Data with our
+*       company ID in an ADV packet, walking its AD structures.
+*
+* @param const uint8_t* advData:    The ADV packet
+* @param uint8_t advDataLen:        Its length
+* @param uint8_t* payloadLen:       Set to the bytes after the company ID
+*                                  (can be NULL)
+*
+* @returns int:                     Index of the payload (after the company
+*                                  ID), -1 if there isn't one of at least
+*                                  MFC_PAYLOAD_LEN bytes
+*******************************************************************************/
+int MfcPayloadFind(const uint8_t *advData, uint8_t advDataLen,
+                   uint8_t *payloadLen)
+{
+    uint8_t i = 0;
+
+    /* Every AD structure is [length][type][length - 1 bytes of data] */
+    while(i + 1u < advDataLen && advData[i] != 0u)
+    {
+        uint8_t length = advData[i];
+
+        if(i + 1u + length > advDataLen)
+        {
+            break;  // Truncated structure
+        }
+        if(advData[i + 1u] == MFC_AD_TYPE &&
+           length >= 1u + MFC_COMPANY_ID_LEN + MFC_PAYLOAD_LEN &&
+           advData[i + 2u] == (uint8_t)(MFC_COMPANY_ID & 0xFFu) &&
+           advData[i + 3u] == (uint8_t)(MFC_COMPANY_ID >> 8))
+        {
+            if(payloadLen != NULL)
+            {
+                *payloadLen = (uint8_t)(length - 1u - MFC_COMPANY_ID_LEN);
+            }
+            return i + 2 + MFC_COMPANY_ID_LEN;
+        }
+        i += 1u + length;
+    }
+    return -1;
+}
+
+/*******************************************************************************
+* @brief This function packs the fields.
+*
+* NOTE: presses saturates at MFC_PRESSES_MAX and seq is taken modulo 128.
+*   counter and tag are only written for MFC_PAYLOAD_VERSION_AUTH, any other
+*   version is written as MFC_PAYLOAD_VERSION.
+*
+* @param uint8_t* out:                      Where to write
+* @param const MFC_PAYLOAD_T* payload:      The fields
+*
+* @returns uint8_t:                 Bytes written (MFC_PAYLOAD_LEN or
+*                                  MFC_PAYLOAD_AUTH_LEN)
+*******************************************************************************/
+uint8_t MfcPayloadEncode(uint8_t *out, const MFC_PAYLOAD_T *payload)
+{
+    uint8_t version = (payload->version == MFC_PAYLOAD_VERSION_AUTH) ?
+                      MFC_PAYLOAD_VERSION_AUTH : MFC_PAYLOAD_VERSION;
+    uint8_t presses = payload->presses;
+
+    if(presses > MFC_PRESSES_MAX)
+    {
+        presses = MFC_PRESSES_MAX;
+    }
+
+    out[0] = (uint8_t)(version | (presses << 4));
+    out[1] = (uint8_t)((payload->flags & MFC_FLAG_PAIRING) |
+                       ((payload->seq & MFC_SEQ_MASK) << 1));
+    out[2] = (uint8_t)(payload->uptimeMinutes & 0xFFu);
+    out[3] = (uint8_t)(payload->uptimeMinutes >> 8);
+
+    if(version != MFC_PAYLOAD_VERSION_AUTH)
+    {
+        return MFC_PAYLOAD_LEN;
+    }
+    Put32(&out[4], payload->counter);
+    Put32(&out[8], payload->tag);
+    return MFC_PAYLOAD_AUTH_LEN;
+}
+
+/*******************************************************************************
+* @brief This function unpacks a payload.
+*
+* @param const uint8_t* data:       The payload (ie: advData + MfcPayloadFind())
+* @param uint8_t length:            Bytes available from data
+* @param MFC_PAYLOAD_T* payload:    The fields
+*
+* @returns int:                     0 on success, -1 if too short or of an
+*                                  unknown version
+*******************************************************************************/
+int MfcPayloadDecode(const uint8_t *data, uint8_t length, MFC_PAYLOAD_T *payload)
+{
+    uint8_t version;
+
+    if(length < MFC_PAYLOAD_LEN)
+    {
+        return -1;
+    }
+    version = data[0] & 0x0Fu;
+    if(version != MFC_PAYLOAD_VERSION &&
+       (version != MFC_PAYLOAD_VERSION_AUTH || length < MFC_PAYLOAD_AUTH_LEN))
+    {
+        return -1;
+    }
+
+    payload->version = version;
+    payload->presses = data[0] >> 4;
+    payload->flags = data[1] & MFC_FLAG_PAIRING;
+    payload->seq = data[1] >> 1;
+    payload->uptimeMinutes = (uint16_t)(data[2] | (data[3] << 8));
+    payload->counter = 0;
+    payload->tag = 0;
+
+    if(version == MFC_PAYLOAD_VERSION_AUTH)
+    {
+        payload->counter = Get32(&data[4]);
+        payload->tag = Get32(&data[8]);
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* @brief This routine builds the AES input block for a keystream block, a
+*       block of hash rows or the key of a band.
+*
+*   byte 0 the domain, bytes 4-7 the index (little endian), bytes 8-13 the
+* address, the rest 0.
+*
+* @param uint8_t* out:              MFC_AUTH_BLOCK_LEN bytes
+* @param uint8_t domain:            MFC_AUTH_DOMAIN_KEYSTREAM, _HASH or
+*                                  _BAND_KEY
+* @param const uint8_t* addr:       BD address of the band, MFC_AUTH_ADDR_LEN
+*                                  bytes
+* @param uint32_t index:            Block number (ie: counter >> 2), 0 for
+*                                  the band key
+*
+* @returns None
+*******************************************************************************/
+void MfcAuthBlockInput(uint8_t *out, uint8_t domain, const uint8_t *addr,
+                       uint32_t index)
+{
+    uint8_t i;
+
+    out[0] = domain;
+    for(i = 1u; i < MFC_AUTH_BLOCK_LEN; ++i)
+    {
+        out[i] = 0u;
+    }
+    Put32(&out[4], index);
+    for(i = 0u; i < MFC_AUTH_ADDR_LEN; ++i)
+    {
+        out[8u + i] = addr[i];
+    }
+}
+
+/*******************************************************************************
+* @brief This routine builds the nibble tables of the hash.
+*
+* @param MFC_AUTH_HASH_T* hash:     The tables to build
+* @param const uint8_t* rows:       The MFC_AUTH_HASH_BLOCKS AES outputs, in
+*                                  order (MFC_AUTH_ROWS * 4 bytes)
+*
+* @returns None
+*******************************************************************************/
+void MfcAuthHashInit(MFC_AUTH_HASH_T *hash, const uint8_t *rows)
+{
+    uint8_t nibble, value, bit;
+
+    for(nibble = 0u; nibble < 8u; ++nibble)
+    {
+        for(value = 0u; value < 16u; ++value)
+        {
+            uint32_t sum = 0;
+
+            for(bit = 0u; bit < 4u; ++bit)
+            {
+                if(value & (1u << bit))
+                {
+                    sum ^= Get32(&rows[(nibble * 4u + bit) * 4u]);
+                }
+            }
+            hash->table[nibble][value] = sum;
+        }
+    }
+}
+
+/*******************************************************************************
+* @brief This function hashes the first MFC_PAYLOAD_LEN bytes of a payload.
+*
+* @param const MFC_AUTH_HASH_T* hash:   The tables
+* @param const uint8_t* payload:        The encoded payload
+*
+* @returns uint32_t:                The hash
+*******************************************************************************/
+uint32_t MfcAuthHash(const MFC_AUTH_HASH_T *hash, const uint8_t *payload)
+{
+    return hash->table[0][payload[0] & 0x0Fu] ^ hash->table[1][payload[0] >> 4] ^
+           hash->table[2][payload[1] & 0x0Fu] ^ hash->table[3][payload[1] >> 4] ^
+           hash->table[4][payload[2] & 0x0Fu] ^ hash->table[5][payload[2] >> 4] ^
+           hash->table[6][payload[3] & 0x0Fu] ^ hash->table[7][payload[3] >> 4];
+}
+
+/*******************************************************************************
+* @brief This function hashes the first MFC_PAYLOAD_LEN bytes of a payload
+*       straight from the rows, one XOR per set bit. Same result as
+*       MfcAuthHash, for a receiver that keeps the rows of many bands
+*       rather than their tables.
+*
+* @param const uint8_t* rows:       The MFC_AUTH_HASH_BLOCKS AES outputs, in
+*                                  order (MFC_AUTH_ROWS * 4 bytes)
+* @param const uint8_t* payload:    The encoded payload
+*
+* @returns uint32_t:                The hash
+*******************************************************************************/
+uint32_t MfcAuthHashRows(const uint8_t *rows, const uint8_t *payload)
+{
+    uint32_t sum = 0;
+    uint8_t bit;
+
+    /* Row n goes with bit n % 8 of byte n / 8, as in MfcAuthHashInit */
+    for(bit = 0u; bit < MFC_AUTH_ROWS; ++bit)
+    {
+        if(payload[bit / 8u] & (1u << (bit % 8u)))
+        {
+            sum ^= Get32(&rows[bit * 4u]);
+        }
+    }
+    return sum;
+}
+
+/*******************************************************************************
+* @brief This function picks the keystream word of a counter out of its block.
+*
+* @param const uint8_t* block:      AES output for block counter >> 2
+* @param uint32_t counter:          The counter
+*
+* @returns uint32_t:                The keystream word
+*******************************************************************************/
+uint32_t MfcAuthKeystreamWord(const uint8_t *block, uint32_t counter)
+{
+    return Get32(&block[(counter % MFC_AUTH_WORDS_PER_BLOCK) * 4u]);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,215 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    mfc_payload.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for mfc_payload.c
+ * @author  prisma.ai
+ *
+ *  Shared with the receivers (app / gateways), so only standard C types are
+ * used here.
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef MFC_PAYLOAD_HEADER
+#define MFC_PAYLOAD_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Constants
+*
+*   Manufacturer Specific Data (AD type 0xFF) after the company ID:
+*       byte 0  [3:0]   version (MFC_PAYLOAD_VERSION or MFC_PAYLOAD_VERSION_AUTH)
+*               [7:4]   presses (0 to 15, 4 or more = High Danger)
+*       byte 1  [0]     MFC_FLAG_PAIRING
+*               [7:1]   sequence number, +1 whenever presses / flags change
+*       byte 2-3        uptime in minutes, little endian, wraps
+*   Version 2 (authenticated) goes on with:
+*       byte 4-7        counter, little endian, never repeats for a key
+*       byte 8-11       tag, little endian
+*   The version nibble stays first in every future layout.
+*******************************************************************************/
+#define MFC_AD_TYPE                 (0xFFu)     // Manufacturer Specific Data
+#define MFC_COMPANY_ID              (0xFFFFu)   // No company ID assigned yet
+#define MFC_COMPANY_ID_LEN          (2u)
+
+#define MFC_PAYLOAD_VERSION         (1u)
+#define MFC_PAYLOAD_LEN             (4u)
+#define MFC_PAYLOAD_VERSION_AUTH    (2u)
+#define MFC_PAYLOAD_AUTH_LEN        (12u)
+
+#define MFC_PRESSES_MAX             (15u)
+#define MFC_SEQ_MASK                (0x7Fu)
+
+/* Flags */
+#define MFC_FLAG_PAIRING            (0x01u)     // Band is in pairing mode
+
+/*******************************************************************************
+* Authentication (version 2)
+*
+*   Carter-Wegman: tag = H(bytes 0-3) ^ keystream word of the counter.
+*   H is a linear hash over GF(2): the XOR of one random 32 bit row per set
+* bit of the message. It is evaluated a nibble at a time from tables built
+* once from the rows, so it costs 8 lookups and 8 XORs.
+*   Every band has its own key, AES(master key, MfcAuthBlockInput(
+* MFC_AUTH_DOMAIN_BAND_KEY, address, 0)), so a gateway holding the master
+* key can verify any band. Keystream words come 4 per AES-128 block: word
+* (counter & 3) of AES(key, MfcAuthBlockInput(MFC_AUTH_DOMAIN_KEYSTREAM,
+* address, counter >> 2)). The rows are the 8 blocks AES(key,
+* MfcAuthBlockInput(MFC_AUTH_DOMAIN_HASH, address, 0 to 7)), taken as
+* little endian words. The address is in every input: a payload only
+* verifies under the address of the band that signed it.
+*******************************************************************************/
+#define MFC_AUTH_KEY_LEN            (16u)
+#define MFC_AUTH_BLOCK_LEN          (16u)
+#define MFC_AUTH_WORDS_PER_BLOCK    (4u)
+#define MFC_AUTH_ROWS               (32u)
+#define MFC_AUTH_HASH_BLOCKS        (MFC_AUTH_ROWS / MFC_AUTH_WORDS_PER_BLOCK)
+
+#define MFC_AUTH_ADDR_LEN           (6u)        // BD address, as sent (LSB first)
+
+#define MFC_AUTH_DOMAIN_KEYSTREAM   (0x01u)
+#define MFC_AUTH_DOMAIN_HASH        (0x02u)
+#define MFC_AUTH_DOMAIN_BAND_KEY    (0x03u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint8_t     version;
+    uint8_t     presses;
+    uint8_t     flags;
+    uint8_t     seq;
+    uint16_t    uptimeMinutes;
+    uint32_t    counter;        // Version 2 only
+    uint32_t    tag;            // Version 2 only
+} MFC_PAYLOAD_T;
+
+/* Nibble tables of the hash, built by MfcAuthHashInit */
+typedef struct
+{
+    uint32_t    table[8][16];
+} MFC_AUTH_HASH_T;
+
+/*******************************************************************************
+* @brief This function looks for the Manufacturer Specific Data with our
+*       company ID in an ADV packet, walking its AD structures.
+*
+* @param const uint8_t* advData:    The ADV packet
+* @param uint8_t advDataLen:        Its length
+* @param uint8_t* payloadLen:       Set to the bytes after the company ID
+*                                  (can be NULL)
+*
+* @returns int:                     Index of the payload (after the company
+*                                  ID), -1 if there isn't one of at least
+*                                  MFC_PAYLOAD_LEN bytes
+*******************************************************************************/
+int MfcPayloadFind(const uint8_t *advData, uint8_t advDataLen,
+                   uint8_t *payloadLen);
+
+/*******************************************************************************
+* @brief This function packs the fields.
+*
+* NOTE: presses saturates at MFC_PRESSES_MAX and seq is taken modulo 128.
+*   counter and tag are only written for MFC_PAYLOAD_VERSION_AUTH, any other
+*   version is written as MFC_PAYLOAD_VERSION.
+*
+* @param uint8_t* out:                      Where to write
+* @param const MFC_PAYLOAD_T* payload:      The fields
+*
+* @returns uint8_t:                 Bytes written (MFC_PAYLOAD_LEN or
+*                                  MFC_PAYLOAD_AUTH_LEN)
+*******************************************************************************/
+uint8_t MfcPayloadEncode(uint8_t *out, const MFC_PAYLOAD_T *payload);
+
+/*******************************************************************************
+* @brief This function unpacks a payload.
+*
+* @param const uint8_t* data:       The payload (ie: advData + MfcPayloadFind())
+* @param uint8_t length:            Bytes available from data
+* @param MFC_PAYLOAD_T* payload:    The fields
+*
+* @returns int:                     0 on success, -1 if too short or of an
+*                                  unknown version
+*******************************************************************************/
+int MfcPayloadDecode(const uint8_t *data, uint8_t length, MFC_PAYLOAD_T *payload);
+
+/*******************************************************************************
+* @brief This routine builds the AES input block for a keystream block, a
+*       block of hash rows or the key of a band.
+*
+*   byte 0 the domain, bytes 4-7 the index (little endian), bytes 8-13 the
+* address, the rest 0.
+*
+* @param uint8_t* out:              MFC_AUTH_BLOCK_LEN bytes
+* @param uint8_t domain:            MFC_AUTH_DOMAIN_KEYSTREAM, _HASH or
+*                                  _BAND_KEY
+* @param const uint8_t* addr:       BD address of the band, MFC_AUTH_ADDR_LEN
+*                                  bytes
+* @param uint32_t index:            Block number (ie: counter >> 2), 0 for
+*                                  the band key
+*
+* @returns None
+*******************************************************************************/
+void MfcAuthBlockInput(uint8_t *out, uint8_t domain, const uint8_t *addr,
+                       uint32_t index);
+
+/*******************************************************************************
+* @brief This routine builds the nibble tables of the hash.
+*
+* @param MFC_AUTH_HASH_T* hash:     The tables to build
+* @param const uint8_t* rows:       The MFC_AUTH_HASH_BLOCKS AES outputs, in
+*                                  order (MFC_AUTH_ROWS * 4 bytes)
+*
+* @returns None
+*******************************************************************************/
+void MfcAuthHashInit(MFC_AUTH_HASH_T *hash, const uint8_t *rows);
+
+/*******************************************************************************
+* @brief This function hashes the first MFC_PAYLOAD_LEN bytes of a payload.
+*
+* @param const MFC_AUTH_HASH_T* hash:   The tables
+* @param const uint8_t* payload:        The encoded payload
+*
+* @returns uint32_t:                The hash
+*******************************************************************************/
+uint32_t MfcAuthHash(const MFC_AUTH_HASH_T *hash, const uint8_t *payload);
+
+/*******************************************************************************
+* @brief This function hashes the first MFC_PAYLOAD_LEN bytes of a payload
+*       straight from the rows, one XOR per set bit. Same result as
+*       MfcAuthHash, for a receiver that keeps the rows of many bands
+*       rather than their tables.
+*
+* @param const uint8_t* rows:       The MFC_AUTH_HASH_BLOCKS AES outputs, in
+*                                  order (MFC_AUTH_ROWS * 4 bytes)
+* @param const uint8_t* payload:    The encoded payload
+*
+* @returns uint32_t:                The hash
+*******************************************************************************/
+uint32_t MfcAuthHashRows(const uint8_t *rows, const uint8_t *payload);
+
+/*******************************************************************************
+* @brief This function picks the keystream word of a counter out of its block.
+*
+* @param const uint8_t* block:      AES output for block counter >> 2
+* @param uint32_t counter:          The counter
+*
+* @returns uint32_t:                The keystream word
+*******************************************************************************/
+uint32_t MfcAuthKeystreamWord(const uint8_t *block, uint32_t counter);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,85 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    power_stats.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Low power residency and wakeup counters
+ * @author  prisma.ai
+ *
+ *  Counting has to stay cheaper than what it measures: the interrupts only
+ * increment a counter, and a sleep costs two reads of the free-running
+ * LFCLK counter plus a handful of adds. The wakeup source is found after
+ * the fact, by looking at which interrupt counter moved while sleeping; if
+ * none did, it was the BLESS interrupt.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "power_stats.h"
+#include "lp_timer.h"
+
+/*******************************************************************************
+* Global variables
+*******************************************************************************/
+FW_STATE POWER_STATS_T power_stats;
+
+/*******************************************************************************
+* @brief This routine is called right before entering a low power mode.
+*
+* @param POWER_STATS_MARK_T* mark:  Filled with the state before sleeping
+* @param uint8 state:               POWER_STATE_DEEPSLEEP or POWER_STATE_SLEEP
+*
+* @returns None
+*******************************************************************************/
+void PowerStatsSleep(POWER_STATS_MARK_T *mark, uint8 state)
+{
+    mark->state = state;
+    mark->buttonIrqs = power_stats.buttonIrqs;
+    mark->timerIrqs = power_stats.timerIrqs;
+    mark->ticks = LowPowerTimerNow();
+}
+
+/*******************************************************************************
+* @brief This routine is called after waking up, once the interrupts ran
+*       (after CyExitCriticalSection), and accounts for the sleep.
+*
+* @param const POWER_STATS_MARK_T* mark:    What PowerStatsSleep remembered
+*
+* @returns None
+*******************************************************************************/
+void PowerStatsWake(const POWER_STATS_MARK_T *mark)
+{
+    uint32 ticks = LowPowerTimerNow() - mark->ticks;
+
+    if(mark->state == POWER_STATE_DEEPSLEEP)
+    {
+        ++power_stats.deepSleepEntries;
+        power_stats.deepSleepTicks += ticks;
+    }
+    else
+    {
+        ++power_stats.sleepEntries;
+        power_stats.sleepTicks += ticks;
+    }
+
+    if(power_stats.buttonIrqs != mark->buttonIrqs)
+    {
+        ++power_stats.wakeButton;
+    }
+    else if(power_stats.timerIrqs != mark->timerIrqs)
+    {
+        ++power_stats.wakeTimer;
+    }
+    else
+    {
+        ++power_stats.wakeBle;
+    }
+}
+
+/* [] END OF FILE */
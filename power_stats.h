@@ -0,0 +1,88 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    power_stats.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for power_stats.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef POWER_STATS_HEADER
+#define POWER_STATS_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Low power branches taken by EnterLowPowerMode */
+#define POWER_STATE_DEEPSLEEP       (0u)
+#define POWER_STATE_SLEEP           (1u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 deepSleepEntries;
+    uint32 deepSleepTicks;      // LFCLK ticks spent in Deep-Sleep (wraps)
+    uint32 sleepEntries;
+    uint32 sleepTicks;          // LFCLK ticks spent in Sleep (wraps)
+    uint32 closeSpins;          // Passes that found BLESS in EVENT_CLOSE
+    uint32 wakeButton;
+    uint32 wakeTimer;
+    uint32 wakeBle;
+    volatile uint32 buttonIrqs; // Counted by the interrupts themselves
+    volatile uint32 timerIrqs;
+} POWER_STATS_T;
+
+/* What EnterLowPowerMode remembers about one sleep */
+typedef struct
+{
+    uint32 ticks;
+    uint32 buttonIrqs;
+    uint32 timerIrqs;
+    uint8  state;
+} POWER_STATS_MARK_T;
+
+/*******************************************************************************
+* Counters
+*******************************************************************************/
+extern FW_STATE POWER_STATS_T power_stats;
+
+/* Counts one event, ie: POWER_STATS_COUNT(closeSpins) */
+#define POWER_STATS_COUNT(counter)  (++power_stats.counter)
+
+/*******************************************************************************
+* @brief This routine is called right before entering a low power mode.
+*
+* @param POWER_STATS_MARK_T* mark:  Filled with the state before sleeping
+* @param uint8 state:               POWER_STATE_DEEPSLEEP or POWER_STATE_SLEEP
+*
+* @returns None
+*******************************************************************************/
+void PowerStatsSleep(POWER_STATS_MARK_T *mark, uint8 state);
+
+/*******************************************************************************
+* @brief This routine is called after waking up, once the interrupts ran
+*       (after CyExitCriticalSection), and accounts for the sleep.
+*
+* @param const POWER_STATS_MARK_T* mark:    What PowerStatsSleep remembered
+*
+* @returns None
+*******************************************************************************/
+void PowerStatsWake(const POWER_STATS_MARK_T *mark);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,104 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    press_queue.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Lock-free single producer / single consumer queue of presses
+ * @author  prisma.ai
+ *
+ *  The interrupts only ever write press_head and the main loop only ever
+ * writes press_tail. Both are single bytes (atomic on the Cortex-M0) and
+ * free-running, so (head - tail) is the fill level. The slot is written
+ * before head is published, and read before tail is released; everything
+ * shared is volatile so the compiler keeps that order.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "press_queue.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define PRESS_QUEUE_MASK            (PRESS_QUEUE_SIZE - 1u)
+
+/* Compile time check: the size must be a power of two that fits the
+ * free-running uint8 indexes */
+typedef char press_queue_size_check[
+    ((PRESS_QUEUE_SIZE & PRESS_QUEUE_MASK) == 0u &&
+     PRESS_QUEUE_SIZE <= 128u) ? 1 : -1];
+
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE volatile PRESS_EVENT_T press_events[PRESS_QUEUE_SIZE];
+static FW_STATE volatile uint8 press_head = 0;       // Written by the producer only
+static FW_STATE volatile uint8 press_tail = 0;       // Written by the consumer only
+static FW_STATE volatile uint32 press_dropped = 0;   // Written by the producer only
+
+/*******************************************************************************
+* @brief This function queues a press. Interrupt side (single producer) only.
+*
+* NOTE: Never blocks, a full queue drops the press and counts it.
+*
+* @param uint32 timestamp:          When the press happened
+* @param uint8 button:              What was pressed (ie: BOTH_BUTTONS or 2)
+*
+* @returns uint8:                   1 if queued, 0 if the queue was full
+*******************************************************************************/
+uint8 PressQueuePush(uint32 timestamp, uint8 button) {
+    uint8 head = press_head;
+    
+    if ((uint8)(head - press_tail) >= PRESS_QUEUE_SIZE) {
+        ++press_dropped;
+        return 0;
+    }
+    
+    press_events[head & PRESS_QUEUE_MASK].timestamp = timestamp;
+    press_events[head & PRESS_QUEUE_MASK].button = button;
+    
+    /* Publish the slot only once it is filled */
+    press_head = (uint8)(head + 1u);
+    return 1;
+}
+
+/*******************************************************************************
+* @brief This function takes the oldest press. Main loop (single consumer) only.
+*
+* @param PRESS_EVENT_T* event:      Where to store the press
+*
+* @returns uint8:                   1 if a press was taken, 0 if empty
+*******************************************************************************/
+uint8 PressQueuePop(PRESS_EVENT_T *event) {
+    uint8 tail = press_tail;
+    
+    if (tail == press_head) {
+        return 0;
+    }
+    
+    event->timestamp = press_events[tail & PRESS_QUEUE_MASK].timestamp;
+    event->button = press_events[tail & PRESS_QUEUE_MASK].button;
+    
+    /* Hand the slot back only once it was read */
+    press_tail = (uint8)(tail + 1u);
+    return 1;
+}
+
+/*******************************************************************************
+* @brief This function returns how many presses were dropped on overflow.
+*
+* @param None
+*
+* @returns uint32:                  Dropped presses since boot
+*******************************************************************************/
+uint32 PressQueueDropped(void) {
+    return press_dropped;
+}
+
+/* [] END OF FILE */
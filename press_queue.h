@@ -0,0 +1,71 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    press_queue.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for press_queue.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef PRESS_QUEUE_HEADER
+#define PRESS_QUEUE_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+#define PRESS_QUEUE_SIZE            (16u) // Power of two, at most 128
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32  timestamp;      // LowPowerTimerNow() when the press was classified
+    uint8   button;         // Input, ie: BOTH_BUTTONS (see button_func.h)
+} PRESS_EVENT_T;
+
+/*******************************************************************************
+* @brief This function queues a press. Interrupt side (single producer) only.
+*
+* NOTE: Never blocks, a full queue drops the press and counts it.
+*
+* @param uint32 timestamp:          When the press happened
+* @param uint8 button:              What was pressed (ie: BOTH_BUTTONS or 2)
+*
+* @returns uint8:                   1 if queued, 0 if the queue was full
+*******************************************************************************/
+uint8 PressQueuePush(uint32 timestamp, uint8 button);
+
+/*******************************************************************************
+* @brief This function takes the oldest press. Main loop (single consumer) only.
+*
+* @param PRESS_EVENT_T* event:      Where to store the press
+*
+* @returns uint8:                   1 if a press was taken, 0 if empty
+*******************************************************************************/
+uint8 PressQueuePop(PRESS_EVENT_T *event);
+
+/*******************************************************************************
+* @brief This function returns how many presses were dropped on overflow.
+*
+* @param None
+*
+* @returns uint32:                  Dropped presses since boot
+*******************************************************************************/
+uint32 PressQueueDropped(void);
+
+#endif
+
+/* [] END OF FILE */
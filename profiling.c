@@ -0,0 +1,199 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    profiling.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Stack high-water mark and cycle histograms, for profiling builds
+ * @author  prisma.ai
+ *
+ *  Built with PROFILING = 1 only: in a release build the PROFILING_START /
+ * PROFILING_STOP spans in the ISRs, StackEventHandler and the main loop are
+ * empty, and nothing here is called (the linker drops GetProfilingStats).
+ *   Spans are timed with SysTick, free-running at HFCLK over its 24 bits
+ * with its interrupt off, so the counts are cycles at whatever level the
+ * clock governor set. A span is added to a log2 histogram of its source, a
+ * few hundred bytes for all of them, and the longest one is kept.
+ *   The free stack is painted once at start. The high-water mark is found
+ * by scanning up from the limit for the first byte that isn't paint, it is
+ * only measured when read: on connection, for the Data characteristic, and
+ * by GetProfilingStats.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <stdint.h>
+#include "profiling.h"
+
+#if (PROFILING)
+/*******************************************************************************
+* Variables
+*******************************************************************************/
+static FW_STATE PROFILING_STATS_T profiling_stats;
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+/*******************************************************************************
+* @brief This function measures the stack high-water mark.
+*
+* @param None
+*
+* @returns uint16:                  Bytes of stack used at most so far
+*******************************************************************************/
+static uint16 ProfilingStackUsed(void)
+{
+    const uint8 *p = PROFILING_STACK_LIMIT;
+
+    while(p < PROFILING_STACK_TOP && *p == PROFILING_STACK_PAINT)
+    {
+        ++p;
+    }
+    return (uint16)(PROFILING_STACK_TOP - p);
+}
+
+/*******************************************************************************
+* @brief This routine appends a little endian value to a buffer.
+*
+* @param uint8 **out:               Where to write, moved past the value
+* @param uint32 value:              The value
+* @param uint8 bytes:               Its size
+*
+* @returns None
+*******************************************************************************/
+static void ProfilingPut(uint8 **out, uint32 value, uint8 bytes)
+{
+    while(bytes-- > 0u)
+    {
+        *(*out)++ = (uint8)value;
+        value >>= 8;
+    }
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine paints the free stack and starts SysTick. Called once,
+*       early in InitializeSystem.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ProfilingStart(void)
+{
+    uint8 marker;
+    /* Volatile, or the loop becomes a call to memset that runs on the
+    stack being painted */
+    volatile uint8 *p = PROFILING_STACK_LIMIT;
+    uintptr_t end = (uintptr_t)&marker - PROFILING_STACK_MARGIN;
+
+    while((uintptr_t)p < end)
+    {
+        *p++ = PROFILING_STACK_PAINT;
+    }
+
+    profiling_stats.stackSize = (uint16)(PROFILING_STACK_TOP - PROFILING_STACK_LIMIT);
+
+    /* Free-running over 24 bits, no interrupt */
+    CySysTickSetReload(CY_SYS_SYST_RVR_CNT_MASK);
+    CySysTickClear();
+    CySysTickEnable();
+    CySysTickDisableInterrupt();
+}
+
+/*******************************************************************************
+* @brief This routine adds one span to the histogram of its source.
+*
+*   Called from the ISRs too: a span is only ever interrupted by the span of
+* another source, so they never share a counter.
+*
+* @param uint8 source:              What was timed (ie: PROFILING_ISR_BUTTON)
+* @param uint32 start:              SysTick value at the start of the span
+*
+* @returns None
+*******************************************************************************/
+void ProfilingRecord(uint8 source, uint32 start)
+{
+    /* SysTick counts down */
+    uint32 cycles = (start - CySysTickGetValue()) & CY_SYS_SYST_RVR_CNT_MASK;
+    uint32 above = cycles >> PROFILING_MIN_LOG2;
+    uint8 bucket = 0;
+
+    /* No CLZ on the M0 */
+    while(above != 0u && bucket < PROFILING_BUCKETS - 1u)
+    {
+        above >>= 1;
+        ++bucket;
+    }
+
+    if(profiling_stats.buckets[source][bucket] != 0xFFFFu)
+    {
+        ++profiling_stats.buckets[source][bucket];
+    }
+    if(cycles > profiling_stats.maxCycles[source])
+    {
+        profiling_stats.maxCycles[source] = cycles;
+    }
+}
+
+/*******************************************************************************
+* @brief This routine copies the counters to the Data characteristic, so a
+*       client can read them. Called when a client connects.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ProfilingPublish(void)
+{
+    uint8 data[PROFILING_DATA_LEN];
+    uint8 *out = data;
+    CYBLE_GATT_HANDLE_VALUE_PAIR_T pair;
+    uint8 source;
+    uint8 bucket;
+
+    ProfilingPut(&out, PROFILING_VERSION, 1u);
+    ProfilingPut(&out, ProfilingStackUsed(), 2u);
+    ProfilingPut(&out, profiling_stats.stackSize, 2u);
+    for(source = 0; source < PROFILING_SOURCES; ++source)
+    {
+        ProfilingPut(&out, profiling_stats.maxCycles[source], 4u);
+        for(bucket = 0; bucket < PROFILING_BUCKETS; ++bucket)
+        {
+            ProfilingPut(&out, profiling_stats.buckets[source][bucket], 2u);
+        }
+    }
+
+    pair.attrHandle = CYBLE_PROFILING_DATA_CHAR_HANDLE;
+    pair.value.val = data;
+    pair.value.len = (uint16)(out - data);
+    CyBle_GattsWriteAttributeValue(&pair, 0u, NULL, CYBLE_GATT_DB_LOCALLY_INITIATED);
+}
+#endif
+
+/*******************************************************************************
+* @brief This function returns the counters, with the stack high-water mark
+*       measured now.
+*
+* @param None
+*
+* @returns const PROFILING_STATS_T*:    The counters, NULL without PROFILING
+*******************************************************************************/
+const PROFILING_STATS_T *GetProfilingStats(void)
+{
+#if (PROFILING)
+    profiling_stats.stackUsed = ProfilingStackUsed();
+    return &profiling_stats;
+#else
+    return NULL;
+#endif
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,139 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    profiling.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for profiling.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef PROFILING_HEADER
+#define PROFILING_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Set to 1 for a profiling build, with 0 the macros below compile to nothing */
+#ifndef PROFILING
+#define PROFILING                   (0u)
+#endif
+
+/* What is timed */
+#define PROFILING_ISR_BUTTON        (0u)    // Alert_Interrupt_Handler
+#define PROFILING_ISR_TIMER         (1u)    // The low power timer callbacks
+#define PROFILING_BLE_EVENT         (2u)    // StackEventHandler
+#define PROFILING_MAIN_LOOP         (3u)    // One pass, up to EnterLowPowerMode
+#define PROFILING_SOURCES           (4u)
+
+/*  Histogram of SysTick (HFCLK) cycles: bucket 0 is below
+ * 2^PROFILING_MIN_LOG2 cycles, each next one doubles, the last is open */
+#define PROFILING_BUCKETS           (12u)
+#define PROFILING_MIN_LOG2          (6u)
+
+/* Stack painting: the paint byte, and what is left unpainted below the
+ * frame of ProfilingStart (it is in use by then) */
+#define PROFILING_STACK_PAINT       (0xA5u)
+#define PROFILING_STACK_MARGIN      (64u)
+
+/* Stack bounds, from cy_boot's GCC linker script (the simulator has its own) */
+#if (PROFILING) && !defined(PROFILING_STACK_LIMIT)
+extern uint8 __cy_stack_limit[];
+extern uint8 __cy_stack[];
+#define PROFILING_STACK_LIMIT       ((uint8 *)__cy_stack_limit)
+#define PROFILING_STACK_TOP         ((uint8 *)__cy_stack)
+#endif
+
+/*  GATT readout (Profiling service, Data characteristic, read only), multi-
+ * byte values are little endian:
+ *      [0]     PROFILING_VERSION
+ *      [1-2]   Stack high-water mark, bytes
+ *      [3-4]   Stack size, bytes
+ *      then for each source, PROFILING_SOURCE_LEN bytes:
+ *      [0-3]   Longest, cycles
+ *      [4-..]  PROFILING_BUCKETS counts, 16 bit, saturated               */
+#define PROFILING_VERSION           (0x01u)
+#define PROFILING_SOURCE_LEN        (4u + 2u * PROFILING_BUCKETS)
+#define PROFILING_DATA_LEN          (5u + PROFILING_SOURCES * PROFILING_SOURCE_LEN)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint16 buckets[PROFILING_SOURCES][PROFILING_BUCKETS];
+    uint32 maxCycles[PROFILING_SOURCES];
+    uint16 stackUsed;           // Filled by GetProfilingStats
+    uint16 stackSize;
+} PROFILING_STATS_T;
+
+/*******************************************************************************
+* Macros
+*
+*   PROFILING_START(mark) declares the start of a span (with the other
+* declarations), PROFILING_STOP(source, mark) adds it to the histogram.
+*******************************************************************************/
+#if (PROFILING)
+#define PROFILING_START(mark)           uint32 mark = CySysTickGetValue()
+#define PROFILING_STOP(source, mark)    ProfilingRecord((source), (mark))
+#else
+#define PROFILING_START(mark)
+#define PROFILING_STOP(source, mark)
+#endif
+
+#if (PROFILING)
+/*******************************************************************************
+* @brief This routine paints the free stack and starts SysTick. Called once,
+*       early in InitializeSystem.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ProfilingStart(void);
+
+/*******************************************************************************
+* @brief This routine adds one span to the histogram of its source.
+*
+* @param uint8 source:              What was timed (ie: PROFILING_ISR_BUTTON)
+* @param uint32 start:              SysTick value at the start of the span
+*
+* @returns None
+*******************************************************************************/
+void ProfilingRecord(uint8 source, uint32 start);
+
+/*******************************************************************************
+* @brief This routine copies the counters to the Data characteristic, so a
+*       client can read them. Called when a client connects.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ProfilingPublish(void);
+#endif
+
+/*******************************************************************************
+* @brief This function returns the counters, with the stack high-water mark
+*       measured now.
+*
+* @param None
+*
+* @returns const PROFILING_STATS_T*:    The counters, NULL without PROFILING
+*******************************************************************************/
+const PROFILING_STATS_T *GetProfilingStats(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,252 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    scan_telemetry.c
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Telemetry in the scan response, built when a scanner asks for it
+ * @author  prisma.ai
+ *
+ *  Gateways and phones in the background scan passively: they never ask
+ * for the scan response, so nothing is spent on it for them. A phone that
+ * scans actively sends a SCAN_REQ, the link layer answers it on its own
+ * with the scan response it holds, and the stack tells us with
+ * CYBLE_EVT_GAPP_SCAN_REQ_RECVD. Only then is the telemetry field built,
+ * at the next EVENT_CLOSE, and handed to the stack with the ADV payload:
+ * the scanner gets it in the answer to its next request, one advertising
+ * interval later.
+ *   The field is cached. It is only built again when one of its inputs
+ * changed since: the uptime minute, or a gesture ended. The residency is
+ * measured between two builds, and the sleep entry and spin counters are
+ * read when it is built, so they don't make the field change by themselves.
+ *
+ * ========================================
+*/
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include "scan_telemetry.h"
+#include "gesture.h"
+#include "lp_timer.h"
+#include "power_stats.h"
+
+#if (SCAN_TELEMETRY)
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Gesture counters, as in the field */
+#define SCAN_GESTURE_UNSAFE         (0u)
+#define SCAN_GESTURE_CUSTOM         (1u)
+#define SCAN_GESTURE_ALERT          (2u)
+#define SCAN_GESTURE_PAIRING        (3u)
+#define SCAN_GESTURES               (4u)
+
+/*******************************************************************************
+* Global variables
+*******************************************************************************/
+static FW_STATE uint8  scan_base_len = 0xFFu;     // Length set in the component
+static FW_STATE uint8  scan_wanted = 0;           // A scanner asked since the last pass
+static FW_STATE uint8  scan_stale = 1;            // A gesture since the last build
+static FW_STATE uint32 scan_minutes = 0;          // Uptime in the field
+static FW_STATE uint32 scan_seconds = 0;          // When it was built
+static FW_STATE uint32 scan_ticks = 0;
+static FW_STATE uint32 scan_deep_sleep = 0;
+static FW_STATE uint32 scan_sleep = 0;
+static FW_STATE uint32 scan_gestures[SCAN_GESTURES];
+static FW_STATE SCAN_TELEMETRY_STATS_T scan_stats = {0, 0};
+
+/*******************************************************************************
+* Internal helpers
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine writes a saturated little endian uint16.
+*
+* @param uint8* field:              Where to write
+* @param uint32 value:              The value
+*
+* @returns None
+*******************************************************************************/
+static void ScanTelemetryPut16(uint8 *field, uint32 value)
+{
+    if(value > 0xFFFFu)
+    {
+        value = 0xFFFFu;
+    }
+    field[0] = (uint8)(value & 0xFFu);
+    field[1] = (uint8)(value >> 8);
+}
+
+/*******************************************************************************
+* @brief This function turns a tick count into a residency, in 0.5 % units.
+*
+* @param uint32 ticks:              Ticks in the low power mode
+* @param uint32 window:             Ticks in the window
+*
+* @returns uint8:                   0 to 200
+*******************************************************************************/
+static uint8 ScanTelemetryResidency(uint32 ticks, uint32 window)
+{
+    /* Scale down so that ticks * 200 fits in 32 bit */
+    while(window > 0x00FFFFFFu)
+    {
+        ticks >>= 1;
+        window >>= 1;
+    }
+    if(window == 0u)
+    {
+        return 0u;
+    }
+    if(ticks >= window)
+    {
+        return 200u;
+    }
+    return (uint8)((ticks * 200u) / window);
+}
+
+/*******************************************************************************
+* Public
+*******************************************************************************/
+/*******************************************************************************
+* @brief This routine counts a gesture for the telemetry, once it is over
+*       (its code cleared).
+*
+* @param uint8 code:                Its last code (ie: GESTURE_CODE_ALERT)
+*
+* @returns None
+*******************************************************************************/
+void ScanTelemetryGesture(uint8 code)
+{
+    if(code == GESTURE_CODE_PAIRING)
+    {
+        ++scan_gestures[SCAN_GESTURE_PAIRING];
+    }
+    else if(code >= GESTURE_CODE_ALERT)
+    {
+        ++scan_gestures[SCAN_GESTURE_ALERT];
+    }
+    else if(code == GESTURE_CODE_CUSTOM)
+    {
+        ++scan_gestures[SCAN_GESTURE_CUSTOM];
+    }
+    else
+    {
+        /* 3 presses have no meaning of their own and go with 1 */
+        ++scan_gestures[SCAN_GESTURE_UNSAFE];
+    }
+    scan_stale = 1;
+}
+
+/*******************************************************************************
+* @brief This routine is called on CYBLE_EVT_GAPP_SCAN_REQ_RECVD: a scanner
+*       asked for the scan response.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ScanTelemetryRequested(void)
+{
+    ++scan_stats.requests;
+    scan_wanted = 1;
+}
+
+/*******************************************************************************
+* @brief This function builds the telemetry field into the scan response if
+*       a scanner asked for it and the cached one is out of date. Called at
+*       EVENT_CLOSE, before the stack is updated.
+*
+* NOTE: The field is appended after the scan response set in the component,
+*   if it doesn't fit nothing is published.
+*
+* @param CYBLE_GAPP_SCAN_RSP_DATA_T* scanRsp:   The scan response data
+*
+* @returns uint8:                   1 if the scan response changed
+*******************************************************************************/
+uint8 ScanTelemetryUpdate(CYBLE_GAPP_SCAN_RSP_DATA_T *scanRsp)
+{
+    uint32 seconds;
+    uint32 now;
+    uint32 window;
+    uint8 *field;
+
+    if(scan_wanted == 0)
+    {
+        return 0;
+    }
+    scan_wanted = 0;
+
+    if(scan_base_len == 0xFFu)
+    {
+        scan_base_len = scanRsp->scanRspDataLen;
+    }
+    seconds = LowPowerTimerSeconds();
+    if((scan_stale == 0 && seconds / 60u == scan_minutes) ||
+       scan_base_len + SCAN_TELEMETRY_FIELD_LEN > CYBLE_GAP_MAX_SCAN_RSP_DATA_LEN)
+    {
+        return 0;
+    }
+
+    now = LowPowerTimerNow();
+    window = now - scan_ticks;
+    field = &scanRsp->scanRspData[scan_base_len];
+    field[0] = SCAN_TELEMETRY_FIELD_LEN - 1u;
+    field[1] = 0xFFu;
+    ScanTelemetryPut16(&field[2], SCAN_TELEMETRY_COMPANY_ID);
+    field[4] = SCAN_TELEMETRY_VERSION;
+    field[5] = (uint8)((FW_VERSION_MAJOR << 4) | (FW_VERSION_MINOR & 0x0Fu));
+    field[6] = FW_VERSION_PATCH;
+    ScanTelemetryPut16(&field[7], seconds / 60u);
+    if(seconds - scan_seconds > SCAN_TELEMETRY_WINDOW_MAX_S)
+    {
+        field[9] = SCAN_TELEMETRY_UNKNOWN;
+        field[10] = SCAN_TELEMETRY_UNKNOWN;
+    }
+    else
+    {
+        field[9] = ScanTelemetryResidency(
+            power_stats.deepSleepTicks - scan_deep_sleep, window);
+        field[10] = ScanTelemetryResidency(power_stats.sleepTicks - scan_sleep, window);
+    }
+    ScanTelemetryPut16(&field[11], power_stats.deepSleepEntries);
+    ScanTelemetryPut16(&field[13], power_stats.sleepEntries);
+    ScanTelemetryPut16(&field[15], power_stats.closeSpins);
+    ScanTelemetryPut16(&field[17], scan_gestures[SCAN_GESTURE_UNSAFE]);
+    ScanTelemetryPut16(&field[19], scan_gestures[SCAN_GESTURE_CUSTOM]);
+    ScanTelemetryPut16(&field[21], scan_gestures[SCAN_GESTURE_ALERT]);
+    field[23] = (scan_gestures[SCAN_GESTURE_PAIRING] > 0xFFu) ?
+                0xFFu : (uint8)scan_gestures[SCAN_GESTURE_PAIRING];
+    scanRsp->scanRspDataLen = scan_base_len + SCAN_TELEMETRY_FIELD_LEN;
+
+    scan_stale = 0;
+    scan_minutes = seconds / 60u;
+    scan_seconds = seconds;
+    scan_ticks = now;
+    scan_deep_sleep = power_stats.deepSleepTicks;
+    scan_sleep = power_stats.sleepTicks;
+    ++scan_stats.builds;
+
+    return 1;
+}
+#endif
+
+/*******************************************************************************
+* @brief This function returns the scan response counters.
+*
+* @param None
+*
+* @returns const SCAN_TELEMETRY_STATS_T*:   Requests / builds, NULL without
+*                                          SCAN_TELEMETRY
+*******************************************************************************/
+const SCAN_TELEMETRY_STATS_T *GetScanTelemetryStats(void)
+{
+#if (SCAN_TELEMETRY)
+    return &scan_stats;
+#else
+    return NULL;
+#endif
+}
+
+/* [] END OF FILE */
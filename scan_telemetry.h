@@ -0,0 +1,128 @@
+/* ========================================
+ *
+ * Copyright (c) prisma.ai
+ * All Rights Reserved
+ *
+ * @file    scan_telemetry.h
+ * @date    16 Oct 2026
+ * @version 3.4.0
+ * @brief   Header for scan_telemetry.c
+ * @author  prisma.ai
+ *
+ * ========================================
+*/
+
+/* Guard: */
+#ifndef SCAN_TELEMETRY_HEADER
+#define SCAN_TELEMETRY_HEADER
+
+/*******************************************************************************
+* Headers / Libs
+*******************************************************************************/
+#include <project.h>
+#include "fw_state.h"
+
+/*******************************************************************************
+* Constants
+*******************************************************************************/
+/* Set to 0 to leave the component's scan response as it is */
+#ifndef SCAN_TELEMETRY
+#define SCAN_TELEMETRY              (1u)
+#endif
+
+/* Firmware version, as in the file headers, major and minor 0 to 15 */
+#define FW_VERSION_MAJOR            (3u)
+#define FW_VERSION_MINOR            (4u)
+#define FW_VERSION_PATCH            (0u)
+
+#define SCAN_TELEMETRY_COMPANY_ID   (0xFFFFu)   // Same as the ADV Manfc. Data
+#define SCAN_TELEMETRY_VERSION      (0x02u)     // Layout of the field below
+
+/* Residency over a longer window is not sent, the tick counters may wrap */
+#define SCAN_TELEMETRY_WINDOW_MAX_S (86400u)
+#define SCAN_TELEMETRY_UNKNOWN      (0xFFu)
+
+/*  Scan response field (Manufacturer Specific Data), appended after the
+ * component's scan response. Multi-byte values are little endian, counters
+ * saturate:
+ *      [0]     length (SCAN_TELEMETRY_FIELD_LEN - 1)
+ *      [1]     0xFF
+ *      [2-3]   SCAN_TELEMETRY_COMPANY_ID
+ *      [4]     SCAN_TELEMETRY_VERSION
+ *      [5]     Firmware version: major [7:4], minor [3:0]
+ *      [6]     Firmware version: patch
+ *      [7-8]   Uptime, minutes
+ *      [9]     Deep-Sleep residency since the previous field was built,
+ *              0.5 % units, SCAN_TELEMETRY_UNKNOWN after
+ *              SCAN_TELEMETRY_WINDOW_MAX_S
+ *      [10]    Sleep residency, same
+ *      [11-12] Deep-Sleep entries since boot
+ *      [13-14] Sleep entries since boot
+ *      [15-16] EVENT_CLOSE spins since boot
+ *      [17-18] Gestures: feels unsafe
+ *      [19-20] Gestures: configurable
+ *      [21-22] Gestures: 113 alert
+ *      [23]    Gestures: pairing
+ *  With the 7 bytes of the component's scan response (service UUID and TX
+ * power) this fills the 31 bytes. Version 1 had the firmware version in 3
+ * bytes, 16 bit pairing gestures and no entry / spin counters.             */
+#define SCAN_TELEMETRY_FIELD_LEN    (24u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef struct
+{
+    uint32 requests;    // CYBLE_EVT_GAPP_SCAN_REQ_RECVD events
+    uint32 builds;      // Times the field was built, the others found it cached
+} SCAN_TELEMETRY_STATS_T;
+
+#if (SCAN_TELEMETRY)
+/*******************************************************************************
+* @brief This routine counts a gesture for the telemetry, once it is over
+*       (its code cleared).
+*
+* @param uint8 code:                Its last code (ie: GESTURE_CODE_ALERT)
+*
+* @returns None
+*******************************************************************************/
+void ScanTelemetryGesture(uint8 code);
+
+/*******************************************************************************
+* @brief This routine is called on CYBLE_EVT_GAPP_SCAN_REQ_RECVD: a scanner
+*       asked for the scan response.
+*
+* @param None
+*
+* @returns None
+*******************************************************************************/
+void ScanTelemetryRequested(void);
+
+/*******************************************************************************
+* @brief This function builds the telemetry field into the scan response if
+*       a scanner asked for it and the cached one is out of date. Called at
+*       EVENT_CLOSE, before the stack is updated.
+*
+* NOTE: The field is appended after the scan response set in the component,
+*   if it doesn't fit nothing is published.
+*
+* @param CYBLE_GAPP_SCAN_RSP_DATA_T* scanRsp:   The scan response data
+*
+* @returns uint8:                   1 if the scan response changed
+*******************************************************************************/
+uint8 ScanTelemetryUpdate(CYBLE_GAPP_SCAN_RSP_DATA_T *scanRsp);
+#endif
+
+/*******************************************************************************
+* @brief This function returns the scan response counters.
+*
+* @param None
+*
+* @returns const SCAN_TELEMETRY_STATS_T*:   Requests / builds, NULL without
+*                                          SCAN_TELEMETRY
+*******************************************************************************/
+const SCAN_TELEMETRY_STATS_T *GetScanTelemetryStats(void);
+
+#endif
+
+/* [] END OF FILE */